@@ -0,0 +1,115 @@
+/*=========================================================================
+*
+* Copyright Marius Staring, Stefan Klein, David Doria. 2011.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0.txt
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*=========================================================================*/
+/** \file
+ \brief Test that the ConvertingImageFileReader reads only the requested region.
+
+ The image is read in the same streams as pxcastconvert -ns uses. Each
+ stream should buffer only its own region, and give the same values as
+ the itk::ImageFileReader.
+ */
+
+#include "itkConvertingImageFileReader.h"
+#include "itkImageFileReader.h"
+#include "itkImageRegionConstIterator.h"
+#include "itkImageRegionSplitterSlowDimension.h"
+
+#include <iostream>
+
+
+int main( int argc, char ** argv )
+{
+  if( argc != 3 )
+  {
+    std::cerr << "Usage: " << argv[ 0 ] << " inputImage numberOfStreams" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  typedef itk::Image< short, 2 >                        ImageType;
+  typedef ImageType::RegionType                         RegionType;
+  typedef itk::ConvertingImageFileReader< ImageType >   ReaderType;
+  typedef itk::ImageFileReader< ImageType >             ReferenceReaderType;
+  typedef itk::ImageRegionConstIterator< ImageType >    IteratorType;
+
+  const unsigned int numberOfStreams = atoi( argv[ 2 ] );
+
+  try
+  {
+    ReferenceReaderType::Pointer referenceReader = ReferenceReaderType::New();
+    referenceReader->SetFileName( argv[ 1 ] );
+    referenceReader->Update();
+
+    ReaderType::Pointer reader = ReaderType::New();
+    reader->SetFileName( argv[ 1 ] );
+    reader->UpdateOutputInformation();
+    if( !reader->GetModifiableImageIO()->CanStreamRead() )
+    {
+      std::cerr << "ERROR: " << argv[ 1 ] << " can not be read streamed." << std::endl;
+      return EXIT_FAILURE;
+    }
+
+    /** Read the image stream by stream. */
+    const RegionType largestRegion = reader->GetOutput()->GetLargestPossibleRegion();
+    itk::ImageRegionSplitterSlowDimension::Pointer splitter
+      = itk::ImageRegionSplitterSlowDimension::New();
+    const unsigned int numberOfSplits
+      = splitter->GetNumberOfSplits( largestRegion, numberOfStreams );
+    if( numberOfSplits < 2 )
+    {
+      std::cerr << "ERROR: The image is not split in streams." << std::endl;
+      return EXIT_FAILURE;
+    }
+
+    for( unsigned int i = 0; i < numberOfSplits; ++i )
+    {
+      RegionType region = largestRegion;
+      splitter->GetSplit( i, numberOfSplits, region );
+      reader->GetOutput()->SetRequestedRegion( region );
+      reader->Update();
+
+      /** Only the region of the stream should have been read. */
+      const RegionType bufferedRegion = reader->GetOutput()->GetBufferedRegion();
+      if( bufferedRegion != region )
+      {
+        std::cerr << "ERROR: Stream " << i << " read the region "
+          << bufferedRegion.GetIndex() << bufferedRegion.GetSize()
+          << " instead of " << region.GetIndex() << region.GetSize() << "." << std::endl;
+        return EXIT_FAILURE;
+      }
+
+      IteratorType it( reader->GetOutput(), region );
+      IteratorType itRef( referenceReader->GetOutput(), region );
+      for( ; !it.IsAtEnd(); ++it, ++itRef )
+      {
+        if( it.Get() != itRef.Get() )
+        {
+          std::cerr << "ERROR: Stream " << i << " read " << it.Get()
+            << " instead of " << itRef.Get() << " at " << it.GetIndex() << "." << std::endl;
+          return EXIT_FAILURE;
+        }
+      }
+    }
+  }
+  catch( itk::ExceptionObject & excp )
+  {
+    std::cerr << "ERROR: Caught ITK exception: " << excp << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+
+} // end main
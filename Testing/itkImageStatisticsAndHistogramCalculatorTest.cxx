@@ -0,0 +1,197 @@
+/*=========================================================================
+*
+* Copyright Marius Staring, Stefan Klein, David Doria. 2011.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0.txt
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*=========================================================================*/
+/** \file
+ \brief Test the exact quantiles of the ImageStatisticsAndHistogramCalculator.
+
+ The quantiles of ComputeExactQuantiles() should be:
+ - the given quantiles of the input image, e.g. its known median;
+ - those of the sorted values, interpolated between the two nearest ranks,
+   for probabilities from 0 to 1, of the input image and of a random image
+   in which most values share a coarse bin, with and without a mask, also
+   when at most one value may be gathered per bin, so that the coarse bins
+   are refined;
+ - the value of an image of a single value, for all probabilities.
+ */
+
+#include "itkImageStatisticsAndHistogramCalculator.h"
+#include "itkImageFileReader.h"
+#include "itkImageRegionConstIterator.h"
+#include "itkImageRegionIterator.h"
+#include "itkMersenneTwisterRandomVariateGenerator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+
+typedef itk::Image< float, 2 >                          ImageType;
+typedef itk::Image< unsigned char, 2 >                  MaskImageType;
+typedef itk::ImageStatisticsAndHistogramCalculator<
+  ImageType, MaskImageType >                            CalculatorType;
+typedef CalculatorType::RealType                        RealType;
+
+
+/** The quantiles of the sorted values within the mask. */
+std::vector< RealType > ComputeSortedQuantiles( const ImageType * image,
+  const MaskImageType * mask, const std::vector< RealType > & probabilities )
+{
+  std::vector< RealType > values;
+  itk::ImageRegionConstIterator< ImageType > it( image, image->GetBufferedRegion() );
+  for( ; !it.IsAtEnd(); ++it )
+  {
+    if( mask && !mask->GetPixel( it.GetIndex() ) ) continue;
+    values.push_back( it.Get() );
+  }
+  std::sort( values.begin(), values.end() );
+
+  std::vector< RealType > quantiles( probabilities.size() );
+  for( unsigned int i = 0; i < probabilities.size(); ++i )
+  {
+    const RealType h = probabilities[ i ] * static_cast< RealType >( values.size() - 1 );
+    const std::size_t lower = static_cast< std::size_t >( std::floor( h ) );
+    const std::size_t upper = std::min( lower + 1, values.size() - 1 );
+    quantiles[ i ] = values[ lower ] + ( h - std::floor( h ) ) * ( values[ upper ] - values[ lower ] );
+  }
+  return quantiles;
+
+} // end ComputeSortedQuantiles()
+
+
+/** Compare the exact quantiles of the calculator with the expected ones. */
+bool CompareQuantiles( const ImageType * image, const MaskImageType * mask,
+  const std::vector< RealType > & probabilities,
+  const std::vector< RealType > & expected, const std::string & description,
+  const itk::SizeValueType maximumNumberOfGatheredValues = 65536 )
+{
+  CalculatorType::Pointer calculator = CalculatorType::New();
+  calculator->SetInput( image );
+  calculator->SetMask( mask );
+  calculator->SetMaximumNumberOfGatheredValues( maximumNumberOfGatheredValues );
+  calculator->Compute();
+  const std::vector< RealType > quantiles = calculator->ComputeExactQuantiles( probabilities );
+
+  bool equal = true;
+  for( unsigned int i = 0; i < probabilities.size(); ++i )
+  {
+    if( std::abs( quantiles[ i ] - expected[ i ] ) > 1e-12 * std::max( 1.0, std::abs( expected[ i ] ) ) )
+    {
+      std::cerr << "ERROR: " << description << ": the quantile of " << probabilities[ i ]
+        << " is " << quantiles[ i ] << " instead of " << expected[ i ] << "." << std::endl;
+      equal = false;
+    }
+  }
+  return equal;
+
+} // end CompareQuantiles()
+
+
+int main( int argc, char ** argv )
+{
+  if( argc < 2 || argc % 2 != 0 )
+  {
+    std::cerr << "Usage: " << argv[ 0 ]
+      << " inputImage [probability quantile ...]" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  /** The probabilities 0, 0.01, ..., 1. */
+  std::vector< RealType > probabilities;
+  for( unsigned int i = 0; i <= 100; ++i )
+  {
+    probabilities.push_back( i / 100.0 );
+  }
+
+  bool equal = true;
+  try
+  {
+    typedef itk::ImageFileReader< ImageType > ReaderType;
+    ReaderType::Pointer reader = ReaderType::New();
+    reader->SetFileName( argv[ 1 ] );
+    reader->Update();
+    const ImageType * input = reader->GetOutput();
+
+    /** The given quantiles of the input image. */
+    std::vector< RealType > givenProbabilities;
+    std::vector< RealType > givenQuantiles;
+    for( int i = 2; i < argc; i += 2 )
+    {
+      givenProbabilities.push_back( atof( argv[ i ] ) );
+      givenQuantiles.push_back( atof( argv[ i + 1 ] ) );
+    }
+    if( !givenProbabilities.empty() )
+    {
+      equal &= CompareQuantiles( input, nullptr,
+        givenProbabilities, givenQuantiles, "Given quantiles" );
+    }
+    equal &= CompareQuantiles( input, nullptr, probabilities,
+      ComputeSortedQuantiles( input, nullptr, probabilities ), "Input image" );
+
+    /** A random image of values in [0, 1), with duplicates, and a single
+     * large value, so that most values share the first coarse bin and have
+     * to be gathered. The mask is a checkerboard.
+     */
+    ImageType::SizeType size;
+    size.Fill( 64 );
+    ImageType::Pointer random = ImageType::New();
+    random->SetRegions( size );
+    random->Allocate();
+    MaskImageType::Pointer mask = MaskImageType::New();
+    mask->SetRegions( size );
+    mask->Allocate();
+
+    typedef itk::Statistics::MersenneTwisterRandomVariateGenerator RandomGeneratorType;
+    RandomGeneratorType::Pointer randomGenerator = RandomGeneratorType::New();
+    randomGenerator->SetSeed( 1 );
+    itk::ImageRegionIterator< ImageType > it( random, random->GetBufferedRegion() );
+    for( ; !it.IsAtEnd(); ++it )
+    {
+      const ImageType::IndexType index = it.GetIndex();
+      it.Set( std::floor( randomGenerator->GetUniformVariate( 0.0, 1.0 ) * 1000.0 ) / 1000.0 );
+      mask->SetPixel( index, ( index[ 0 ] + index[ 1 ] ) % 2 );
+    }
+    ImageType::IndexType largeIndex;
+    largeIndex.Fill( 1 );
+    random->SetPixel( largeIndex, 1e6 );
+
+    equal &= CompareQuantiles( random, nullptr, probabilities,
+      ComputeSortedQuantiles( random, nullptr, probabilities ), "Random image" );
+    equal &= CompareQuantiles( random, mask, probabilities,
+      ComputeSortedQuantiles( random, mask, probabilities ), "Masked random image" );
+    equal &= CompareQuantiles( random, nullptr, probabilities,
+      ComputeSortedQuantiles( random, nullptr, probabilities ), "Random image, refined", 1 );
+    equal &= CompareQuantiles( random, mask, probabilities,
+      ComputeSortedQuantiles( random, mask, probabilities ), "Masked random image, refined", 1 );
+
+    /** An image of a single value. */
+    ImageType::Pointer constant = ImageType::New();
+    constant->SetRegions( size );
+    constant->Allocate();
+    constant->FillBuffer( 3.5 );
+    equal &= CompareQuantiles( constant, nullptr, probabilities,
+      std::vector< RealType >( probabilities.size(), 3.5 ), "Single value image" );
+  }
+  catch( itk::ExceptionObject & excp )
+  {
+    std::cerr << "ERROR: Caught ITK exception: " << excp << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  if( !equal ) return EXIT_FAILURE;
+  return EXIT_SUCCESS;
+
+} // end main
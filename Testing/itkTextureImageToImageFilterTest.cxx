@@ -0,0 +1,185 @@
+/*=========================================================================
+*
+* Copyright Marius Staring, Stefan Klein, David Doria. 2011.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0.txt
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*=========================================================================*/
+/** \file
+ \brief Test the TextureImageToImageFilter against the co-occurrence matrix
+ of each pixel, computed from scratch.
+
+ For every pixel the co-occurrence matrix of its neighborhood is computed by
+ the ScalarImageToGrayLevelCooccurrenceMatrixGenerator, and its features by
+ the GrayLevelCooccurrenceMatrixTextureCoefficientsCalculator, as the filter
+ did before it updated the matrix incrementally. All eight features of the
+ filter should be equal to those.
+
+ Optionally the histogram range is given, so that some pixels fall outside
+ of it and are skipped, and a mask, outside of which the features are 0.
+ */
+
+#include "itkTextureImageToImageFilter.h"
+#include "itkGrayLevelCooccurrenceMatrixTextureCoefficientsCalculator.h"
+#include "itkImageFileReader.h"
+#include "itkImageRegionConstIteratorWithIndex.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+
+int main( int argc, char ** argv )
+{
+  if( argc != 5 && argc != 7 && argc != 8 )
+  {
+    std::cerr << "Usage: " << argv[ 0 ]
+      << " inputImage radius numberOfBins normalize [minimum maximum [mask]]" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  typedef itk::Image< float, 2 >                                InputImageType;
+  typedef itk::Image< double, 2 >                               OutputImageType;
+  typedef itk::ImageFileReader< InputImageType >                ReaderType;
+  typedef itk::TextureImageToImageFilter<
+    InputImageType, OutputImageType >                           FilterType;
+  typedef FilterType::CooccurrenceMatrixGeneratorType           GeneratorType;
+  typedef itk::Statistics::GrayLevelCooccurrenceMatrixTextureCoefficientsCalculator<
+    GeneratorType::HistogramType >                              CalculatorType;
+  typedef FilterType::MaskImageType                             MaskImageType;
+  typedef itk::ImageFileReader< MaskImageType >                 MaskReaderType;
+  typedef InputImageType::RegionType                            RegionType;
+  typedef itk::ImageRegionConstIteratorWithIndex< InputImageType > IteratorType;
+
+  const unsigned int radius = atoi( argv[ 2 ] );
+  const unsigned int numberOfBins = atoi( argv[ 3 ] );
+  const bool normalize = atoi( argv[ 4 ] ) != 0;
+  const unsigned int numberOfFeatures = 8;
+
+  try
+  {
+    ReaderType::Pointer reader = ReaderType::New();
+    reader->SetFileName( argv[ 1 ] );
+    reader->Update();
+    InputImageType::Pointer input = reader->GetOutput();
+
+    /** The filter, with two offset scales, so that the slabs that enter and
+     * leave the neighborhood have pairs with pixels outside of it.
+     */
+    std::vector< unsigned int > offsetScales;
+    offsetScales.push_back( 1 );
+    offsetScales.push_back( 2 );
+
+    FilterType::Pointer filter = FilterType::New();
+    filter->SetInput( input );
+    filter->SetNeighborhoodRadius( radius );
+    filter->SetOffsetScales( offsetScales );
+    filter->SetNumberOfHistogramBins( numberOfBins );
+    filter->SetNormalizeHistogram( normalize );
+    filter->SetNumberOfRequestedOutputs( numberOfFeatures );
+    if( argc > 5 )
+    {
+      filter->SetHistogramMinimum( atof( argv[ 5 ] ) );
+      filter->SetHistogramMaximum( atof( argv[ 6 ] ) );
+    }
+    MaskImageType::Pointer mask;
+    if( argc > 7 )
+    {
+      MaskReaderType::Pointer maskReader = MaskReaderType::New();
+      maskReader->SetFileName( argv[ 7 ] );
+      maskReader->Update();
+      mask = maskReader->GetOutput();
+      filter->SetMask( mask );
+    }
+    filter->Update();
+
+    /** The co-occurrence matrix of each pixel, from scratch. */
+    GeneratorType::Pointer generator = GeneratorType::New();
+    generator->SetInput( input );
+    generator->SetOffsets( filter->GetOffsets() );
+    generator->SetNumberOfBinsPerAxis( numberOfBins );
+    generator->SetPixelValueMinMax(
+      filter->GetHistogramMinimum(), filter->GetHistogramMaximum() );
+    generator->SetNormalize( normalize );
+    CalculatorType::Pointer calculator = CalculatorType::New();
+
+    const RegionType largestRegion = input->GetLargestPossibleRegion();
+    unsigned long numberOfDifferences = 0;
+    for( IteratorType it( input, largestRegion ); !it.IsAtEnd(); ++it )
+    {
+      /** Outside the mask all features are 0. */
+      if( mask && !mask->GetPixel( it.GetIndex() ) )
+      {
+        for( unsigned int i = 0; i < numberOfFeatures; ++i )
+        {
+          const double value = filter->GetOutput( i )->GetPixel( it.GetIndex() );
+          if( value != 0.0 )
+          {
+            std::cerr << "ERROR: Feature " << i << " at " << it.GetIndex()
+              << " is " << value << " outside the mask." << std::endl;
+            ++numberOfDifferences;
+          }
+        }
+        continue;
+      }
+
+      RegionType localRegion;
+      InputImageType::IndexType localIndex = it.GetIndex();
+      InputImageType::SizeType localSize;
+      for( unsigned int d = 0; d < 2; ++d )
+      {
+        localIndex[ d ] -= radius;
+        localSize[ d ] = 2 * radius + 1;
+      }
+      localRegion.SetIndex( localIndex );
+      localRegion.SetSize( localSize );
+      localRegion.Crop( largestRegion );
+
+      generator->SetComputeRegion( localRegion );
+      generator->Compute();
+      calculator->SetHistogram( generator->GetOutput() );
+      calculator->Compute();
+
+      /** Features that are not a number, e.g. the correlation of a constant
+       * neighborhood, should be so for both.
+       */
+      for( unsigned int i = 0; i < numberOfFeatures; ++i )
+      {
+        const double expected = calculator->GetFeature( i );
+        const double value = filter->GetOutput( i )->GetPixel( it.GetIndex() );
+        const bool equal = ( std::isnan( expected ) && std::isnan( value ) )
+          || std::abs( value - expected ) <= 1e-9 * std::max( 1.0, std::abs( expected ) );
+        if( !equal )
+        {
+          std::cerr << "ERROR: Feature " << i << " at " << it.GetIndex() << " is "
+            << value << " instead of " << expected << "." << std::endl;
+          ++numberOfDifferences;
+        }
+      }
+    }
+
+    if( numberOfDifferences > 0 )
+    {
+      std::cerr << "There are " << numberOfDifferences << " different features!" << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  catch( itk::ExceptionObject & excp )
+  {
+    std::cerr << "ERROR: Caught ITK exception: " << excp << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+
+} // end main
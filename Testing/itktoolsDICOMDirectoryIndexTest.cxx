@@ -0,0 +1,179 @@
+/*=========================================================================
+*
+* Copyright Marius Staring, Stefan Klein, David Doria. 2011.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0.txt
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*=========================================================================*/
+/** \file
+ \brief Test the itktools::DICOMDirectoryIndex.
+
+ The DICOM files are copied to a working directory, which is indexed:
+ - in parallel, with and without the index file, and the series and
+   their sorted files should be those of itk::GDCMSeriesFileNames;
+ - after the series number of one file is changed, without changing its
+   size and typically within the same second, the index file should not be used
+   for that file, so the file should be in a series of its own.
+ */
+
+#include "ITKToolsDICOMDirectoryIndex.h"
+#include "itkGDCMSeriesFileNames.h"
+
+#include <itksys/Directory.hxx>
+#include <itksys/SystemTools.hxx>
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+
+
+/** Compare the series and files of the index with those of gdcm. */
+bool CompareWithGDCM( const itktools::DICOMDirectoryIndex & index,
+  const std::string & directory, const std::string & description )
+{
+  itk::GDCMSeriesFileNames::Pointer gdcmNames = itk::GDCMSeriesFileNames::New();
+  gdcmNames->SetUseSeriesDetails( true );
+  gdcmNames->SetDirectory( directory );
+
+  const itk::GDCMSeriesFileNames::SeriesUIDContainerType gdcmUIDs = gdcmNames->GetSeriesUIDs();
+  const itktools::DICOMDirectoryIndex::SeriesUIDContainerType uids = index.GetSeriesUIDs();
+  if( uids.size() != gdcmUIDs.size() )
+  {
+    std::cerr << "ERROR: " << description << ": found " << uids.size()
+      << " series instead of " << gdcmUIDs.size() << "." << std::endl;
+    return false;
+  }
+
+  for( unsigned int i = 0; i < gdcmUIDs.size(); ++i )
+  {
+    const itk::GDCMSeriesFileNames::FileNamesContainerType gdcmFileNames
+      = gdcmNames->GetFileNames( gdcmUIDs[ i ] );
+    const itktools::DICOMDirectoryIndex::FileNamesContainerType fileNames
+      = index.GetFileNames( gdcmUIDs[ i ] );
+    if( fileNames.size() != gdcmFileNames.size() )
+    {
+      std::cerr << "ERROR: " << description << ": found " << fileNames.size()
+        << " files instead of " << gdcmFileNames.size()
+        << " in series " << gdcmUIDs[ i ] << "." << std::endl;
+      return false;
+    }
+    for( unsigned int j = 0; j < fileNames.size(); ++j )
+    {
+      if( itksys::SystemTools::GetFilenameName( fileNames[ j ] )
+        != itksys::SystemTools::GetFilenameName( gdcmFileNames[ j ] ) )
+      {
+        std::cerr << "ERROR: " << description << ": file " << j << " of series "
+          << gdcmUIDs[ i ] << " is " << fileNames[ j ] << " instead of "
+          << gdcmFileNames[ j ] << "." << std::endl;
+        return false;
+      }
+    }
+  }
+  return true;
+
+} // end CompareWithGDCM()
+
+
+int main( int argc, char ** argv )
+{
+  if( argc != 3 )
+  {
+    std::cerr << "Usage: " << argv[ 0 ] << " inputDirectory workingDirectory" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  const std::string inputDirectory = argv[ 1 ];
+  const std::string directory = argv[ 2 ];
+
+  try
+  {
+    /** Copy the files to an empty working directory. */
+    itksys::SystemTools::RemoveADirectory( directory );
+    itksys::SystemTools::MakeDirectory( directory );
+    itksys::Directory input;
+    input.Load( inputDirectory );
+    std::string lastFileName;
+    for( unsigned long i = 0; i < input.GetNumberOfFiles(); ++i )
+    {
+      const std::string fileName = inputDirectory + "/" + input.GetFile( i );
+      if( itksys::SystemTools::FileIsDirectory( fileName ) ) continue;
+      itksys::SystemTools::CopyFileAlways( fileName, directory );
+      lastFileName = std::max( lastFileName, std::string( input.GetFile( i ) ) );
+    }
+
+    /** Index in parallel, without and with the index file. */
+    itktools::DICOMDirectoryIndex index;
+    index.SetDirectory( directory );
+    index.SetNumberOfThreads( 4 );
+    index.Update();
+    if( !CompareWithGDCM( index, directory, "Without index file" ) ) return EXIT_FAILURE;
+
+    index.SetUseIndexFile( true );
+    index.Update();
+    if( !CompareWithGDCM( index, directory, "Writing the index file" ) ) return EXIT_FAILURE;
+    if( !itksys::SystemTools::FileExists(
+      directory + "/" + itktools::DICOMDirectoryIndex::IndexFileName ) )
+    {
+      std::cerr << "ERROR: The index file is not written." << std::endl;
+      return EXIT_FAILURE;
+    }
+
+    index.Update();
+    if( !CompareWithGDCM( index, directory, "Reading the index file" ) ) return EXIT_FAILURE;
+
+    /** Change the series number (0020|0011) of the last file in place. */
+    const std::string fileName = directory + "/" + lastFileName;
+    std::string contents;
+    {
+      std::ifstream file( fileName.c_str(), std::ios::binary );
+      contents.assign( std::istreambuf_iterator<char>( file ), std::istreambuf_iterator<char>() );
+    }
+    const std::string seriesNumberTag( "\x20\x00\x11\x00", 4 );
+    const std::string::size_type position = contents.find( seriesNumberTag );
+    std::string::size_type digit = std::string::npos;
+    if( position != std::string::npos && position + 8 < contents.size() )
+    {
+      const std::string::size_type length
+        = static_cast<unsigned char>( contents[ position + 4 ] );
+      digit = contents.substr( position + 8, length ).find_last_of( "0123456789" );
+    }
+    if( digit == std::string::npos )
+    {
+      std::cerr << "ERROR: " << fileName << " has no series number." << std::endl;
+      return EXIT_FAILURE;
+    }
+    char & value = contents[ position + 8 + digit ];
+    value = value == '9' ? '8' : value + 1;
+    {
+      std::ofstream file( fileName.c_str(), std::ios::binary | std::ios::trunc );
+      file.write( contents.data(), contents.size() );
+    }
+
+    index.Update();
+    if( !CompareWithGDCM( index, directory, "After changing a file" ) ) return EXIT_FAILURE;
+    if( index.GetSeriesUIDs().size() < 2 )
+    {
+      std::cerr << "ERROR: The changed file is not in a series of its own." << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  catch( itk::ExceptionObject & excp )
+  {
+    std::cerr << "ERROR: Caught ITK exception: " << excp << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+
+} // end main
@@ -64,12 +64,15 @@ std::string GetHelpString( void )
     << "- casting: changing the component type of a voxel, e.g. short, float,\n"
     << "           unsigned long, etc.\n"
     << "\nNotes:\n"
-    << "- Casting of scalar images is done by the itk::ShiftScaleImageFilter,\n"
-    << "  where values are mapped to itself, leaving the intensity range\n"
-    << "  the same. NB: When casting to a component type with smaller dynamic\n"
+    << "- Images are read in their on-disk component type, and cast straight\n"
+    << "  to the output component type, where values are mapped to itself,\n"
+    << "  leaving the intensity range the same. Values outside the range of the\n"
+    << "  output component type are clamped to that range, and floating point\n"
+    << "  values are rounded to the nearest integer when casting to an integer\n"
+    << "  type. NB: When casting to a component type with smaller dynamic\n"
     << "  range, information might get lost.\n"
-    << "- Casting of multi-component images, such as vector or RGB images, is\n"
-    << "  done using the itk::VectorCastImageFilter.\n"
+    << "- Multi-component images, such as vector or RGB images, are cast\n"
+    << "  component wise.\n"
     << "- Input images can be in all file formats ITK supports and for which\n"
     << "  the itk::ImageFileReader works, and additionally 3D dicom series.\n"
     << "  It is also possible to extract a specific DICOM series from a directory\n"
@@ -83,6 +86,8 @@ std::string GetHelpString( void )
     << "  -out     outputfilename\n"
     << "  [-opct]  outputPixelComponentType, default equal to input\n"
     << "  [-z]     compression flag; if provided, the output image is compressed\n"
+    << "  [-ns]    number of streams, default 1; when the input and output formats\n"
+    << "           support streaming, only a part of the image is in memory at a time\n"
     << "OR pxcastconvert\n"
     << "  -in      dicomDirectory\n"
     << "  -out     outputfilename\n"
@@ -90,6 +95,10 @@ std::string GetHelpString( void )
     << "  [-s]     seriesUID, default the first UID found\n"
     << "  [-r]     add restrictions to generate a unique seriesUID\n"
     << "           e.g. \"0020|0012\" to add a check for acquisition number.\n"
+    << "  [-index] read and write the index of the directory, see\n"
+    << "           pxgetDICOMseriesUIDs\n"
+    << "  [-ns]    number of streams, default 1; the slices are decoded in parallel,\n"
+    << "           and with more than one stream written slab by slab\n"
     << "  [-z]     compression flag; if provided, the output image is compressed\n\n"
     << "OutputPixelComponentType should be one of {[unsigned_]char, [unsigned_]short,\n"
     << "  [unsigned_]int, [unsigned_]long, float, double}.\n"
@@ -171,8 +180,13 @@ int main( int argc, char **argv )
   std::vector<std::string> restrictions;
   parser->GetCommandLineArgument( "-r", restrictions );
 
+  const bool useIndexFile = parser->ArgumentExists( "-index" );
+
   bool useCompression = parser->ArgumentExists( "-z" );
 
+  unsigned int numberOfStreams = 1;
+  parser->GetCommandLineArgument( "-ns", numberOfStreams );
+
   /** Check -opct. */
   if( retopct )
   {
@@ -198,6 +212,7 @@ int main( int argc, char **argv )
   /** Get image information. */
   std::string inputFileName = "";
   std::string inputDirectoryName = "";
+  std::vector<std::string> dicomFileNames;
   unsigned int dim = 0;
   if( !isDICOM )
   {
@@ -207,19 +222,20 @@ int main( int argc, char **argv )
   {
     inputDirectoryName = input;
 
-    /** Get the first DICOM image file name, to extract information from. */
-    std::string fileNameOfFirstDICOMImage = "";
+    /** Get the DICOM image file names of the series. The first is used to
+     * extract information from.
+     */
     std::string errorMessage = "";
-    bool allOK = GetFileNameFromDICOMDirectory(
-      inputDirectoryName, fileNameOfFirstDICOMImage,
-      seriesUID, restrictions, errorMessage );
+    bool allOK = GetFileNamesFromDICOMDirectory(
+      inputDirectoryName, dicomFileNames,
+      seriesUID, restrictions, useIndexFile, errorMessage );
     if( !allOK )
     {
       std::cerr << errorMessage << std::endl;
       return EXIT_FAILURE;
     }
 
-    inputFileName = fileNameOfFirstDICOMImage;
+    inputFileName = dicomFileNames[ 0 ];
   }
 
   /** Get dimension and component type. */
@@ -262,10 +278,10 @@ int main( int argc, char **argv )
     castConvert->m_InputFileName = inputFileName;
     castConvert->m_OutputFileName = outputFileName;
     castConvert->m_UseCompression = useCompression;
+    castConvert->m_NumberOfStreams = numberOfStreams;
 
     castConvert->m_InputDirectoryName = inputDirectoryName;
-    castConvert->m_DICOMSeriesUID = seriesUID;
-    castConvert->m_DICOMSeriesRestrictions = restrictions;
+    castConvert->m_DICOMFileNames = dicomFileNames;
 
     castConvert->Run();
 
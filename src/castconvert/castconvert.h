@@ -29,18 +29,14 @@
 
 /** Reading and writing images. */
 #include "itkImageFileReader.h"
-#include "itkImageSeriesReader.h"
 #include "itkImageFileWriter.h"
+#include "itkParallelImageSeriesReader.h"
 
 /** DICOM headers. */
 #include "itkGDCMImageIO.h"
-#include "itkGDCMSeriesFileNames.h"
 
-/** One of these is used to cast the image. */
-#include "itkCastImageFilter.h"
-#include "itkVectorIndexSelectionCastImageFilter.h"
-#include "itkComposeImageFilter.h"
-//#include "itkShiftScaleImageFilter.h"
+/** The readers cast the image while reading. */
+#include "itkConvertingImageFileReader.h"
 
 
 /** \class ITKToolsCastConvertBase
@@ -58,9 +54,9 @@ public:
     this->m_InputFileName = "";
     this->m_OutputFileName = "";
     this->m_UseCompression = false;
+    this->m_NumberOfStreams = 1;
 
     this->m_InputDirectoryName = "";
-    this->m_DICOMSeriesUID = "";
   };
   /** Destructor. */
   ~ITKToolsCastConvertBase(){};
@@ -69,11 +65,11 @@ public:
   std::string m_InputFileName;
   std::string m_OutputFileName;
   bool m_UseCompression;
+  unsigned int m_NumberOfStreams;
 
   /** DICOM specific input parameters. */
   std::string m_InputDirectoryName;
-  std::string m_DICOMSeriesUID;
-  std::vector<std::string> m_DICOMSeriesRestrictions;
+  std::vector<std::string> m_DICOMFileNames; // sorted, see GetFileNamesFromDICOMDirectory()
 
 }; // end class ITKToolsCastConvertBase
 
@@ -98,40 +94,34 @@ public:
   /** Run function. */
   void Run( void )
   {
-    typedef itk::VectorImage< double, VDimension >              InputVectorImageType;
-    typedef itk::VectorImage< TComponentType, VDimension >      OutputVectorImageType;
-    typedef itk::Image< double, VDimension >                    InputScalarImageType;
-    typedef itk::Image< TComponentType, VDimension >            OutputScalarImageType;
-    typedef typename itk::ImageFileReader< InputVectorImageType >     ImageReaderType;
+    /** The image is read in its on-disk component type, and converted
+     * straight into the output buffer, region by region.
+     */
+    typedef itk::VectorImage< TComponentType, VDimension >            OutputVectorImageType;
+    typedef typename itk::ConvertingImageFileReader<
+      OutputVectorImageType >                                         ImageReaderType;
     typedef typename itk::ImageFileWriter< OutputVectorImageType >    ImageWriterType;
 
     /** Create and setup the reader. */
     typename ImageReaderType::Pointer reader = ImageReaderType::New();
     reader->SetFileName( this->m_InputFileName.c_str() );
-    reader->Update();
+    reader->UpdateOutputInformation();
 
-    // Create the disassembler
-    typedef itk::VectorIndexSelectionCastImageFilter<
-      InputVectorImageType, InputScalarImageType >        IndexSelectionType;
-    typename IndexSelectionType::Pointer indexSelectionFilter
-      = IndexSelectionType::New();
-    indexSelectionFilter->SetInput( reader->GetOutput() );
-
-    // Create the re-assembler
-    typedef itk::ComposeImageFilter< OutputScalarImageType > ImageToVectorImageFilterType;
-    typename ImageToVectorImageFilterType::Pointer imageToVectorImageFilter
-      = ImageToVectorImageFilterType::New();
-
-    typedef itk::CastImageFilter< InputVectorImageType, OutputVectorImageType > CastImageFilterType;
-    typename CastImageFilterType::Pointer castImageFilter = CastImageFilterType::New();
-
-    castImageFilter->SetInput( reader->GetOutput() );
-    castImageFilter->Update();
+    /** Stream only if the input can be read streamed; otherwise each
+     * stream would read the whole file again.
+     */
+    unsigned int numberOfStreams = this->m_NumberOfStreams;
+    if( !reader->GetModifiableImageIO()->CanStreamRead() )
+    {
+      numberOfStreams = 1;
+    }
 
+    /** Write the image, possibly streamed. */
     typename ImageWriterType::Pointer writer = ImageWriterType::New();
     writer->SetFileName( this->m_OutputFileName.c_str() );
     writer->SetUseCompression( this->m_UseCompression );
-    writer->SetInput( castImageFilter->GetOutput() );
+    writer->SetInput( reader->GetOutput() );
+    writer->SetNumberOfStreamDivisions( numberOfStreams );
     writer->Update();
 
   } // end Run()
@@ -159,47 +149,33 @@ public:
   /** Run function. */
   virtual void Run( void )
   {
-    /** Typedef the correct reader, caster and writer. */
-    typedef itk::Image< double, VDimension >                          InputScalarImageType;
+    /** Typedef the correct reader and writer. The slices are decoded
+     * in parallel, straight into the output buffer.
+     */
     typedef itk::Image< TComponentType, VDimension >                  OutputScalarImageType;
-
-    typedef typename itk::ImageSeriesReader< InputScalarImageType >   SeriesReaderType;
-    typedef typename itk::CastImageFilter<
-      InputScalarImageType, OutputScalarImageType >                   CastFilterType;
+    typedef typename itk::ParallelImageSeriesReader<
+      OutputScalarImageType >                                         SeriesReaderType;
     typedef typename itk::ImageFileWriter< OutputScalarImageType >    ImageWriterType;
 
     /** Typedef DICOM stuff. */
     typedef itk::GDCMImageIO                  GDCMImageIOType;
-    typedef itk::GDCMSeriesFileNames          GDCMNamesGeneratorType;
-    typedef std::vector< std::string >        FileNamesContainerType;
 
     /** Create the DICOM ImageIO. */
     typename GDCMImageIOType::Pointer dicomIO = GDCMImageIOType::New();
 
-    /** Get a list of the filenames of the 2D input DICOM images. */
-    GDCMNamesGeneratorType::Pointer nameGenerator = GDCMNamesGeneratorType::New();
-    nameGenerator->SetUseSeriesDetails( true );
-    for( unsigned int i = 0; i < this->m_DICOMSeriesRestrictions.size(); ++i )
-    {
-      nameGenerator->AddSeriesRestriction( this->m_DICOMSeriesRestrictions[ i ] );
-    }
-    nameGenerator->SetInputDirectory( this->m_InputDirectoryName.c_str() );
-    FileNamesContainerType fileNames = nameGenerator->GetFileNames( this->m_DICOMSeriesUID );
-
     /** Create and setup the seriesReader. */
     typename SeriesReaderType::Pointer seriesReader = SeriesReaderType::New();
-    seriesReader->SetFileNames( fileNames );
+    seriesReader->SetFileNames( this->m_DICOMFileNames );
     seriesReader->SetImageIO( dicomIO );
 
-    /** Create and setup caster and writer. */
-    typename CastFilterType::Pointer caster = CastFilterType::New();
+    /** Create and setup the writer. With more than one stream, the
+     * slices are read and written slab by slab.
+     */
     typename ImageWriterType::Pointer writer = ImageWriterType::New();
     writer->SetFileName( this->m_OutputFileName.c_str()  );
     writer->SetUseCompression( this->m_UseCompression );
-
-    /** Connect the pipeline. */
-    caster->SetInput(  seriesReader->GetOutput()  );
-    writer->SetInput(  caster->GetOutput()  );
+    writer->SetInput(  seriesReader->GetOutput()  );
+    writer->SetNumberOfStreamDivisions( this->m_NumberOfStreams );
 
     /**  Do the actual  conversion.  */
     writer->Update();
@@ -19,7 +19,7 @@
 #define __castconverthelpers2_h_
 
 #include <itksys/SystemTools.hxx>
-#include "itkGDCMSeriesFileNames.h"
+#include "ITKToolsDICOMDirectoryIndex.h"
 
 
 // NOTE that these functions can not be moved to castconverthelpers.h,
@@ -56,55 +56,46 @@ bool IsDICOM( std::string & input, bool & isDICOM )
 
 
 /**
- * ******************* GetFileNameFromDICOMDirectory *******************
+ * ******************* GetFileNamesFromDICOMDirectory *******************
  */
 
-bool GetFileNameFromDICOMDirectory(
+bool GetFileNamesFromDICOMDirectory(
   const std::string & inputDirectoryName,
-  std::string & fileName,
+  std::vector<std::string> & fileNames,
   const std::string & seriesUID,
   const std::vector<std::string> & restrictions,
+  const bool useIndexFile,
   std::string & errorMessage )
 {
-  typedef itk::GDCMSeriesFileNames                GDCMNamesGeneratorType;
-  typedef std::vector< std::string >              FileNamesContainerType;
+  typedef itktools::DICOMDirectoryIndex           DICOMDirectoryIndexType;
 
-  /** Create vector of filenames from the DICOM directory. */
-  GDCMNamesGeneratorType::Pointer nameGenerator = GDCMNamesGeneratorType::New();
-  nameGenerator->SetUseSeriesDetails( true );
-  for( unsigned int i = 0; i < restrictions.size(); ++i )
+  /** Index the DICOM directory, reusing a previous index if possible. */
+  DICOMDirectoryIndexType directoryIndex;
+  directoryIndex.SetDirectory( inputDirectoryName );
+  directoryIndex.SetUseIndexFile( useIndexFile );
+  try
   {
-    nameGenerator->AddSeriesRestriction( restrictions[ i ] );
-  }
-  nameGenerator->SetInputDirectory( inputDirectoryName.c_str() );
-
-  /** The short and fast way. */
-  FileNamesContainerType fileNames;
-  if( seriesUID == "" )
-  {
-    fileNames = nameGenerator->GetInputFileNames();
-    if( fileNames.size() != 0 )
-    {
-      fileName = fileNames[ 0 ];
-      return true;
-    }
-    else
+    for( unsigned int i = 0; i < restrictions.size(); ++i )
     {
-      std::cerr << "ERROR: No files found in this directory." << std::endl;
-      return false;
+      directoryIndex.AddSeriesRestriction( restrictions[ i ] );
     }
+    directoryIndex.Update();
+  }
+  catch( itk::ExceptionObject & excp )
+  {
+    errorMessage = "ERROR: " + std::string( excp.GetDescription() );
+    return false;
   }
 
-  /** Get all series in this directory. */
-  FileNamesContainerType seriesNames = nameGenerator->GetSeriesUIDs();
-  if( !seriesNames.size() )
+  /** Check that there is at least one series in this directory. */
+  if( directoryIndex.GetSeriesUIDs().empty() )
   {
     errorMessage = "ERROR: no DICOM series in directory " + inputDirectoryName + ".";
     return false;
   }
 
-  /** Get a list of files in series. */
-  fileNames = nameGenerator->GetFileNames( seriesUID );
+  /** Get the sorted list of files in the series; by default the first. */
+  fileNames = directoryIndex.GetFileNames( seriesUID );
   if( !fileNames.size() )
   {
     errorMessage = "ERROR: no DICOM series " + seriesUID
@@ -112,13 +103,10 @@ bool GetFileNameFromDICOMDirectory(
     return false;
   }
 
-  /** Get a name of a 2D image. */
-  fileName = fileNames[ 0 ];
-
   /** Return a value. */
   return true;
 
-} // end GetFileNameFromDICOMDirectory()
+} // end GetFileNamesFromDICOMDirectory()
 
 
 #endif //__castconverthelpers2_h_
@@ -0,0 +1,171 @@
+/*=========================================================================
+*
+* Copyright Marius Staring, Stefan Klein, David Doria. 2011.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0.txt
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*=========================================================================*/
+#ifndef __itkClampRoundCastFunctor_h_
+#define __itkClampRoundCastFunctor_h_
+
+#include "itkNumericTraits.h"
+#include "itkImageIOBase.h"
+
+#include <cmath>
+#include <cstdint>
+#include <type_traits>
+
+
+namespace itk
+{
+
+namespace Functor
+{
+
+/** \class ClampRoundCast
+ * \brief Casts a component to another type, saturating at the limits of
+ * the output type, and rounding to the nearest integer when a floating
+ * point value is cast to an integer type. NaN is cast to zero.
+ *
+ * The conversion is selected at compile time, and is branch free apart
+ * from the clamping, so that loops over buffers are vectorized.
+ */
+
+template< class TInput, class TOutput >
+class ClampRoundCast
+{
+public:
+  ClampRoundCast() {};
+  ~ClampRoundCast() {};
+
+  inline TOutput operator()( const TInput & A ) const
+  {
+    return Convert( A,
+      std::integral_constant< bool, std::is_integral< TInput >::value >(),
+      std::integral_constant< bool, std::is_integral< TOutput >::value >() );
+  }
+
+private:
+  typedef std::true_type  IntegerType;
+  typedef std::false_type FloatType;
+
+  /** Integer to integer: compare in the widest type of the right signedness. */
+  static inline TOutput Convert( const TInput & A, IntegerType, IntegerType )
+  {
+    const bool below = std::is_signed< TInput >::value
+      && static_cast< std::intmax_t >( A ) < 0
+      && ( !std::is_signed< TOutput >::value
+      || static_cast< std::intmax_t >( A )
+      < static_cast< std::intmax_t >( NumericTraits< TOutput >::NonpositiveMin() ) );
+    const bool above = A > TInput( 0 )
+      && static_cast< std::uintmax_t >( A )
+      > static_cast< std::uintmax_t >( NumericTraits< TOutput >::max() );
+
+    if( below ) return NumericTraits< TOutput >::NonpositiveMin();
+    if( above ) return NumericTraits< TOutput >::max();
+    return static_cast< TOutput >( A );
+  }
+
+  /** Floating point to integer: clamp, then round half away from zero. */
+  static inline TOutput Convert( const TInput & A, FloatType, IntegerType )
+  {
+    const double value = static_cast< double >( A );
+    const double minimum = static_cast< double >( NumericTraits< TOutput >::NonpositiveMin() );
+    const double maximum = static_cast< double >( NumericTraits< TOutput >::max() );
+
+    if( !( value == value ) ) return NumericTraits< TOutput >::ZeroValue();
+    if( value <= minimum ) return NumericTraits< TOutput >::NonpositiveMin();
+    if( value >= maximum ) return NumericTraits< TOutput >::max();
+    return static_cast< TOutput >( std::round( value ) );
+  }
+
+  /** To floating point: only double to float can be out of range. */
+  static inline TOutput Convert( const TInput & A, IntegerType, FloatType )
+  {
+    return static_cast< TOutput >( A );
+  }
+
+  static inline TOutput Convert( const TInput & A, FloatType, FloatType )
+  {
+    if( sizeof( TOutput ) < sizeof( TInput ) )
+    {
+      const TInput maximum = static_cast< TInput >( NumericTraits< TOutput >::max() );
+      if( A > maximum ) return NumericTraits< TOutput >::max();
+      if( A < -maximum ) return NumericTraits< TOutput >::NonpositiveMin();
+    }
+    return static_cast< TOutput >( A );
+  }
+
+}; // end class ClampRoundCast
+
+} // end namespace Functor
+
+
+/** Casts a buffer of components to the output component type, with the
+ * ClampRoundCast functor.
+ */
+template< class TInput, class TOutput >
+void ClampRoundCastBuffer( const void * input, TOutput * output, const SizeValueType size )
+{
+  const Functor::ClampRoundCast< TInput, TOutput > converter;
+  const TInput * in = static_cast< const TInput * >( input );
+  for( SizeValueType i = 0; i < size; ++i )
+  {
+    output[ i ] = converter( in[ i ] );
+  }
+} // end ClampRoundCastBuffer()
+
+
+/** Casts a buffer of components of a type known at run time, e.g. as read
+ * by an ImageIO. Returns false if the input component type is not supported.
+ */
+template< class TOutput >
+bool ClampRoundCastBuffer( const IOComponentEnum inputComponentType,
+  const void * input, TOutput * output, const SizeValueType size )
+{
+  switch( inputComponentType )
+  {
+  case IOComponentEnum::UCHAR:
+    ClampRoundCastBuffer< unsigned char >( input, output, size ); break;
+  case IOComponentEnum::CHAR:
+    ClampRoundCastBuffer< char >( input, output, size ); break;
+  case IOComponentEnum::USHORT:
+    ClampRoundCastBuffer< unsigned short >( input, output, size ); break;
+  case IOComponentEnum::SHORT:
+    ClampRoundCastBuffer< short >( input, output, size ); break;
+  case IOComponentEnum::UINT:
+    ClampRoundCastBuffer< unsigned int >( input, output, size ); break;
+  case IOComponentEnum::INT:
+    ClampRoundCastBuffer< int >( input, output, size ); break;
+  case IOComponentEnum::ULONG:
+    ClampRoundCastBuffer< unsigned long >( input, output, size ); break;
+  case IOComponentEnum::LONG:
+    ClampRoundCastBuffer< long >( input, output, size ); break;
+  case IOComponentEnum::ULONGLONG:
+    ClampRoundCastBuffer< unsigned long long >( input, output, size ); break;
+  case IOComponentEnum::LONGLONG:
+    ClampRoundCastBuffer< long long >( input, output, size ); break;
+  case IOComponentEnum::FLOAT:
+    ClampRoundCastBuffer< float >( input, output, size ); break;
+  case IOComponentEnum::DOUBLE:
+    ClampRoundCastBuffer< double >( input, output, size ); break;
+  default:
+    return false;
+  }
+  return true;
+
+} // end ClampRoundCastBuffer()
+
+} // end namespace itk
+
+#endif // end #ifndef __itkClampRoundCastFunctor_h_
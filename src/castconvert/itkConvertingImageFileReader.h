@@ -0,0 +1,108 @@
+/*=========================================================================
+*
+* Copyright Marius Staring, Stefan Klein, David Doria. 2011.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0.txt
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*=========================================================================*/
+#ifndef __itkConvertingImageFileReader_h_
+#define __itkConvertingImageFileReader_h_
+
+#include "itkImageSource.h"
+#include "itkImageIOBase.h"
+
+
+namespace itk
+{
+
+/** \class ConvertingImageFileReader
+ * \brief Reads an image in its on-disk component type, and converts it
+ * straight into the output buffer.
+ *
+ * The itk::ImageFileReader casts the components with a static_cast.
+ * This reader instead clamps the values to the range of the output
+ * component type, and rounds when converting floating point values to
+ * integers, see itk::Functor::ClampRoundCast. The conversion is
+ * multi-threaded.
+ *
+ * Only the requested region is read, when the ImageIO supports streamed
+ * reading, so that together with a streaming writer only a part of the
+ * input and of the output is in memory at any time.
+ *
+ * The output can be an itk::Image or an itk::VectorImage. In the latter
+ * case the number of components is taken from the file.
+ */
+
+template< class TOutputImage >
+class ITK_EXPORT ConvertingImageFileReader : public ImageSource< TOutputImage >
+{
+public:
+  /** Standard class typedefs. */
+  typedef ConvertingImageFileReader     Self;
+  typedef ImageSource< TOutputImage >   Superclass;
+  typedef SmartPointer< Self >          Pointer;
+  typedef SmartPointer< const Self >    ConstPointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro( Self );
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro( ConvertingImageFileReader, ImageSource );
+
+  /** Dimension of the image. */
+  itkStaticConstMacro( ImageDimension, unsigned int, TOutputImage::ImageDimension );
+
+  /** Typedefs. */
+  typedef TOutputImage                                OutputImageType;
+  typedef typename OutputImageType::RegionType        OutputImageRegionType;
+  typedef typename OutputImageType::InternalPixelType OutputComponentType;
+
+  /** Set and get the file name. */
+  itkSetStringMacro( FileName );
+  itkGetStringMacro( FileName );
+
+  /** Get the ImageIO, which is created from the file name. */
+  itkGetModifiableObjectMacro( ImageIO, ImageIOBase );
+
+protected:
+  ConvertingImageFileReader();
+  virtual ~ConvertingImageFileReader() {};
+
+  /** PrintSelf. */
+  virtual void PrintSelf( std::ostream & os, Indent indent ) const;
+
+  /** Read the header of the file. */
+  virtual void GenerateOutputInformation( void );
+
+  /** Enlarge the requested region to what the ImageIO can read. */
+  virtual void EnlargeOutputRequestedRegion( DataObject * output );
+
+  /** Read and convert the requested region. */
+  virtual void GenerateData( void );
+
+private:
+  ConvertingImageFileReader( const Self & ); // purposely not implemented
+  void operator=( const Self & ); // purposely not implemented
+
+  std::string           m_FileName;
+  ImageIOBase::Pointer  m_ImageIO;
+
+}; // end class ConvertingImageFileReader
+
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkConvertingImageFileReader.hxx"
+#endif
+
+#endif // end #ifndef __itkConvertingImageFileReader_h_
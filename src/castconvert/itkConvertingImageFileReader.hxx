@@ -0,0 +1,236 @@
+/*=========================================================================
+*
+* Copyright Marius Staring, Stefan Klein, David Doria. 2011.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0.txt
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*=========================================================================*/
+#ifndef _itkConvertingImageFileReader_hxx_
+#define _itkConvertingImageFileReader_hxx_
+
+#include "itkConvertingImageFileReader.h"
+
+#include "itkClampRoundCastFunctor.h"
+#include "itkImageIOFactory.h"
+#include "itkImageIORegion.h"
+
+#include <algorithm>
+#include <vector>
+
+
+namespace itk
+{
+
+/**
+ * ********************* Constructor ****************************
+ */
+
+template< class TOutputImage >
+ConvertingImageFileReader< TOutputImage >
+::ConvertingImageFileReader()
+{
+  this->m_FileName = "";
+} // end Constructor
+
+
+/**
+ * ********************* GenerateOutputInformation ****************************
+ */
+
+template< class TOutputImage >
+void
+ConvertingImageFileReader< TOutputImage >
+::GenerateOutputInformation( void )
+{
+  typedef typename OutputImageType::SizeType      SizeType;
+  typedef typename OutputImageType::IndexType     IndexType;
+  typedef typename OutputImageType::SpacingType   SpacingType;
+  typedef typename OutputImageType::PointType     PointType;
+  typedef typename OutputImageType::DirectionType DirectionType;
+
+  if( this->m_FileName.empty() )
+  {
+    itkExceptionMacro( << "No file name has been set." );
+  }
+
+  /** Create the ImageIO and read the header. */
+  this->m_ImageIO = ImageIOFactory::CreateImageIO(
+    this->m_FileName.c_str(), IOFileModeEnum::ReadMode );
+  if( this->m_ImageIO.IsNull() )
+  {
+    itkExceptionMacro( << "Could not create an ImageIO for " << this->m_FileName << "." );
+  }
+  this->m_ImageIO->SetFileName( this->m_FileName );
+  this->m_ImageIO->ReadImageInformation();
+
+  const unsigned int fileDimension = this->m_ImageIO->GetNumberOfDimensions();
+  if( fileDimension > ImageDimension )
+  {
+    itkExceptionMacro( << "The image in " << this->m_FileName << " has dimension "
+      << fileDimension << ", but the reader has dimension " << ImageDimension << "." );
+  }
+
+  /** Copy the geometry. Missing dimensions get size 1. */
+  SizeType size; size.Fill( 1 );
+  IndexType index; index.Fill( 0 );
+  SpacingType spacing; spacing.Fill( 1.0 );
+  PointType origin; origin.Fill( 0.0 );
+  DirectionType direction; direction.SetIdentity();
+  for( unsigned int i = 0; i < fileDimension; ++i )
+  {
+    size[ i ] = this->m_ImageIO->GetDimensions( i );
+    spacing[ i ] = this->m_ImageIO->GetSpacing( i );
+    origin[ i ] = this->m_ImageIO->GetOrigin( i );
+    const std::vector< double > axis = this->m_ImageIO->GetDirection( i );
+    for( unsigned int j = 0; j < fileDimension; ++j )
+    {
+      direction[ j ][ i ] = axis[ j ];
+    }
+  }
+
+  OutputImageRegionType largestRegion;
+  largestRegion.SetSize( size );
+  largestRegion.SetIndex( index );
+
+  OutputImageType * output = this->GetOutput();
+  output->SetLargestPossibleRegion( largestRegion );
+  output->SetSpacing( spacing );
+  output->SetOrigin( origin );
+  output->SetDirection( direction );
+  output->SetNumberOfComponentsPerPixel( this->m_ImageIO->GetNumberOfComponents() );
+
+  /** An itk::Image can only hold one component. */
+  if( output->GetNumberOfComponentsPerPixel() != this->m_ImageIO->GetNumberOfComponents() )
+  {
+    itkExceptionMacro( << "The image in " << this->m_FileName << " has "
+      << this->m_ImageIO->GetNumberOfComponents()
+      << " components, which does not fit the output image type." );
+  }
+
+} // end GenerateOutputInformation()
+
+
+/**
+ * ********************* EnlargeOutputRequestedRegion ****************************
+ */
+
+template< class TOutputImage >
+void
+ConvertingImageFileReader< TOutputImage >
+::EnlargeOutputRequestedRegion( DataObject * dataObject )
+{
+  OutputImageType * output = dynamic_cast< OutputImageType * >( dataObject );
+  const OutputImageRegionType largestRegion = output->GetLargestPossibleRegion();
+  OutputImageRegionType requestedRegion = output->GetRequestedRegion();
+
+  /** Ask the ImageIO which region it reads for the requested region;
+   * this is the largest possible region if it can not stream. As in the
+   * itk::ImageFileReader, streamed reading has to be switched on first,
+   * otherwise the ImageIO always answers the largest possible region.
+   */
+  this->m_ImageIO->SetUseStreamedReading( true );
+  ImageIORegion ioRegion( ImageDimension );
+  ImageIORegionAdaptor< ImageDimension >::Convert(
+    requestedRegion, ioRegion, largestRegion.GetIndex() );
+  ioRegion = this->m_ImageIO->GenerateStreamableReadRegionFromRequestedRegion( ioRegion );
+  ImageIORegionAdaptor< ImageDimension >::Convert(
+    ioRegion, requestedRegion, largestRegion.GetIndex() );
+
+  output->SetRequestedRegion( requestedRegion );
+
+} // end EnlargeOutputRequestedRegion()
+
+
+/**
+ * ********************* GenerateData ****************************
+ */
+
+template< class TOutputImage >
+void
+ConvertingImageFileReader< TOutputImage >
+::GenerateData( void )
+{
+  OutputImageType * output = this->GetOutput();
+  const OutputImageRegionType region = output->GetRequestedRegion();
+  output->SetBufferedRegion( region );
+  output->Allocate();
+
+  ImageIORegion ioRegion( ImageDimension );
+  ImageIORegionAdaptor< ImageDimension >::Convert(
+    region, ioRegion, output->GetLargestPossibleRegion().GetIndex() );
+  this->m_ImageIO->SetIORegion( ioRegion );
+
+  /** Without conversion, read straight into the output buffer. */
+  const IOComponentEnum componentType = this->m_ImageIO->GetComponentType();
+  if( componentType == ImageIOBase::MapPixelType< OutputComponentType >::CType )
+  {
+    this->m_ImageIO->Read( output->GetBufferPointer() );
+    return;
+  }
+
+  /** Otherwise read the region in the on-disk type, and convert it. The
+   * buffer holds only the IO region; GetImageSizeInBytes() would give the
+   * size of the whole image, also when streaming. */
+  std::vector< char > inputBuffer( ioRegion.GetNumberOfPixels()
+    * this->m_ImageIO->GetNumberOfComponents()
+    * this->m_ImageIO->GetComponentSize() );
+  this->m_ImageIO->Read( inputBuffer.data() );
+
+  const SizeValueType size = region.GetNumberOfPixels()
+    * output->GetNumberOfComponentsPerPixel();
+  const SizeValueType componentSize = this->m_ImageIO->GetComponentSize();
+  const char * input = inputBuffer.data();
+  OutputComponentType * outputBuffer = output->GetBufferPointer();
+
+  /** Check the type once, with an empty buffer. */
+  if( !ClampRoundCastBuffer( componentType, input, outputBuffer, 0 ) )
+  {
+    itkExceptionMacro( << "The component type "
+      << ImageIOBase::GetComponentTypeAsString( componentType )
+      << " of " << this->m_FileName << " is not supported." );
+  }
+
+  /** Convert in chunks, so that the inner loop is a plain loop over an array. */
+  const SizeValueType chunkSize = 65536;
+  const SizeValueType numberOfChunks = ( size + chunkSize - 1 ) / chunkSize;
+  this->GetMultiThreader()->ParallelizeArray( 0, numberOfChunks,
+    [componentType, input, outputBuffer, size, chunkSize, componentSize]( SizeValueType chunk )
+    {
+      const SizeValueType begin = chunk * chunkSize;
+      const SizeValueType end = std::min( begin + chunkSize, size );
+      ClampRoundCastBuffer( componentType,
+        input + begin * componentSize, outputBuffer + begin, end - begin );
+    }, this );
+
+} // end GenerateData()
+
+
+/**
+ * ********************* PrintSelf ****************************
+ */
+
+template< class TOutputImage >
+void
+ConvertingImageFileReader< TOutputImage >
+::PrintSelf( std::ostream & os, Indent indent ) const
+{
+  Superclass::PrintSelf( os, indent );
+
+  os << indent << "FileName: " << this->m_FileName << std::endl;
+  os << indent << "ImageIO: " << this->m_ImageIO.GetPointer() << std::endl;
+
+} // end PrintSelf()
+
+} // end namespace itk
+
+#endif // end #ifndef _itkConvertingImageFileReader_hxx_
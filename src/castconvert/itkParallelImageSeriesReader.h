@@ -0,0 +1,140 @@
+/*=========================================================================
+*
+* Copyright Marius Staring, Stefan Klein, David Doria. 2011.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0.txt
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*=========================================================================*/
+#ifndef __itkParallelImageSeriesReader_h_
+#define __itkParallelImageSeriesReader_h_
+
+#include "itkImageSource.h"
+#include "itkImageIOBase.h"
+#include "itkVector.h"
+
+#include <string>
+#include <vector>
+
+
+namespace itk
+{
+
+/** \class ParallelImageSeriesReader
+ * \brief Reads a series of slices, e.g. a DICOM series, in parallel.
+ *
+ * Every slice is decoded by its own copy of the ImageIO, on the thread
+ * pool, straight into its place in the output buffer, converting the
+ * components with itk::Functor::ClampRoundCast. Compared to the
+ * itk::ImageSeriesReader this avoids decoding the slices one by one, and
+ * avoids an intermediate image in another type.
+ *
+ * Only the slices of the requested region are read, so that together with
+ * a streaming writer the output can be written slab by slab.
+ *
+ * The file names should be sorted, as by the itktools::DICOMDirectoryIndex.
+ * The geometry is derived as by the itk::ImageSeriesReader, with the
+ * slice spacing computed from the positions of the first and the last
+ * slice, and the direction of the first slice. Multi-frame files are not
+ * supported. As the itk::ImageSeriesReader, a warning is given when a
+ * slice is off the uniform grid between the first and the last slice,
+ * e.g. because a slice is missing.
+ */
+
+template< class TOutputImage >
+class ITK_EXPORT ParallelImageSeriesReader : public ImageSource< TOutputImage >
+{
+public:
+  /** Standard class typedefs. */
+  typedef ParallelImageSeriesReader     Self;
+  typedef ImageSource< TOutputImage >   Superclass;
+  typedef SmartPointer< Self >          Pointer;
+  typedef SmartPointer< const Self >    ConstPointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro( Self );
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro( ParallelImageSeriesReader, ImageSource );
+
+  /** Dimension of the image; the slices have one dimension less. */
+  itkStaticConstMacro( ImageDimension, unsigned int, TOutputImage::ImageDimension );
+
+  /** Typedefs. */
+  typedef TOutputImage                                OutputImageType;
+  typedef typename OutputImageType::RegionType        OutputImageRegionType;
+  typedef typename OutputImageType::InternalPixelType OutputComponentType;
+  typedef std::vector< std::string >                  FileNamesContainerType;
+
+  /** Set the sorted file names of the slices. */
+  void SetFileNames( const FileNamesContainerType & fileNames )
+  {
+    this->m_FileNames = fileNames;
+    this->Modified();
+  }
+  const FileNamesContainerType & GetFileNames( void ) const { return this->m_FileNames; }
+
+  /** Set the ImageIO. Every slice is read with a new instance of its class,
+   * obtained with CreateAnother(). By default it is created by the factory.
+   */
+  itkSetObjectMacro( ImageIO, ImageIOBase );
+  itkGetModifiableObjectMacro( ImageIO, ImageIOBase );
+
+  /** Set the distance of a slice to its place on the uniform grid, relative
+   * to the slice spacing, above which a warning is given; default 1e-4. */
+  itkSetMacro( SpacingWarningRelThreshold, double );
+  itkGetConstMacro( SpacingWarningRelThreshold, double );
+
+protected:
+  ParallelImageSeriesReader();
+  virtual ~ParallelImageSeriesReader() {};
+
+  /** PrintSelf. */
+  virtual void PrintSelf( std::ostream & os, Indent indent ) const;
+
+  /** Read the headers of the first and the last slice. */
+  virtual void GenerateOutputInformation( void );
+
+  /** Only whole slices are read. */
+  virtual void EnlargeOutputRequestedRegion( DataObject * output );
+
+  /** Read the slices of the requested region in parallel. */
+  virtual void GenerateData( void );
+
+  /** Create a new ImageIO for a slice, and read its header. */
+  ImageIOBase::Pointer CreateSliceImageIO( const std::string & fileName ) const;
+
+  /** Read a slice into the output buffer, and return the distance of its
+   * position to its place on the uniform grid of the slices. */
+  double ReadSlice( const SizeValueType slice, OutputComponentType * outputBuffer ) const;
+
+private:
+  ParallelImageSeriesReader( const Self & ); // purposely not implemented
+  void operator=( const Self & ); // purposely not implemented
+
+  FileNamesContainerType  m_FileNames;
+  ImageIOBase::Pointer    m_ImageIO;
+  double                  m_SpacingWarningRelThreshold;
+
+  /** The step from one slice position to the next on the uniform grid,
+   * zero if the positions of the slices are unknown. */
+  Vector< double, TOutputImage::ImageDimension > m_SliceStep;
+
+}; // end class ParallelImageSeriesReader
+
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkParallelImageSeriesReader.hxx"
+#endif
+
+#endif // end #ifndef __itkParallelImageSeriesReader_h_
@@ -0,0 +1,341 @@
+/*=========================================================================
+*
+* Copyright Marius Staring, Stefan Klein, David Doria. 2011.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0.txt
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*=========================================================================*/
+#ifndef _itkParallelImageSeriesReader_hxx_
+#define _itkParallelImageSeriesReader_hxx_
+
+#include "itkParallelImageSeriesReader.h"
+
+#include "itkClampRoundCastFunctor.h"
+#include "itkImageIOFactory.h"
+#include "itkImageIORegion.h"
+
+#include <algorithm>
+#include <cmath>
+
+
+namespace itk
+{
+
+/**
+ * ********************* Constructor ****************************
+ */
+
+template< class TOutputImage >
+ParallelImageSeriesReader< TOutputImage >
+::ParallelImageSeriesReader()
+{
+  this->m_SpacingWarningRelThreshold = 1e-4;
+  this->m_SliceStep.Fill( 0.0 );
+} // end Constructor
+
+
+/**
+ * ********************* CreateSliceImageIO ****************************
+ */
+
+template< class TOutputImage >
+ImageIOBase::Pointer
+ParallelImageSeriesReader< TOutputImage >
+::CreateSliceImageIO( const std::string & fileName ) const
+{
+  ImageIOBase::Pointer imageIO;
+  if( this->m_ImageIO.IsNotNull() )
+  {
+    imageIO = dynamic_cast< ImageIOBase * >( this->m_ImageIO->CreateAnother().GetPointer() );
+  }
+  else
+  {
+    imageIO = ImageIOFactory::CreateImageIO( fileName.c_str(), IOFileModeEnum::ReadMode );
+  }
+  if( imageIO.IsNull() )
+  {
+    itkExceptionMacro( << "Could not create an ImageIO for " << fileName << "." );
+  }
+
+  imageIO->SetFileName( fileName );
+  imageIO->ReadImageInformation();
+  return imageIO;
+
+} // end CreateSliceImageIO()
+
+
+/**
+ * ********************* GenerateOutputInformation ****************************
+ */
+
+template< class TOutputImage >
+void
+ParallelImageSeriesReader< TOutputImage >
+::GenerateOutputInformation( void )
+{
+  typedef typename OutputImageType::SizeType      SizeType;
+  typedef typename OutputImageType::IndexType     IndexType;
+  typedef typename OutputImageType::SpacingType   SpacingType;
+  typedef typename OutputImageType::PointType     PointType;
+  typedef typename OutputImageType::DirectionType DirectionType;
+
+  const unsigned int sliceDimension = ImageDimension - 1;
+  const SizeValueType numberOfSlices = this->m_FileNames.size();
+  if( numberOfSlices == 0 )
+  {
+    itkExceptionMacro( << "No file names have been set." );
+  }
+
+  /** The geometry of the slices is taken from the first slice. */
+  ImageIOBase::Pointer firstIO = this->CreateSliceImageIO( this->m_FileNames[ 0 ] );
+  const unsigned int fileDimension = firstIO->GetNumberOfDimensions();
+  for( unsigned int i = sliceDimension; i < fileDimension; ++i )
+  {
+    if( firstIO->GetDimensions( i ) != 1 )
+    {
+      itkExceptionMacro( << this->m_FileNames[ 0 ]
+        << " is not a single slice; multi-frame files are not supported." );
+    }
+  }
+  const unsigned int geometryDimension = std::min( fileDimension, ImageDimension );
+
+  SizeType size; size.Fill( 1 );
+  IndexType index; index.Fill( 0 );
+  SpacingType spacing; spacing.Fill( 1.0 );
+  PointType origin; origin.Fill( 0.0 );
+  DirectionType direction; direction.SetIdentity();
+  for( unsigned int i = 0; i < geometryDimension; ++i )
+  {
+    if( i < sliceDimension )
+    {
+      size[ i ] = firstIO->GetDimensions( i );
+      spacing[ i ] = firstIO->GetSpacing( i );
+    }
+    origin[ i ] = firstIO->GetOrigin( i );
+    const std::vector< double > axis = firstIO->GetDirection( i );
+    for( unsigned int j = 0; j < geometryDimension; ++j )
+    {
+      direction[ j ][ i ] = axis[ j ];
+    }
+  }
+  size[ sliceDimension ] = numberOfSlices;
+
+  /** The slice spacing follows from the positions of the first and the last slice. */
+  this->m_SliceStep.Fill( 0.0 );
+  if( numberOfSlices > 1 && geometryDimension == ImageDimension )
+  {
+    ImageIOBase::Pointer lastIO = this->CreateSliceImageIO( this->m_FileNames.back() );
+    for( unsigned int i = 0; i < ImageDimension; ++i )
+    {
+      this->m_SliceStep[ i ] = ( lastIO->GetOrigin( i ) - firstIO->GetOrigin( i ) )
+        / static_cast< double >( numberOfSlices - 1 );
+    }
+    const double distance = this->m_SliceStep.GetNorm();
+    if( distance > 0.0 )
+    {
+      spacing[ sliceDimension ] = distance;
+    }
+  }
+
+  OutputImageRegionType largestRegion;
+  largestRegion.SetSize( size );
+  largestRegion.SetIndex( index );
+
+  OutputImageType * output = this->GetOutput();
+  output->SetLargestPossibleRegion( largestRegion );
+  output->SetSpacing( spacing );
+  output->SetOrigin( origin );
+  output->SetDirection( direction );
+  output->SetNumberOfComponentsPerPixel( firstIO->GetNumberOfComponents() );
+
+  /** An itk::Image can only hold one component. */
+  if( output->GetNumberOfComponentsPerPixel() != firstIO->GetNumberOfComponents() )
+  {
+    itkExceptionMacro( << "The slices have " << firstIO->GetNumberOfComponents()
+      << " components, which does not fit the output image type." );
+  }
+
+} // end GenerateOutputInformation()
+
+
+/**
+ * ********************* EnlargeOutputRequestedRegion ****************************
+ */
+
+template< class TOutputImage >
+void
+ParallelImageSeriesReader< TOutputImage >
+::EnlargeOutputRequestedRegion( DataObject * dataObject )
+{
+  OutputImageType * output = dynamic_cast< OutputImageType * >( dataObject );
+  const OutputImageRegionType largestRegion = output->GetLargestPossibleRegion();
+  OutputImageRegionType requestedRegion = output->GetRequestedRegion();
+
+  for( unsigned int i = 0; i < ImageDimension - 1; ++i )
+  {
+    requestedRegion.SetIndex( i, largestRegion.GetIndex( i ) );
+    requestedRegion.SetSize( i, largestRegion.GetSize( i ) );
+  }
+  output->SetRequestedRegion( requestedRegion );
+
+} // end EnlargeOutputRequestedRegion()
+
+
+/**
+ * ********************* GenerateData ****************************
+ */
+
+template< class TOutputImage >
+void
+ParallelImageSeriesReader< TOutputImage >
+::GenerateData( void )
+{
+  const unsigned int sliceDimension = ImageDimension - 1;
+
+  OutputImageType * output = this->GetOutput();
+  const OutputImageRegionType region = output->GetRequestedRegion();
+  output->SetBufferedRegion( region );
+  output->Allocate();
+
+  const SizeValueType numberOfSlices = region.GetSize( sliceDimension );
+  if( numberOfSlices == 0 ) return;
+
+  const SizeValueType firstSlice = region.GetIndex( sliceDimension )
+    - output->GetLargestPossibleRegion().GetIndex( sliceDimension );
+  const SizeValueType sliceSize = region.GetNumberOfPixels() / numberOfSlices
+    * output->GetNumberOfComponentsPerPixel();
+  OutputComponentType * outputBuffer = output->GetBufferPointer();
+
+  /** Each slice is decoded by its own ImageIO, on the thread pool. */
+  std::vector< double > deviations( numberOfSlices, 0.0 );
+  this->GetMultiThreader()->ParallelizeArray( 0, numberOfSlices,
+    [this, outputBuffer, firstSlice, sliceSize, &deviations]( SizeValueType slice )
+    {
+      deviations[ slice ] = this->ReadSlice( firstSlice + slice, outputBuffer + slice * sliceSize );
+    }, this );
+
+  /** Warn about the slice furthest off the uniform grid, if too far. */
+  const SizeValueType worst = std::max_element( deviations.begin(), deviations.end() )
+    - deviations.begin();
+  const double sliceSpacing = output->GetSpacing()[ sliceDimension ];
+  if( deviations[ worst ] > this->m_SpacingWarningRelThreshold * sliceSpacing )
+  {
+    itkWarningMacro( << "Non uniform sampling or missing slices detected: "
+      << this->m_FileNames[ firstSlice + worst ] << " is " << deviations[ worst ]
+      << " off its position on the grid with slice spacing " << sliceSpacing
+      << " between the first and the last slice." );
+  }
+
+} // end GenerateData()
+
+
+/**
+ * ********************* ReadSlice ****************************
+ */
+
+template< class TOutputImage >
+double
+ParallelImageSeriesReader< TOutputImage >
+::ReadSlice( const SizeValueType slice, OutputComponentType * outputBuffer ) const
+{
+  const std::string & fileName = this->m_FileNames[ slice ];
+  ImageIOBase::Pointer imageIO = this->CreateSliceImageIO( fileName );
+
+  /** Check that the slice fits in the volume. */
+  const OutputImageType * output = this->GetOutput();
+  const OutputImageRegionType & largestRegion = output->GetLargestPossibleRegion();
+  const unsigned int fileDimension = imageIO->GetNumberOfDimensions();
+  bool fits = imageIO->GetNumberOfComponents() == output->GetNumberOfComponentsPerPixel();
+  SizeValueType sliceSize = imageIO->GetNumberOfComponents();
+  for( unsigned int i = 0; i < ImageDimension - 1; ++i )
+  {
+    const SizeValueType size = i < fileDimension ? imageIO->GetDimensions( i ) : 1;
+    fits &= size == largestRegion.GetSize( i );
+    sliceSize *= size;
+  }
+  for( unsigned int i = ImageDimension - 1; i < fileDimension; ++i )
+  {
+    fits &= imageIO->GetDimensions( i ) == 1;
+  }
+  if( !fits )
+  {
+    itkExceptionMacro( << "The slice " << fileName
+      << " does not have the size or the number of components of the first slice." );
+  }
+
+  /** The distance of the slice to its place on the uniform grid. */
+  double deviation = 0.0;
+  if( this->m_SliceStep.GetNorm() > 0.0 )
+  {
+    const typename OutputImageType::PointType & origin = output->GetOrigin();
+    for( unsigned int i = 0; i < ImageDimension; ++i )
+    {
+      const double position = i < fileDimension ? imageIO->GetOrigin( i ) : 0.0;
+      const double difference = position - origin[ i ]
+        - static_cast< double >( slice ) * this->m_SliceStep[ i ];
+      deviation += difference * difference;
+    }
+    deviation = std::sqrt( deviation );
+  }
+
+  /** Read the whole slice. */
+  ImageIORegion ioRegion( fileDimension );
+  for( unsigned int i = 0; i < fileDimension; ++i )
+  {
+    ioRegion.SetIndex( i, 0 );
+    ioRegion.SetSize( i, imageIO->GetDimensions( i ) );
+  }
+  imageIO->SetIORegion( ioRegion );
+
+  /** Without conversion, read straight into the output buffer. */
+  const IOComponentEnum componentType = imageIO->GetComponentType();
+  if( componentType == ImageIOBase::MapPixelType< OutputComponentType >::CType )
+  {
+    imageIO->Read( outputBuffer );
+    return deviation;
+  }
+
+  std::vector< char > inputBuffer( imageIO->GetImageSizeInBytes() );
+  imageIO->Read( inputBuffer.data() );
+  if( !ClampRoundCastBuffer( componentType, inputBuffer.data(), outputBuffer, sliceSize ) )
+  {
+    itkExceptionMacro( << "The component type "
+      << ImageIOBase::GetComponentTypeAsString( componentType )
+      << " of " << fileName << " is not supported." );
+  }
+
+  return deviation;
+
+} // end ReadSlice()
+
+
+/**
+ * ********************* PrintSelf ****************************
+ */
+
+template< class TOutputImage >
+void
+ParallelImageSeriesReader< TOutputImage >
+::PrintSelf( std::ostream & os, Indent indent ) const
+{
+  Superclass::PrintSelf( os, indent );
+
+  os << indent << "FileNames: " << this->m_FileNames.size() << " files" << std::endl;
+  os << indent << "ImageIO: " << this->m_ImageIO.GetPointer() << std::endl;
+  os << indent << "SpacingWarningRelThreshold: " << this->m_SpacingWarningRelThreshold << std::endl;
+
+} // end PrintSelf()
+
+} // end namespace itk
+
+#endif // end #ifndef _itkParallelImageSeriesReader_hxx_
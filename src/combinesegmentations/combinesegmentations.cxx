@@ -40,14 +40,24 @@ std::string GetHelpString( void )
     << "This program combines multiple segmentations into one.\n"
     << "Usage:\n"
     << "pxcombinesegmentations\n"
-    << "[-m]     {STAPLE, VOTE, MULTISTAPLE, MULTISTAPLE2, VOTE_MULTISTAPLE2}:\n"
+    << "[-m]     {STAPLE, VOTE, MULTISTAPLE, MULTISTAPLE2, VOTE_MULTISTAPLE2, LOCALVOTE}:\n"
     << "        the method used to combine the segmentations. default: MULTISTAPLE2.\n"
     << "        VOTE_MULTISTAPLE2 is in fact just VOTE followed by MULTISTAPLE2.\n"
+    << "        LOCALVOTE weights the vote of each atlas at each voxel by the similarity\n"
+    << "        of its intensity image to the target image in a patch around the voxel:\n"
+    << "        w = trust * ( meanSquaredDifference + 1e-6 )^( -gain ).\n"
     << "-in      inputFilename0 [inputFileName1 ... ]: the input segmentations,\n"
     << "        as unsigned char images. More than 2 labels are allowed, but\n"
     << "        with some restrictions: {0,1,2}=ok, {0,3,4}=bad, {1,2,3}=bad.\n"
     << "[-n]     numberOfClasses: the number of classes to segment;\n"
     << "        default: 2 (so, 0 and 1).\n"
+    << "[-target] targetImageFilename: the image to be segmented. Required for LOCALVOTE.\n"
+    << "[-ini]   inputIntensityFilename0 [inputIntensityFileName1 ... ]: the intensity\n"
+    << "        images of the atlases, registered to the target image like the input\n"
+    << "        segmentations, one for each input segmentation. Required for LOCALVOTE.\n"
+    << "[-pr]    patchRadius: the radius of the patches that are compared by LOCALVOTE;\n"
+    << "        default: 2.\n"
+    << "[-gain]  gain: the power of the inverse patch distance in LOCALVOTE; default: 1.\n"
     << "[-P]     priorProbImageFilename0 priorProbImageFilename1 [...]:\n"
     << "        the names of the prior probabilities for each class, stored as float images.\n"
     << "        This has only effect when using [VOTE_]MULTISTAPLE2.\n"
@@ -59,12 +69,16 @@ std::string GetHelpString( void )
     << "       For MULTISTAPLE[2], the number is really the prior probability.\n"
     << "        If -p and -P are not provided, the prior probs are estimated from the data.\n"
     << "[-t]     trust0 [trust1 ...]: a factor between 0 and 1 indicating the 'trust' in each observer;\n"
-    << "        default: 0.99999 for each observer for [VOTE_]MULTISTAPLE2. 1.0 for VOTE.\n"
+    << "        default: 0.99999 for each observer for [VOTE_]MULTISTAPLE2. 1.0 for [LOCAL]VOTE.\n"
     << "        Ignored by STAPLE and MULTISTAPLE; they estimate it by majority voting.\n"
     << "[-e]     termination threshold: a small float. the smaller the more accurate the solution;\n"
-    << "        default: 1e-5. Ignored by STAPLE and VOTE.\n"
+    << "        default: 1e-5. Ignored by STAPLE and [LOCAL]VOTE.\n"
     << "[-outs]  outputFilename0 outputFileName1 [...]: the output (soft) probabilistic\n"
-    << "        segmentations for each label. These will be float images.\n"
+    << "        segmentations for each label. These will be float images, or with \"-q\"\n"
+    << "        unsigned short images.\n"
+    << "[-q]     quantize the soft segmentations to 16 bits, to save memory: they are\n"
+    << "        stored as unsigned short images, 0 to 65535 for a probability 0 to 1.\n"
+    << "        Only taken into account by [VOTE_]MULTISTAPLE2 and [LOCAL]VOTE.\n"
     << "[-outh]  outputFilename: the output hard segmentation, stored as a single\n"
     << "        unsigned char image, containing the label numbers.\n"
     << "       The value 'numberOfClasses' corresponds to 'undecided' (if two labels\n"
@@ -73,7 +87,7 @@ std::string GetHelpString( void )
     << "        the confusion matrix for each observer. The x-axis corresponds to the\n"
     << "        real label, the y-axis corresponds to the label given by the observer.\n"
     << "[-mask]  [maskDilationRadius]: Use a mask if this flag is provided.\n"
-    << "        Only taken into account by [VOTE_]MULTISTAPLE2 and VOTE.\n"
+    << "        Only taken into account by [VOTE_]MULTISTAPLE2 and [LOCAL]VOTE.\n"
     << "        The mask is 0 at those pixels were the decision is unanimous, and 1 elsewhere.\n"
     << "        A dilation is performed with a kernel with radius maskDilationRadius (default:1)\n"
     << "        Pixels that are outside the mask, will have class of the first observer.\n"
@@ -141,6 +155,36 @@ int main( int argc, char **argv )
   unsigned char numberOfClasses = 2;
   parser->GetCommandLineArgument( "-n", numberOfClasses );
 
+  /** Get the intensity images for LOCALVOTE */
+  std::string targetImageFileName = "";
+  std::vector< std::string > inputIntensityImageFileNames;
+  unsigned int patchRadius = 2;
+  float gain = 1.0;
+  parser->GetCommandLineArgument( "-target", targetImageFileName );
+  parser->GetCommandLineArgument( "-ini", inputIntensityImageFileNames );
+  parser->GetCommandLineArgument( "-pr", patchRadius );
+  parser->GetCommandLineArgument( "-gain", gain );
+  if( combinationMethod == "LOCALVOTE" )
+  {
+    if( targetImageFileName == "" )
+    {
+      std::cerr << "ERROR: LOCALVOTE needs a target image (\"-target\")." << std::endl;
+      return EXIT_FAILURE;
+    }
+    if( inputIntensityImageFileNames.size() != inputSegmentationFileNames.size() )
+    {
+      std::cerr
+        << "ERROR: Number of input intensity images should be equal to the number of "
+        << "input segmentations."
+        << std::endl;
+      std::cerr
+        << "i.e., \"-ini\" should be followed by "
+        << inputSegmentationFileNames.size()
+        << " filenames." << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
   /** Get the prior probability images (not mandatory) */
   std::vector< std::string >  priorProbImageFileNames;
   bool retP = parser->GetCommandLineArgument( "-P", priorProbImageFileNames );
@@ -249,6 +293,9 @@ int main( int argc, char **argv )
   /** Use compression */
   const bool useCompression = parser->ArgumentExists( "-z" );
 
+  /** Quantize the soft segmentations */
+  const bool quantizeSoftOutputs = parser->ArgumentExists( "-q" );
+
   /** Threads. */
   unsigned int maximumNumberOfThreads
     = itk::MultiThreaderBase::GetGlobalDefaultNumberOfThreads();
@@ -311,6 +358,11 @@ int main( int argc, char **argv )
     filter->m_InValues = inValues;
     filter->m_OutValues = outValues;
     filter->m_UseCompression = useCompression;
+    filter->m_QuantizeSoftOutputs = quantizeSoftOutputs;
+    filter->m_TargetImageFileName = targetImageFileName;
+    filter->m_InputIntensityImageFileNames = inputIntensityImageFileNames;
+    filter->m_PatchRadius = patchRadius;
+    filter->m_Gain = gain;
 
     filter->Run();
 
@@ -28,12 +28,13 @@
 #include "itkImageFileWriter.h"
 #include "itkSTAPLEImageFilter.h"
 #include "itkLabelVoting2ImageFilter.h"
+#include "itkLocallyWeightedLabelVotingImageFilter.h"
 #include "itkMultiLabelSTAPLEImageFilter.h"
 #include "itkMultiLabelSTAPLE2ImageFilter.h"
 #include "itkInvertIntensityImageFilter.h"
 #include "itkBinaryThresholdImageFilter.h"
 #include "itkImageRegionIteratorWithIndex.h"
-#include "itkNaryUnequalityTestImageFilter.h"
+#include "itkObserverLabelsConstIterator.h"
 #include "itkBinaryDilateImageFilter.h"
 #include "itkBinaryBallStructuringElement.h"
 #include "itkChangeLabelImageFilter.h"
@@ -60,6 +61,10 @@ public:
     this->m_UseMask = false;
     this->m_MaskDilationRadius = 1;
     this->m_UseCompression = false;
+    this->m_QuantizeSoftOutputs = false;
+    this->m_TargetImageFileName = "";
+    this->m_PatchRadius = 2;
+    this->m_Gain = 1.0;
   };
   /** Destructor. */
   ~ITKToolsCombineSegmentationsBase(){};
@@ -81,6 +86,11 @@ public:
   std::vector< unsigned int > m_InValues;
   std::vector< unsigned int > m_OutValues;
   bool                        m_UseCompression;
+  bool                        m_QuantizeSoftOutputs;
+  std::vector< std::string >  m_InputIntensityImageFileNames;
+  std::string                 m_TargetImageFileName;
+  unsigned int                m_PatchRadius;
+  float                       m_Gain;
 
 }; // end class ITKToolsCombineSegmentationsBase
 
@@ -109,10 +119,12 @@ public:
     typedef TComponentType  LabelPixelType;
     typedef float           ProbPixelType;
     typedef float           ConfusionMatrixPixelType;
+    typedef float           IntensityPixelType;
 
     typedef itk::Image< LabelPixelType, VDimension >    LabelImageType;
     typedef itk::Image< ProbPixelType, VDimension >     ProbImageType;
     typedef itk::Image< ConfusionMatrixPixelType, 3 >   ConfusionMatrixImageType;
+    typedef itk::Image< IntensityPixelType, VDimension > IntensityImageType;
 
     typedef typename LabelImageType::RegionType         RegionType;
 
@@ -122,6 +134,7 @@ public:
 
     typedef itk::ImageFileReader< LabelImageType >    LabelImageReaderType;
     typedef itk::ImageFileReader< ProbImageType >     ProbImageReaderType;
+    typedef itk::ImageFileReader< IntensityImageType > IntensityImageReaderType;
     typedef itk::ImageFileWriter< LabelImageType >    LabelImageWriterType;
     typedef itk::ImageFileWriter< ProbImageType >     ProbImageWriterType;
     typedef itk::ImageFileWriter<
@@ -135,6 +148,11 @@ public:
       LabelImageType, ProbImageType >                 STAPLEType;
     typedef itk::LabelVoting2ImageFilter<
       LabelImageType, LabelImageType, ProbPixelType > LabelVotingType;
+    typedef itk::LocallyWeightedLabelVotingImageFilter<
+      LabelImageType, LabelImageType,
+      IntensityImageType, ProbPixelType >             LocalLabelVotingType;
+    typedef typename
+      LocalLabelVotingType::RadiusType                PatchRadiusType;
     typedef itk::MultiLabelSTAPLEImageFilter<
       LabelImageType, LabelImageType, ProbPixelType > MultiLabelSTAPLEType;
     typedef itk::MultiLabelSTAPLE2ImageFilter<
@@ -165,11 +183,27 @@ public:
     typedef typename MultiLabelSTAPLE2Type::
       MaskImageType                                  MaskImageType;
     typedef typename MaskImageType::PixelType        MaskPixelType;
+    typedef typename MaskImageType::Pointer          MaskImagePointer;
     typedef typename
       MultiLabelSTAPLE2Type::PriorPreferenceType     PriorPreferenceType;
 
-    typedef itk::NaryUnequalityTestImageFilter<
-      LabelImageType, MaskImageType>                 MaskGeneratorType;
+    typedef typename MultiLabelSTAPLE2Type::
+      QuantizedProbabilityImageType                  QuantizedProbImageType;
+    typedef typename QuantizedProbImageType::Pointer QuantizedProbImagePointer;
+    typedef itk::ImageFileWriter<
+      QuantizedProbImageType >                       QuantizedProbImageWriterType;
+
+    typedef typename
+      MultiLabelSTAPLE2Type::ObserverStackType       ObserverStackType;
+    typedef typename ObserverStackType::Pointer      ObserverStackPointer;
+    typedef typename
+      ObserverStackType::InternalPixelType           ObserverLabelType;
+    typedef itk::ObserverLabelsConstIterator<
+      LabelImageType >                               ObserverLabelsIteratorType;
+    typedef itk::ImageRegionConstIterator<
+      LabelImageType >                               LabelImageIteratorType;
+    typedef itk::ImageRegionIterator<
+      MaskImageType >                                MaskImageIteratorType;
 
     typedef itk::BinaryBallStructuringElement<
       MaskPixelType, VDimension >                    StructuringElementType;
@@ -182,6 +216,7 @@ public:
 
     typedef std::vector< LabelImagePointer >         LabelImageArrayType;
     typedef std::vector< ProbImagePointer >          ProbImageArrayType;
+    typedef std::vector< QuantizedProbImagePointer > QuantizedProbImageArrayType;
 
     /** Declare some variables */
     unsigned int numberOfObservers = 0;
@@ -189,6 +224,9 @@ public:
     LabelImageArrayType labelImageArray;
     ProbImageArrayType priorProbImageArray;
     ProbImageArrayType softSegmentationArray;
+    QuantizedProbImageArrayType quantizedSoftSegmentationArray;
+    ObserverStackPointer observerStack = nullptr;
+    MaskImagePointer disagreementMask = nullptr;
     LabelImagePointer hardSegmentation = nullptr;
     ConfusionMatrixImagePointer confusionMatrixImage = nullptr;
 
@@ -196,8 +234,18 @@ public:
     numberOfObservers = this->m_InputSegmentationFileNames.size();
     labelImageArray.resize( numberOfObservers );
     softSegmentationArray.resize( this->m_NumberOfClasses );
+    quantizedSoftSegmentationArray.resize( this->m_NumberOfClasses );
     priorProbImageArray.resize( this->m_NumberOfClasses );
 
+    /** The methods that support it get the labels in an observer stack, which
+     * stores the labels of all observers interleaved per voxel, as unsigned char.
+     * Each label image is copied into the stack and released after reading. */
+    const bool useObserverStack =
+      this->m_CombinationMethod == "MULTISTAPLE2"
+      || this->m_CombinationMethod == "VOTE_MULTISTAPLE2"
+      || this->m_CombinationMethod == "VOTE"
+      || this->m_CombinationMethod == "LOCALVOTE";
+
     /** Read the input label images */
     RegionType lastRegion;
     bool relabel = ( this->m_InValues.size() > 0 );
@@ -236,9 +284,54 @@ public:
       {
         labelImageArray[ i ] = labelImageReader->GetOutput();
       }
+
+      /** Copy the labels to the observer stack */
+      if( useObserverStack )
+      {
+        if( i == 0 )
+        {
+          observerStack = ObserverStackType::New();
+          observerStack->CopyInformation( labelImageArray[ i ] );
+          observerStack->SetRegions( region );
+          observerStack->SetVectorLength( numberOfObservers );
+          observerStack->Allocate();
+        }
+
+        ObserverLabelType * stackBuffer = observerStack->GetBufferPointer();
+        LabelImageIteratorType lit( labelImageArray[ i ], region );
+        itk::SizeValueType voxel = 0;
+        for( lit.GoToBegin(); !lit.IsAtEnd(); ++lit, ++voxel )
+        {
+          stackBuffer[ voxel * numberOfObservers + i ] =
+            static_cast<ObserverLabelType>( lit.Get() );
+        }
+        labelImageArray[ i ] = nullptr;
+      }
     }
     std::cout << "Done reading input segmentations." << std::endl;
 
+    /** The mask is 1 where the observers disagree, and 0 elsewhere */
+    if( useObserverStack && this->m_UseMask && ( numberOfObservers > 1 ) )
+    {
+      disagreementMask = MaskImageType::New();
+      disagreementMask->CopyInformation( observerStack );
+      disagreementMask->SetRegions( lastRegion );
+      disagreementMask->Allocate();
+
+      ObserverLabelsIteratorType oit( observerStack, lastRegion );
+      MaskImageIteratorType mit( disagreementMask, lastRegion );
+      for( oit.GoToBegin(), mit.GoToBegin(); !oit.IsAtEnd(); ++oit, ++mit )
+      {
+        const LabelPixelType * labels = oit.Get();
+        bool allEqual = true;
+        for( unsigned int i = 1; i < numberOfObservers && allEqual; ++i )
+        {
+          allEqual = labels[ i ] == labels[ 0 ];
+        }
+        mit.Set( static_cast<MaskPixelType>( !allEqual ) );
+      }
+    }
+
     /** Read the prior probability images, if supplied */
     if( this->m_PriorProbImageFileNames.size() == this->m_NumberOfClasses )
     {
@@ -402,18 +495,13 @@ public:
       typename MultiLabelSTAPLE2Type::Pointer multistaple2 = MultiLabelSTAPLE2Type::New();
       segmentationCombiner = multistaple2;
 
-      typename MaskGeneratorType::Pointer maskGenerator = MaskGeneratorType::New();
       typename DilateFilterType::Pointer dilater = DilateFilterType::New();
 
       /** Set the number of classes */
       multistaple2->SetNumberOfClasses( this->m_NumberOfClasses );
 
-      /** Set the inputs */
-      for( unsigned int i = 0; i < numberOfObservers; ++i )
-      {
-        multistaple2->SetInput(i, labelImageArray[ i ]);
-        maskGenerator->SetInput(i, labelImageArray[ i ]);
-      }
+      /** Set the observer stack */
+      multistaple2->SetObserverStack( observerStack );
 
       /** Set the mask */
       if( this->m_UseMask && ( numberOfObservers > 1 ) )
@@ -426,7 +514,7 @@ public:
         dilater->SetKernel(kernel);
         dilater->SetForegroundValue( itk::NumericTraits<MaskPixelType>::One );
         dilater->SetBackgroundValue( itk::NumericTraits<MaskPixelType>::Zero );
-        dilater->SetInput( maskGenerator->GetOutput() );
+        dilater->SetInput( disagreementMask );
         std::cout << "Creating mask (this->m_MaskDilationRadius = " << this->m_MaskDilationRadius << ")..." << std::endl;
         dilater->Update();
         multistaple2->SetMaskImage( dilater->GetOutput() );
@@ -480,6 +568,7 @@ public:
       if( this->m_SoftOutputFileNames.size() > 0 )
       {
         multistaple2->SetGenerateProbabilisticSegmentations(true);
+        multistaple2->SetQuantizeProbabilisticSegmentations( this->m_QuantizeSoftOutputs );
       }
 
       /** Set the termination threshold */
@@ -513,7 +602,15 @@ public:
       {
         for( unsigned int i = 0; i < this->m_NumberOfClasses; ++i )
         {
-          softSegmentationArray[ i ] = multistaple2->GetProbabilisticSegmentationArray()[ i ];
+          if( this->m_QuantizeSoftOutputs )
+          {
+            quantizedSoftSegmentationArray[ i ] =
+              multistaple2->GetQuantizedProbabilisticSegmentationArray()[ i ];
+          }
+          else
+          {
+            softSegmentationArray[ i ] = multistaple2->GetProbabilisticSegmentationArray()[ i ];
+          }
         }
       }
 
@@ -543,23 +640,49 @@ public:
       } // end if confusion
 
     } // end if MULTISTAPLE2
-    else if( this->m_CombinationMethod == "VOTE" )
+    else if( ( this->m_CombinationMethod == "VOTE" ) || ( this->m_CombinationMethod == "LOCALVOTE" ) )
     {
-      /** Run the LabelVoting2 algorithm */
-      typename LabelVotingType::Pointer voting = LabelVotingType::New();
-      typename MaskGeneratorType::Pointer maskGenerator = MaskGeneratorType::New();
+      /** Run the LabelVoting2 algorithm, or its locally weighted variant */
+      typename LabelVotingType::Pointer voting = nullptr;
       typename DilateFilterType::Pointer dilater = DilateFilterType::New();
+      if( this->m_CombinationMethod == "LOCALVOTE" )
+      {
+        typename LocalLabelVotingType::Pointer localVoting = LocalLabelVotingType::New();
+        voting = localVoting;
+
+        /** Read the target image and the intensity image of each atlas */
+        std::cout << "Reading intensity images..." << std::endl;
+        typename IntensityImageReaderType::Pointer targetReader =
+          IntensityImageReaderType::New();
+        targetReader->SetFileName( this->m_TargetImageFileName.c_str() );
+        targetReader->Update();
+        localVoting->SetTargetImage( targetReader->GetOutput() );
+        for( unsigned int i = 0; i < numberOfObservers; ++i )
+        {
+          typename IntensityImageReaderType::Pointer intensityReader =
+            IntensityImageReaderType::New();
+          intensityReader->SetFileName( this->m_InputIntensityImageFileNames[ i ].c_str() );
+          intensityReader->Update();
+          localVoting->SetAtlasImage( i, intensityReader->GetOutput() );
+        }
+        std::cout << "Done reading intensity images." << std::endl;
+
+        PatchRadiusType patchRadius;
+        patchRadius.Fill( this->m_PatchRadius );
+        localVoting->SetPatchRadius( patchRadius );
+        localVoting->SetGain( this->m_Gain );
+      }
+      else
+      {
+        voting = LabelVotingType::New();
+      }
       segmentationCombiner = voting;
 
       /** Set the number of classes */
       voting->SetNumberOfClasses( this->m_NumberOfClasses );
 
-      /** Set the inputs */
-      for( unsigned int i = 0; i < numberOfObservers; ++i )
-      {
-        voting->SetInput(i, labelImageArray[ i ]);
-        maskGenerator->SetInput(i, labelImageArray[ i ]);
-      }
+      /** Set the observer stack */
+      voting->SetObserverStack( observerStack );
 
       /** Set the mask */
       if( this->m_UseMask  && ( numberOfObservers > 1) )
@@ -572,7 +695,7 @@ public:
         dilater->SetKernel(kernel);
         dilater->SetForegroundValue( itk::NumericTraits<MaskPixelType>::One );
         dilater->SetBackgroundValue( itk::NumericTraits<MaskPixelType>::Zero );
-        dilater->SetInput( maskGenerator->GetOutput() );
+        dilater->SetInput( disagreementMask );
         std::cout << "Creating mask (this->m_MaskDilationRadius = "
           << this->m_MaskDilationRadius << ")..." << std::endl;
         dilater->Update();
@@ -607,12 +730,13 @@ public:
       if( this->m_SoftOutputFileNames.size() > 0 )
       {
         voting->SetGenerateProbabilisticSegmentations(true);
+        voting->SetQuantizeProbabilisticSegmentations( this->m_QuantizeSoftOutputs );
       }
 
       /** Run!! */
-      std::cout << "Performing VOTE algorithm..." << std::endl;
+      std::cout << "Performing " << this->m_CombinationMethod << " algorithm..." << std::endl;
       voting->Update();
-      std::cout << "Done performing VOTE algorithm." << std::endl;
+      std::cout << "Done performing " << this->m_CombinationMethod << " algorithm." << std::endl;
 
       std::cout
         << "Estimated/supplied initial observer this->m_Trust was: "
@@ -627,7 +751,15 @@ public:
       {
         for( unsigned int i = 0; i < this->m_NumberOfClasses; ++i )
         {
-          softSegmentationArray[ i ] = voting->GetProbabilisticSegmentationArray()[ i ];
+          if( this->m_QuantizeSoftOutputs )
+          {
+            quantizedSoftSegmentationArray[ i ] =
+              voting->GetQuantizedProbabilisticSegmentationArray()[ i ];
+          }
+          else
+          {
+            softSegmentationArray[ i ] = voting->GetProbabilisticSegmentationArray()[ i ];
+          }
         }
       }
 
@@ -656,7 +788,7 @@ public:
         } // end while
       } // end if confusion
 
-    } // end if VOTE
+    } // end if [LOCAL]VOTE
     else
     {
       std::cout << "ERROR: The desired combination method "
@@ -682,6 +814,15 @@ public:
           softWriter->SetUseCompression( this->m_UseCompression );
           softWriter->Update();
         }
+        else if( quantizedSoftSegmentationArray[ i ].IsNotNull() )
+        {
+          typename QuantizedProbImageWriterType::Pointer quantizedSoftWriter =
+            QuantizedProbImageWriterType::New();
+          quantizedSoftWriter->SetFileName( this->m_SoftOutputFileNames[ i ].c_str() );
+          quantizedSoftWriter->SetInput( quantizedSoftSegmentationArray[ i ] );
+          quantizedSoftWriter->SetUseCompression( this->m_UseCompression );
+          quantizedSoftWriter->Update();
+        }
       }
       std::cout << "Done writing soft segmentations." << std::endl;
     }
@@ -27,6 +27,8 @@
 #include <vector>
 #include "itkArray.h"
 #include "itkArray2D.h"
+#include "itkObserverLabelsConstIterator.h"
+#include "itkProbabilisticSegmentationIterator.h"
 
 namespace itk
 {
@@ -63,7 +65,12 @@ namespace itk
   * maximum number of "votes" from the input pixels.. If the maximum number of
   * votes is not unique, i.e., if more than one label have a maximum number of
   * votes, the prior preferences are used to select a winning label. On request,
-  * the probabilistic segmentation can also be produced.
+  * the probabilistic segmentation can also be produced, optionally quantized
+  * to 16 bits.
+  *
+  * Instead of one input per observer, the labels can be supplied as an
+  * observer stack (SetObserverStack()): a VectorImage of unsigned char, which
+  * stores the labels of all observers interleaved per voxel.
   *
   * \par PARAMETERS
   *
@@ -135,6 +142,29 @@ namespace itk
       ProbabilityImageType >                            ProbIteratorType;
     typedef ImageRegionConstIterator< MaskImageType >   MaskConstIteratorType;
 
+    /** Typedefs for the observer stack, an alternative to the inputs that
+     * stores the labels of all observers interleaved per voxel */
+    typedef ObserverLabelsConstIterator<
+      InputImageType >                                  ObserverLabelsConstIteratorType;
+    typedef typename
+      ObserverLabelsConstIteratorType::ObserverStackType ObserverStackType;
+    typedef typename ObserverStackType::Pointer         ObserverStackPointer;
+
+    /** Typedefs for the probabilistic segmentations quantized to 16 bits */
+    typedef unsigned short                              QuantizedProbabilityPixelType;
+    typedef Image<
+      QuantizedProbabilityPixelType,
+      InputImageType::ImageDimension >                  QuantizedProbabilityImageType;
+    typedef typename
+      QuantizedProbabilityImageType::Pointer            QuantizedProbabilityImagePointer;
+    typedef std::vector<
+      QuantizedProbabilityImagePointer >                QuantizedProbabilisticSegmentationArrayType;
+    typedef ImageRegionIterator<
+      QuantizedProbabilityImageType >                   QuantizedProbIteratorType;
+    typedef ProbabilisticSegmentationIterator<
+      ProbabilityImageType,
+      QuantizedProbabilityImageType >                   ProbabilisticSegmentationIteratorType;
+
     /** Set/get/unset prior preference; a scalar for each class indicating
     * the preference in case of undecided pixels. The lower the number,
     * the more preference. If not provided, the class numbers are assumed
@@ -212,14 +242,34 @@ namespace itk
       return this->m_ProbabilisticSegmentationArray;
     }
 
+    /** Setting: turn on/off whether the probabilistic segmentations are stored
+    * quantized to 16 bits, as round( p * 65535 ), which halves their memory.
+    * They are then available through GetQuantizedProbabilisticSegmentationArray()
+    * instead of GetProbabilisticSegmentationArray(); default: false */
+    itkSetMacro( QuantizeProbabilisticSegmentations, bool );
+    itkGetConstMacro( QuantizeProbabilisticSegmentations, bool );
+
+    /** Get the quantized probabilistic segmentations. Only valid when
+    * SetGenerateProbabilisticSegmentations(true) and
+    * SetQuantizeProbabilisticSegmentations(true) have been
+    * invoked before updating this filter. */
+    virtual const QuantizedProbabilisticSegmentationArrayType &
+      GetQuantizedProbabilisticSegmentationArray( void ) const
+    {
+      return this->m_QuantizedProbabilisticSegmentationArray;
+    }
+
     /** If you have inspected the probabilistic segmentations and want to get rid
     * of those float images sitting in your memory, call this function */
     virtual void CleanProbabilisticSegmentations( void )
     {
-      if( this->m_ProbabilisticSegmentationArray.size() > 0 )
+      if( this->m_ProbabilisticSegmentationArray.size() > 0
+        || this->m_QuantizedProbabilisticSegmentationArray.size() > 0 )
       {
         this->m_ProbabilisticSegmentationArray =
           ProbabilisticSegmentationArrayType(0);
+        this->m_QuantizedProbabilisticSegmentationArray =
+          QuantizedProbabilisticSegmentationArrayType(0);
         this->Modified();
       }
     }
@@ -231,6 +281,33 @@ namespace itk
     itkSetObjectMacro( MaskImage, MaskImageType );
     itkGetObjectMacro( MaskImage, MaskImageType );
 
+    /** Set/Get an observer stack; if supplied, the labels of the observers are
+     * read from the stack, which stores them as unsigned char, interleaved
+     * per voxel, and no inputs are needed. */
+    virtual void SetObserverStack( ObserverStackType * stack )
+    {
+      if( this->m_ObserverStack != stack )
+      {
+        this->m_ObserverStack = stack;
+        this->SetNumberOfRequiredInputs( stack ? 0 : 1 );
+        if( stack ) this->RemoveRequiredInputName( "Primary" );
+        this->Modified();
+      }
+    }
+
+    itkGetObjectMacro( ObserverStack, ObserverStackType );
+
+    /** The number of observers: the number of inputs, or the vector length
+     * of the observer stack */
+    virtual unsigned int GetNumberOfObservers( void ) const
+    {
+      if( this->m_ObserverStack.IsNotNull() )
+      {
+        return this->m_ObserverStack->GetNumberOfComponentsPerPixel();
+      }
+      return this->GetNumberOfInputs();
+    }
+
     /** Setting: turn on/off to whether a confusion matrix
      * is generated; default: false */
     itkSetMacro(GenerateConfusionMatrix, bool);
@@ -275,6 +352,24 @@ namespace itk
 
     void PrintSelf(std::ostream&, Indent) const;
 
+    /** With an observer stack, the output information is copied from the stack */
+    void GenerateOutputInformation();
+
+    /** An iterator over the labels of all observers in a region, reading
+     * either the inputs or the observer stack */
+    virtual ObserverLabelsConstIteratorType GetObserverLabelsIterator(
+      const OutputImageRegionType & region ) const;
+
+    /** Allocate the probabilistic segmentations like the output, if they
+     * are to be generated, either as WeightsType or as quantized images */
+    virtual void AllocateProbabilisticSegmentations( void );
+
+    /** An iterator that sets the probabilities of all classes in a region of
+     * the probabilistic segmentations; it does nothing if they are not
+     * generated */
+    virtual ProbabilisticSegmentationIteratorType GetProbabilisticSegmentationIterator(
+      const OutputImageRegionType & region ) const;
+
     /** The number of different labels found in the input segmentations */
     InputPixelType m_NumberOfClasses;
 
@@ -294,6 +389,8 @@ namespace itk
     * but for inheriting classes this would be annoying. So, make them protected. */
     ObserverTrustType                  m_ObserverTrust;
     ProbabilisticSegmentationArrayType m_ProbabilisticSegmentationArray;
+    QuantizedProbabilisticSegmentationArrayType m_QuantizedProbabilisticSegmentationArray;
+    ObserverStackPointer               m_ObserverStack;
     PriorPreferenceType                m_PriorPreference;
     ConfusionMatrixArrayType           m_ConfusionMatrixArray;
 
@@ -312,6 +409,7 @@ namespace itk
 
     /** Settings that can be accessed via the set/get member functions */
     bool m_GenerateProbabilisticSegmentations;
+    bool m_QuantizeProbabilisticSegmentations;
     bool m_GenerateConfusionMatrix;
     MaskImagePointer m_MaskImage;
 
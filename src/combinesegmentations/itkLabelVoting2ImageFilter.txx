@@ -38,6 +38,8 @@ namespace itk
     this->m_LeastPreferredLabel = 1;
     this->m_MaskImage = 0;
     this->m_GenerateConfusionMatrix = false;
+    this->m_ObserverStack = 0;
+    this->m_QuantizeProbabilisticSegmentations = false;
   } // end constructor
 
 
@@ -58,15 +60,14 @@ namespace itk
   {
     /** compute the maximum class label from the input data */
     InputPixelType maxLabel = 0;
-    const unsigned int numberOfInputs = this->GetNumberOfInputs();
+    const unsigned int numberOfObservers = this->GetNumberOfObservers();
 
-    for( unsigned int k = 0; k < numberOfInputs; ++k )
+    ObserverLabelsConstIteratorType it = this->GetObserverLabelsIterator(
+      this->GetOutput()->GetRequestedRegion() );
+    for ( it.GoToBegin(); !it.IsAtEnd(); ++it )
     {
-      InputConstIteratorType it
-        ( this->GetInput( k ), this->GetInput( k )->GetBufferedRegion() );
-
-      for ( it.GoToBegin(); !it.IsAtEnd(); ++it )
-        maxLabel = std::max( maxLabel, it.Get() );
+      for( unsigned int k = 0; k < numberOfObservers; ++k )
+        maxLabel = std::max( maxLabel, it.Get( k ) );
     }
 
     return maxLabel;
@@ -79,13 +80,13 @@ namespace itk
     ::AllocateConfusionMatrixArray()
   {
     /**  we need one confusion matrix for every input */
-    const unsigned int numberOfInputs = this->GetNumberOfInputs();
+    const unsigned int numberOfObservers = this->GetNumberOfObservers();
 
     this->m_ConfusionMatrixArray.clear();
 
     /** create the confusion matrix and space for updated confusion matrix for
      * each of the input images */
-    for( unsigned int k = 0; k < numberOfInputs; ++k )
+    for( unsigned int k = 0; k < numberOfObservers; ++k )
     {
       /** the confusion matrix has as many row/columns as there are input labels,
        * The column nrs correspond to the 'real' class, as estimated by the
@@ -104,7 +105,7 @@ namespace itk
     for( unsigned int t = 0; t < numberOfThreads; ++t)
     {
       this->m_ConfusionMatrixArrays[t].clear();
-      for( unsigned int k = 0; k < numberOfInputs; ++k )
+      for( unsigned int k = 0; k < numberOfObservers; ++k )
       {
         this->m_ConfusionMatrixArrays[t].push_back(
           ConfusionMatrixType( this->m_NumberOfClasses, this->m_NumberOfClasses ) );
@@ -123,9 +124,7 @@ namespace itk
   {
     this->Superclass::BeforeThreadedGenerateData();
 
-    const bool generateProbSeg =
-      this->GetGenerateProbabilisticSegmentations();
-    const unsigned int numberOfInputs = this->GetNumberOfInputs();
+    const unsigned int numberOfObservers = this->GetNumberOfObservers();
 
     /** Set some default values if necessary */
     if( this->m_HasNumberOfClasses == false )
@@ -142,7 +141,7 @@ namespace itk
     }
     if( !this->m_HasObserverTrust )
     {
-      this->m_ObserverTrust.SetSize( numberOfInputs );
+      this->m_ObserverTrust.SetSize( numberOfObservers );
       this->m_ObserverTrust.Fill(1.0);
     }
 
@@ -158,23 +157,9 @@ namespace itk
 
     /**  Allocate the output image. */
     this->AllocateOutputs();
-    typename TOutputImage::Pointer output = this->GetOutput();
 
     /** If probabilistic segmentations are desired, allocate them */
-    if( generateProbSeg )
-    {
-      this->m_ProbabilisticSegmentationArray =
-        ProbabilisticSegmentationArrayType( this->m_NumberOfClasses );
-      for( unsigned int k = 0; k < this->m_NumberOfClasses; ++k )
-      {
-        this->m_ProbabilisticSegmentationArray[k] =
-          ProbabilityImageType::New();
-        this->m_ProbabilisticSegmentationArray[k]->SetRegions(
-          output->GetRequestedRegion() );
-        this->m_ProbabilisticSegmentationArray[k]->CopyInformation( output );
-        this->m_ProbabilisticSegmentationArray[k]->Allocate();
-      }
-    }
+    this->AllocateProbabilisticSegmentations();
 
     /** Allocate the confusion matrix arrays */
     if( this->GetGenerateConfusionMatrix() )
@@ -192,37 +177,21 @@ namespace itk
     ThreadIdType threadId)
   {
     typedef Array<WeightsType>                  WType;
-    typedef std::vector<InputConstIteratorType> InputConstIteratorArrayType;
-    typedef std::vector<ProbIteratorType>       ProbIteratorArrayType;
 
     typename TOutputImage::Pointer output = this->GetOutput();
-    const bool generateProbSeg =
-      this->GetGenerateProbabilisticSegmentations();
     const bool generateConfusionMatrix = this->GetGenerateConfusionMatrix();
-    const unsigned int numberOfInputs = this->GetNumberOfInputs();
+    const unsigned int numberOfObservers = this->GetNumberOfObservers();
     const bool useMask = this->m_MaskImage.IsNotNull();
     /** Votes by label, weighted by the observer trust */
     WType W( this->m_NumberOfClasses );
 
-    /** create and initialize all input image iterators */
-    InputConstIteratorArrayType it(numberOfInputs);
-    for( unsigned int k = 0; k < numberOfInputs; ++k )
-    {
-      it[k] = InputConstIteratorType
-        ( this->GetInput( k ), outputRegionForThread );
-    }
+    /** create and initialize the iterator over the labels of all observers */
+    ObserverLabelsConstIteratorType it =
+      this->GetObserverLabelsIterator( outputRegionForThread );
 
-    /** Create and initialize the output probabilistic segmentation image iterators */
-    ProbIteratorArrayType psit;
-    if( generateProbSeg )
-    {
-      psit = ProbIteratorArrayType( this->m_NumberOfClasses );
-      for( unsigned int k = 0; k < this->m_NumberOfClasses; ++k )
-      {
-        psit[k] = ProbIteratorType(
-          this->m_ProbabilisticSegmentationArray[k], outputRegionForThread );
-      }
-    }
+    /** Create and initialize the output probabilistic segmentation image iterator */
+    ProbabilisticSegmentationIteratorType psit =
+      this->GetProbabilisticSegmentationIterator( outputRegionForThread );
 
     /** Create and initialize the mask iterator */
     MaskConstIteratorType mit;
@@ -251,15 +220,12 @@ namespace itk
         if( mit.Get() == zeroMaskPixel )
         {
           insideMask = false;
-          winningLabel = it[0].Get();
+          winningLabel = it.Get( 0 );
           W[ winningLabel ] = 1.0;
           /** Set the winning label to the output pixel */
           out.Set( winningLabel );
-          /** move the it iterators */
-          for( unsigned int k = 0; k < numberOfInputs; ++k )
-          {
-            ++(it[k]);
-          }
+          /** move the it iterator */
+          ++it;
         } // if mit==zero
         ++mit;
       } // end if useMask
@@ -268,9 +234,9 @@ namespace itk
       {
 
         // count number of votes for the labels
-        for( unsigned int i = 0; i < numberOfInputs; ++i )
+        for( unsigned int i = 0; i < numberOfObservers; ++i )
         {
-          const InputPixelType label = it[ i ].Get();
+          const InputPixelType label = it.Get( i );
           W[label] += this->m_ObserverTrust( i );
         }
 
@@ -309,9 +275,9 @@ namespace itk
         /** Update the confusion matrix */
         if( generateConfusionMatrix )
         {
-          for( unsigned int i = 0; i < numberOfInputs; ++i )
+          for( unsigned int i = 0; i < numberOfObservers; ++i )
           {
-            const InputPixelType label = it[ i ].Get();
+            const InputPixelType label = it.Get( i );
             for ( OutputPixelType ci = 0; ci < this->m_NumberOfClasses; ++ci )
             {
               this->m_ConfusionMatrixArrays[threadId][ i ][label][ci] += W[ci];
@@ -320,22 +286,12 @@ namespace itk
         } // end if generateConfusionMatrix
 
         /** Next input pixel */
-        for( unsigned int i = 0; i < numberOfInputs; ++i )
-        {
-          ++(it[ i ]);
-        }
+        ++it;
       } // end if insideMask
 
       /** copy the W values into the probabilistic segmentation images
-       * and move the psit iterators */
-      if( generateProbSeg )
-      {
-        for ( OutputPixelType ci = 0; ci < this->m_NumberOfClasses; ++ci )
-        {
-          psit[ci].Set( W[ci] );
-          ++(psit[ci]);
-        }
-      } // end if generateProbSeg
+       * and move the psit iterator */
+      psit.SetProbabilities( W );
 
     } // end loop over output pixels
 
@@ -349,7 +305,7 @@ namespace itk
   {
     this->Superclass::AfterThreadedGenerateData();
 
-    const unsigned int numberOfInputs = this->GetNumberOfInputs();
+    const unsigned int numberOfObservers = this->GetNumberOfObservers();
 
     if( this->GetGenerateConfusionMatrix() )
     {
@@ -357,7 +313,7 @@ namespace itk
       /** Add the confusion matrix arrays of all threads */
       for( unsigned int t = 0; t < this->GetNumberOfWorkUnits(); ++t )
       {
-        for( unsigned int i = 0; i < numberOfInputs; ++i )
+        for( unsigned int i = 0; i < numberOfObservers; ++i )
         {
           this->m_ConfusionMatrixArray[ i ] +=
             this->m_ConfusionMatrixArrays[t][ i ];
@@ -365,7 +321,7 @@ namespace itk
       } // end for t
 
       /** Normalize each column of each confusion matrix */
-      for( unsigned int i = 0; i < numberOfInputs; ++i )
+      for( unsigned int i = 0; i < numberOfObservers; ++i )
       {
         // compute sum over all output classifications
         for ( OutputPixelType ci = 0; ci < this->m_NumberOfClasses; ++ci )
@@ -388,6 +344,69 @@ namespace itk
 
   } // end AfterThreadedGenerateData
 
+
+  template< typename TInputImage, typename TOutputImage, typename TWeights >
+    void
+    LabelVoting2ImageFilter< TInputImage, TOutputImage, TWeights >
+    ::GenerateOutputInformation()
+  {
+    if( this->m_ObserverStack.IsNull() )
+    {
+      Superclass::GenerateOutputInformation();
+      return;
+    }
+
+    /** Without input images, the output gets the geometry of the stack */
+    this->GetOutput()->CopyInformation( this->m_ObserverStack );
+  } // end GenerateOutputInformation
+
+
+  template< typename TInputImage, typename TOutputImage, typename TWeights >
+    typename LabelVoting2ImageFilter< TInputImage, TOutputImage, TWeights >
+      ::ObserverLabelsConstIteratorType
+    LabelVoting2ImageFilter< TInputImage, TOutputImage, TWeights >
+    ::GetObserverLabelsIterator( const OutputImageRegionType & region ) const
+  {
+    if( this->m_ObserverStack.IsNotNull() )
+    {
+      return ObserverLabelsConstIteratorType( this->m_ObserverStack, region );
+    }
+
+    typename ObserverLabelsConstIteratorType::LabelImageArrayType
+      labelImages( this->GetNumberOfInputs() );
+    for( unsigned int k = 0; k < labelImages.size(); ++k )
+    {
+      labelImages[k] = this->GetInput( k );
+    }
+    return ObserverLabelsConstIteratorType( labelImages, region );
+  } // end GetObserverLabelsIterator
+
+
+  template< typename TInputImage, typename TOutputImage, typename TWeights >
+    void
+    LabelVoting2ImageFilter< TInputImage, TOutputImage, TWeights >
+    ::AllocateProbabilisticSegmentations( void )
+  {
+    const unsigned int numberOfClasses =
+      this->m_GenerateProbabilisticSegmentations ? this->m_NumberOfClasses : 0;
+    ProbabilisticSegmentationIteratorType::Allocate( numberOfClasses,
+      this->m_QuantizeProbabilisticSegmentations, this->GetOutput(),
+      this->m_ProbabilisticSegmentationArray,
+      this->m_QuantizedProbabilisticSegmentationArray );
+  } // end AllocateProbabilisticSegmentations
+
+
+  template< typename TInputImage, typename TOutputImage, typename TWeights >
+    typename LabelVoting2ImageFilter< TInputImage, TOutputImage, TWeights >
+      ::ProbabilisticSegmentationIteratorType
+    LabelVoting2ImageFilter< TInputImage, TOutputImage, TWeights >
+    ::GetProbabilisticSegmentationIterator( const OutputImageRegionType & region ) const
+  {
+    return ProbabilisticSegmentationIteratorType(
+      this->m_ProbabilisticSegmentationArray,
+      this->m_QuantizedProbabilisticSegmentationArray, region );
+  } // end GetProbabilisticSegmentationIterator
+
 } // end namespace itk
 
 #endif // end #ifndef _itkLabelVoting2ImageFilter_txx_
@@ -0,0 +1,230 @@
+/*=========================================================================
+*
+* Copyright Marius Staring, Stefan Klein, David Doria. 2011.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0.txt
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*=========================================================================*/
+#ifndef __itkLocallyWeightedLabelVotingImageFilter_h_
+#define __itkLocallyWeightedLabelVotingImageFilter_h_
+
+#include "itkLabelVoting2ImageFilter.h"
+
+#include <vector>
+
+namespace itk
+{
+  /** \class LocallyWeightedLabelVotingImageFilter
+  *
+  * \brief This filter performs pixelwise voting among the segmentations of
+  * a number of atlases, where the vote of each atlas is weighted by the
+  * local similarity of its (registered) intensity image to the target image.
+  *
+  * For each atlas k the weight at voxel x is
+  *
+  *   w_k(x) = t_k * ( MSD_k(x) + epsilon )^( -gain ),
+  *
+  * with t_k the observer trust and MSD_k(x) the mean squared intensity
+  * difference between the target image and the intensity image of atlas k,
+  * over a patch centred at x. This is the local weighted voting of
+  *
+  * X. Artaechevarria, A. Munoz-Barrutia and C. Ortiz-de-Solorzano,
+  * "Combination strategies in multi-atlas image segmentation: application
+  * to brain MR data," IEEE Transactions on Medical Imaging, 2009.
+  *
+  * The winning label, the tie breaking with the prior preferences, the
+  * probabilistic segmentations and the confusion matrices are as in
+  * LabelVoting2ImageFilter, with the normalized weighted votes instead of
+  * the normalized global votes.
+  *
+  * \par INPUTS
+  * The atlas segmentations, as inputs or as an observer stack, like in
+  * LabelVoting2ImageFilter. Furthermore the target image (SetTargetImage())
+  * and the intensity image of each atlas (SetAtlasImage()), which must
+  * contain the largest possible region of the output, and have the spacing,
+  * origin and direction of the atlas segmentations. The intensities of
+  * the atlases must be comparable to those of the target.
+  *
+  * \par PATCH DISTANCES
+  * The patch sums of the squared differences are not computed by a loop over
+  * the patch at each voxel, but by a running box sum along each image axis in
+  * turn, which costs a few additions per voxel per axis, whatever the patch
+  * radius. At the image border the patch is cropped to the image.
+  *
+  * \par THREADING
+  * Each thread processes its region in slabs along the last axis, so that
+  * the work space stays small: the labels of all atlases and a vote per
+  * class for each voxel of the slab, and the squared differences of one
+  * atlas in the slab padded by the patch radius. Voxels where all atlases
+  * agree, and voxels outside the mask, do not need weights, and slabs with
+  * only such voxels skip the patch distances altogether.
+  *
+  * \par PARAMETERS
+  * The patch radius (default 2), the gain (default 1) and epsilon (default
+  * 1e-6), which avoids a division by zero for identical patches.
+  *
+  * \sa LabelVoting2ImageFilter
+  */
+
+  template <typename TInputImage, typename TOutputImage = TInputImage,
+    typename TIntensityImage = Image< float, TInputImage::ImageDimension >,
+    typename TWeights = float>
+  class LocallyWeightedLabelVotingImageFilter :
+    public LabelVoting2ImageFilter< TInputImage, TOutputImage, TWeights >
+  {
+  public:
+    /** Standard class typedefs. */
+    typedef LocallyWeightedLabelVotingImageFilter Self;
+    typedef LabelVoting2ImageFilter<
+      TInputImage, TOutputImage, TWeights >       Superclass;
+    typedef SmartPointer<Self>                    Pointer;
+    typedef SmartPointer<const Self>              ConstPointer;
+
+    /** Method for creation through the object factory. */
+    itkNewMacro(Self);
+
+    /** Run-time type information (and related methods) */
+    itkTypeMacro(LocallyWeightedLabelVotingImageFilter, LabelVoting2ImageFilter);
+
+    /** Typedefs from the superclass */
+    typedef typename Superclass::InputPixelType         InputPixelType;
+    typedef typename Superclass::OutputPixelType        OutputPixelType;
+    typedef typename Superclass::InputImageType         InputImageType;
+    typedef typename Superclass::OutputImageType        OutputImageType;
+    typedef typename Superclass::OutputImageRegionType  OutputImageRegionType;
+    typedef typename Superclass::WeightsType            WeightsType;
+    typedef typename Superclass::MaskImageType          MaskImageType;
+    typedef typename Superclass::MaskPixelType          MaskPixelType;
+    typedef typename Superclass::ObserverLabelsConstIteratorType
+      ObserverLabelsConstIteratorType;
+    typedef typename Superclass::OutputIteratorType     OutputIteratorType;
+    typedef typename Superclass::MaskConstIteratorType  MaskConstIteratorType;
+    typedef typename Superclass::ProbabilisticSegmentationIteratorType
+      ProbabilisticSegmentationIteratorType;
+
+    itkStaticConstMacro(ImageDimension, unsigned int,
+      TOutputImage::ImageDimension);
+
+    /** Intensity image typedefs */
+    typedef TIntensityImage                             IntensityImageType;
+    typedef typename IntensityImageType::ConstPointer   IntensityImageConstPointer;
+    typedef typename IntensityImageType::PixelType      IntensityPixelType;
+    typedef std::vector< IntensityImageConstPointer >   AtlasImageArrayType;
+
+    /** Various typedefs */
+    typedef typename OutputImageType::SizeType          RadiusType;
+    typedef typename OutputImageType::IndexType         IndexType;
+    typedef typename OutputImageType::SizeType          SizeType;
+
+    /** Set/Get the target image, the image to be segmented */
+    itkSetConstObjectMacro( TargetImage, IntensityImageType );
+    itkGetConstObjectMacro( TargetImage, IntensityImageType );
+
+    /** Set/Get the intensity image of atlas k, registered to the target
+     * image like the segmentation of atlas k */
+    virtual void SetAtlasImage( const unsigned int k, const IntensityImageType * image )
+    {
+      if( k >= this->m_AtlasImageArray.size() )
+      {
+        this->m_AtlasImageArray.resize( k + 1 );
+      }
+      if( this->m_AtlasImageArray[ k ] != image )
+      {
+        this->m_AtlasImageArray[ k ] = image;
+        this->Modified();
+      }
+    }
+
+    virtual const IntensityImageType * GetAtlasImage( const unsigned int k ) const
+    {
+      return k < this->m_AtlasImageArray.size()
+        ? this->m_AtlasImageArray[ k ].GetPointer() : nullptr;
+    }
+
+    /** Set/Get the radius of the patches that are compared; default: 2 */
+    itkSetMacro( PatchRadius, RadiusType );
+    itkGetConstReferenceMacro( PatchRadius, RadiusType );
+
+    /** Set/Get the gain, the power of the inverse patch distance; default: 1 */
+    itkSetMacro( Gain, WeightsType );
+    itkGetConstMacro( Gain, WeightsType );
+
+    /** Set/Get epsilon, added to the patch distances; default: 1e-6 */
+    itkSetMacro( Epsilon, WeightsType );
+    itkGetConstMacro( Epsilon, WeightsType );
+
+  protected:
+    LocallyWeightedLabelVotingImageFilter();
+    virtual ~LocallyWeightedLabelVotingImageFilter() {}
+
+    /** Check the intensity images, before the superclass initializes */
+    void BeforeThreadedGenerateData ();
+    void ThreadedGenerateData
+      ( const OutputImageRegionType &outputRegionForThread, ThreadIdType threadId);
+
+    void PrintSelf(std::ostream&, Indent) const;
+
+    /** The state of a voxel of a slab: only undecided voxels need weights */
+    enum VoxelStateType { UndecidedVoxel = 0, UnanimousVoxel, OutsideMaskVoxel };
+
+    /** The work space of a thread, reused for all its slabs */
+    struct ThreadBuffersType
+    {
+      /** The labels of all observers, numberOfObservers per voxel */
+      std::vector<InputPixelType> m_Labels;
+      /** The VoxelStateType of each voxel */
+      std::vector<unsigned char>  m_VoxelStates;
+      /** The weighted votes, numberOfClasses per voxel */
+      std::vector<WeightsType>    m_Votes;
+      /** The target intensities in the padded slab */
+      std::vector<double>         m_Target;
+      /** The (box summed) squared differences in the padded slab */
+      std::vector<double>         m_Distances;
+      /** A line of the padded slab */
+      std::vector<double>         m_Line;
+      /** The number of voxels in the box, for each position along each axis */
+      std::vector<double>         m_BoxCounts[ TOutputImage::ImageDimension ];
+    };
+
+    /** Vote in a slab of the output region */
+    virtual void VoteInSlab( const OutputImageRegionType & slab,
+      ThreadIdType threadId, ThreadBuffersType & buffers );
+
+    /** Add the weighted votes of all atlases to the votes of the undecided
+     * voxels of the slab */
+    virtual void AddWeightedVotes( const OutputImageRegionType & slab,
+      ThreadBuffersType & buffers ) const;
+
+    /** Replace the values in a buffer of the given size by their sum over a
+     * box with the patch radius, cropped to the buffer */
+    virtual void BoxSum( const SizeType & size, ThreadBuffersType & buffers ) const;
+
+  private:
+    LocallyWeightedLabelVotingImageFilter(const Self&); //purposely not implemented
+    void operator=(const Self&); //purposely not implemented
+
+    IntensityImageConstPointer  m_TargetImage;
+    AtlasImageArrayType         m_AtlasImageArray;
+    RadiusType                  m_PatchRadius;
+    WeightsType                 m_Gain;
+    WeightsType                 m_Epsilon;
+
+  };
+
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkLocallyWeightedLabelVotingImageFilter.txx"
+#endif
+
+#endif // end #ifndef __itkLocallyWeightedLabelVotingImageFilter_h_
@@ -0,0 +1,452 @@
+/*=========================================================================
+*
+* Copyright Marius Staring, Stefan Klein, David Doria. 2011.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0.txt
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*=========================================================================*/
+#ifndef _itkLocallyWeightedLabelVotingImageFilter_txx_
+#define _itkLocallyWeightedLabelVotingImageFilter_txx_
+
+#include "itkLocallyWeightedLabelVotingImageFilter.h"
+
+#include "itkImageRegionConstIterator.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace itk
+{
+
+  template <typename TInputImage, typename TOutputImage, typename TIntensityImage, typename TWeights>
+    LocallyWeightedLabelVotingImageFilter<TInputImage, TOutputImage, TIntensityImage, TWeights>
+    ::LocallyWeightedLabelVotingImageFilter()
+  {
+    this->m_TargetImage = 0;
+    this->m_PatchRadius.Fill( 2 );
+    this->m_Gain = 1.0;
+    this->m_Epsilon = 1e-6;
+
+    /** The confusion matrices are accumulated per thread id */
+    this->DynamicMultiThreadingOff();
+  } // end constructor
+
+
+  template <typename TInputImage, typename TOutputImage, typename TIntensityImage, typename TWeights>
+    void
+    LocallyWeightedLabelVotingImageFilter<TInputImage, TOutputImage, TIntensityImage, TWeights>
+    ::PrintSelf(std::ostream& os, Indent indent) const
+  {
+    Superclass::PrintSelf(os,indent);
+    os << indent << "PatchRadius: " << this->m_PatchRadius << std::endl;
+    os << indent << "Gain: " << this->m_Gain << std::endl;
+    os << indent << "Epsilon: " << this->m_Epsilon << std::endl;
+  } // end PrintSelf
+
+
+  template <typename TInputImage, typename TOutputImage, typename TIntensityImage, typename TWeights>
+    void
+    LocallyWeightedLabelVotingImageFilter<TInputImage, TOutputImage, TIntensityImage, TWeights>
+    ::BeforeThreadedGenerateData ()
+  {
+    /** The intensity images must cover the output */
+    const OutputImageRegionType & region =
+      this->GetOutput()->GetLargestPossibleRegion();
+    const unsigned int numberOfObservers = this->GetNumberOfObservers();
+    if( this->m_TargetImage.IsNull() )
+    {
+      itkExceptionMacro( << "The target image is not set." );
+    }
+    if( !this->m_TargetImage->GetBufferedRegion().IsInside( region ) )
+    {
+      itkExceptionMacro( << "The target image should be buffered for the region of the output." );
+    }
+    if( this->m_AtlasImageArray.size() != numberOfObservers )
+    {
+      itkExceptionMacro( << "The number of atlas images (" << this->m_AtlasImageArray.size()
+        << ") should be equal to the number of observers (" << numberOfObservers << ")." );
+    }
+    for( unsigned int k = 0; k < numberOfObservers; ++k )
+    {
+      if( this->m_AtlasImageArray[ k ].IsNull()
+        || !this->m_AtlasImageArray[ k ]->GetBufferedRegion().IsInside( region ) )
+      {
+        itkExceptionMacro( << "Atlas image " << k
+          << " is not set, or not buffered for the region of the output." );
+      }
+    }
+
+    /** The intensity images must lie where the atlas segmentations lie */
+    if( !this->m_TargetImage->IsSameImageGeometryAs( this->GetOutput() ) )
+    {
+      itkExceptionMacro( << "The spacing, origin or direction of the target image "
+        << "differs from that of the atlas segmentations." );
+    }
+    for( unsigned int k = 0; k < numberOfObservers; ++k )
+    {
+      if( !this->m_AtlasImageArray[ k ]->IsSameImageGeometryAs( this->GetOutput() ) )
+      {
+        itkExceptionMacro( << "The spacing, origin or direction of atlas image " << k
+          << " differs from that of the atlas segmentations." );
+      }
+    }
+
+    this->Superclass::BeforeThreadedGenerateData();
+
+  } // end BeforeThreadedGenerateData
+
+
+  template <typename TInputImage, typename TOutputImage, typename TIntensityImage, typename TWeights>
+    void
+    LocallyWeightedLabelVotingImageFilter<TInputImage, TOutputImage, TIntensityImage, TWeights>
+    ::ThreadedGenerateData( const OutputImageRegionType &outputRegionForThread,
+    ThreadIdType threadId)
+  {
+    const unsigned int lastDimension = ImageDimension - 1;
+    const SizeType & size = outputRegionForThread.GetSize();
+    const unsigned int numberOfObservers = this->GetNumberOfObservers();
+
+    /** The number of slices per slab: as many as fit in a work space of
+     * about 64 MB, but at least one */
+    const SizeValueType workSpaceBytes = 64 * 1024 * 1024;
+    const SizeValueType bytesPerVoxel =
+      numberOfObservers * sizeof( InputPixelType ) + 1
+      + this->m_NumberOfClasses * sizeof( WeightsType ) + 2 * sizeof( double );
+    SizeValueType sliceSize = 1;
+    for( unsigned int d = 0; d < lastDimension; ++d )
+    {
+      sliceSize *= size[ d ];
+    }
+    if( sliceSize == 0 ) return;
+    const SizeValueType slabThickness = std::max< SizeValueType >(
+      1, workSpaceBytes / ( bytesPerVoxel * sliceSize ) );
+
+    /** Vote slab by slab, in the work space of this thread */
+    ThreadBuffersType buffers;
+    OutputImageRegionType slab = outputRegionForThread;
+    for( SizeValueType s = 0; s < size[ lastDimension ]; s += slabThickness )
+    {
+      slab.SetIndex( lastDimension,
+        outputRegionForThread.GetIndex( lastDimension ) + static_cast<IndexValueType>( s ) );
+      slab.SetSize( lastDimension,
+        std::min( slabThickness, size[ lastDimension ] - s ) );
+      this->VoteInSlab( slab, threadId, buffers );
+    }
+
+  } // end ThreadedGenerateData
+
+
+  template <typename TInputImage, typename TOutputImage, typename TIntensityImage, typename TWeights>
+    void
+    LocallyWeightedLabelVotingImageFilter<TInputImage, TOutputImage, TIntensityImage, TWeights>
+    ::VoteInSlab( const OutputImageRegionType & slab,
+    ThreadIdType threadId, ThreadBuffersType & buffers )
+  {
+    typedef Array<WeightsType>                  WType;
+
+    typename TOutputImage::Pointer output = this->GetOutput();
+    const bool generateConfusionMatrix = this->GetGenerateConfusionMatrix();
+    const unsigned int numberOfObservers = this->GetNumberOfObservers();
+    const unsigned int numberOfClasses = this->m_NumberOfClasses;
+    const SizeValueType numberOfVoxels = slab.GetNumberOfPixels();
+    MaskImageType * mask = this->GetMaskImage();
+    const MaskPixelType zeroMaskPixel = itk::NumericTraits<MaskPixelType>::Zero;
+
+    /** Read the labels of all observers, and find the voxels that do not need
+     * weights: outside the mask the label of the first observer is taken, and
+     * where all observers agree their label. */
+    buffers.m_Labels.resize( numberOfVoxels * numberOfObservers );
+    buffers.m_VoxelStates.resize( numberOfVoxels );
+    bool allDecided = true;
+    ObserverLabelsConstIteratorType it = this->GetObserverLabelsIterator( slab );
+    MaskConstIteratorType mit;
+    if( mask )
+    {
+      mit = MaskConstIteratorType( mask, slab );
+    }
+    SizeValueType v = 0;
+    for( it.GoToBegin(); !it.IsAtEnd(); ++it, ++v )
+    {
+      const InputPixelType * observerLabels = it.Get();
+      InputPixelType * labels = &buffers.m_Labels[ v * numberOfObservers ];
+      bool unanimous = true;
+      for( unsigned int k = 0; k < numberOfObservers; ++k )
+      {
+        labels[ k ] = observerLabels[ k ];
+        unanimous &= ( labels[ k ] == labels[ 0 ] );
+      }
+
+      unsigned char state = unanimous ? UnanimousVoxel : UndecidedVoxel;
+      if( mask )
+      {
+        if( mit.Get() == zeroMaskPixel ) state = OutsideMaskVoxel;
+        ++mit;
+      }
+      buffers.m_VoxelStates[ v ] = state;
+      allDecided &= ( state != UndecidedVoxel );
+    }
+
+    /** The weighted votes of the undecided voxels */
+    if( !allDecided )
+    {
+      buffers.m_Votes.assign( numberOfVoxels * numberOfClasses, 0.0 );
+      this->AddWeightedVotes( slab, buffers );
+    }
+
+    /** Create and initialize the output probabilistic segmentation image iterator */
+    ProbabilisticSegmentationIteratorType psit =
+      this->GetProbabilisticSegmentationIterator( slab );
+
+    /** Loop over the output pixels of the slab */
+    WType W( numberOfClasses );
+    OutputIteratorType out( output, slab );
+    v = 0;
+    for( out.GoToBegin(); !out.IsAtEnd(); ++out, ++v )
+    {
+      const InputPixelType * labels = &buffers.m_Labels[ v * numberOfObservers ];
+      const unsigned char state = buffers.m_VoxelStates[ v ];
+      W.Fill( 0.0 );
+      OutputPixelType winningLabel = this->m_LeastPreferredLabel;
+
+      if( state != UndecidedVoxel )
+      {
+        /** The label of the first observer, which is everybody's label
+         * for unanimous voxels */
+        winningLabel = labels[ 0 ];
+        W[ winningLabel ] = 1.0;
+      }
+      else
+      {
+        /** normalize the weighted votes */
+        const WeightsType * votes = &buffers.m_Votes[ v * numberOfClasses ];
+        WeightsType sumW = 0.0;
+        for( unsigned int ci = 0; ci < numberOfClasses; ++ci )
+        {
+          W[ ci ] = votes[ ci ];
+          sumW += votes[ ci ];
+        }
+        if( sumW )
+        {
+          W /= sumW;
+        }
+
+        /** now determine the label with the maximum W */
+        WeightsType winningLabelW = 0.0;
+        for ( OutputPixelType ci = 0; ci < this->m_NumberOfClasses; ++ci )
+        {
+          if( W[ci] > winningLabelW )
+          {
+            winningLabelW = W[ci];
+            winningLabel = ci;
+          }
+          else
+          {
+            if( ! (W[ci] < winningLabelW ) )
+            {
+              if( this->m_PriorPreference[ci] < this->m_PriorPreference[winningLabel] )
+              {
+                winningLabel = ci;
+              }
+            }
+          }
+        } // next ci
+      }
+
+      /** Set the winning label to the output pixel */
+      out.Set( winningLabel );
+
+      /** Update the confusion matrix, inside the mask */
+      if( generateConfusionMatrix && state != OutsideMaskVoxel )
+      {
+        for( unsigned int i = 0; i < numberOfObservers; ++i )
+        {
+          const InputPixelType label = labels[ i ];
+          for ( OutputPixelType ci = 0; ci < this->m_NumberOfClasses; ++ci )
+          {
+            this->m_ConfusionMatrixArrays[threadId][ i ][label][ci] += W[ci];
+          }
+        }
+      } // end if generateConfusionMatrix
+
+      /** copy the W values into the probabilistic segmentation images
+       * and move the psit iterator */
+      psit.SetProbabilities( W );
+
+    } // end loop over output pixels
+
+  } // end VoteInSlab
+
+
+  template <typename TInputImage, typename TOutputImage, typename TIntensityImage, typename TWeights>
+    void
+    LocallyWeightedLabelVotingImageFilter<TInputImage, TOutputImage, TIntensityImage, TWeights>
+    ::AddWeightedVotes( const OutputImageRegionType & slab,
+    ThreadBuffersType & buffers ) const
+  {
+    typedef ImageRegionConstIterator< IntensityImageType > IntensityIteratorType;
+
+    const unsigned int numberOfObservers = this->GetNumberOfObservers();
+    const unsigned int numberOfClasses = this->m_NumberOfClasses;
+    const double gain = this->m_Gain;
+    const double epsilon = this->m_Epsilon;
+
+    /** The slab padded by the patch radius, cropped to the image. A box
+     * cropped to the padded slab is then the patch cropped to the image,
+     * for all voxels of the slab. */
+    OutputImageRegionType padded = slab;
+    padded.PadByRadius( this->m_PatchRadius );
+    padded.Crop( this->GetOutput()->GetLargestPossibleRegion() );
+    const SizeType & paddedSize = padded.GetSize();
+    const SizeType & slabSize = slab.GetSize();
+    const SizeValueType numberOfPaddedVoxels = padded.GetNumberOfPixels();
+    const SizeValueType numberOfLines = slab.GetNumberOfPixels() / slabSize[ 0 ];
+
+    /** The position of the slab in the padded slab, and the number of voxels
+     * of the cropped box for each position along each axis */
+    SizeValueType slabOffset[ ImageDimension ];
+    for( unsigned int d = 0; d < ImageDimension; ++d )
+    {
+      slabOffset[ d ] = slab.GetIndex( d ) - padded.GetIndex( d );
+      const OffsetValueType radius = this->m_PatchRadius[ d ];
+      const OffsetValueType n = paddedSize[ d ];
+      buffers.m_BoxCounts[ d ].resize( n );
+      for( OffsetValueType i = 0; i < n; ++i )
+      {
+        buffers.m_BoxCounts[ d ][ i ] = static_cast<double>(
+          std::min( i + radius, n - 1 ) - std::max( i - radius, OffsetValueType( 0 ) ) + 1 );
+      }
+    }
+
+    /** The target intensities of the padded slab */
+    buffers.m_Target.resize( numberOfPaddedVoxels );
+    buffers.m_Distances.resize( numberOfPaddedVoxels );
+    IntensityIteratorType tit( this->m_TargetImage, padded );
+    SizeValueType p = 0;
+    for( tit.GoToBegin(); !tit.IsAtEnd(); ++tit, ++p )
+    {
+      buffers.m_Target[ p ] = tit.Get();
+    }
+
+    /** Vote atlas by atlas */
+    for( unsigned int k = 0; k < numberOfObservers; ++k )
+    {
+      /** The squared differences with the target in the padded slab,
+       * summed over the patches */
+      IntensityIteratorType ait( this->m_AtlasImageArray[ k ], padded );
+      for( ait.GoToBegin(), p = 0; !ait.IsAtEnd(); ++ait, ++p )
+      {
+        const double difference = ait.Get() - buffers.m_Target[ p ];
+        buffers.m_Distances[ p ] = difference * difference;
+      }
+      this->BoxSum( paddedSize, buffers );
+
+      /** Add the weight of atlas k to the votes for its label, line by line
+       * along the first axis of the slab */
+      const double trust = this->m_ObserverTrust[ k ];
+      IndexType lineIndex;
+      lineIndex.Fill( 0 );
+      SizeValueType v = 0;
+      for( SizeValueType line = 0; line < numberOfLines; ++line )
+      {
+        /** The offset of the line in the padded slab, and the size of the
+         * box along all but the first axis */
+        p = slabOffset[ 0 ];
+        SizeValueType stride = paddedSize[ 0 ];
+        double lineBoxCount = 1.0;
+        for( unsigned int d = 1; d < ImageDimension; ++d )
+        {
+          const SizeValueType position = lineIndex[ d ] + slabOffset[ d ];
+          p += position * stride;
+          stride *= paddedSize[ d ];
+          lineBoxCount *= buffers.m_BoxCounts[ d ][ position ];
+        }
+
+        for( SizeValueType i = 0; i < slabSize[ 0 ]; ++i, ++v, ++p )
+        {
+          if( buffers.m_VoxelStates[ v ] != UndecidedVoxel ) continue;
+
+          /** The running sums may leave a tiny negative rest for identical patches */
+          const double msd = std::max( 0.0, buffers.m_Distances[ p ]
+            / ( lineBoxCount * buffers.m_BoxCounts[ 0 ][ slabOffset[ 0 ] + i ] ) );
+          const double weight = gain == 1.0
+            ? trust / ( msd + epsilon )
+            : trust * std::pow( msd + epsilon, -gain );
+          const unsigned int label = buffers.m_Labels[ v * numberOfObservers + k ];
+          buffers.m_Votes[ v * numberOfClasses + label ] += static_cast<WeightsType>( weight );
+        }
+
+        /** Next line */
+        for( unsigned int d = 1; d < ImageDimension; ++d )
+        {
+          if( ++lineIndex[ d ] < static_cast<IndexValueType>( slabSize[ d ] ) ) break;
+          lineIndex[ d ] = 0;
+        }
+      } // end for line
+
+    } // end for k
+
+  } // end AddWeightedVotes
+
+
+  template <typename TInputImage, typename TOutputImage, typename TIntensityImage, typename TWeights>
+    void
+    LocallyWeightedLabelVotingImageFilter<TInputImage, TOutputImage, TIntensityImage, TWeights>
+    ::BoxSum( const SizeType & size, ThreadBuffersType & buffers ) const
+  {
+    std::vector<double> & values = buffers.m_Distances;
+    std::vector<double> & line = buffers.m_Line;
+    const SizeValueType numberOfValues = values.size();
+
+    /** Sum along each axis in turn, with a running sum per line */
+    SizeValueType stride = 1;
+    for( unsigned int d = 0; d < ImageDimension; ++d )
+    {
+      const SizeValueType n = size[ d ];
+      const SizeValueType radius = this->m_PatchRadius[ d ];
+      const SizeValueType blockSize = n * stride;
+      if( radius > 0 && n > 1 )
+      {
+        line.resize( n );
+        for( SizeValueType block = 0; block < numberOfValues; block += blockSize )
+        {
+          for( SizeValueType first = block; first < block + stride; ++first )
+          {
+            for( SizeValueType i = 0; i < n; ++i )
+            {
+              line[ i ] = values[ first + i * stride ];
+            }
+
+            /** The box of voxel i is [ i - radius, i + radius ], cropped to the line */
+            double sum = 0.0;
+            for( SizeValueType i = 0; i <= std::min( radius, n - 1 ); ++i )
+            {
+              sum += line[ i ];
+            }
+            values[ first ] = sum;
+            for( SizeValueType i = 1; i < n; ++i )
+            {
+              if( i + radius < n ) sum += line[ i + radius ];
+              if( i > radius ) sum -= line[ i - radius - 1 ];
+              values[ first + i * stride ] = sum;
+            }
+          } // end for first
+        } // end for block
+      }
+      stride = blockSize;
+    } // end for d
+
+  } // end BoxSum
+
+} // end namespace itk
+
+#endif // end #ifndef _itkLocallyWeightedLabelVotingImageFilter_txx_
@@ -27,6 +27,9 @@
 #include <vector>
 #include "itkArray.h"
 #include "itkArray2D.h"
+#include "itkObserverLabelsConstIterator.h"
+#include "itkProbabilisticSegmentationIterator.h"
+#include "itkSplitRegionInPieces.h"
 
 namespace itk
 {
@@ -103,6 +106,25 @@ namespace itk
   * after a smaller number of iterations if the termination threshold criterion
   * is satisfied.
   *
+  * \par UNANIMOUS VOXELS
+  * Usually most voxels get the same label from all observers. All these
+  * voxels with the same label have the same weights in the E step, so they
+  * are counted once, before the iterations, and added per label in each
+  * iteration. The E and M steps only loop over a compact list of the labels
+  * of the voxels where the observers disagree. This is not possible with
+  * prior probability images, in which case all voxels are visited.
+  *
+  * \par OBSERVER STACK
+  * Instead of one input per observer, the labels can be supplied as an
+  * observer stack (SetObserverStack()): a VectorImage of unsigned char, which
+  * stores the labels of all observers interleaved per voxel. The probabilistic
+  * segmentations are only allocated when requested, and can be stored
+  * quantized to 16 bits (SetQuantizeProbabilisticSegmentations()).
+  *
+  * \par THREADING
+  * The E and M steps and the computation of the output are multi-threaded,
+  * over the pieces of SplitRegionInPieces().
+  *
   * \par EVENTS
   * This filter invokes IterationEvent() at each iteration of the E-M
   * algorithm. Setting the AbortGenerateData() flag will cause the algorithm to
@@ -183,6 +205,35 @@ namespace itk
       ProbabilityImageType >                            ProbIteratorType;
     typedef ImageRegionConstIterator< MaskImageType >   MaskConstIteratorType;
 
+    /** Typedefs for the observer stack, an alternative to the inputs that
+     * stores the labels of all observers interleaved per voxel */
+    typedef ObserverLabelsConstIterator<
+      InputImageType >                                  ObserverLabelsConstIteratorType;
+    typedef typename
+      ObserverLabelsConstIteratorType::ObserverStackType ObserverStackType;
+    typedef typename ObserverStackType::Pointer         ObserverStackPointer;
+
+    /** Typedefs for the probabilistic segmentations quantized to 16 bits */
+    typedef unsigned short                              QuantizedProbabilityPixelType;
+    typedef Image<
+      QuantizedProbabilityPixelType,
+      InputImageType::ImageDimension >                  QuantizedProbabilityImageType;
+    typedef typename
+      QuantizedProbabilityImageType::Pointer            QuantizedProbabilityImagePointer;
+    typedef std::vector<
+      QuantizedProbabilityImagePointer >                QuantizedProbabilisticSegmentationArrayType;
+    typedef ImageRegionIterator<
+      QuantizedProbabilityImageType >                   QuantizedProbIteratorType;
+    typedef ProbabilisticSegmentationIterator<
+      ProbabilityImageType,
+      QuantizedProbabilityImageType >                   ProbabilisticSegmentationIteratorType;
+
+    /** The labels of the observers at the voxels where they disagree, for one
+     * piece of the output region, stored per observer: labels[k][v] is the
+     * label of observer k at undecided voxel v. */
+    typedef std::vector< std::vector<InputPixelType> >  UndecidedVoxelLabelsType;
+    typedef std::vector<SizeValueType>                  UnanimousVoxelCountsType;
+
     /** Set/get/unset maximum number of iterations. */
     virtual void SetMaximumNumberOfIterations( const unsigned int mit )
     {
@@ -317,6 +368,33 @@ namespace itk
     itkSetObjectMacro( MaskImage, MaskImageType );
     itkGetObjectMacro( MaskImage, MaskImageType );
 
+    /** Set/Get an observer stack; if supplied, the labels of the observers are
+     * read from the stack, which stores them as unsigned char, interleaved
+     * per voxel, and no inputs are needed. */
+    virtual void SetObserverStack( ObserverStackType * stack )
+    {
+      if( this->m_ObserverStack != stack )
+      {
+        this->m_ObserverStack = stack;
+        this->SetNumberOfRequiredInputs( stack ? 0 : 1 );
+        if( stack ) this->RemoveRequiredInputName( "Primary" );
+        this->Modified();
+      }
+    }
+
+    itkGetObjectMacro( ObserverStack, ObserverStackType );
+
+    /** The number of observers: the number of inputs, or the vector length
+     * of the observer stack */
+    virtual unsigned int GetNumberOfObservers( void ) const
+    {
+      if( this->m_ObserverStack.IsNotNull() )
+      {
+        return this->m_ObserverStack->GetNumberOfComponentsPerPixel();
+      }
+      return this->GetNumberOfInputs();
+    }
+
     /** Set whether a majority voting step should be used
      * to initialize the confusion matrix */
     itkSetMacro( InitializeWithMajorityVoting, bool)
@@ -336,14 +414,34 @@ namespace itk
       return this->m_ProbabilisticSegmentationArray;
     }
 
+    /** Setting: turn on/off whether the probabilistic segmentations are stored
+     * quantized to 16 bits, as round( p * 65535 ), which halves their memory.
+     * They are then available through GetQuantizedProbabilisticSegmentationArray()
+     * instead of GetProbabilisticSegmentationArray(); default: false */
+    itkSetMacro( QuantizeProbabilisticSegmentations, bool );
+    itkGetConstMacro( QuantizeProbabilisticSegmentations, bool );
+
+    /** Get the quantized probabilistic segmentations. Only valid when
+     * SetGenerateProbabilisticSegmentations(true) and
+     * SetQuantizeProbabilisticSegmentations(true) have been
+     * invoked before updating this filter. */
+    virtual const QuantizedProbabilisticSegmentationArrayType &
+      GetQuantizedProbabilisticSegmentationArray( void ) const
+    {
+      return this->m_QuantizedProbabilisticSegmentationArray;
+    }
+
     /** If you have inspected the probabilistic segmentations and want to get rid
      * of those float images sitting in your memory, call this function */
     virtual void CleanProbabilisticSegmentations( void )
     {
-      if( this->m_ProbabilisticSegmentationArray.size() > 0 )
+      if( this->m_ProbabilisticSegmentationArray.size() > 0
+        || this->m_QuantizedProbabilisticSegmentationArray.size() > 0 )
       {
         this->m_ProbabilisticSegmentationArray =
           ProbabilisticSegmentationArrayType(0);
+        this->m_QuantizedProbabilisticSegmentationArray =
+          QuantizedProbabilisticSegmentationArrayType(0);
         this->Modified();
       }
     }
@@ -371,6 +469,24 @@ namespace itk
     /** Do the actual work */
     void GenerateData();
 
+    /** With an observer stack, the output information is copied from the stack */
+    void GenerateOutputInformation();
+
+    /** An iterator over the labels of all observers in a region, reading
+     * either the inputs or the observer stack */
+    virtual ObserverLabelsConstIteratorType GetObserverLabelsIterator(
+      const OutputImageRegionType & region ) const;
+
+    /** Allocate the probabilistic segmentations like the output, if they
+     * are to be generated, either as WeightsType or as quantized images */
+    virtual void AllocateProbabilisticSegmentations( void );
+
+    /** An iterator that sets the probabilities of all classes in a region of
+     * the probabilistic segmentations; it does nothing if they are not
+     * generated */
+    virtual ProbabilisticSegmentationIteratorType GetProbabilisticSegmentationIterator(
+      const OutputImageRegionType & region ) const;
+
     /** Print some information, not really implemented */
     void PrintSelf(std::ostream&, Indent) const;
 
@@ -384,6 +500,33 @@ namespace itk
     virtual void AllocateConfusionMatrixArray();
     virtual void InitializeConfusionMatrixArray();
 
+    /** The E and M step for the pixels of a region: accumulate the updated
+     * confusion matrices, not yet normalized. Called by multiple threads. */
+    virtual void AccumulateConfusionMatrices( const OutputImageRegionType & region,
+      std::vector<ConfusionMatrixType> & updatedConfusionMatrixArray ) const;
+
+    /** Split the voxels of a region, inside the mask, in voxels where all
+     * observers agree, which are only counted per label, and undecided voxels,
+     * of which the labels are stored. Called by multiple threads. */
+    virtual void CollectUndecidedVoxels( const OutputImageRegionType & region,
+      UndecidedVoxelLabelsType & undecidedVoxelLabels,
+      UnanimousVoxelCountsType & unanimousVoxelCounts ) const;
+
+    /** The E and M step for a list of undecided voxels. Called by multiple threads. */
+    virtual void AccumulateConfusionMatricesOfUndecidedVoxels(
+      const UndecidedVoxelLabelsType & undecidedVoxelLabels,
+      std::vector<ConfusionMatrixType> & updatedConfusionMatrixArray ) const;
+
+    /** The E and M step for the unanimous voxels: all voxels with the same
+     * label have the same weights, so they are added at once to
+     * m_UpdatedConfusionMatrixArray. */
+    virtual void AddUnanimousVoxels( const UnanimousVoxelCountsType & unanimousVoxelCounts );
+
+    /** Compute the output, and the probabilistic segmentations, for the pixels
+     * of a region. Called by multiple threads. */
+    virtual void GenerateOutputRegion( const OutputImageRegionType & region,
+      const OutputPixelType leastPreferredLabel );
+
     /** The number of different labels found in the input segmentations */
     InputPixelType m_NumberOfClasses;
 
@@ -404,6 +547,8 @@ namespace itk
     std::vector<ConfusionMatrixType>   m_ConfusionMatrixArray;
     std::vector<ConfusionMatrixType>   m_UpdatedConfusionMatrixArray;
     ProbabilisticSegmentationArrayType m_ProbabilisticSegmentationArray;
+    QuantizedProbabilisticSegmentationArrayType m_QuantizedProbabilisticSegmentationArray;
+    ObserverStackPointer               m_ObserverStack;
     PriorPreferenceType                m_PriorPreference;
 
     /** Variables updated during iterating: */
@@ -417,6 +562,7 @@ namespace itk
     /** Settings that can be accessed via the set/get member functions */
     unsigned int m_MaximumNumberOfIterations;
     bool m_GenerateProbabilisticSegmentations;
+    bool m_QuantizeProbabilisticSegmentations;
     WeightsType m_TerminationUpdateThreshold;
     MaskImagePointer m_MaskImage;
     bool m_InitializeWithMajorityVoting;
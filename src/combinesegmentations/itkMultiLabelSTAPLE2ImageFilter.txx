@@ -20,6 +20,7 @@
 
 #include "itkMultiLabelSTAPLE2ImageFilter.h"
 #include "itkLabelVoting2ImageFilter.h"
+#include "itkMultiThreaderBase.h"
 
 #include "vnl/vnl_math.h"
 
@@ -44,6 +45,8 @@ namespace itk
     this->m_NumberOfClasses = 2;
     this->m_MaskImage = 0;
     this->m_InitializeWithMajorityVoting = false;
+    this->m_ObserverStack = 0;
+    this->m_QuantizeProbabilisticSegmentations = false;
   } // end constructor
 
 
@@ -64,15 +67,14 @@ namespace itk
   {
     /** compute the maximum class label from the input data */
     InputPixelType maxLabel = 0;
-    const unsigned int numberOfInputs = this->GetNumberOfInputs();
+    const unsigned int numberOfObservers = this->GetNumberOfObservers();
 
-    for( unsigned int k = 0; k < numberOfInputs; ++k )
+    ObserverLabelsConstIteratorType it = this->GetObserverLabelsIterator(
+      this->GetOutput()->GetRequestedRegion() );
+    for ( it.GoToBegin(); !it.IsAtEnd(); ++it )
     {
-      InputConstIteratorType it
-        ( this->GetInput( k ), this->GetInput( k )->GetBufferedRegion() );
-
-      for ( it.GoToBegin(); !it.IsAtEnd(); ++it )
-        maxLabel = std::max( maxLabel, it.Get() );
+      for( unsigned int k = 0; k < numberOfObservers; ++k )
+        maxLabel = std::max( maxLabel, it.Get( k ) );
     }
 
     return maxLabel;
@@ -85,14 +87,14 @@ namespace itk
     ::AllocateConfusionMatrixArray()
   {
     /**  we need one confusion matrix for every input */
-    const unsigned int numberOfInputs = this->GetNumberOfInputs();
+    const unsigned int numberOfObservers = this->GetNumberOfObservers();
 
     this->m_ConfusionMatrixArray.clear();
     this->m_UpdatedConfusionMatrixArray.clear();
 
     /** create the confusion matrix and space for updated confusion matrix for
      * each of the input images */
-    for( unsigned int k = 0; k < numberOfInputs; ++k )
+    for( unsigned int k = 0; k < numberOfObservers; ++k )
     {
       /** the confusion matrix has as many row/columns as there are input labels,
        * The column nrs correspond to the 'real' class, as estimated by the
@@ -113,16 +115,23 @@ namespace itk
     MultiLabelSTAPLE2ImageFilter< TInputImage, TOutputImage, TWeights >
     ::InitializeConfusionMatrixArray()
   {
-    const unsigned int numberOfInputs = this->GetNumberOfInputs();
+    const unsigned int numberOfObservers = this->GetNumberOfObservers();
 
     if( this->GetInitializeWithMajorityVoting() )
     {
       typedef itk::LabelVoting2ImageFilter<
         InputImageType, OutputImageType, WeightsType>  VotingFilterType;
       typename VotingFilterType::Pointer voting = VotingFilterType::New();
-      for( unsigned int i = 0; i < numberOfInputs; ++i )
+      if( this->m_ObserverStack.IsNotNull() )
+      {
+        voting->SetObserverStack( this->m_ObserverStack );
+      }
+      else
       {
-        voting->SetInput( i, this->GetInput(i) );
+        for( unsigned int i = 0; i < numberOfObservers; ++i )
+        {
+          voting->SetInput( i, this->GetInput(i) );
+        }
       }
       voting->SetNumberOfClasses( this->GetNumberOfClasses() );
       voting->SetObserverTrust( this->GetObserverTrust() );
@@ -131,7 +140,7 @@ namespace itk
       voting->SetGenerateConfusionMatrix( true );
       voting->SetGenerateProbabilisticSegmentations( false );
       voting->Update();
-      for( unsigned int i = 0; i < numberOfInputs; ++i )
+      for( unsigned int i = 0; i < numberOfObservers; ++i )
       {
         this->m_ConfusionMatrixArray[ i ] = voting->GetConfusionMatrix(i);
       }
@@ -142,7 +151,7 @@ namespace itk
       /** Set the trust factor on the diagonal.
       * All off-diagonal elements get an equal value,
       * such that the columns are normalized */
-      for( unsigned int k = 0; k < numberOfInputs; ++k )
+      for( unsigned int k = 0; k < numberOfObservers; ++k )
       {
         this->m_ConfusionMatrixArray[k].Fill( 0.0 );
         const WeightsType trust = this->m_ObserverTrust[k];
@@ -202,34 +211,26 @@ namespace itk
           this->m_MaskImage, this->GetOutput()->GetRequestedRegion() );
       }
 
-      /** Loop over all input images to estimate the prior probabilities */
-      const unsigned int numberOfInputs = this->GetNumberOfInputs();
-      for( unsigned int k = 0; k < numberOfInputs; ++k )
+      /** Loop over all voxels to estimate the prior probabilities */
+      const unsigned int numberOfObservers = this->GetNumberOfObservers();
+      ObserverLabelsConstIteratorType it = this->GetObserverLabelsIterator(
+        this->GetOutput()->GetRequestedRegion() );
+      for ( it.GoToBegin(); ! it.IsAtEnd(); ++it )
       {
-        InputConstIteratorType in = InputConstIteratorType
-          ( this->GetInput( k ), this->GetOutput()->GetRequestedRegion() );
-
-        const WeightsType trust = this->GetObserverTrust()[k];
-
+        bool insideMask = true;
         if( useMask )
         {
-          mit.GoToBegin();
-          for ( in.GoToBegin(); ! in.IsAtEnd(); ++in )
-          {
-            if( mit.Get() != zeroMaskPixel  )
-            {
-              this->m_PriorProbabilities[ in.Get() ] += trust;
-            }
-            ++mit;
-          }
-        } // end use mask
-        else
+          insideMask = mit.Get() != zeroMaskPixel;
+          ++mit;
+        }
+
+        if( insideMask )
         {
-          for ( in.GoToBegin(); ! in.IsAtEnd(); ++in )
+          for( unsigned int k = 0; k < numberOfObservers; ++k )
           {
-            this->m_PriorProbabilities[ in.Get() ] += trust;
+            this->m_PriorProbabilities[ it.Get( k ) ] += this->m_ObserverTrust[k];
           }
-        } // end no mask
+        }
       }
 
       /** Normalize */
@@ -248,20 +249,10 @@ namespace itk
     MultiLabelSTAPLE2ImageFilter< TInputImage, TOutputImage, TWeights >
     ::GenerateData()
   {
-    typedef Array<WeightsType>                  WType;
-    typedef std::vector<InputConstIteratorType> InputConstIteratorArrayType;
-    typedef std::vector<ProbIteratorType>       ProbIteratorArrayType;
-    typedef std::vector<ProbConstIteratorType>  ProbConstIteratorArrayType;
-
     /** Initialize some variables */
     this->m_MaximumConfusionMatrixElementUpdate = 0.0;
     this->m_ElapsedIterations = 0;
-    const bool generateProbSeg =
-      this->GetGenerateProbabilisticSegmentations();
-    const bool useMask = this->m_MaskImage.IsNotNull();
-    const unsigned int numberOfInputs = this->GetNumberOfInputs();
-    WType W( this->m_NumberOfClasses );
-    OutputImagePointer output = this->GetOutput();
+    const unsigned int numberOfObservers = this->GetNumberOfObservers();
     this->AllocateOutputs();
 
     /** Set some default values if necessary */
@@ -279,7 +270,7 @@ namespace itk
     }
     if( !this->m_HasObserverTrust )
     {
-      this->m_ObserverTrust.SetSize( numberOfInputs );
+      this->m_ObserverTrust.SetSize( numberOfObservers );
       this->m_ObserverTrust.Fill(0.99999);
     }
 
@@ -299,29 +290,167 @@ namespace itk
     this->InitializeConfusionMatrixArray();
 
     /** If probabilistic segmentations are desired, allocate them */
-    if( generateProbSeg )
+    this->AllocateProbabilisticSegmentations();
+
+    /** Split the output region in pieces for the threads, each with its
+     * own confusion matrices */
+    std::vector<OutputImageRegionType> pieces;
+    SplitRegionInPieces( this->GetOutput()->GetRequestedRegion(),
+      4 * this->GetNumberOfWorkUnits(), pieces );
+    const unsigned int numberOfPieces = pieces.size();
+    std::vector< std::vector<ConfusionMatrixType> > pieceConfusionMatrixArrays(
+      numberOfPieces, this->m_UpdatedConfusionMatrixArray );
+    MultiThreaderBase * threader = this->GetMultiThreader();
+
+    /** Without prior probability images, the voxels where all observers agree
+     * are only counted per label, and the E and M steps loop over a list of
+     * the voxels where they disagree. */
+    const bool skipUnanimousVoxels = !this->m_HasPriorProbabilityImageArray;
+    std::vector<UndecidedVoxelLabelsType> undecidedVoxelLabels;
+    UnanimousVoxelCountsType unanimousVoxelCounts;
+    if( skipUnanimousVoxels )
     {
-      this->m_ProbabilisticSegmentationArray =
-        ProbabilisticSegmentationArrayType( this->m_NumberOfClasses );
-      for( unsigned int k = 0; k < this->m_NumberOfClasses; ++k )
+      undecidedVoxelLabels.resize( numberOfPieces );
+      std::vector<UnanimousVoxelCountsType> pieceUnanimousVoxelCounts( numberOfPieces );
+      threader->ParallelizeArray( 0, numberOfPieces,
+        [this, &pieces, &undecidedVoxelLabels, &pieceUnanimousVoxelCounts]( SizeValueType piece )
+        {
+          this->CollectUndecidedVoxels( pieces[ piece ],
+            undecidedVoxelLabels[ piece ], pieceUnanimousVoxelCounts[ piece ] );
+        }, nullptr );
+
+      unanimousVoxelCounts.assign( this->m_NumberOfClasses, 0 );
+      for( unsigned int piece = 0; piece < numberOfPieces; ++piece )
       {
-        this->m_ProbabilisticSegmentationArray[k] =
-          ProbabilityImageType::New();
-        this->m_ProbabilisticSegmentationArray[k]->SetRegions(
-          output->GetRequestedRegion() );
-        this->m_ProbabilisticSegmentationArray[k]->CopyInformation( output );
-        this->m_ProbabilisticSegmentationArray[k]->Allocate();
+        for( unsigned int j = 0; j < this->m_NumberOfClasses; ++j )
+        {
+          unanimousVoxelCounts[ j ] += pieceUnanimousVoxelCounts[ piece ][ j ];
+        }
       }
     }
 
-    /** create and initialize all input image iterators */
-    InputConstIteratorArrayType it(numberOfInputs);
-    for( unsigned int k = 0; k < numberOfInputs; ++k )
+    /** Start iterating! */
+    while (  ( !this->m_HasMaximumNumberOfIterations ) ||
+             ( this->m_ElapsedIterations < this->m_MaximumNumberOfIterations )   )
     {
-      it[k] = InputConstIteratorType
-        ( this->GetInput( k ), output->GetRequestedRegion() );
+      /** Do the E and M step for all pixels, in parallel */
+      threader->ParallelizeArray( 0, numberOfPieces,
+        [this, skipUnanimousVoxels, &pieces, &undecidedVoxelLabels,
+          &pieceConfusionMatrixArrays]( SizeValueType piece )
+        {
+          if( skipUnanimousVoxels )
+          {
+            this->AccumulateConfusionMatricesOfUndecidedVoxels(
+              undecidedVoxelLabels[ piece ], pieceConfusionMatrixArrays[ piece ] );
+          }
+          else
+          {
+            this->AccumulateConfusionMatrices(
+              pieces[ piece ], pieceConfusionMatrixArrays[ piece ] );
+          }
+        }, nullptr );
+
+      /** Sum the updated confusion matrices of the pieces */
+      for( unsigned int k = 0; k < numberOfObservers; ++k )
+      {
+        this->m_UpdatedConfusionMatrixArray[k].Fill( 0.0 );
+        for( unsigned int piece = 0; piece < numberOfPieces; ++piece )
+        {
+          this->m_UpdatedConfusionMatrixArray[k] += pieceConfusionMatrixArrays[ piece ][k];
+        }
+      }
+      if( skipUnanimousVoxels )
+      {
+        this->AddUnanimousVoxels( unanimousVoxelCounts );
+      }
+
+      /** Normalize matrix elements of each of the updated confusion matrices
+       * with sum over all expert decisions. */
+      for( unsigned int k = 0; k < numberOfObservers; ++k )
+      {
+        // compute sum over all output classifications
+        for ( OutputPixelType ci = 0; ci < this->m_NumberOfClasses; ++ci )
+        {
+          WeightsType sumW = this->m_UpdatedConfusionMatrixArray[k][0][ci];
+          for ( InputPixelType j = 1; j < this->m_NumberOfClasses; ++j )
+          {
+            sumW += this->m_UpdatedConfusionMatrixArray[k][j][ci];
+          }
+
+          // normalize with sumW for each class ci
+          if( sumW )
+          {
+            this->m_UpdatedConfusionMatrixArray[k].scale_column(ci, 1.0/sumW);
+          }
+        }
+      } // end for k: end normalization of updated confusion matrix
+
+      // now we're applying the update to the confusion matrices and compute the
+      // maximum parameter change in the process, to check for convergence.
+      WeightsType maximumUpdate = 0;
+      for( unsigned int k = 0; k < numberOfObservers; ++k )
+      {
+        const WeightsType maximumUpdate_k = static_cast<WeightsType>(
+          (this->m_UpdatedConfusionMatrixArray[k]-this->m_ConfusionMatrixArray[k]).array_inf_norm() );
+        maximumUpdate = std::max( maximumUpdate, maximumUpdate_k );
+
+        this->m_ConfusionMatrixArray[k] = this->m_UpdatedConfusionMatrixArray[k];
+      }
+      this->m_MaximumConfusionMatrixElementUpdate = maximumUpdate;
+
+      /** We have finished this iteration */
+      ++(this->m_ElapsedIterations);
+
+      /** Allow user to do something */
+      this->InvokeEvent( IterationEvent() );
+      if( this->GetAbortGenerateData() )
+      {
+        this->ResetPipeline();
+        // fake this to cause termination; we could really just break
+        maximumUpdate = 0;
+      }
+
+      // if all confusion matrix parameters changes by less than the defined
+      // threshold, we're done.
+      if( maximumUpdate < this->m_TerminationUpdateThreshold )
+        break;
+
+    } // end for ( iteration )
+
+
+    /** now we'll build the combined output image based on the estimated
+     * confusion matrices, in parallel */
+    threader->ParallelizeArray( 0, numberOfPieces,
+      [this, &pieces, leastPreferredLabel]( SizeValueType piece )
+      {
+        this->GenerateOutputRegion( pieces[ piece ], leastPreferredLabel );
+      }, nullptr );
+
+  } // end GenerateData
+
+
+  template< typename TInputImage, typename TOutputImage, typename TWeights >
+    void
+    MultiLabelSTAPLE2ImageFilter< TInputImage, TOutputImage, TWeights >
+    ::AccumulateConfusionMatrices( const OutputImageRegionType & region,
+      std::vector<ConfusionMatrixType> & updatedConfusionMatrixArray ) const
+  {
+    typedef Array<WeightsType>                  WType;
+    typedef std::vector<ProbConstIteratorType>  ProbConstIteratorArrayType;
+
+    const bool useMask = this->m_MaskImage.IsNotNull();
+    const unsigned int numberOfObservers = this->GetNumberOfObservers();
+    WType W( this->m_NumberOfClasses );
+
+    /** reset updated confusion matrix */
+    for( unsigned int k = 0; k < numberOfObservers; ++k )
+    {
+      updatedConfusionMatrixArray[k].Fill( 0.0 );
     }
 
+    /** create and initialize the iterator over the labels of all observers */
+    ObserverLabelsConstIteratorType it = this->GetObserverLabelsIterator( region );
+
     /** Create and initialize the prior prob image iterators */
     ProbConstIteratorArrayType pit;
     if( this->m_HasPriorProbabilityImageArray )
@@ -329,20 +458,7 @@ namespace itk
       pit = ProbConstIteratorArrayType( this->m_NumberOfClasses );
       for( unsigned int k = 0; k < this->m_NumberOfClasses; ++k )
       {
-        pit[k] = ProbConstIteratorType(
-          this->m_PriorProbabilityImageArray[k], output->GetRequestedRegion() );
-      }
-    }
-
-    /** Create and initialize the output probabilistic segmentation image iterators */
-    ProbIteratorArrayType psit;
-    if( generateProbSeg )
-    {
-      psit = ProbIteratorArrayType( this->m_NumberOfClasses );
-      for( unsigned int k = 0; k < this->m_NumberOfClasses; ++k )
-      {
-        psit[k] = ProbIteratorType(
-          this->m_ProbabilisticSegmentationArray[k], output->GetRequestedRegion() );
+        pit[k] = ProbConstIteratorType( this->m_PriorProbabilityImageArray[k], region );
       }
     }
 
@@ -351,173 +467,286 @@ namespace itk
     const MaskPixelType zeroMaskPixel = itk::NumericTraits<MaskPixelType>::Zero;
     if( useMask )
     {
-      mit = MaskConstIteratorType(
-        this->m_MaskImage, this->GetOutput()->GetRequestedRegion() );
+      mit = MaskConstIteratorType( this->m_MaskImage, region );
     }
 
-    /** Create and initialize the output iterator */
-    OutputIteratorType out = OutputIteratorType( output, output->GetRequestedRegion() );
-
-    /** Start iterating! */
-    while (  ( !this->m_HasMaximumNumberOfIterations ) ||
-             ( this->m_ElapsedIterations < this->m_MaximumNumberOfIterations )   )
+    /** Loop over voxels and do the E and M step */
+    while ( ! it.IsAtEnd() )
     {
-      /** reset updated confusion matrix */
-      for( unsigned int k = 0; k < numberOfInputs; ++k )
-      {
-        this->m_UpdatedConfusionMatrixArray[k].Fill( 0.0 );
-      }
-
-      /** Loop over voxels and do the E and M step
-       * use it[0] as indicator for image pixel count */
-      while ( ! it[0].IsAtEnd() )
+      if(useMask)
       {
-        if(useMask)
+        if( mit.Get() == zeroMaskPixel )
         {
-          if( mit.Get() == zeroMaskPixel )
+          /** Move all iterators to the next pixel and go to the
+           * next cycle of the while loop */
+          ++mit;
+          ++it;
+          if( this->m_HasPriorProbabilityImageArray )
           {
-            /** Move all iterators to the next pixel and go to the
-             * next cycle of the while loop */
-            ++mit;
-            for( unsigned int k = 0; k < numberOfInputs; ++k )
-            {
-              ++(it[k]);
-            }
-            if( this->m_HasPriorProbabilityImageArray )
+            for ( OutputPixelType ci = 0; ci < this->m_NumberOfClasses; ++ci )
             {
-              for ( OutputPixelType ci = 0; ci < this->m_NumberOfClasses; ++ci )
-              {
-                ++(pit[ci]);
-              }
+              ++(pit[ci]);
             }
-            continue;
-          } // end if mit==zero
-          /** Move the iterator to the next pixel */
-          ++mit;
-        } // end if useMask
+          }
+          continue;
+        } // end if mit==zero
+        /** Move the iterator to the next pixel */
+        ++mit;
+      } // end if useMask
 
-        /** the following is the E step for one pixel, only performed when this
-         * pixel is inside the mask */
-        if( this->m_HasPriorProbabilityImageArray )
+      /** the following is the E step for one pixel, only performed when this
+       * pixel is inside the mask */
+      if( this->m_HasPriorProbabilityImageArray )
+      {
+        for ( OutputPixelType ci = 0; ci < this->m_NumberOfClasses; ++ci )
         {
-          for ( OutputPixelType ci = 0; ci < this->m_NumberOfClasses; ++ci )
-          {
-            W[ci] = pit[ci].Get();
-            /** move already to next pixel */
-            ++(pit[ci]);
-          }
+          W[ci] = pit[ci].Get();
+          /** move already to next pixel */
+          ++(pit[ci]);
         }
-        else
+      }
+      else
+      {
+        W = this->m_PriorProbabilities;
+      }
+
+      for( unsigned int k = 0; k < numberOfObservers; ++k )
+      {
+        const InputPixelType j = it.Get( k );
+        for ( OutputPixelType ci = 0; ci < this->m_NumberOfClasses; ++ci )
         {
-          W = this->m_PriorProbabilities;
+          W[ci] *= this->m_ConfusionMatrixArray[k][j][ci];
         }
+      }
 
-        for( unsigned int k = 0; k < numberOfInputs; ++k )
+      // the following is the M step
+      /** normalize: */
+      WeightsType sumW = W.sum();
+      if( sumW )
+      {
+        W /= sumW;
+      }
+
+      for( unsigned int k = 0; k < numberOfObservers; ++k )
+      {
+        const InputPixelType j = it.Get( k );
+        for ( OutputPixelType ci = 0; ci < this->m_NumberOfClasses; ++ci )
         {
-          const InputPixelType j = it[k].Get();
-          for ( OutputPixelType ci = 0; ci < this->m_NumberOfClasses; ++ci )
-          {
-            W[ci] *= this->m_ConfusionMatrixArray[k][j][ci];
-          }
+          updatedConfusionMatrixArray[k][j][ci] += W[ci];
         }
+      }
 
-        // the following is the M step
-        /** normalize: */
-        WeightsType sumW = W.sum();
-        if( sumW )
+      // we're now done with this input pixel, so update.
+      ++it;
+
+    } // end loop over voxels
+
+  } // end AccumulateConfusionMatrices
+
+
+  template< typename TInputImage, typename TOutputImage, typename TWeights >
+    void
+    MultiLabelSTAPLE2ImageFilter< TInputImage, TOutputImage, TWeights >
+    ::CollectUndecidedVoxels( const OutputImageRegionType & region,
+      UndecidedVoxelLabelsType & undecidedVoxelLabels,
+      UnanimousVoxelCountsType & unanimousVoxelCounts ) const
+  {
+
+    const bool useMask = this->m_MaskImage.IsNotNull();
+    const unsigned int numberOfObservers = this->GetNumberOfObservers();
+
+    undecidedVoxelLabels.assign( numberOfObservers, std::vector<InputPixelType>() );
+    unanimousVoxelCounts.assign( this->m_NumberOfClasses, 0 );
+
+    /** create and initialize the iterator over the labels of all observers */
+    ObserverLabelsConstIteratorType it = this->GetObserverLabelsIterator( region );
+
+    /** Create and initialize the mask iterator */
+    MaskConstIteratorType mit;
+    const MaskPixelType zeroMaskPixel = itk::NumericTraits<MaskPixelType>::Zero;
+    if( useMask )
+    {
+      mit = MaskConstIteratorType( this->m_MaskImage, region );
+    }
+
+    /** Loop over voxels */
+    while ( ! it.IsAtEnd() )
+    {
+      bool insideMask = true;
+      if( useMask )
+      {
+        insideMask = mit.Get() != zeroMaskPixel;
+        ++mit;
+      }
+
+      if( insideMask )
+      {
+        /** Check whether all observers agree */
+        const InputPixelType firstLabel = it.Get( 0 );
+        bool unanimous = true;
+        for( unsigned int k = 1; k < numberOfObservers && unanimous; ++k )
         {
-          W /= sumW;
+          unanimous = it.Get( k ) == firstLabel;
         }
 
-        for( unsigned int k = 0; k < numberOfInputs; ++k )
+        if( unanimous )
         {
-          const InputPixelType j = it[k].Get();
-          for ( OutputPixelType ci = 0; ci < this->m_NumberOfClasses; ++ci )
+          ++unanimousVoxelCounts[ firstLabel ];
+        }
+        else
+        {
+          for( unsigned int k = 0; k < numberOfObservers; ++k )
           {
-            this->m_UpdatedConfusionMatrixArray[k][j][ci] += W[ci];
+            undecidedVoxelLabels[k].push_back( it.Get( k ) );
           }
-
-          // we're now done with this input pixel, so update.
-          ++(it[k]);
         }
+      } // end if insideMask
 
-      } // end loop over voxels
+      ++it;
 
-      /** Normalize matrix elements of each of the updated confusion matrices
-       * with sum over all expert decisions. */
-      for( unsigned int k = 0; k < numberOfInputs; ++k )
+    } // end loop over voxels
+
+  } // end CollectUndecidedVoxels
+
+
+  template< typename TInputImage, typename TOutputImage, typename TWeights >
+    void
+    MultiLabelSTAPLE2ImageFilter< TInputImage, TOutputImage, TWeights >
+    ::AccumulateConfusionMatricesOfUndecidedVoxels(
+      const UndecidedVoxelLabelsType & undecidedVoxelLabels,
+      std::vector<ConfusionMatrixType> & updatedConfusionMatrixArray ) const
+  {
+    typedef Array<WeightsType>                  WType;
+
+    const unsigned int numberOfObservers = this->GetNumberOfObservers();
+    const SizeValueType numberOfUndecidedVoxels = undecidedVoxelLabels[0].size();
+    WType W( this->m_NumberOfClasses );
+
+    /** reset updated confusion matrix */
+    for( unsigned int k = 0; k < numberOfObservers; ++k )
+    {
+      updatedConfusionMatrixArray[k].Fill( 0.0 );
+    }
+
+    /** Loop over the undecided voxels and do the E and M step */
+    for( SizeValueType v = 0; v < numberOfUndecidedVoxels; ++v )
+    {
+      /** the E step */
+      W = this->m_PriorProbabilities;
+      for( unsigned int k = 0; k < numberOfObservers; ++k )
       {
-        // compute sum over all output classifications
+        const WeightsType * confusion = this->m_ConfusionMatrixArray[k][ undecidedVoxelLabels[k][v] ];
         for ( OutputPixelType ci = 0; ci < this->m_NumberOfClasses; ++ci )
         {
-          WeightsType sumW = this->m_UpdatedConfusionMatrixArray[k][0][ci];
-          for ( InputPixelType j = 1; j < this->m_NumberOfClasses; ++j )
-          {
-            sumW += this->m_UpdatedConfusionMatrixArray[k][j][ci];
-          }
-
-          // normalize with sumW for each class ci
-          if( sumW )
-          {
-            this->m_UpdatedConfusionMatrixArray[k].scale_column(ci, 1.0/sumW);
-          }
+          W[ci] *= confusion[ ci ];
         }
-      } // end for k: end normalization of updated confusion matrix
+      }
 
-      // now we're applying the update to the confusion matrices and compute the
-      // maximum parameter change in the process, to check for convergence.
-      WeightsType maximumUpdate = 0;
-      for( unsigned int k = 0; k < numberOfInputs; ++k )
+      /** the M step */
+      WeightsType sumW = W.sum();
+      if( sumW )
       {
-        const WeightsType maximumUpdate_k = static_cast<WeightsType>(
-          (this->m_UpdatedConfusionMatrixArray[k]-this->m_ConfusionMatrixArray[k]).array_inf_norm() );
-        maximumUpdate = std::max( maximumUpdate, maximumUpdate_k );
+        W /= sumW;
+      }
 
-        this->m_ConfusionMatrixArray[k] = this->m_UpdatedConfusionMatrixArray[k];
+      for( unsigned int k = 0; k < numberOfObservers; ++k )
+      {
+        WeightsType * updatedConfusion = updatedConfusionMatrixArray[k][ undecidedVoxelLabels[k][v] ];
+        for ( OutputPixelType ci = 0; ci < this->m_NumberOfClasses; ++ci )
+        {
+          updatedConfusion[ ci ] += W[ci];
+        }
       }
-      this->m_MaximumConfusionMatrixElementUpdate = maximumUpdate;
+    } // end loop over undecided voxels
 
-      /** We have finished this iteration */
-      ++(this->m_ElapsedIterations);
+  } // end AccumulateConfusionMatricesOfUndecidedVoxels
 
-      /** reset all input iterators to start, to be prepared for next iteration
-       * or for generating the final segmentation, if the current iteration
-       * happened to be the last one */
-      if(useMask)
+
+  template< typename TInputImage, typename TOutputImage, typename TWeights >
+    void
+    MultiLabelSTAPLE2ImageFilter< TInputImage, TOutputImage, TWeights >
+    ::AddUnanimousVoxels( const UnanimousVoxelCountsType & unanimousVoxelCounts )
+  {
+    typedef Array<WeightsType>                  WType;
+
+    const unsigned int numberOfObservers = this->GetNumberOfObservers();
+    WType W( this->m_NumberOfClasses );
+
+    for( unsigned int j = 0; j < this->m_NumberOfClasses; ++j )
+    {
+      if( unanimousVoxelCounts[ j ] == 0 ) continue;
+
+      /** the E step, for all voxels labeled j by all observers */
+      W = this->m_PriorProbabilities;
+      for( unsigned int k = 0; k < numberOfObservers; ++k )
       {
-        mit.GoToBegin();
+        for ( OutputPixelType ci = 0; ci < this->m_NumberOfClasses; ++ci )
+        {
+          W[ci] *= this->m_ConfusionMatrixArray[k][j][ci];
+        }
       }
-      for( unsigned int k = 0; k < numberOfInputs; ++k )
+
+      /** the M step, multiplied by the number of voxels */
+      WeightsType sumW = W.sum();
+      if( sumW )
       {
-        it[k].GoToBegin();
+        W /= sumW;
       }
-      if( this->m_HasPriorProbabilityImageArray )
+      W *= static_cast<WeightsType>( unanimousVoxelCounts[ j ] );
+
+      for( unsigned int k = 0; k < numberOfObservers; ++k )
       {
-        for( unsigned int k = 0; k < this->m_NumberOfClasses; ++k )
+        for ( OutputPixelType ci = 0; ci < this->m_NumberOfClasses; ++ci )
         {
-          pit[k].GoToBegin();
+          this->m_UpdatedConfusionMatrixArray[k][j][ci] += W[ci];
         }
       }
+    } // end for j
 
-      /** Allow user to do something */
-      this->InvokeEvent( IterationEvent() );
-      if( this->GetAbortGenerateData() )
+  } // end AddUnanimousVoxels
+
+
+  template< typename TInputImage, typename TOutputImage, typename TWeights >
+    void
+    MultiLabelSTAPLE2ImageFilter< TInputImage, TOutputImage, TWeights >
+    ::GenerateOutputRegion( const OutputImageRegionType & region,
+      const OutputPixelType leastPreferredLabel )
+  {
+    typedef Array<WeightsType>                  WType;
+    typedef std::vector<ProbConstIteratorType>  ProbConstIteratorArrayType;
+
+    const bool useMask = this->m_MaskImage.IsNotNull();
+    const unsigned int numberOfObservers = this->GetNumberOfObservers();
+    WType W( this->m_NumberOfClasses );
+
+    /** create and initialize the iterator over the labels of all observers */
+    ObserverLabelsConstIteratorType it = this->GetObserverLabelsIterator( region );
+
+    /** Create and initialize the prior prob image iterators */
+    ProbConstIteratorArrayType pit;
+    if( this->m_HasPriorProbabilityImageArray )
+    {
+      pit = ProbConstIteratorArrayType( this->m_NumberOfClasses );
+      for( unsigned int k = 0; k < this->m_NumberOfClasses; ++k )
       {
-        this->ResetPipeline();
-        // fake this to cause termination; we could really just break
-        maximumUpdate = 0;
+        pit[k] = ProbConstIteratorType( this->m_PriorProbabilityImageArray[k], region );
       }
+    }
 
-      // if all confusion matrix parameters changes by less than the defined
-      // threshold, we're done.
-      if( maximumUpdate < this->m_TerminationUpdateThreshold )
-        break;
-
-    } // end for ( iteration )
+    /** Create and initialize the output probabilistic segmentation image iterator */
+    ProbabilisticSegmentationIteratorType psit =
+      this->GetProbabilisticSegmentationIterator( region );
 
+    /** Create and initialize the mask iterator */
+    MaskConstIteratorType mit;
+    const MaskPixelType zeroMaskPixel = itk::NumericTraits<MaskPixelType>::Zero;
+    if( useMask )
+    {
+      mit = MaskConstIteratorType( this->m_MaskImage, region );
+    }
 
-    /** now we'll build the combined output image based on the estimated
-     * confusion matrices */
+    /** Create and initialize the output iterator */
+    OutputIteratorType out = OutputIteratorType( this->GetOutput(), region );
     for ( out.GoToBegin(); !out.IsAtEnd(); ++out )
     {
       OutputPixelType winningLabel = leastPreferredLabel;
@@ -531,7 +760,7 @@ namespace itk
         {
           insideMask = false;
           W.Fill( 0.0 );
-          winningLabel = it[0].Get();
+          winningLabel = it.Get( 0 );
           W[ winningLabel ] = 1.0;
           /** Set the winning label to the output pixel */
           out.Set( winningLabel );
@@ -543,10 +772,7 @@ namespace itk
               ++(pit[ci]);
             }
           }
-          for( unsigned int k = 0; k < numberOfInputs; ++k )
-          {
-            ++(it[k]);
-          }
+          ++it;
         } // if mit==zero
         ++mit;
       } // end if useMask
@@ -567,15 +793,15 @@ namespace itk
           W = this->m_PriorProbabilities;
         }
 
-        for( unsigned int k = 0; k < numberOfInputs; ++k )
+        for( unsigned int k = 0; k < numberOfObservers; ++k )
         {
-          const InputPixelType j = it[k].Get();
+          const InputPixelType j = it.Get( k );
           for ( OutputPixelType ci = 0; ci < this->m_NumberOfClasses; ++ci )
           {
             W[ci] *= this->m_ConfusionMatrixArray[k][j][ci];
           }
-          ++(it[k]);
         }
+        ++it;
 
         /** normalize: */
         WeightsType sumW = W.sum();
@@ -611,19 +837,75 @@ namespace itk
 
 
       /** copy the W values into the probabilistic segmentation images
-       * and move the psit iterators */
-      if( generateProbSeg )
-      {
-        for ( OutputPixelType ci = 0; ci < this->m_NumberOfClasses; ++ci )
-        {
-          psit[ci].Set( W[ci] );
-          ++(psit[ci]);
-        }
-      }
+       * and move the psit iterator */
+      psit.SetProbabilities( W );
 
     } // end loop over output pixels
 
-  } // end GenerateData
+  } // end GenerateOutputRegion
+
+
+  template< typename TInputImage, typename TOutputImage, typename TWeights >
+    void
+    MultiLabelSTAPLE2ImageFilter< TInputImage, TOutputImage, TWeights >
+    ::GenerateOutputInformation()
+  {
+    if( this->m_ObserverStack.IsNull() )
+    {
+      Superclass::GenerateOutputInformation();
+      return;
+    }
+
+    /** Without input images, the output gets the geometry of the stack */
+    this->GetOutput()->CopyInformation( this->m_ObserverStack );
+  } // end GenerateOutputInformation
+
+
+  template< typename TInputImage, typename TOutputImage, typename TWeights >
+    typename MultiLabelSTAPLE2ImageFilter< TInputImage, TOutputImage, TWeights >
+      ::ObserverLabelsConstIteratorType
+    MultiLabelSTAPLE2ImageFilter< TInputImage, TOutputImage, TWeights >
+    ::GetObserverLabelsIterator( const OutputImageRegionType & region ) const
+  {
+    if( this->m_ObserverStack.IsNotNull() )
+    {
+      return ObserverLabelsConstIteratorType( this->m_ObserverStack, region );
+    }
+
+    typename ObserverLabelsConstIteratorType::LabelImageArrayType
+      labelImages( this->GetNumberOfInputs() );
+    for( unsigned int k = 0; k < labelImages.size(); ++k )
+    {
+      labelImages[k] = this->GetInput( k );
+    }
+    return ObserverLabelsConstIteratorType( labelImages, region );
+  } // end GetObserverLabelsIterator
+
+
+  template< typename TInputImage, typename TOutputImage, typename TWeights >
+    void
+    MultiLabelSTAPLE2ImageFilter< TInputImage, TOutputImage, TWeights >
+    ::AllocateProbabilisticSegmentations( void )
+  {
+    const unsigned int numberOfClasses =
+      this->m_GenerateProbabilisticSegmentations ? this->m_NumberOfClasses : 0;
+    ProbabilisticSegmentationIteratorType::Allocate( numberOfClasses,
+      this->m_QuantizeProbabilisticSegmentations, this->GetOutput(),
+      this->m_ProbabilisticSegmentationArray,
+      this->m_QuantizedProbabilisticSegmentationArray );
+  } // end AllocateProbabilisticSegmentations
+
+
+  template< typename TInputImage, typename TOutputImage, typename TWeights >
+    typename MultiLabelSTAPLE2ImageFilter< TInputImage, TOutputImage, TWeights >
+      ::ProbabilisticSegmentationIteratorType
+    MultiLabelSTAPLE2ImageFilter< TInputImage, TOutputImage, TWeights >
+    ::GetProbabilisticSegmentationIterator( const OutputImageRegionType & region ) const
+  {
+    return ProbabilisticSegmentationIteratorType(
+      this->m_ProbabilisticSegmentationArray,
+      this->m_QuantizedProbabilisticSegmentationArray, region );
+  } // end GetProbabilisticSegmentationIterator
 
 } // end namespace itk
 
@@ -27,6 +27,7 @@
 #include <vector>
 #include "itkArray.h"
 #include "itkArray2D.h"
+#include "itkSplitRegionInPieces.h"
 
 namespace itk
 {
@@ -102,6 +103,9 @@ namespace itk
   * after a smaller number of iterations if the termination threshold criterion
   * is satisfied.
   *
+  * \par THREADING
+  * As in MultiLabelSTAPLE2ImageFilter, see SplitRegionInPieces().
+  *
   * \par EVENTS
   * This filter invokes IterationEvent() at each iteration of the E-M
   * algorithm. Setting the AbortGenerateData() flag will cause the algorithm to
@@ -291,6 +295,14 @@ namespace itk
     void AllocateConfusionMatrixArray();
     void InitializeConfusionMatrixArrayFromVoting();
 
+    // the E and M step for the pixels of a region: accumulate the updated
+    // confusion matrices, not yet normalized; called by multiple threads
+    void AccumulateConfusionMatrices( const OutputImageRegionType & region,
+      std::vector<ConfusionMatrixType> & updatedConfusionMatrixArray ) const;
+
+    // compute the output for the pixels of a region; called by multiple threads
+    void GenerateOutputRegion( const OutputImageRegionType & region );
+
     bool m_HasMaximumNumberOfIterations;
     unsigned int m_MaximumNumberOfIterations;
 
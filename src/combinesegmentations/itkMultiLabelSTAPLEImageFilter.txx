@@ -21,6 +21,7 @@
 #include "itkMultiLabelSTAPLEImageFilter.h"
 
 #include "itkLabelVotingImageFilter.h"
+#include "itkMultiThreaderBase.h"
 
 #include "vnl/vnl_math.h"
 
@@ -218,67 +219,36 @@ namespace itk
     // Record the number of input files.
     const unsigned int numberOfInputs = this->GetNumberOfInputs();
 
-    // create and initialize all input image iterators
-    InputConstIteratorType *it = new InputConstIteratorType[numberOfInputs];
-    for( unsigned int k = 0; k < numberOfInputs; ++k )
-    {
-      it[k] = InputConstIteratorType
-        ( this->GetInput( k ), output->GetRequestedRegion() );
-    }
-
-    // allocate array for pixel class weights
-    WeightsType* W = new WeightsType[ this->m_TotalLabelCount ];
+    // split the output region in pieces for the threads, each with its own
+    // confusion matrices
+    std::vector<OutputImageRegionType> pieces;
+    SplitRegionInPieces( output->GetRequestedRegion(),
+      4 * this->GetNumberOfWorkUnits(), pieces );
+    const unsigned int numberOfPieces = pieces.size();
+    std::vector< std::vector<ConfusionMatrixType> > pieceConfusionMatrixArrays(
+      numberOfPieces, this->m_UpdatedConfusionMatrixArray );
+    MultiThreaderBase * threader = this->GetMultiThreader();
 
     for( unsigned int iteration = 0;
       (!this->m_HasMaximumNumberOfIterations) ||
       (iteration < this->m_MaximumNumberOfIterations);
     ++iteration )
     {
-      // reset updated confusion matrix
-      for( unsigned int k = 0; k < numberOfInputs; ++k )
-      {
-        this->m_UpdatedConfusionMatrixArray[k].Fill( 0.0 );
-      }
+      // the E and M step for all pixels, in parallel
+      threader->ParallelizeArray( 0, numberOfPieces,
+        [this, &pieces, &pieceConfusionMatrixArrays]( SizeValueType piece )
+        {
+          this->AccumulateConfusionMatrices(
+            pieces[ piece ], pieceConfusionMatrixArrays[ piece ] );
+        }, nullptr );
 
-      // reset all input iterators to start
+      // sum the updated confusion matrices of the pieces
       for( unsigned int k = 0; k < numberOfInputs; ++k )
-        it[k].GoToBegin();
-
-      // use it[0] as indicator for image pixel count
-      while ( ! it[0].IsAtEnd() )
       {
-        // the following is the E step
-        for ( OutputPixelType ci = 0; ci < this->m_TotalLabelCount; ++ci )
-          W[ci] = this->m_PriorProbabilities[ci];
-
-        for( unsigned int k = 0; k < numberOfInputs; ++k )
-        {
-          const InputPixelType j = it[k].Get();
-          for ( OutputPixelType ci = 0; ci < this->m_TotalLabelCount; ++ci )
-          {
-            W[ci] *= this->m_ConfusionMatrixArray[k][j][ci];
-          }
-        }
-
-        // the following is the M step
-        WeightsType sumW = W[0];
-        for ( OutputPixelType ci = 1; ci < this->m_TotalLabelCount; ++ci )
-          sumW += W[ci];
-
-        if( sumW )
-        {
-          for ( OutputPixelType ci = 0; ci < this->m_TotalLabelCount; ++ci )
-            W[ci] /= sumW;
-        }
-
-        for( unsigned int k = 0; k < numberOfInputs; ++k )
+        this->m_UpdatedConfusionMatrixArray[k].Fill( 0.0 );
+        for( unsigned int piece = 0; piece < numberOfPieces; ++piece )
         {
-          const InputPixelType j = it[k].Get();
-          for ( OutputPixelType ci = 0; ci < this->m_TotalLabelCount; ++ci )
-            this->m_UpdatedConfusionMatrixArray[k][j][ci] += W[ci];
-
-          // we're now done with this input pixel, so update.
-          ++(it[k]);
+          this->m_UpdatedConfusionMatrixArray[k] += pieceConfusionMatrixArrays[ piece ][k];
         }
       }
 
@@ -335,14 +305,95 @@ namespace itk
     } // end for ( iteration )
 
     // now we'll build the combined output image based on the estimated
-    // confusion matrices
+    // confusion matrices, in parallel
+    threader->ParallelizeArray( 0, numberOfPieces,
+      [this, &pieces]( SizeValueType piece )
+      {
+        this->GenerateOutputRegion( pieces[ piece ] );
+      }, nullptr );
+  }
 
-    // reset all input iterators to start
+  template< typename TInputImage, typename TOutputImage, typename TWeights >
+    void
+    MultiLabelSTAPLEImageFilter< TInputImage, TOutputImage, TWeights >
+    ::AccumulateConfusionMatrices( const OutputImageRegionType & region,
+      std::vector<ConfusionMatrixType> & updatedConfusionMatrixArray ) const
+  {
+    const unsigned int numberOfInputs = this->GetNumberOfInputs();
+
+    // reset updated confusion matrix
     for( unsigned int k = 0; k < numberOfInputs; ++k )
-      it[k].GoToBegin();
+    {
+      updatedConfusionMatrixArray[k].Fill( 0.0 );
+    }
 
-    // reset output iterator to start
-    OutputIteratorType out = OutputIteratorType( output, output->GetRequestedRegion() );
+    // create and initialize all input image iterators
+    std::vector<InputConstIteratorType> it( numberOfInputs );
+    for( unsigned int k = 0; k < numberOfInputs; ++k )
+    {
+      it[k] = InputConstIteratorType( this->GetInput( k ), region );
+    }
+
+    // array for pixel class weights
+    std::vector<WeightsType> W( this->m_TotalLabelCount );
+
+    // use it[0] as indicator for image pixel count
+    while ( ! it[0].IsAtEnd() )
+    {
+      // the following is the E step
+      for ( OutputPixelType ci = 0; ci < this->m_TotalLabelCount; ++ci )
+        W[ci] = this->m_PriorProbabilities[ci];
+
+      for( unsigned int k = 0; k < numberOfInputs; ++k )
+      {
+        const InputPixelType j = it[k].Get();
+        for ( OutputPixelType ci = 0; ci < this->m_TotalLabelCount; ++ci )
+        {
+          W[ci] *= this->m_ConfusionMatrixArray[k][j][ci];
+        }
+      }
+
+      // the following is the M step
+      WeightsType sumW = W[0];
+      for ( OutputPixelType ci = 1; ci < this->m_TotalLabelCount; ++ci )
+        sumW += W[ci];
+
+      if( sumW )
+      {
+        for ( OutputPixelType ci = 0; ci < this->m_TotalLabelCount; ++ci )
+          W[ci] /= sumW;
+      }
+
+      for( unsigned int k = 0; k < numberOfInputs; ++k )
+      {
+        const InputPixelType j = it[k].Get();
+        for ( OutputPixelType ci = 0; ci < this->m_TotalLabelCount; ++ci )
+          updatedConfusionMatrixArray[k][j][ci] += W[ci];
+
+        // we're now done with this input pixel, so update.
+        ++(it[k]);
+      }
+    }
+  }
+
+  template< typename TInputImage, typename TOutputImage, typename TWeights >
+    void
+    MultiLabelSTAPLEImageFilter< TInputImage, TOutputImage, TWeights >
+    ::GenerateOutputRegion( const OutputImageRegionType & region )
+  {
+    const unsigned int numberOfInputs = this->GetNumberOfInputs();
+
+    // create and initialize all input image iterators
+    std::vector<InputConstIteratorType> it( numberOfInputs );
+    for( unsigned int k = 0; k < numberOfInputs; ++k )
+    {
+      it[k] = InputConstIteratorType( this->GetInput( k ), region );
+    }
+
+    // array for pixel class weights
+    std::vector<WeightsType> W( this->m_TotalLabelCount );
+
+    OutputIteratorType out = OutputIteratorType( this->GetOutput(), region );
     for ( out.GoToBegin(); !out.IsAtEnd(); ++out )
     {
       // basically, we'll repeat the E step from above
@@ -378,9 +429,6 @@ namespace itk
 
       out.Set( winningLabel );
     }
-
-    delete[] W;
-    delete[] it;
   }
 
 } // end namespace itk
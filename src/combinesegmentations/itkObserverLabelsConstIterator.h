@@ -0,0 +1,181 @@
+/*=========================================================================
+*
+* Copyright Marius Staring, Stefan Klein, David Doria. 2011.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0.txt
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*=========================================================================*/
+#ifndef __itkObserverLabelsConstIterator_h_
+#define __itkObserverLabelsConstIterator_h_
+
+#include "itkImageRegionConstIterator.h"
+#include "itkVectorImage.h"
+
+#include <vector>
+
+namespace itk
+{
+  /** \class ObserverLabelsConstIterator
+  *
+  * \brief Iterates over a region of a set of segmentations, and gives at
+  * each voxel the labels of all observers.
+  *
+  * The labels are read either from one label image per observer, or from an
+  * observer stack: a VectorImage of unsigned char, which stores the labels
+  * of all observers interleaved per voxel. The stack needs one byte per
+  * observer per voxel, whatever the pixel type of the label images, and the
+  * labels of a voxel are adjacent in memory, so iterating over the stack
+  * reads one stream instead of one per observer.
+  */
+  template <typename TLabelImage>
+  class ObserverLabelsConstIterator
+  {
+  public:
+    /** Standard class typedefs. */
+    typedef ObserverLabelsConstIterator Self;
+
+    /** Image typedef support */
+    typedef TLabelImage                                 LabelImageType;
+    typedef typename LabelImageType::PixelType          LabelType;
+    typedef typename LabelImageType::RegionType         RegionType;
+    typedef std::vector<const LabelImageType *>         LabelImageArrayType;
+
+    /** The observer stack */
+    typedef unsigned char                               ObserverLabelType;
+    typedef VectorImage<
+      ObserverLabelType, LabelImageType::ImageDimension > ObserverStackType;
+
+    /** Iterator types. */
+    typedef ImageRegionConstIterator< LabelImageType >    LabelIteratorType;
+    typedef ImageRegionConstIterator< ObserverStackType > StackIteratorType;
+
+    /** Default constructor, needed for arrays of iterators. */
+    ObserverLabelsConstIterator() : m_UseStack( false ) {}
+
+    /** Iterate over a region of one label image per observer */
+    ObserverLabelsConstIterator( const LabelImageArrayType & labelImages,
+      const RegionType & region ) : m_UseStack( false )
+    {
+      this->m_LabelIterators.resize( labelImages.size() );
+      for( unsigned int k = 0; k < labelImages.size(); ++k )
+      {
+        this->m_LabelIterators[k] = LabelIteratorType( labelImages[k], region );
+      }
+      this->m_Labels.resize( labelImages.size() );
+      this->ReadLabels();
+    }
+
+    /** Iterate over a region of an observer stack */
+    ObserverLabelsConstIterator( const ObserverStackType * stack,
+      const RegionType & region ) : m_UseStack( true )
+    {
+      this->m_StackIterator = StackIteratorType( stack, region );
+      this->m_Labels.resize( stack->GetNumberOfComponentsPerPixel() );
+      this->ReadLabels();
+    }
+
+    /** The number of observers */
+    unsigned int GetNumberOfObservers( void ) const
+    {
+      return this->m_Labels.size();
+    }
+
+    /** Move to the first voxel of the region */
+    void GoToBegin( void )
+    {
+      if( this->m_UseStack )
+      {
+        this->m_StackIterator.GoToBegin();
+      }
+      else
+      {
+        for( unsigned int k = 0; k < this->m_LabelIterators.size(); ++k )
+        {
+          this->m_LabelIterators[k].GoToBegin();
+        }
+      }
+      this->ReadLabels();
+    }
+
+    /** Is the iterator past the last voxel of the region? */
+    bool IsAtEnd( void ) const
+    {
+      return this->m_UseStack ? this->m_StackIterator.IsAtEnd()
+        : this->m_LabelIterators[0].IsAtEnd();
+    }
+
+    /** Move to the next voxel */
+    Self & operator++()
+    {
+      if( this->m_UseStack )
+      {
+        ++(this->m_StackIterator);
+      }
+      else
+      {
+        for( unsigned int k = 0; k < this->m_LabelIterators.size(); ++k )
+        {
+          ++(this->m_LabelIterators[k]);
+        }
+      }
+      this->ReadLabels();
+      return *this;
+    }
+
+    /** The labels of all observers at the current voxel */
+    const LabelType * Get( void ) const
+    {
+      return &(this->m_Labels[0]);
+    }
+
+    /** The label of observer k at the current voxel */
+    LabelType Get( const unsigned int k ) const
+    {
+      return this->m_Labels[k];
+    }
+
+  private:
+    /** Copy the labels of the current voxel, if any, to m_Labels */
+    void ReadLabels( void )
+    {
+      if( this->IsAtEnd() ) return;
+
+      if( this->m_UseStack )
+      {
+        /** Get() wraps the voxel in the buffer of the stack, without copying */
+        const ObserverLabelType * labels =
+          this->m_StackIterator.Get().GetDataPointer();
+        for( unsigned int k = 0; k < this->m_Labels.size(); ++k )
+        {
+          this->m_Labels[k] = static_cast<LabelType>( labels[k] );
+        }
+      }
+      else
+      {
+        for( unsigned int k = 0; k < this->m_LabelIterators.size(); ++k )
+        {
+          this->m_Labels[k] = this->m_LabelIterators[k].Get();
+        }
+      }
+    }
+
+    bool                            m_UseStack;
+    std::vector<LabelIteratorType>  m_LabelIterators;
+    StackIteratorType               m_StackIterator;
+    std::vector<LabelType>          m_Labels;
+
+  };
+
+} // end namespace itk
+
+#endif // end #ifndef __itkObserverLabelsConstIterator_h_
@@ -0,0 +1,156 @@
+/*=========================================================================
+*
+* Copyright Marius Staring, Stefan Klein, David Doria. 2011.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0.txt
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*=========================================================================*/
+#ifndef __itkProbabilisticSegmentationIterator_h_
+#define __itkProbabilisticSegmentationIterator_h_
+
+#include "itkImageRegionIterator.h"
+#include "itkNumericTraits.h"
+
+#include <vector>
+
+namespace itk
+{
+  /** \class ProbabilisticSegmentationIterator
+  *
+  * \brief Iterates over a region of the probabilistic segmentations of a
+  * label fusion filter, one image per class, and sets at each voxel the
+  * probabilities of all classes.
+  *
+  * The probabilistic segmentations are stored either as images of
+  * probabilities, or quantized to the range of an unsigned integer type,
+  * with 0 for probability 0 and the maximum of the type for probability 1.
+  * Allocate() creates the images of one of both arrays, and the iterator
+  * writes to whichever array has images; without images it does nothing.
+  * It is shared by LabelVoting2ImageFilter, its subclasses and
+  * MultiLabelSTAPLE2ImageFilter.
+  */
+  template <typename TProbabilityImage, typename TQuantizedProbabilityImage>
+  class ProbabilisticSegmentationIterator
+  {
+  public:
+    /** Standard class typedefs. */
+    typedef ProbabilisticSegmentationIterator Self;
+
+    /** Image typedef support */
+    typedef TProbabilityImage                               ProbabilityImageType;
+    typedef typename ProbabilityImageType::Pointer          ProbabilityImagePointer;
+    typedef typename ProbabilityImageType::PixelType        ProbabilityPixelType;
+    typedef typename ProbabilityImageType::RegionType       RegionType;
+    typedef std::vector<ProbabilityImagePointer>            ProbabilisticSegmentationArrayType;
+    typedef TQuantizedProbabilityImage                      QuantizedProbabilityImageType;
+    typedef typename QuantizedProbabilityImageType::Pointer QuantizedProbabilityImagePointer;
+    typedef typename
+      QuantizedProbabilityImageType::PixelType              QuantizedProbabilityPixelType;
+    typedef std::vector<
+      QuantizedProbabilityImagePointer >                    QuantizedProbabilisticSegmentationArrayType;
+
+    /** Iterator types. */
+    typedef ImageRegionIterator< ProbabilityImageType >     ProbIteratorType;
+    typedef ImageRegionIterator<
+      QuantizedProbabilityImageType >                       QuantizedProbIteratorType;
+
+    /** Allocate an image per class, with the requested region and the
+     * information of the output, in the quantized array if quantize is true,
+     * and in the other array otherwise. The other array is cleared, and
+     * both are empty for zero classes. */
+    template <typename TOutputImage>
+    static void Allocate( const unsigned int numberOfClasses, const bool quantize,
+      const TOutputImage * output,
+      ProbabilisticSegmentationArrayType & probabilisticSegmentations,
+      QuantizedProbabilisticSegmentationArrayType & quantizedProbabilisticSegmentations )
+    {
+      probabilisticSegmentations.clear();
+      quantizedProbabilisticSegmentations.clear();
+      if( quantize )
+      {
+        AllocateImages( numberOfClasses, output, quantizedProbabilisticSegmentations );
+      }
+      else
+      {
+        AllocateImages( numberOfClasses, output, probabilisticSegmentations );
+      }
+    }
+
+    /** Default constructor, an iterator that does nothing */
+    ProbabilisticSegmentationIterator() : m_QuantizationScale( 0.0 ) {}
+
+    /** Iterate over a region of the images of either array */
+    ProbabilisticSegmentationIterator(
+      const ProbabilisticSegmentationArrayType & probabilisticSegmentations,
+      const QuantizedProbabilisticSegmentationArrayType & quantizedProbabilisticSegmentations,
+      const RegionType & region )
+    {
+      this->m_QuantizationScale = static_cast<double>(
+        NumericTraits<QuantizedProbabilityPixelType>::max() );
+      this->m_ProbIterators.resize( probabilisticSegmentations.size() );
+      for( unsigned int k = 0; k < probabilisticSegmentations.size(); ++k )
+      {
+        this->m_ProbIterators[k] = ProbIteratorType( probabilisticSegmentations[k], region );
+      }
+      this->m_QuantizedProbIterators.resize( quantizedProbabilisticSegmentations.size() );
+      for( unsigned int k = 0; k < quantizedProbabilisticSegmentations.size(); ++k )
+      {
+        this->m_QuantizedProbIterators[k] = QuantizedProbIteratorType(
+          quantizedProbabilisticSegmentations[k], region );
+      }
+    }
+
+    /** Set the probabilities W[k] of all classes k at the current voxel,
+     * and move to the next voxel */
+    template <typename TProbabilities>
+    void SetProbabilities( const TProbabilities & W )
+    {
+      for( unsigned int k = 0; k < this->m_ProbIterators.size(); ++k )
+      {
+        this->m_ProbIterators[k].Set( static_cast<ProbabilityPixelType>( W[k] ) );
+        ++(this->m_ProbIterators[k]);
+      }
+      for( unsigned int k = 0; k < this->m_QuantizedProbIterators.size(); ++k )
+      {
+        this->m_QuantizedProbIterators[k].Set( static_cast<QuantizedProbabilityPixelType>(
+          W[k] * this->m_QuantizationScale + 0.5 ) );
+        ++(this->m_QuantizedProbIterators[k]);
+      }
+    }
+
+  private:
+    /** Allocate numberOfClasses images like the output */
+    template <typename TOutputImage, typename TImageArray>
+    static void AllocateImages( const unsigned int numberOfClasses,
+      const TOutputImage * output, TImageArray & images )
+    {
+      typedef typename TImageArray::value_type::ObjectType ImageType;
+      images.resize( numberOfClasses );
+      for( unsigned int k = 0; k < numberOfClasses; ++k )
+      {
+        images[k] = ImageType::New();
+        images[k]->SetRegions( output->GetRequestedRegion() );
+        images[k]->CopyInformation( output );
+        images[k]->Allocate();
+      }
+    }
+
+    std::vector<ProbIteratorType>           m_ProbIterators;
+    std::vector<QuantizedProbIteratorType>  m_QuantizedProbIterators;
+    double                                  m_QuantizationScale;
+
+  };
+
+} // end namespace itk
+
+#endif // end #ifndef __itkProbabilisticSegmentationIterator_h_
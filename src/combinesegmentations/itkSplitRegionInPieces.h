@@ -0,0 +1,56 @@
+/*=========================================================================
+*
+* Copyright Marius Staring, Stefan Klein, David Doria. 2011.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0.txt
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*=========================================================================*/
+#ifndef __itkSplitRegionInPieces_h_
+#define __itkSplitRegionInPieces_h_
+
+#include "itkImageRegion.h"
+#include "itkImageRegionSplitterSlowDimension.h"
+
+#include <vector>
+
+namespace itk
+{
+  /** Split a region in pieces along its slowest dimensions, like
+  * ImageSource::SplitRequestedRegion(), in at most requestedNumberOfPieces.
+  *
+  * The multi-label STAPLE filters run their E and M steps and compute their
+  * output in parallel over these pieces. Each piece has its own accumulators
+  * of the confusion matrices, which are summed in the order of the pieces,
+  * so the result does not depend on the scheduling of the threads, only on
+  * the number of pieces. A few pieces per work unit balance the load.
+  */
+  template <unsigned int VImageDimension>
+  void SplitRegionInPieces( const ImageRegion<VImageDimension> & region,
+    const unsigned int requestedNumberOfPieces,
+    std::vector< ImageRegion<VImageDimension> > & pieces )
+  {
+    ImageRegionSplitterSlowDimension::Pointer splitter
+      = ImageRegionSplitterSlowDimension::New();
+    const unsigned int numberOfPieces
+      = splitter->GetNumberOfSplits( region, requestedNumberOfPieces );
+
+    pieces.assign( numberOfPieces, region );
+    for( unsigned int i = 0; i < numberOfPieces; ++i )
+    {
+      splitter->GetSplit( i, numberOfPieces, pieces[ i ] );
+    }
+  } // end SplitRegionInPieces
+
+} // end namespace itk
+
+#endif // end #ifndef __itkSplitRegionInPieces_h_
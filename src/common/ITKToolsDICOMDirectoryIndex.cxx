@@ -0,0 +1,618 @@
+/*=========================================================================
+*
+* Copyright Marius Staring, Stefan Klein, David Doria. 2011.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0.txt
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*=========================================================================*/
+#include "ITKToolsDICOMDirectoryIndex.h"
+
+#include "itkMacro.h"
+#include "itkMultiThreaderBase.h"
+
+#include "gdcmReader.h"
+#include "gdcmStringFilter.h"
+#include "gdcmTag.h"
+
+#include <itksys/Directory.hxx>
+#include <itksys/SystemTools.hxx>
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <random>
+#include <set>
+#include <sstream>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <process.h>
+#define ITKTOOLS_GETPID _getpid
+#else
+#include <sys/stat.h>
+#include <unistd.h>
+#define ITKTOOLS_GETPID getpid
+#endif
+
+
+namespace itktools
+{
+
+const char * DICOMDirectoryIndex::IndexFileName = ".itktools_dicom_index";
+
+namespace
+{
+
+/** The version of the index file format. */
+const char * IndexFileHeader = "# ITKTools DICOM directory index, version 2";
+
+/** Convert "0020|000e" to a gdcm tag, as itk::GDCMSeriesFileNames does. */
+gdcm::Tag StringToTag( const std::string & tag )
+{
+  unsigned int group = 0, element = 0;
+  if( std::sscanf( tag.c_str(), "%x|%x", &group, &element ) != 2 )
+  {
+    itkGenericExceptionMacro( << "Invalid DICOM tag \"" << tag
+      << "\", expected e.g. \"0020|0012\"." );
+  }
+  return gdcm::Tag( static_cast<uint16_t>( group ), static_cast<uint16_t>( element ) );
+} // end StringToTag()
+
+
+/** Parse the numbers of a multi-valued DICOM string, e.g. "1.5\-20\3". */
+std::vector<double> StringToNumbers( const std::string & value )
+{
+  std::vector<double> numbers;
+  std::istringstream iss( value );
+  std::string token;
+  while( std::getline( iss, token, '\\' ) )
+  {
+    std::istringstream tss( token );
+    double number;
+    if( !( tss >> number ) ) return std::vector<double>();
+    numbers.push_back( number );
+  }
+  return numbers;
+} // end StringToNumbers()
+
+
+/** The modification time of a file, in the finest unit of the platform:
+ * nanoseconds, or 100 nanoseconds on Windows. The times are only compared
+ * for equality. itksys::SystemTools::ModifiedTime() counts in seconds, so
+ * a file rewritten with the same size within a second would seem unchanged.
+ */
+long long GetModifiedTime( const std::string & fileName )
+{
+#if defined( _WIN32 )
+  WIN32_FILE_ATTRIBUTE_DATA data;
+  if( !GetFileAttributesExA( fileName.c_str(), GetFileExInfoStandard, &data ) ) return 0;
+  return ( static_cast<long long>( data.ftLastWriteTime.dwHighDateTime ) << 32 )
+    | data.ftLastWriteTime.dwLowDateTime;
+#else
+  struct stat info;
+  if( stat( fileName.c_str(), &info ) != 0 ) return 0;
+#if defined( __APPLE__ )
+  return info.st_mtimespec.tv_sec * 1000000000LL + info.st_mtimespec.tv_nsec;
+#else
+  return info.st_mtim.tv_sec * 1000000000LL + info.st_mtim.tv_nsec;
+#endif
+#endif
+} // end GetModifiedTime()
+
+} // end namespace
+
+
+/**
+ * ******************* Constructor *******************
+ */
+
+DICOMDirectoryIndex::DICOMDirectoryIndex()
+{
+  this->m_UseIndexFile = false;
+  this->m_NumberOfThreads = 0;
+
+  /** The tags used for sorting. */
+  this->m_Tags.push_back( "0020|0032" ); // Image Position (Patient)
+  this->m_Tags.push_back( "0020|0037" ); // Image Orientation (Patient)
+  this->m_Tags.push_back( "0020|0013" ); // Instance Number
+
+  /** The series identifier: the series instance UID, the details added by
+   * GDCMSeriesFileNames::SetUseSeriesDetails( true ), and the restrictions.
+   */
+  this->m_Tags.push_back( "0020|000e" ); // Series Instance UID
+  this->m_Tags.push_back( "0020|0011" ); // Series Number
+  this->m_Tags.push_back( "0018|0024" ); // Sequence Name
+  this->m_Tags.push_back( "0018|0050" ); // Slice Thickness
+  this->m_Tags.push_back( "0028|0010" ); // Rows
+  this->m_Tags.push_back( "0028|0011" ); // Columns
+
+} // end Constructor
+
+
+/**
+ * ******************* SetDirectory *******************
+ */
+
+void
+DICOMDirectoryIndex::SetDirectory( const std::string & directory )
+{
+  this->m_Directory = directory;
+
+  /** Remove a trailing slash. */
+  while( this->m_Directory.size() > 1
+    && ( *this->m_Directory.rbegin() == '/' || *this->m_Directory.rbegin() == '\\' ) )
+  {
+    this->m_Directory.erase( this->m_Directory.size() - 1 );
+  }
+} // end SetDirectory()
+
+
+/**
+ * ******************* AddSeriesRestriction *******************
+ */
+
+void
+DICOMDirectoryIndex::AddSeriesRestriction( const std::string & tag )
+{
+  /** Check the tag, and store it in a normalized form. */
+  const gdcm::Tag gdcmTag = StringToTag( tag );
+  char buffer[ 10 ];
+  std::sprintf( buffer, "%04x|%04x", gdcmTag.GetGroup(), gdcmTag.GetElement() );
+  this->m_Tags.push_back( buffer );
+
+} // end AddSeriesRestriction()
+
+
+/**
+ * ******************* SetUseIndexFile *******************
+ */
+
+void
+DICOMDirectoryIndex::SetUseIndexFile( const bool useIndexFile )
+{
+  this->m_UseIndexFile = useIndexFile;
+} // end SetUseIndexFile()
+
+
+/**
+ * ******************* SetNumberOfThreads *******************
+ */
+
+void
+DICOMDirectoryIndex::SetNumberOfThreads( const unsigned int numberOfThreads )
+{
+  this->m_NumberOfThreads = numberOfThreads;
+} // end SetNumberOfThreads()
+
+
+/**
+ * ******************* GetTagsString *******************
+ */
+
+std::string
+DICOMDirectoryIndex::GetTagsString( void ) const
+{
+  std::string tags = "tags";
+  for( unsigned int i = 0; i < this->m_Tags.size(); ++i )
+  {
+    tags += "\t" + this->m_Tags[ i ];
+  }
+  return tags;
+} // end GetTagsString()
+
+
+/**
+ * ******************* ReadFileEntry *******************
+ */
+
+void
+DICOMDirectoryIndex::ReadFileEntry( FileEntry & entry ) const
+{
+  entry.m_IsDICOM = false;
+  entry.m_Values.assign( this->m_Tags.size(), "" );
+
+  std::set<gdcm::Tag> tags;
+  std::vector<gdcm::Tag> gdcmTags( this->m_Tags.size() );
+  for( unsigned int i = 0; i < this->m_Tags.size(); ++i )
+  {
+    gdcmTags[ i ] = StringToTag( this->m_Tags[ i ] );
+    tags.insert( gdcmTags[ i ] );
+  }
+
+  /** Parse the file up to the last of the tags, skipping all others. */
+  gdcm::Reader reader;
+  reader.SetFileName( ( this->m_Directory + "/" + entry.m_FileName ).c_str() );
+  if( !reader.ReadSelectedTags( tags ) ) return;
+  entry.m_IsDICOM = true;
+
+  gdcm::StringFilter stringFilter;
+  stringFilter.SetFile( reader.GetFile() );
+  const gdcm::DataSet & dataSet = reader.GetFile().GetDataSet();
+  for( unsigned int i = 0; i < gdcmTags.size(); ++i )
+  {
+    if( !dataSet.FindDataElement( gdcmTags[ i ] ) ) continue;
+    std::string value = stringFilter.ToString( gdcmTags[ i ] );
+
+    /** Tabs and newlines separate the fields of the index file. */
+    std::replace( value.begin(), value.end(), '\t', ' ' );
+    std::replace( value.begin(), value.end(), '\n', ' ' );
+    std::replace( value.begin(), value.end(), '\r', ' ' );
+    entry.m_Values[ i ] = value;
+  }
+
+} // end ReadFileEntry()
+
+
+/**
+ * ******************* ReadIndexFile *******************
+ */
+
+void
+DICOMDirectoryIndex::ReadIndexFile( FileEntryMapType & entries ) const
+{
+  entries.clear();
+
+  std::ifstream file( ( this->m_Directory + "/" + IndexFileName ).c_str() );
+  if( !file.is_open() ) return;
+
+  /** An index file of another version, or of other tags, is ignored. */
+  std::string line;
+  if( !std::getline( file, line ) || line != IndexFileHeader ) return;
+  if( !std::getline( file, line ) || line != this->GetTagsString() ) return;
+
+  /** One line per file: name, size, time, is DICOM, and the tag values. */
+  while( std::getline( file, line ) )
+  {
+    std::vector<std::string> fields;
+    std::string::size_type start = 0, end;
+    while( ( end = line.find( '\t', start ) ) != std::string::npos )
+    {
+      fields.push_back( line.substr( start, end - start ) );
+      start = end + 1;
+    }
+    fields.push_back( line.substr( start ) );
+    if( fields.size() != 4 + this->m_Tags.size() )
+    {
+      entries.clear();
+      return;
+    }
+
+    FileEntry entry;
+    entry.m_FileName = fields[ 0 ];
+    std::istringstream( fields[ 1 ] ) >> entry.m_Size;
+    std::istringstream( fields[ 2 ] ) >> entry.m_ModifiedTime;
+    entry.m_IsDICOM = fields[ 3 ] == "1";
+    entry.m_Values.assign( fields.begin() + 4, fields.end() );
+    entries[ entry.m_FileName ] = entry;
+  }
+
+} // end ReadIndexFile()
+
+
+/**
+ * ******************* WriteIndexFile *******************
+ */
+
+void
+DICOMDirectoryIndex::WriteIndexFile( const FileEntryMapType & entries ) const
+{
+  /** Write to a temporary file, and rename it when complete, so that a
+   * concurrent run never reads a partial index. The temporary file name
+   * contains the process id and a random number, so that concurrent runs
+   * never write to the same temporary file. Failure is not an error.
+   */
+  const std::string fileName = this->m_Directory + "/" + IndexFileName;
+  std::string temporaryFileName;
+  std::random_device randomDevice;
+  for( unsigned int attempt = 0; attempt < 16; ++attempt )
+  {
+    std::ostringstream name;
+    name << fileName << "." << ITKTOOLS_GETPID() << "." << std::hex << randomDevice() << ".tmp";
+    if( !itksys::SystemTools::FileExists( name.str() ) )
+    {
+      temporaryFileName = name.str();
+      break;
+    }
+  }
+  if( temporaryFileName.empty() ) return;
+
+  {
+    std::ofstream file( temporaryFileName.c_str() );
+    if( !file.is_open() ) return;
+
+    file << IndexFileHeader << "\n" << this->GetTagsString() << "\n";
+    for( FileEntryMapType::const_iterator it = entries.begin(); it != entries.end(); ++it )
+    {
+      const FileEntry & entry = it->second;
+      file << entry.m_FileName << "\t" << entry.m_Size << "\t"
+        << entry.m_ModifiedTime << "\t" << ( entry.m_IsDICOM ? 1 : 0 );
+      for( unsigned int i = 0; i < entry.m_Values.size(); ++i )
+      {
+        file << "\t" << entry.m_Values[ i ];
+      }
+      file << "\n";
+    }
+    if( !file.good() )
+    {
+      file.close();
+      itksys::SystemTools::RemoveFile( temporaryFileName );
+      return;
+    }
+  }
+
+  if( !itksys::SystemTools::RenameFile( temporaryFileName, fileName ) )
+  {
+    itksys::SystemTools::RemoveFile( temporaryFileName );
+  }
+
+} // end WriteIndexFile()
+
+
+/**
+ * ******************* Update *******************
+ */
+
+void
+DICOMDirectoryIndex::Update( void )
+{
+  this->m_FileEntries.clear();
+  this->m_Series.clear();
+
+  itksys::Directory directory;
+  if( !directory.Load( this->m_Directory ) )
+  {
+    itkGenericExceptionMacro( << "Could not read the directory " << this->m_Directory << "." );
+  }
+
+  /** The previous index. */
+  FileEntryMapType previousEntries;
+  if( this->m_UseIndexFile )
+  {
+    this->ReadIndexFile( previousEntries );
+  }
+
+  /** Collect the files, and reuse the entries of unchanged files. */
+  const std::string indexFileName = IndexFileName;
+  std::vector<FileEntry *> filesToRead;
+  bool changed = false;
+  for( unsigned long i = 0; i < directory.GetNumberOfFiles(); ++i )
+  {
+    const std::string fileName = directory.GetFile( i );
+    const std::string fullFileName = this->m_Directory + "/" + fileName;
+    if( fileName.compare( 0, indexFileName.size(), indexFileName ) == 0
+      || itksys::SystemTools::FileIsDirectory( fullFileName ) )
+    {
+      continue;
+    }
+
+    FileEntry & entry = this->m_FileEntries[ fileName ];
+    entry.m_FileName = fileName;
+    entry.m_Size = itksys::SystemTools::FileLength( fullFileName );
+    entry.m_ModifiedTime = GetModifiedTime( fullFileName );
+
+    FileEntryMapType::const_iterator previous = previousEntries.find( fileName );
+    if( previous != previousEntries.end()
+      && previous->second.m_Size == entry.m_Size
+      && previous->second.m_ModifiedTime == entry.m_ModifiedTime )
+    {
+      entry.m_IsDICOM = previous->second.m_IsDICOM;
+      entry.m_Values = previous->second.m_Values;
+    }
+    else
+    {
+      filesToRead.push_back( &entry );
+      changed = true;
+    }
+  }
+  changed |= previousEntries.size() != this->m_FileEntries.size() - filesToRead.size();
+
+  /** Parse the new and changed files in parallel. Each thread writes its
+   * own entries only.
+   */
+  if( !filesToRead.empty() )
+  {
+    itk::MultiThreaderBase::Pointer threader = itk::MultiThreaderBase::New();
+    if( this->m_NumberOfThreads > 0 )
+    {
+      threader->SetNumberOfWorkUnits( this->m_NumberOfThreads );
+    }
+    threader->ParallelizeArray( 0, filesToRead.size(),
+      [this, &filesToRead]( itk::SizeValueType i )
+      {
+        this->ReadFileEntry( *filesToRead[ i ] );
+      }, nullptr );
+  }
+
+  if( this->m_UseIndexFile && changed )
+  {
+    this->WriteIndexFile( this->m_FileEntries );
+  }
+
+  /** Group the files per series. */
+  for( FileEntryMapType::const_iterator it = this->m_FileEntries.begin();
+    it != this->m_FileEntries.end(); ++it )
+  {
+    if( !it->second.m_IsDICOM ) continue;
+    this->m_Series[ this->CreateSeriesIdentifier( it->second ) ].push_back( &it->second );
+  }
+
+  for( SeriesMapType::iterator it = this->m_Series.begin(); it != this->m_Series.end(); ++it )
+  {
+    this->SortSeries( it->second );
+  }
+
+} // end Update()
+
+
+/**
+ * ******************* CreateSeriesIdentifier *******************
+ */
+
+std::string
+DICOMDirectoryIndex::CreateSeriesIdentifier( const FileEntry & entry ) const
+{
+  /** Append the details to the series instance UID. */
+  const std::string & uid = entry.m_Values[ SeriesInstanceUIDTag ];
+  std::string id = uid;
+  for( unsigned int i = SeriesInstanceUIDTag + 1; i < entry.m_Values.size(); ++i )
+  {
+    const std::string & value = entry.m_Values[ i ];
+    if( id == uid && !value.empty() )
+    {
+      id += ".";
+    }
+    id += value;
+  }
+
+  /** Remove the characters that are not allowed, e.g. white space. */
+  std::string result;
+  for( std::string::size_type i = 0; i < id.size(); ++i )
+  {
+    const char c = id[ i ];
+    if( c == '.' || c == '%' || c == '_' || ( c >= '+' && c <= '-' )
+      || ( c >= 'a' && c <= 'z' ) || ( c >= '0' && c <= '9' ) || ( c >= 'A' && c <= 'Z' ) )
+    {
+      result += c;
+    }
+  }
+  return result;
+
+} // end CreateSeriesIdentifier()
+
+
+/**
+ * ******************* SortSeries *******************
+ */
+
+void
+DICOMDirectoryIndex::SortSeries( std::vector<const FileEntry *> & files ) const
+{
+  typedef std::pair<double, const FileEntry *>  KeyType;
+  std::vector<KeyType> keys( files.size() );
+
+  typedef std::vector<KeyType>::const_iterator KeyIteratorType;
+  const auto lessKey
+    = []( const KeyType & a, const KeyType & b ) { return a.first < b.first; };
+  const auto equalKey
+    = []( const KeyType & a, const KeyType & b ) { return a.first == b.first; };
+
+  /** Sort along the normal of the image orientation, as the image position
+   * ordering of gdcm::SerieHelper: only if all files have the same
+   * orientation, and the positions along the normal are all different.
+   * Repeated positions, e.g. of multi-echo or temporal series with one
+   * series UID, fall back to the instance number.
+   */
+  bool usePosition = true;
+  const std::vector<double> orientation
+    = StringToNumbers( files[ 0 ]->m_Values[ ImageOrientationTag ] );
+  usePosition &= orientation.size() == 6;
+  double normal[ 3 ] = { 0.0, 0.0, 0.0 };
+  if( usePosition )
+  {
+    normal[ 0 ] = orientation[ 1 ] * orientation[ 5 ] - orientation[ 2 ] * orientation[ 4 ];
+    normal[ 1 ] = orientation[ 2 ] * orientation[ 3 ] - orientation[ 0 ] * orientation[ 5 ];
+    normal[ 2 ] = orientation[ 0 ] * orientation[ 4 ] - orientation[ 1 ] * orientation[ 3 ];
+  }
+  for( unsigned int i = 0; i < files.size() && usePosition; ++i )
+  {
+    const std::vector<double> position = StringToNumbers( files[ i ]->m_Values[ ImagePositionTag ] );
+    usePosition &= position.size() == 3
+      && files[ i ]->m_Values[ ImageOrientationTag ] == files[ 0 ]->m_Values[ ImageOrientationTag ];
+    if( usePosition )
+    {
+      keys[ i ] = KeyType( normal[ 0 ] * position[ 0 ] + normal[ 1 ] * position[ 1 ]
+        + normal[ 2 ] * position[ 2 ], files[ i ] );
+    }
+  }
+  if( usePosition )
+  {
+    std::sort( keys.begin(), keys.end(), lessKey );
+    usePosition = std::adjacent_find( keys.begin(), keys.end(), equalKey ) == keys.end();
+  }
+
+  /** Otherwise sort by instance number, as the image number ordering of
+   * gdcm::SerieHelper: only if all files have one, and the numbers are not
+   * all the same, not all zero, and not more spread than the number of files.
+   */
+  bool useInstanceNumber = !usePosition;
+  for( unsigned int i = 0; i < files.size() && useInstanceNumber; ++i )
+  {
+    const std::vector<double> number = StringToNumbers( files[ i ]->m_Values[ InstanceNumberTag ] );
+    useInstanceNumber &= number.size() == 1;
+    if( useInstanceNumber ) keys[ i ] = KeyType( number[ 0 ], files[ i ] );
+  }
+  if( useInstanceNumber )
+  {
+    const std::pair<KeyIteratorType, KeyIteratorType> range
+      = std::minmax_element( keys.begin(), keys.end(), lessKey );
+    const double minimum = range.first->first;
+    const double maximum = range.second->first;
+    useInstanceNumber = minimum != maximum && maximum != 0.0
+      && maximum < files.size() + minimum;
+    if( useInstanceNumber )
+    {
+      std::stable_sort( keys.begin(), keys.end(), lessKey );
+    }
+  }
+
+  /** Otherwise sort by file name, which is the order of m_FileEntries. */
+  if( !usePosition && !useInstanceNumber ) return;
+
+  for( unsigned int i = 0; i < files.size(); ++i )
+  {
+    files[ i ] = keys[ i ].second;
+  }
+
+} // end SortSeries()
+
+
+/**
+ * ******************* GetSeriesUIDs *******************
+ */
+
+DICOMDirectoryIndex::SeriesUIDContainerType
+DICOMDirectoryIndex::GetSeriesUIDs( void ) const
+{
+  SeriesUIDContainerType seriesUIDs;
+  for( SeriesMapType::const_iterator it = this->m_Series.begin(); it != this->m_Series.end(); ++it )
+  {
+    seriesUIDs.push_back( it->first );
+  }
+  return seriesUIDs;
+} // end GetSeriesUIDs()
+
+
+/**
+ * ******************* GetFileNames *******************
+ */
+
+DICOMDirectoryIndex::FileNamesContainerType
+DICOMDirectoryIndex::GetFileNames( const std::string & seriesUID ) const
+{
+  FileNamesContainerType fileNames;
+  SeriesMapType::const_iterator it = seriesUID.empty()
+    ? this->m_Series.begin() : this->m_Series.find( seriesUID );
+  if( it == this->m_Series.end() ) return fileNames;
+
+  for( unsigned int i = 0; i < it->second.size(); ++i )
+  {
+    fileNames.push_back( this->m_Directory + "/" + it->second[ i ]->m_FileName );
+  }
+  return fileNames;
+
+} // end GetFileNames()
+
+} // end namespace itktools
@@ -0,0 +1,144 @@
+/*=========================================================================
+*
+* Copyright Marius Staring, Stefan Klein, David Doria. 2011.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0.txt
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*=========================================================================*/
+#ifndef __ITKToolsDICOMDirectoryIndex_h_
+#define __ITKToolsDICOMDirectoryIndex_h_
+
+#include <map>
+#include <string>
+#include <vector>
+
+
+namespace itktools
+{
+
+/** \class DICOMDirectoryIndex
+ * \brief An index of the DICOM series in a directory.
+ *
+ * This replaces itk::GDCMSeriesFileNames with SetUseSeriesDetails( true ),
+ * which parses the complete header of every file of the directory, each
+ * time a tool is run. Here, only the tags needed to group and sort the
+ * files are read, the files are parsed in parallel, and the parsing of a
+ * file stops after the last of these tags.
+ *
+ * With SetUseIndexFile( true ) the result is stored in the directory, in the
+ * file IndexFileName, and reused by a next run: a file is only parsed again
+ * if it is new, or if its size or modification time changed. The
+ * modification time is compared with the resolution of the file system,
+ * not in seconds, so a file that is rewritten within the same second is
+ * also parsed again. This writes
+ * into the directory, so it is off by default. If the index file can not be
+ * written, e.g. for a read-only directory, the directory is simply parsed
+ * each time.
+ *
+ * The series identifiers are the same as those of itk::GDCMSeriesFileNames,
+ * so they can be exchanged between pxgetDICOMseriesUIDs, pxgetdicominformation
+ * and pxcastconvert. The files of a series are sorted as by gdcm: along the
+ * normal of the image orientation, or else by instance number, or else by
+ * file name.
+ */
+
+class DICOMDirectoryIndex
+{
+public:
+  typedef std::vector< std::string >      FileNamesContainerType;
+  typedef std::vector< std::string >      SeriesUIDContainerType;
+
+  /** Constructor. */
+  DICOMDirectoryIndex();
+
+  /** Destructor. */
+  ~DICOMDirectoryIndex(){};
+
+  /** The name of the index file, relative to the directory. */
+  static const char * IndexFileName;
+
+  /** Set the DICOM directory. */
+  void SetDirectory( const std::string & directory );
+
+  /** Add a tag, e.g. "0020|0012", to the series identifier. */
+  void AddSeriesRestriction( const std::string & tag );
+
+  /** Read and write the index file, default false. */
+  void SetUseIndexFile( const bool useIndexFile );
+
+  /** Set the number of threads used to parse the files, default 0 to
+   * use the number of threads of the itk::MultiThreaderBase.
+   */
+  void SetNumberOfThreads( const unsigned int numberOfThreads );
+
+  /** Index the directory. Throws an itk::ExceptionObject on error. */
+  void Update( void );
+
+  /** Get the series identifiers, in sorted order. */
+  SeriesUIDContainerType GetSeriesUIDs( void ) const;
+
+  /** Get the sorted files of a series, with the directory prepended. An
+   * empty seriesUID selects the first series, as GDCMSeriesFileNames does.
+   */
+  FileNamesContainerType GetFileNames( const std::string & seriesUID ) const;
+
+protected:
+
+  /** The tags read of a file, in the order of m_Tags. */
+  struct FileEntry
+  {
+    std::string               m_FileName;
+    unsigned long             m_Size;
+    long long                 m_ModifiedTime;
+    bool                      m_IsDICOM;
+    std::vector<std::string>  m_Values;
+  };
+
+  typedef std::map< std::string, FileEntry >                      FileEntryMapType;
+  typedef std::map< std::string, std::vector<const FileEntry *> > SeriesMapType;
+
+  /** The position of the tags in m_Tags. The tags of the series identifier
+   * start at SeriesInstanceUIDTag, in the order used by gdcm.
+   */
+  enum { ImagePositionTag = 0, ImageOrientationTag, InstanceNumberTag, SeriesInstanceUIDTag };
+
+  /** Read a few tags of a file. */
+  void ReadFileEntry( FileEntry & entry ) const;
+
+  /** Read and write the index file. */
+  void ReadIndexFile( FileEntryMapType & entries ) const;
+  void WriteIndexFile( const FileEntryMapType & entries ) const;
+
+  /** Construct the series identifier of a file, as gdcm::SerieHelper. */
+  std::string CreateSeriesIdentifier( const FileEntry & entry ) const;
+
+  /** Sort the files of a series, as gdcm::SerieHelper. */
+  void SortSeries( std::vector<const FileEntry *> & files ) const;
+
+  /** The tags as a string, to check that an index file is compatible. */
+  std::string GetTagsString( void ) const;
+
+private:
+
+  std::string               m_Directory;
+  std::vector<std::string>  m_Tags;
+  bool                      m_UseIndexFile;
+  unsigned int              m_NumberOfThreads;
+  FileEntryMapType          m_FileEntries;
+  SeriesMapType             m_Series;
+
+}; // end class DICOMDirectoryIndex
+
+} // end namespace itktools
+
+#endif // end #ifndef __ITKToolsDICOMDirectoryIndex_h_
@@ -0,0 +1,163 @@
+/*=========================================================================
+*
+* Copyright Marius Staring, Stefan Klein, David Doria. 2011.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0.txt
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*=========================================================================*/
+#ifndef __ITKToolsImageReading_h_
+#define __ITKToolsImageReading_h_
+
+#include "itkImageFileReader.h"
+#include "itkImageRegionIterator.h"
+#include "itkImageRegionSplitterSlowDimension.h"
+#include "itkBitPackedMask.h"
+#include <algorithm>
+#include <future>
+#include <string>
+
+
+namespace itktools
+{
+
+/** Read an image from disk and disconnect it from the reader,
+ * so that the reader can be destroyed.
+ */
+template< class TImage >
+typename TImage::Pointer ReadImage( const std::string & fileName )
+{
+  typedef itk::ImageFileReader< TImage > ReaderType;
+  typename ReaderType::Pointer reader = ReaderType::New();
+  reader->SetFileName( fileName );
+  reader->Update();
+
+  typename TImage::Pointer image = reader->GetOutput();
+  image->DisconnectPipeline();
+  return image;
+
+} // end ReadImage()
+
+
+/** Start reading an image in a background thread. This allows to read
+ * the next image of a list while the current one is processed.
+ * Exceptions thrown by the reader are rethrown by get().
+ */
+template< class TImage >
+std::future< typename TImage::Pointer > ReadImageAsynchronously(
+  const std::string & fileName )
+{
+  return std::async( std::launch::async, &ReadImage< TImage >, fileName );
+
+} // end ReadImageAsynchronously()
+
+
+/** Read a mask image from disk, with 1 for every nonzero voxel and 0
+ * elsewhere. The image is read as double, in a number of streams, and
+ * thresholded before it is narrowed to the mask pixel type, so that a
+ * value like 256 or 0.5 is not cast to 0. Only one stream of doubles is
+ * in memory at any time.
+ */
+template< class TMaskImage >
+typename TMaskImage::Pointer ReadMaskImage( const std::string & fileName,
+  const unsigned int numberOfStreams )
+{
+  typedef itk::Image< double, TMaskImage::ImageDimension >  ImageType;
+  typedef itk::ImageFileReader< ImageType >                 ReaderType;
+  typedef typename TMaskImage::RegionType                   RegionType;
+
+  typename ReaderType::Pointer reader = ReaderType::New();
+  reader->SetFileName( fileName );
+  reader->UpdateOutputInformation();
+
+  typename TMaskImage::Pointer mask = TMaskImage::New();
+  mask->CopyInformation( reader->GetOutput() );
+  mask->SetRegions( reader->GetOutput()->GetLargestPossibleRegion() );
+  mask->Allocate();
+
+  /** Read and threshold the image chunk by chunk. */
+  const RegionType largestRegion = mask->GetLargestPossibleRegion();
+  itk::ImageRegionSplitterSlowDimension::Pointer splitter
+    = itk::ImageRegionSplitterSlowDimension::New();
+  const unsigned int numberOfChunks = splitter->GetNumberOfSplits(
+    largestRegion, std::max( numberOfStreams, 1u ) );
+
+  for( unsigned int i = 0; i < numberOfChunks; ++i )
+  {
+    RegionType chunk = largestRegion;
+    splitter->GetSplit( i, numberOfChunks, chunk );
+    reader->GetOutput()->SetRequestedRegion( chunk );
+    reader->Update();
+
+    itk::ImageRegionConstIterator< ImageType > it( reader->GetOutput(), chunk );
+    itk::ImageRegionIterator< TMaskImage > mit( mask, chunk );
+    for( ; !it.IsAtEnd(); ++it, ++mit )
+    {
+      mit.Set( it.Get() != 0.0 ? 1 : 0 );
+    }
+  }
+
+  return mask;
+
+} // end ReadMaskImage()
+
+
+/** Read an image from disk into a bit-packed mask, in a number of streams,
+ * so that only a part of the image is in memory at any time. Every
+ * nonzero voxel is set in the mask. On return isBinary tells whether
+ * the image contained only the values 0 and 1. If stopIfNotBinary is true,
+ * reading stops after the first chunk with other values, and the mask is
+ * incomplete; this is for callers that need a binary image anyway, and
+ * read the image in another way otherwise.
+ */
+template< class TImage >
+typename itk::BitPackedMask< TImage::ImageDimension >::Pointer
+ReadBitPackedMask( const std::string & fileName,
+  const unsigned int numberOfStreams, bool & isBinary,
+  const bool stopIfNotBinary = false )
+{
+  typedef itk::ImageFileReader< TImage >                    ReaderType;
+  typedef itk::BitPackedMask< TImage::ImageDimension >      MaskType;
+  typedef typename TImage::RegionType                       RegionType;
+
+  typename ReaderType::Pointer reader = ReaderType::New();
+  reader->SetFileName( fileName );
+  reader->UpdateOutputInformation();
+
+  typename MaskType::Pointer mask = MaskType::New();
+  mask->SetGeometry( reader->GetOutput() );
+
+  /** Read and pack the image chunk by chunk. */
+  const RegionType largestRegion = reader->GetOutput()->GetLargestPossibleRegion();
+  itk::ImageRegionSplitterSlowDimension::Pointer splitter
+    = itk::ImageRegionSplitterSlowDimension::New();
+  const unsigned int numberOfChunks = splitter->GetNumberOfSplits(
+    largestRegion, std::max( numberOfStreams, 1u ) );
+
+  isBinary = true;
+  for( unsigned int i = 0; i < numberOfChunks; ++i )
+  {
+    RegionType chunk = largestRegion;
+    splitter->GetSplit( i, numberOfChunks, chunk );
+    reader->GetOutput()->SetRequestedRegion( chunk );
+    reader->Update();
+    isBinary &= mask->Pack( reader->GetOutput(), chunk );
+    if( !isBinary && stopIfNotBinary ) break;
+  }
+
+  return mask;
+
+} // end ReadBitPackedMask()
+
+} // end itktools namespace
+
+#endif // end #ifndef __ITKToolsImageReading_h_
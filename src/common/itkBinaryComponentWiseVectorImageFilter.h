@@ -0,0 +1,103 @@
+/*=========================================================================
+*
+* Copyright Marius Staring, Stefan Klein, David Doria. 2011.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0.txt
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*=========================================================================*/
+#ifndef __itkBinaryComponentWiseVectorImageFilter_h_
+#define __itkBinaryComponentWiseVectorImageFilter_h_
+
+#include "itkInPlaceImageFilter.h"
+
+
+namespace itk
+{
+
+/** \class BinaryComponentWiseVectorImageFilter
+ * \brief Applies a binary functor to every component of two images.
+ *
+ * The functor is called on the components, not on the pixels, so for an
+ * itk::VectorImage it works directly on the interleaved buffers, in a
+ * single multi-threaded pass. This avoids extracting every channel with
+ * a VectorIndexSelectionCastImageFilter and reassembling the result with
+ * a ComposeImageFilter. The filter also accepts an itk::Image, which is
+ * treated as an image with a single component.
+ *
+ * The inputs should have the same number of components per pixel, and
+ * the same size, as for the itk::BinaryFunctorImageFilter.
+ */
+
+template< class TInputImage1, class TInputImage2, class TOutputImage, class TFunctor >
+class ITK_EXPORT BinaryComponentWiseVectorImageFilter
+  : public InPlaceImageFilter< TInputImage1, TOutputImage >
+{
+public:
+  /** Standard class typedefs. */
+  typedef BinaryComponentWiseVectorImageFilter              Self;
+  typedef InPlaceImageFilter< TInputImage1, TOutputImage >  Superclass;
+  typedef SmartPointer< Self >                              Pointer;
+  typedef SmartPointer< const Self >                        ConstPointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro( Self );
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro( BinaryComponentWiseVectorImageFilter, InPlaceImageFilter );
+
+  /** Typedefs. */
+  typedef TInputImage1                                Input1ImageType;
+  typedef TInputImage2                                Input2ImageType;
+  typedef TOutputImage                                OutputImageType;
+  typedef typename OutputImageType::RegionType        OutputImageRegionType;
+  typedef typename Input1ImageType::InternalPixelType Input1ComponentType;
+  typedef typename Input2ImageType::InternalPixelType Input2ComponentType;
+  typedef typename OutputImageType::InternalPixelType OutputComponentType;
+  typedef TFunctor                                    FunctorType;
+
+  /** Set the inputs. */
+  void SetInput1( const Input1ImageType * input );
+  void SetInput2( const Input2ImageType * input );
+
+  /** Get the functor, e.g. to set its parameters. */
+  FunctorType & GetFunctor( void ) { return this->m_Functor; }
+  const FunctorType & GetFunctor( void ) const { return this->m_Functor; }
+
+protected:
+  BinaryComponentWiseVectorImageFilter();
+  virtual ~BinaryComponentWiseVectorImageFilter() {};
+
+  /** The output has as many components as the inputs. */
+  virtual void GenerateOutputInformation( void );
+
+  /** Check that the inputs have the same number of components. */
+  virtual void BeforeThreadedGenerateData( void );
+
+  /** Apply the functor to the components of a region. */
+  virtual void DynamicThreadedGenerateData( const OutputImageRegionType & outputRegionForThread );
+
+private:
+  BinaryComponentWiseVectorImageFilter( const Self & ); // purposely not implemented
+  void operator=( const Self & ); // purposely not implemented
+
+  FunctorType m_Functor;
+
+}; // end class BinaryComponentWiseVectorImageFilter
+
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkBinaryComponentWiseVectorImageFilter.hxx"
+#endif
+
+#endif // end #ifndef __itkBinaryComponentWiseVectorImageFilter_h_
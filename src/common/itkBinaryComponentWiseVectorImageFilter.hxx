@@ -0,0 +1,161 @@
+/*=========================================================================
+*
+* Copyright Marius Staring, Stefan Klein, David Doria. 2011.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0.txt
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*=========================================================================*/
+#ifndef _itkBinaryComponentWiseVectorImageFilter_hxx_
+#define _itkBinaryComponentWiseVectorImageFilter_hxx_
+
+#include "itkBinaryComponentWiseVectorImageFilter.h"
+
+#include "itkImageScanlineIterator.h"
+
+
+namespace itk
+{
+
+/**
+ * ********************* Constructor ****************************
+ */
+
+template< class TInputImage1, class TInputImage2, class TOutputImage, class TFunctor >
+BinaryComponentWiseVectorImageFilter< TInputImage1, TInputImage2, TOutputImage, TFunctor >
+::BinaryComponentWiseVectorImageFilter()
+{
+  this->SetNumberOfRequiredInputs( 2 );
+  this->DynamicMultiThreadingOn();
+  this->InPlaceOff();
+} // end Constructor
+
+
+/**
+ * ********************* SetInput1 ****************************
+ */
+
+template< class TInputImage1, class TInputImage2, class TOutputImage, class TFunctor >
+void
+BinaryComponentWiseVectorImageFilter< TInputImage1, TInputImage2, TOutputImage, TFunctor >
+::SetInput1( const Input1ImageType * input )
+{
+  this->SetNthInput( 0, const_cast< Input1ImageType * >( input ) );
+} // end SetInput1()
+
+
+/**
+ * ********************* SetInput2 ****************************
+ */
+
+template< class TInputImage1, class TInputImage2, class TOutputImage, class TFunctor >
+void
+BinaryComponentWiseVectorImageFilter< TInputImage1, TInputImage2, TOutputImage, TFunctor >
+::SetInput2( const Input2ImageType * input )
+{
+  this->SetNthInput( 1, const_cast< Input2ImageType * >( input ) );
+} // end SetInput2()
+
+
+/**
+ * ********************* GenerateOutputInformation ****************************
+ */
+
+template< class TInputImage1, class TInputImage2, class TOutputImage, class TFunctor >
+void
+BinaryComponentWiseVectorImageFilter< TInputImage1, TInputImage2, TOutputImage, TFunctor >
+::GenerateOutputInformation( void )
+{
+  Superclass::GenerateOutputInformation();
+
+  this->GetOutput()->SetNumberOfComponentsPerPixel(
+    this->GetInput( 0 )->GetNumberOfComponentsPerPixel() );
+
+} // end GenerateOutputInformation()
+
+
+/**
+ * ********************* BeforeThreadedGenerateData ****************************
+ */
+
+template< class TInputImage1, class TInputImage2, class TOutputImage, class TFunctor >
+void
+BinaryComponentWiseVectorImageFilter< TInputImage1, TInputImage2, TOutputImage, TFunctor >
+::BeforeThreadedGenerateData( void )
+{
+  const Input1ImageType * input1 = this->GetInput( 0 );
+  const Input2ImageType * input2
+    = dynamic_cast< const Input2ImageType * >( this->ProcessObject::GetInput( 1 ) );
+
+  if( input2 == nullptr )
+  {
+    itkExceptionMacro( << "The second input is not of the expected type." );
+  }
+  if( input1->GetNumberOfComponentsPerPixel() != input2->GetNumberOfComponentsPerPixel() )
+  {
+    itkExceptionMacro( << "The inputs have a different number of components per pixel: "
+      << input1->GetNumberOfComponentsPerPixel() << " and "
+      << input2->GetNumberOfComponentsPerPixel() << "." );
+  }
+
+} // end BeforeThreadedGenerateData()
+
+
+/**
+ * ********************* DynamicThreadedGenerateData ****************************
+ */
+
+template< class TInputImage1, class TInputImage2, class TOutputImage, class TFunctor >
+void
+BinaryComponentWiseVectorImageFilter< TInputImage1, TInputImage2, TOutputImage, TFunctor >
+::DynamicThreadedGenerateData( const OutputImageRegionType & outputRegionForThread )
+{
+  typedef ImageScanlineIterator< OutputImageType >    OutputIteratorType;
+  typedef typename OutputImageType::IndexType         IndexType;
+
+  const Input1ImageType * input1 = this->GetInput( 0 );
+  const Input2ImageType * input2
+    = static_cast< const Input2ImageType * >( this->ProcessObject::GetInput( 1 ) );
+  OutputImageType * output = this->GetOutput();
+
+  /** A scan line is contiguous in all buffers, so that it can be processed
+   * as one array of components. Each thread has its own copy of the functor,
+   * since not all functors have a const call operator.
+   */
+  const SizeValueType numberOfComponents = output->GetNumberOfComponentsPerPixel();
+  const SizeValueType lineLength = outputRegionForThread.GetSize( 0 ) * numberOfComponents;
+  const Input1ComponentType * in1Buffer = input1->GetBufferPointer();
+  const Input2ComponentType * in2Buffer = input2->GetBufferPointer();
+  OutputComponentType * outBuffer = output->GetBufferPointer();
+  FunctorType functor = this->m_Functor;
+
+  OutputIteratorType outIt( output, outputRegionForThread );
+  while( !outIt.IsAtEnd() )
+  {
+    const IndexType index = outIt.GetIndex();
+    const Input1ComponentType * in1 = in1Buffer + numberOfComponents * input1->ComputeOffset( index );
+    const Input2ComponentType * in2 = in2Buffer + numberOfComponents * input2->ComputeOffset( index );
+    OutputComponentType * out = outBuffer + numberOfComponents * output->ComputeOffset( index );
+
+    for( SizeValueType i = 0; i < lineLength; ++i )
+    {
+      out[ i ] = static_cast< OutputComponentType >( functor( in1[ i ], in2[ i ] ) );
+    }
+
+    outIt.NextLine();
+  }
+
+} // end DynamicThreadedGenerateData()
+
+} // end namespace itk
+
+#endif // end #ifndef _itkBinaryComponentWiseVectorImageFilter_hxx_
@@ -0,0 +1,176 @@
+/*=========================================================================
+*
+* Copyright Marius Staring, Stefan Klein, David Doria. 2011.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0.txt
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*=========================================================================*/
+#ifndef __itkBitPackedMask_h_
+#define __itkBitPackedMask_h_
+
+#include "itkObject.h"
+#include "itkObjectFactory.h"
+#include "itkImageBase.h"
+
+#include <cstdint>
+#include <vector>
+
+
+namespace itk
+{
+
+/** \class BitPackedMask
+ * \brief A binary mask that stores a single bit per voxel.
+ *
+ * The voxels are stored in the order of the image buffer of the largest
+ * possible region, 64 voxels per word. Compared to a mask of shorts this
+ * needs 16 times less memory, and the logical operators and the counting
+ * of the nonzero voxels work on 64 voxels at a time.
+ *
+ * A mask is filled from an image with Pack(), region by region, so that
+ * it can be read from disk in streams, see itktools::ReadBitPackedMask().
+ * It is converted back to an image with Unpack(), or with the
+ * BitPackedMaskToImageFilter, which supports streamed writing.
+ *
+ * The bits beyond the last voxel of the last word are always zero.
+ */
+
+template< unsigned int VDimension >
+class ITK_EXPORT BitPackedMask : public Object
+{
+public:
+  /** Standard class typedefs. */
+  typedef BitPackedMask               Self;
+  typedef Object                      Superclass;
+  typedef SmartPointer< Self >        Pointer;
+  typedef SmartPointer< const Self >  ConstPointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro( Self );
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro( BitPackedMask, Object );
+
+  /** Dimension of the mask. */
+  itkStaticConstMacro( ImageDimension, unsigned int, VDimension );
+
+  /** Typedefs. */
+  typedef std::uint64_t                           WordType;
+  typedef std::vector< WordType >                 WordContainerType;
+  typedef ImageBase< VDimension >                 ImageBaseType;
+  typedef typename ImageBaseType::RegionType      RegionType;
+  typedef typename ImageBaseType::IndexType       IndexType;
+  typedef typename ImageBaseType::PointType       PointType;
+  typedef typename ImageBaseType::SpacingType     SpacingType;
+  typedef typename ImageBaseType::DirectionType   DirectionType;
+
+  /** The number of voxels per word. */
+  itkStaticConstMacro( WordSize, unsigned int, 64 );
+
+  /** Copy the geometry of an image, and allocate an empty mask. */
+  void SetGeometry( const ImageBaseType * image );
+
+  /** Copy the geometry of another mask, and allocate an empty mask. */
+  void SetGeometry( const Self * mask );
+
+  /** Get the geometry. */
+  const RegionType & GetLargestPossibleRegion( void ) const { return this->m_LargestPossibleRegion; }
+  const PointType & GetOrigin( void ) const { return this->m_Origin; }
+  const SpacingType & GetSpacing( void ) const { return this->m_Spacing; }
+  const DirectionType & GetDirection( void ) const { return this->m_Direction; }
+
+  /** Get the number of voxels and the number of words. */
+  SizeValueType GetNumberOfVoxels( void ) const { return this->m_NumberOfVoxels; }
+  SizeValueType GetNumberOfWords( void ) const { return this->m_Words.size(); }
+
+  /** Get the words. */
+  const WordType * GetBufferPointer( void ) const { return this->m_Words.data(); }
+
+  /** Compute the position of a voxel in the mask. */
+  SizeValueType ComputeOffset( const IndexType & index ) const;
+
+  /** Get and set the bit of a voxel, by its offset. */
+  bool GetBit( const SizeValueType offset ) const
+  {
+    return ( this->m_Words[ offset / WordSize ] >> ( offset % WordSize ) ) & 1;
+  }
+  void SetBit( const SizeValueType offset )
+  {
+    this->m_Words[ offset / WordSize ] |= WordType( 1 ) << ( offset % WordSize );
+  }
+
+  /** Set the bits of the nonzero voxels of a region of an image. The region
+   * should be buffered by the image. Returns false if the region contains
+   * values other than 0 and 1, which is not an error, but tells the caller
+   * that a logical operator on the mask is not the same as a bitwise
+   * operator on the image.
+   */
+  template< class TImage >
+  bool Pack( const TImage * image, const RegionType & region );
+
+  /** Write a region of the mask to an image, as 0 and 1. */
+  template< class TImage >
+  void Unpack( TImage * image, const RegionType & region ) const;
+
+  /** Logical operators, 64 voxels at a time. The result is stored in this
+   * mask. The other mask should have the same region.
+   */
+  void And( const Self * other );
+  void Or( const Self * other );
+  void Xor( const Self * other );
+  void AndNot( const Self * other ); // this & !other
+  void OrNot( const Self * other );  // this | !other
+  void Not( void );
+
+  /** Set all voxels to a value. */
+  void Fill( const bool value );
+
+  /** Count the number of nonzero voxels, using popcount. */
+  SizeValueType CountNonZero( void ) const;
+
+protected:
+  BitPackedMask();
+  virtual ~BitPackedMask() {};
+
+  /** PrintSelf. */
+  virtual void PrintSelf( std::ostream & os, Indent indent ) const;
+
+  /** Allocate an empty mask for the current region. */
+  void Allocate( void );
+
+  /** Set the bits beyond the last voxel to zero. */
+  void ClearUnusedBits( void );
+
+  /** Check that another mask has the same region. */
+  void CheckSize( const Self * other ) const;
+
+private:
+  BitPackedMask( const Self & ); // purposely not implemented
+  void operator=( const Self & ); // purposely not implemented
+
+  RegionType        m_LargestPossibleRegion;
+  PointType         m_Origin;
+  SpacingType       m_Spacing;
+  DirectionType     m_Direction;
+  SizeValueType     m_NumberOfVoxels;
+  WordContainerType m_Words;
+
+}; // end class BitPackedMask
+
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkBitPackedMask.hxx"
+#endif
+
+#endif // end #ifndef __itkBitPackedMask_h_
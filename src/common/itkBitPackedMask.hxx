@@ -0,0 +1,402 @@
+/*=========================================================================
+*
+* Copyright Marius Staring, Stefan Klein, David Doria. 2011.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0.txt
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*=========================================================================*/
+#ifndef _itkBitPackedMask_hxx_
+#define _itkBitPackedMask_hxx_
+
+#include "itkBitPackedMask.h"
+
+#include "itkImageScanlineConstIterator.h"
+#include "itkImageScanlineIterator.h"
+#include "itkNumericTraits.h"
+
+#include <algorithm>
+#include <bitset>
+
+
+namespace itk
+{
+
+/**
+ * ********************* Constructor ****************************
+ */
+
+template< unsigned int VDimension >
+BitPackedMask< VDimension >
+::BitPackedMask()
+{
+  this->m_Origin.Fill( 0.0 );
+  this->m_Spacing.Fill( 1.0 );
+  this->m_Direction.SetIdentity();
+  this->m_NumberOfVoxels = 0;
+} // end Constructor
+
+
+/**
+ * ********************* SetGeometry ****************************
+ */
+
+template< unsigned int VDimension >
+void
+BitPackedMask< VDimension >
+::SetGeometry( const ImageBaseType * image )
+{
+  this->m_LargestPossibleRegion = image->GetLargestPossibleRegion();
+  this->m_Origin = image->GetOrigin();
+  this->m_Spacing = image->GetSpacing();
+  this->m_Direction = image->GetDirection();
+  this->Allocate();
+} // end SetGeometry()
+
+
+/**
+ * ********************* SetGeometry ****************************
+ */
+
+template< unsigned int VDimension >
+void
+BitPackedMask< VDimension >
+::SetGeometry( const Self * mask )
+{
+  this->m_LargestPossibleRegion = mask->GetLargestPossibleRegion();
+  this->m_Origin = mask->GetOrigin();
+  this->m_Spacing = mask->GetSpacing();
+  this->m_Direction = mask->GetDirection();
+  this->Allocate();
+} // end SetGeometry()
+
+
+/**
+ * ********************* Allocate ****************************
+ */
+
+template< unsigned int VDimension >
+void
+BitPackedMask< VDimension >
+::Allocate( void )
+{
+  this->m_NumberOfVoxels = this->m_LargestPossibleRegion.GetNumberOfPixels();
+  this->m_Words.assign( ( this->m_NumberOfVoxels + WordSize - 1 ) / WordSize, 0 );
+  this->Modified();
+} // end Allocate()
+
+
+/**
+ * ********************* ComputeOffset ****************************
+ */
+
+template< unsigned int VDimension >
+SizeValueType
+BitPackedMask< VDimension >
+::ComputeOffset( const IndexType & index ) const
+{
+  const IndexType & start = this->m_LargestPossibleRegion.GetIndex();
+  const typename RegionType::SizeType & size = this->m_LargestPossibleRegion.GetSize();
+
+  SizeValueType offset = 0;
+  SizeValueType stride = 1;
+  for( unsigned int i = 0; i < VDimension; ++i )
+  {
+    offset += static_cast< SizeValueType >( index[ i ] - start[ i ] ) * stride;
+    stride *= size[ i ];
+  }
+  return offset;
+
+} // end ComputeOffset()
+
+
+/**
+ * ********************* Pack ****************************
+ */
+
+template< unsigned int VDimension >
+template< class TImage >
+bool
+BitPackedMask< VDimension >
+::Pack( const TImage * image, const RegionType & region )
+{
+  typedef typename TImage::PixelType                PixelType;
+  typedef ImageScanlineConstIterator< TImage >      IteratorType;
+
+  const PixelType zero = NumericTraits< PixelType >::ZeroValue();
+  const PixelType one = NumericTraits< PixelType >::OneValue();
+
+  bool isBinary = true;
+  IteratorType it( image, region );
+  while( !it.IsAtEnd() )
+  {
+    SizeValueType offset = this->ComputeOffset( it.GetIndex() );
+    while( !it.IsAtEndOfLine() )
+    {
+      const PixelType value = it.Get();
+      if( value != zero )
+      {
+        this->SetBit( offset );
+        isBinary &= value == one;
+      }
+      ++offset;
+      ++it;
+    }
+    it.NextLine();
+  }
+
+  this->Modified();
+  return isBinary;
+
+} // end Pack()
+
+
+/**
+ * ********************* Unpack ****************************
+ */
+
+template< unsigned int VDimension >
+template< class TImage >
+void
+BitPackedMask< VDimension >
+::Unpack( TImage * image, const RegionType & region ) const
+{
+  typedef typename TImage::PixelType                PixelType;
+  typedef ImageScanlineIterator< TImage >           IteratorType;
+
+  const PixelType zero = NumericTraits< PixelType >::ZeroValue();
+  const PixelType one = NumericTraits< PixelType >::OneValue();
+
+  IteratorType it( image, region );
+  while( !it.IsAtEnd() )
+  {
+    SizeValueType offset = this->ComputeOffset( it.GetIndex() );
+    while( !it.IsAtEndOfLine() )
+    {
+      it.Set( this->GetBit( offset ) ? one : zero );
+      ++offset;
+      ++it;
+    }
+    it.NextLine();
+  }
+
+} // end Unpack()
+
+
+/**
+ * ********************* CheckSize ****************************
+ */
+
+template< unsigned int VDimension >
+void
+BitPackedMask< VDimension >
+::CheckSize( const Self * other ) const
+{
+  /** Equal voxel counts are not enough: a 64x32 and a 32x64 mask would be
+   * combined bit by bit.
+   */
+  if( other->GetLargestPossibleRegion() != this->m_LargestPossibleRegion )
+  {
+    itkExceptionMacro( << "The masks have a different region: "
+      << this->m_LargestPossibleRegion.GetIndex() << this->m_LargestPossibleRegion.GetSize()
+      << " and " << other->GetLargestPossibleRegion().GetIndex()
+      << other->GetLargestPossibleRegion().GetSize() << "." );
+  }
+} // end CheckSize()
+
+
+/**
+ * ********************* And ****************************
+ */
+
+template< unsigned int VDimension >
+void
+BitPackedMask< VDimension >
+::And( const Self * other )
+{
+  this->CheckSize( other );
+  const WordType * b = other->GetBufferPointer();
+  for( SizeValueType i = 0; i < this->m_Words.size(); ++i )
+  {
+    this->m_Words[ i ] &= b[ i ];
+  }
+  this->Modified();
+} // end And()
+
+
+/**
+ * ********************* Or ****************************
+ */
+
+template< unsigned int VDimension >
+void
+BitPackedMask< VDimension >
+::Or( const Self * other )
+{
+  this->CheckSize( other );
+  const WordType * b = other->GetBufferPointer();
+  for( SizeValueType i = 0; i < this->m_Words.size(); ++i )
+  {
+    this->m_Words[ i ] |= b[ i ];
+  }
+  this->Modified();
+} // end Or()
+
+
+/**
+ * ********************* Xor ****************************
+ */
+
+template< unsigned int VDimension >
+void
+BitPackedMask< VDimension >
+::Xor( const Self * other )
+{
+  this->CheckSize( other );
+  const WordType * b = other->GetBufferPointer();
+  for( SizeValueType i = 0; i < this->m_Words.size(); ++i )
+  {
+    this->m_Words[ i ] ^= b[ i ];
+  }
+  this->Modified();
+} // end Xor()
+
+
+/**
+ * ********************* AndNot ****************************
+ */
+
+template< unsigned int VDimension >
+void
+BitPackedMask< VDimension >
+::AndNot( const Self * other )
+{
+  this->CheckSize( other );
+  const WordType * b = other->GetBufferPointer();
+  for( SizeValueType i = 0; i < this->m_Words.size(); ++i )
+  {
+    this->m_Words[ i ] &= ~b[ i ];
+  }
+  this->Modified();
+} // end AndNot()
+
+
+/**
+ * ********************* OrNot ****************************
+ */
+
+template< unsigned int VDimension >
+void
+BitPackedMask< VDimension >
+::OrNot( const Self * other )
+{
+  this->CheckSize( other );
+  const WordType * b = other->GetBufferPointer();
+  for( SizeValueType i = 0; i < this->m_Words.size(); ++i )
+  {
+    this->m_Words[ i ] |= ~b[ i ];
+  }
+  this->ClearUnusedBits();
+  this->Modified();
+} // end OrNot()
+
+
+/**
+ * ********************* Not ****************************
+ */
+
+template< unsigned int VDimension >
+void
+BitPackedMask< VDimension >
+::Not( void )
+{
+  for( SizeValueType i = 0; i < this->m_Words.size(); ++i )
+  {
+    this->m_Words[ i ] = ~this->m_Words[ i ];
+  }
+  this->ClearUnusedBits();
+  this->Modified();
+} // end Not()
+
+
+/**
+ * ********************* Fill ****************************
+ */
+
+template< unsigned int VDimension >
+void
+BitPackedMask< VDimension >
+::Fill( const bool value )
+{
+  std::fill( this->m_Words.begin(), this->m_Words.end(),
+    value ? ~WordType( 0 ) : WordType( 0 ) );
+  this->ClearUnusedBits();
+  this->Modified();
+} // end Fill()
+
+
+/**
+ * ********************* ClearUnusedBits ****************************
+ */
+
+template< unsigned int VDimension >
+void
+BitPackedMask< VDimension >
+::ClearUnusedBits( void )
+{
+  const SizeValueType usedBits = this->m_NumberOfVoxels % WordSize;
+  if( usedBits != 0 )
+  {
+    this->m_Words.back() &= ( WordType( 1 ) << usedBits ) - 1;
+  }
+} // end ClearUnusedBits()
+
+
+/**
+ * ********************* CountNonZero ****************************
+ */
+
+template< unsigned int VDimension >
+SizeValueType
+BitPackedMask< VDimension >
+::CountNonZero( void ) const
+{
+  SizeValueType count = 0;
+  for( SizeValueType i = 0; i < this->m_Words.size(); ++i )
+  {
+    count += std::bitset< WordSize >( this->m_Words[ i ] ).count();
+  }
+  return count;
+
+} // end CountNonZero()
+
+
+/**
+ * ********************* PrintSelf ****************************
+ */
+
+template< unsigned int VDimension >
+void
+BitPackedMask< VDimension >
+::PrintSelf( std::ostream & os, Indent indent ) const
+{
+  Superclass::PrintSelf( os, indent );
+
+  os << indent << "LargestPossibleRegion: " << this->m_LargestPossibleRegion << std::endl;
+  os << indent << "NumberOfVoxels: " << this->m_NumberOfVoxels << std::endl;
+  os << indent << "NumberOfWords: " << this->m_Words.size() << std::endl;
+
+} // end PrintSelf()
+
+} // end namespace itk
+
+#endif // end #ifndef _itkBitPackedMask_hxx_
@@ -0,0 +1,87 @@
+/*=========================================================================
+*
+* Copyright Marius Staring, Stefan Klein, David Doria. 2011.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0.txt
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*=========================================================================*/
+#ifndef __itkBitPackedMaskToImageFilter_h_
+#define __itkBitPackedMaskToImageFilter_h_
+
+#include "itkImageSource.h"
+#include "itkBitPackedMask.h"
+
+
+namespace itk
+{
+
+/** \class BitPackedMaskToImageFilter
+ * \brief Converts a BitPackedMask to an image of 0 and 1.
+ *
+ * Only the requested region is unpacked, so that the result can be
+ * written to disk in streams without allocating the full image.
+ */
+
+template< class TOutputImage >
+class ITK_EXPORT BitPackedMaskToImageFilter : public ImageSource< TOutputImage >
+{
+public:
+  /** Standard class typedefs. */
+  typedef BitPackedMaskToImageFilter    Self;
+  typedef ImageSource< TOutputImage >   Superclass;
+  typedef SmartPointer< Self >          Pointer;
+  typedef SmartPointer< const Self >    ConstPointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro( Self );
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro( BitPackedMaskToImageFilter, ImageSource );
+
+  /** Dimension of the image. */
+  itkStaticConstMacro( ImageDimension, unsigned int, TOutputImage::ImageDimension );
+
+  /** Typedefs. */
+  typedef TOutputImage                                OutputImageType;
+  typedef typename OutputImageType::RegionType        OutputImageRegionType;
+  typedef BitPackedMask< itkGetStaticConstMacro( ImageDimension ) > MaskType;
+
+  /** Set and get the mask. */
+  itkSetConstObjectMacro( Mask, MaskType );
+  itkGetConstObjectMacro( Mask, MaskType );
+
+protected:
+  BitPackedMaskToImageFilter();
+  virtual ~BitPackedMaskToImageFilter() {};
+
+  /** Copy the geometry of the mask to the output. */
+  virtual void GenerateOutputInformation( void );
+
+  /** Unpack the requested region. */
+  virtual void DynamicThreadedGenerateData( const OutputImageRegionType & outputRegionForThread );
+
+private:
+  BitPackedMaskToImageFilter( const Self & ); // purposely not implemented
+  void operator=( const Self & ); // purposely not implemented
+
+  typename MaskType::ConstPointer m_Mask;
+
+}; // end class BitPackedMaskToImageFilter
+
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkBitPackedMaskToImageFilter.hxx"
+#endif
+
+#endif // end #ifndef __itkBitPackedMaskToImageFilter_h_
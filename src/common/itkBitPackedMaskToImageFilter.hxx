@@ -0,0 +1,77 @@
+/*=========================================================================
+*
+* Copyright Marius Staring, Stefan Klein, David Doria. 2011.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0.txt
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*=========================================================================*/
+#ifndef _itkBitPackedMaskToImageFilter_hxx_
+#define _itkBitPackedMaskToImageFilter_hxx_
+
+#include "itkBitPackedMaskToImageFilter.h"
+
+
+namespace itk
+{
+
+/**
+ * ********************* Constructor ****************************
+ */
+
+template< class TOutputImage >
+BitPackedMaskToImageFilter< TOutputImage >
+::BitPackedMaskToImageFilter()
+{
+  this->DynamicMultiThreadingOn();
+} // end Constructor
+
+
+/**
+ * ********************* GenerateOutputInformation ****************************
+ */
+
+template< class TOutputImage >
+void
+BitPackedMaskToImageFilter< TOutputImage >
+::GenerateOutputInformation( void )
+{
+  if( this->m_Mask.IsNull() )
+  {
+    itkExceptionMacro( << "No mask has been set." );
+  }
+
+  OutputImageType * output = this->GetOutput();
+  output->SetLargestPossibleRegion( this->m_Mask->GetLargestPossibleRegion() );
+  output->SetOrigin( this->m_Mask->GetOrigin() );
+  output->SetSpacing( this->m_Mask->GetSpacing() );
+  output->SetDirection( this->m_Mask->GetDirection() );
+
+} // end GenerateOutputInformation()
+
+
+/**
+ * ********************* DynamicThreadedGenerateData ****************************
+ */
+
+template< class TOutputImage >
+void
+BitPackedMaskToImageFilter< TOutputImage >
+::DynamicThreadedGenerateData( const OutputImageRegionType & outputRegionForThread )
+{
+  this->m_Mask->Unpack( this->GetOutput(), outputRegionForThread );
+
+} // end DynamicThreadedGenerateData()
+
+} // end namespace itk
+
+#endif // end #ifndef _itkBitPackedMaskToImageFilter_hxx_
@@ -32,6 +32,9 @@ namespace itk
  *  The user can specify the inputs to this filter in two ways. First, they can specify a single filter to be used
  *  on every channel of the image. Second, they can specify a different filter (of the same class, but with different
  *  parameters) for each channel of the image. Filters with multiple inputs are allowed.
+ *
+ *  Pixel wise operations are better done with the itk::UnaryComponentWiseVectorImageFilter or the
+ *  itk::BinaryComponentWiseVectorImageFilter, which work directly on the interleaved buffer.
  */
 template <class TInputImage, class TOutputImage = TInputImage>
 class ITK_EXPORT ChannelByChannelVectorImageFilter
@@ -28,6 +28,10 @@ namespace itk
 {
 /** \class ChannelByChannelVectorImageFilter2
  *  \brief This filter is a helper class to apply per channel a standard itk::ImageToImageFilter to a VectorImage.
+ *
+ *  Every channel is extracted, filtered and reassembled, which costs a copy of the image per channel.
+ *  Pixel wise operations are better done with the itk::UnaryComponentWiseVectorImageFilter or the
+ *  itk::BinaryComponentWiseVectorImageFilter, which work directly on the interleaved buffer.
  */
 template <class TInputImage, class TFilter, class TOutputImage = TInputImage>
 class ITK_EXPORT ChannelByChannelVectorImageFilter2
@@ -52,32 +52,32 @@ void
 ChannelByChannelVectorImageFilter2<TInputImage, TFilter, TOutputImage>
 ::GenerateData()
 {
-  // Create the disassembler
-  typedef itk::VectorIndexSelectionCastImageFilter<TInputImage, InputScalarImageType> IndexSelectionType;
-  typename IndexSelectionType::Pointer indexSelectionFilter = IndexSelectionType::New();
-  indexSelectionFilter->SetInput(this->GetInput());
+  const unsigned int numberOfChannels = this->GetInput()->GetNumberOfComponentsPerPixel();
 
   // Create the re-assembler
   typedef itk::ComposeImageFilter<InputScalarImageType> ImageToVectorImageFilterType;
   typename ImageToVectorImageFilterType::Pointer imageToVectorImageFilter = ImageToVectorImageFilterType::New();
 
   // Create a filter for each channel - duplicating all of the settings of the input filter
-  std::vector<typename TFilter::Pointer> filters;
+  std::vector<typename TFilter::Pointer> filters( numberOfChannels );
   filters[0] = m_Filter;
 
-  for(unsigned int i = 1; i < this->GetInput()->GetNumberOfComponentsPerPixel(); i++)
+  for(unsigned int i = 1; i < numberOfChannels; i++)
     {
     filters[i] = dynamic_cast<FilterType*>(m_Filter->CreateAnother().GetPointer());
     }
 
-  // Apply the filter to each channel
-  for(unsigned int channel = 0; channel < this->GetInput()->GetNumberOfComponentsPerPixel(); channel++)
+  // Apply the filter to each channel. Every channel needs its own disassembler,
+  // since the re-assembler updates the whole pipeline again.
+  typedef itk::VectorIndexSelectionCastImageFilter<TInputImage, InputScalarImageType> IndexSelectionType;
+  std::vector<typename IndexSelectionType::Pointer> indexSelectionFilters( numberOfChannels );
+  for(unsigned int channel = 0; channel < numberOfChannels; channel++)
     {
-    indexSelectionFilter->SetIndex(channel);
-    indexSelectionFilter->Update();
+    indexSelectionFilters[channel] = IndexSelectionType::New();
+    indexSelectionFilters[channel]->SetInput(this->GetInput());
+    indexSelectionFilters[channel]->SetIndex(channel);
 
-    filters[channel]->SetInput(indexSelectionFilter->GetOutput());
-    filters[channel]->Update();
+    filters[channel]->SetInput(indexSelectionFilters[channel]->GetOutput());
 
     imageToVectorImageFilter->SetInput(channel, filters[channel]->GetOutput());
     }
@@ -0,0 +1,88 @@
+/*=========================================================================
+*
+* Copyright Marius Staring, Stefan Klein, David Doria. 2011.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0.txt
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*=========================================================================*/
+#ifndef __itkUnaryComponentWiseVectorImageFilter_h_
+#define __itkUnaryComponentWiseVectorImageFilter_h_
+
+#include "itkInPlaceImageFilter.h"
+
+
+namespace itk
+{
+
+/** \class UnaryComponentWiseVectorImageFilter
+ * \brief Applies a unary functor to every component of an image.
+ *
+ * The unary counterpart of the BinaryComponentWiseVectorImageFilter: for an
+ * itk::VectorImage the functor works directly on the interleaved buffer,
+ * in a single multi-threaded pass, instead of channel by channel.
+ */
+
+template< class TInputImage, class TOutputImage, class TFunctor >
+class ITK_EXPORT UnaryComponentWiseVectorImageFilter
+  : public InPlaceImageFilter< TInputImage, TOutputImage >
+{
+public:
+  /** Standard class typedefs. */
+  typedef UnaryComponentWiseVectorImageFilter             Self;
+  typedef InPlaceImageFilter< TInputImage, TOutputImage > Superclass;
+  typedef SmartPointer< Self >                            Pointer;
+  typedef SmartPointer< const Self >                      ConstPointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro( Self );
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro( UnaryComponentWiseVectorImageFilter, InPlaceImageFilter );
+
+  /** Typedefs. */
+  typedef TInputImage                                 InputImageType;
+  typedef TOutputImage                                OutputImageType;
+  typedef typename OutputImageType::RegionType        OutputImageRegionType;
+  typedef typename InputImageType::InternalPixelType  InputComponentType;
+  typedef typename OutputImageType::InternalPixelType OutputComponentType;
+  typedef TFunctor                                    FunctorType;
+
+  /** Get the functor, e.g. to set its parameters. */
+  FunctorType & GetFunctor( void ) { return this->m_Functor; }
+  const FunctorType & GetFunctor( void ) const { return this->m_Functor; }
+
+protected:
+  UnaryComponentWiseVectorImageFilter();
+  virtual ~UnaryComponentWiseVectorImageFilter() {};
+
+  /** The output has as many components as the input. */
+  virtual void GenerateOutputInformation( void );
+
+  /** Apply the functor to the components of a region. */
+  virtual void DynamicThreadedGenerateData( const OutputImageRegionType & outputRegionForThread );
+
+private:
+  UnaryComponentWiseVectorImageFilter( const Self & ); // purposely not implemented
+  void operator=( const Self & ); // purposely not implemented
+
+  FunctorType m_Functor;
+
+}; // end class UnaryComponentWiseVectorImageFilter
+
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkUnaryComponentWiseVectorImageFilter.hxx"
+#endif
+
+#endif // end #ifndef __itkUnaryComponentWiseVectorImageFilter_h_
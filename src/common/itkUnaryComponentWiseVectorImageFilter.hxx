@@ -0,0 +1,102 @@
+/*=========================================================================
+*
+* Copyright Marius Staring, Stefan Klein, David Doria. 2011.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0.txt
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*=========================================================================*/
+#ifndef _itkUnaryComponentWiseVectorImageFilter_hxx_
+#define _itkUnaryComponentWiseVectorImageFilter_hxx_
+
+#include "itkUnaryComponentWiseVectorImageFilter.h"
+
+#include "itkImageScanlineIterator.h"
+
+
+namespace itk
+{
+
+/**
+ * ********************* Constructor ****************************
+ */
+
+template< class TInputImage, class TOutputImage, class TFunctor >
+UnaryComponentWiseVectorImageFilter< TInputImage, TOutputImage, TFunctor >
+::UnaryComponentWiseVectorImageFilter()
+{
+  this->DynamicMultiThreadingOn();
+  this->InPlaceOff();
+} // end Constructor
+
+
+/**
+ * ********************* GenerateOutputInformation ****************************
+ */
+
+template< class TInputImage, class TOutputImage, class TFunctor >
+void
+UnaryComponentWiseVectorImageFilter< TInputImage, TOutputImage, TFunctor >
+::GenerateOutputInformation( void )
+{
+  Superclass::GenerateOutputInformation();
+
+  this->GetOutput()->SetNumberOfComponentsPerPixel(
+    this->GetInput()->GetNumberOfComponentsPerPixel() );
+
+} // end GenerateOutputInformation()
+
+
+/**
+ * ********************* DynamicThreadedGenerateData ****************************
+ */
+
+template< class TInputImage, class TOutputImage, class TFunctor >
+void
+UnaryComponentWiseVectorImageFilter< TInputImage, TOutputImage, TFunctor >
+::DynamicThreadedGenerateData( const OutputImageRegionType & outputRegionForThread )
+{
+  typedef ImageScanlineIterator< OutputImageType >    OutputIteratorType;
+  typedef typename OutputImageType::IndexType         IndexType;
+
+  const InputImageType * input = this->GetInput();
+  OutputImageType * output = this->GetOutput();
+
+  /** A scan line is contiguous in both buffers, so that it can be processed
+   * as one array of components.
+   */
+  const SizeValueType numberOfComponents = output->GetNumberOfComponentsPerPixel();
+  const SizeValueType lineLength = outputRegionForThread.GetSize( 0 ) * numberOfComponents;
+  const InputComponentType * inBuffer = input->GetBufferPointer();
+  OutputComponentType * outBuffer = output->GetBufferPointer();
+  FunctorType functor = this->m_Functor;
+
+  OutputIteratorType outIt( output, outputRegionForThread );
+  while( !outIt.IsAtEnd() )
+  {
+    const IndexType index = outIt.GetIndex();
+    const InputComponentType * in = inBuffer + numberOfComponents * input->ComputeOffset( index );
+    OutputComponentType * out = outBuffer + numberOfComponents * output->ComputeOffset( index );
+
+    for( SizeValueType i = 0; i < lineLength; ++i )
+    {
+      out[ i ] = static_cast< OutputComponentType >( functor( in[ i ] ) );
+    }
+
+    outIt.NextLine();
+  }
+
+} // end DynamicThreadedGenerateData()
+
+} // end namespace itk
+
+#endif // end #ifndef _itkUnaryComponentWiseVectorImageFilter_hxx_
@@ -27,8 +27,7 @@
 #include "itkCommandLineArgumentParser.h"
 #include "ITKToolsHelpers.h"
 
-#include "itkImageFileReader.h"
-#include "itkImageRegionConstIterator.h"
+#include "ITKToolsImageReading.h"
 
 
 /**
@@ -41,7 +40,10 @@ std::string GetHelpString( void )
   ss << "ITKTools v" << itktools::GetITKToolsVersion() << "\n"
     << "Usage:\n"
     << "pxcountnonzerovoxels\n"
-    << "  -in      inputFilename";
+    << "  -in      inputFilename\n"
+    << "  [-s]     number of streams, default 1.\n"
+    << "The image is read as a bit-packed mask, one bit per voxel, in the given\n"
+    << "number of streams, and the nonzero voxels are counted 64 at a time.";
   return ss.str();
 
 } // end GetHelpString()
@@ -75,6 +77,9 @@ int main( int argc, char *argv[] )
   std::string inputFileName;
   parser->GetCommandLineArgument( "-in", inputFileName );
 
+  unsigned int numberOfStreams = 1;
+  parser->GetCommandLineArgument( "-s", numberOfStreams );
+
   // Some consts.
   const unsigned int  Dimension = 3;
   typedef short PixelType;
@@ -82,16 +87,15 @@ int main( int argc, char *argv[] )
   // TYPEDEF's
   typedef itk::Image< PixelType, Dimension >          ImageType;
   typedef ImageType::SpacingType                      SpacingType;
-  typedef itk::ImageFileReader< ImageType >           ReaderType;
-  typedef itk::ImageRegionConstIterator< ImageType >  IteratorType;
-
-  /** Read image. */
-  ReaderType::Pointer reader = ReaderType::New();
-  reader->SetFileName( inputFileName.c_str() );
+  typedef itk::BitPackedMask< Dimension >             MaskType;
 
+  /** Read image as a bit-packed mask. */
+  MaskType::Pointer mask;
   try
   {
-    reader->Update();
+    bool isBinary = false;
+    mask = itktools::ReadBitPackedMask< ImageType >(
+      inputFileName, numberOfStreams, isBinary );
   }
   catch( itk::ExceptionObject & excp )
   {
@@ -102,28 +106,15 @@ int main( int argc, char *argv[] )
   }
 
   /** Get the spacing. */
-  SpacingType sp = reader->GetOutput()->GetSpacing();
+  SpacingType sp = mask->GetSpacing();
   double voxelVolume = 1.0;
   for( unsigned int i = 0; i < Dimension; i++ )
   {
     voxelVolume *= sp[ i ];
   }
 
-  /** Create iterator and counter. */
-  IteratorType it( reader->GetOutput(),
-    reader->GetOutput()->GetLargestPossibleRegion() );
-  it.GoToBegin();
-  std::size_t counter = 0;
-
-  /** Walk over the image. */
-  while ( !it.IsAtEnd() )
-  {
-    if( it.Value() )
-    {
-      counter++;
-    }
-    ++it;
-  } // end while
+  /** Count the nonzero voxels, using popcount. */
+  const std::size_t counter = mask->CountNonZero();
 
   /** Print to screen. */
   std::cout << "count: " << counter << std::endl;
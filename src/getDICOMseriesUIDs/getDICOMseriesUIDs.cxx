@@ -25,7 +25,8 @@
 #include "ITKToolsHelpers.h"
 #include <iostream>
 #include <itksys/SystemTools.hxx>
-#include "itkGDCMSeriesFileNames.h"
+#include "ITKToolsDICOMDirectoryIndex.h"
+#include "itkMacro.h"
 
 
 /**
@@ -41,7 +42,11 @@ std::string GetHelpString( void )
   << "  -in      inputDirectoryName" << std::endl
   << "  [-r]     add restrictions to generate a unique seriesUID" << std::endl
   << "           e.g. \"0020|0012\" to add a check for acquisition" << std::endl
-  << "number.";
+  << "number." << std::endl
+  << "  [-index] read and write the index of the directory" << std::endl
+  << "With -index the directory is indexed in the file " << itktools::DICOMDirectoryIndex::IndexFileName << "," << std::endl
+  << "so that a next call only parses the new and changed files." << std::endl
+  << "This writes into the directory, so it is off by default.";
 
   return ss.str();
 
@@ -76,6 +81,8 @@ int main( int argc, char **argv )
   std::vector<std::string> restrictions;
   parser->GetCommandLineArgument( "-r", restrictions );
 
+  const bool useIndexFile = parser->ArgumentExists( "-index" );
+
   /** Make sure last character of inputDirectoryName != "/".
    * Otherwise FileIsDirectory() won't work.
    */
@@ -95,18 +102,28 @@ int main( int argc, char **argv )
     return EXIT_FAILURE;
   }
 
-  typedef itk::GDCMSeriesFileNames                GDCMNamesGeneratorType;
-  typedef std::vector< std::string >              FileNamesContainerType;
+  typedef itktools::DICOMDirectoryIndex          DICOMDirectoryIndexType;
+  typedef DICOMDirectoryIndexType::SeriesUIDContainerType SeriesUIDContainerType;
 
   /** Get the seriesUIDs from the DICOM directory. */
-  GDCMNamesGeneratorType::Pointer nameGenerator = GDCMNamesGeneratorType::New();
-  nameGenerator->SetUseSeriesDetails( true );
-  for( unsigned int i = 0; i < restrictions.size(); ++i )
+  DICOMDirectoryIndexType directoryIndex;
+  directoryIndex.SetDirectory( inputDirectoryName );
+  directoryIndex.SetUseIndexFile( useIndexFile );
+  SeriesUIDContainerType seriesNames;
+  try
+  {
+    for( unsigned int i = 0; i < restrictions.size(); ++i )
+    {
+      directoryIndex.AddSeriesRestriction( restrictions[ i ] );
+    }
+    directoryIndex.Update();
+    seriesNames = directoryIndex.GetSeriesUIDs();
+  }
+  catch( itk::ExceptionObject & excp )
   {
-    nameGenerator->AddSeriesRestriction( restrictions[ i ] );
+    std::cerr << "ERROR: Caught ITK exception: " << excp << std::endl;
+    return EXIT_FAILURE;
   }
-  nameGenerator->SetInputDirectory( inputDirectoryName.c_str() );
-  FileNamesContainerType seriesNames = nameGenerator->GetSeriesUIDs();
 
   /** Check. */
   if( !seriesNames.size() )
@@ -27,7 +27,7 @@
 #include <itksys/SystemTools.hxx>
 #include "itkImageSeriesReader.h"
 #include "itkGDCMImageIO.h"
-#include "itkGDCMSeriesFileNames.h"
+#include "ITKToolsDICOMDirectoryIndex.h"
 
 
 /**
@@ -44,7 +44,11 @@ std::string GetHelpString( void )
     << "  [-s]     seriesUID\n"
     << "  [-r]     add restrictions to generate a unique seriesUID\n"
     << "           e.g. \"0020|0012\" to add a check for acquisition number.\n"
-    << "By default the first series encountered is used.";
+    << "  [-index] read and write the index of the directory\n"
+    << "By default the first series encountered is used.\n"
+    << "With -index the directory is indexed in the file " << itktools::DICOMDirectoryIndex::IndexFileName << ",\n"
+    << "so that a next call only parses the new and changed files.\n"
+    << "This writes into the directory, so it is off by default.";
 
   return ss.str();
 
@@ -80,6 +84,8 @@ int main( int argc, char **argv )
   std::vector<std::string> restrictions;
   parser->GetCommandLineArgument( "-r", restrictions );
 
+  const bool useIndexFile = parser->ArgumentExists( "-index" );
+
   /** Make sure last character of inputDirectoryName != "/".
    * Otherwise FileIsDirectory() won't work.
    */
@@ -103,30 +109,32 @@ int main( int argc, char **argv )
   typedef itk::Image< short, 3>               ImageType;
   typedef itk::ImageSeriesReader< ImageType > SeriesReaderType;
   typedef itk::GDCMImageIO                    GDCMImageIOType;
-  typedef itk::GDCMSeriesFileNames            GDCMNamesGeneratorType;
+  typedef itktools::DICOMDirectoryIndex       DICOMDirectoryIndexType;
   typedef std::vector< std::string >          FileNamesContainerType;
 
-  /** Get the seriesUIDs from the DICOM directory.
-   * With SetUseSeriesDetails( true ) series UIDs are generated that
-   * are unique and therefore extra long.
+  /** Get the file names of the series from the DICOM directory.
+   * The series UIDs are generated as GDCMSeriesFileNames does with
+   * SetUseSeriesDetails( true ), so they are unique and therefore extra long.
+   * An empty seriesNumber selects the first series.
    */
-  GDCMNamesGeneratorType::Pointer nameGenerator = GDCMNamesGeneratorType::New();
-  nameGenerator->SetUseSeriesDetails( true );
-  for( unsigned int i = 0; i < restrictions.size(); ++i )
-  {
-    nameGenerator->AddSeriesRestriction( restrictions[ i ] );
-  }
-  nameGenerator->SetInputDirectory( inputDirectoryName.c_str() );
-
-  /** Generate the file names corresponding to the series. */
+  DICOMDirectoryIndexType directoryIndex;
+  directoryIndex.SetDirectory( inputDirectoryName );
+  directoryIndex.SetUseIndexFile( useIndexFile );
   FileNamesContainerType fileNames;
-  if( seriesNumber == "" )
+  try
   {
-    fileNames = nameGenerator->GetInputFileNames();
+    for( unsigned int i = 0; i < restrictions.size(); ++i )
+    {
+      directoryIndex.AddSeriesRestriction( restrictions[ i ] );
+    }
+    directoryIndex.Update();
+    fileNames = directoryIndex.GetFileNames( seriesNumber );
   }
-  else
+  catch( itk::ExceptionObject & excp )
   {
-    fileNames = nameGenerator->GetFileNames( seriesNumber );
+    std::cerr << "ExceptionObject caught !"  << std::endl;
+    std::cerr << excp <<  std::endl;
+    return EXIT_FAILURE;
   }
 
   /** Check if there is at least one dicom file in the directory. */
@@ -50,7 +50,9 @@ std::string GetHelpString( void )
     << "Usage:\n"
     << "pximagecompare\n"
     << "  -test      image filename to test against baseline\n"
-    << "  -base      baseline image filename";
+    << "  -base      baseline image filename\n"
+    << "  [-t]       intensity difference threshold, default 0;\n"
+    << "             pixels that differ by at most this value are equal";
   return ss.str();
 
 } // end GetHelpString()
@@ -89,6 +91,9 @@ int main( int argc, char **argv )
   std::string baselineImageFileName;
   parser->GetCommandLineArgument( "-base", baselineImageFileName );
 
+  double differenceThreshold = 0.0;
+  parser->GetCommandLineArgument( "-t", differenceThreshold );
+
   // Read images
   typedef itk::Image<double,ITK_TEST_DIMENSION_MAX>           ImageType;
   typedef itk::ImageFileReader<ImageType>                     ReaderType;
@@ -140,6 +145,7 @@ int main( int argc, char **argv )
   ComparisonFilterType::Pointer comparisonFilter = ComparisonFilterType::New();
   comparisonFilter->SetTestInput(testReader->GetOutput());
   comparisonFilter->SetValidInput(baselineReader->GetOutput());
+  comparisonFilter->SetDifferenceThreshold( differenceThreshold );
   try
   {
     comparisonFilter->Update();
@@ -0,0 +1,230 @@
+/*=========================================================================
+*
+* Copyright Marius Staring, Stefan Klein, David Doria. 2011.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0.txt
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*=========================================================================*/
+/** \file
+ \brief Evaluate a voxel wise expression of a number of images.
+
+ \verbinclude imageexpression.help
+ */
+
+/** Setup Mevislab DicomTiff IO support */
+#include "itkUseMevisDicomTiff.h"
+
+#include "itkCommandLineArgumentParser.h"
+#include "ITKToolsHelpers.h"
+#include "ITKToolsImageProperties.h"
+#include "imageexpression.h"
+
+
+/**
+ * ******************* GetHelpString *******************
+ */
+
+std::string GetHelpString( void )
+{
+  std::stringstream ss;
+  ss << "ITKTools v" << itktools::GetITKToolsVersion() << "\n"
+    << "Evaluates a voxel wise expression of a number of images in a single pass.\n"
+    << "Usage:\npximageexpression\n"
+    << "  -in      inputFilenames, optionally named as name=filename;\n"
+    << "           by default the inputs are named a, b, c, ...\n"
+    << "  -expr    the expression, e.g. \"(a+b)/2 > c ? a : 0\"\n"
+    << "           operators, from low to high precedence:\n"
+    << "             c ? a : b, ||, &&, == !=, < <= > >=, + -, * / %, unary - + !, ^\n"
+    << "           functions:\n"
+    << "             abs, sign, floor, ceil, round, ln, log10, exp,\n"
+    << "             sin, cos, tan, asin, acos, atan, erf, of one argument,\n"
+    << "             min, max, pow, log (base b), absdiff, sqdiff, magnitude, mod,\n"
+    << "             of two arguments, and\n"
+    << "             linear(x,a,b) = a * x + b, normcdf(x,mean,std), qfunc(x,mean,std),\n"
+    << "             with constant a, b, mean and std.\n"
+    << "           The expression is evaluated in double, with the same functors as\n"
+    << "           pxbinaryimageoperator and pxunaryimageoperator. Comparisons and\n"
+    << "           logical operators give 0 or 1. The result is clamped to the output type.\n"
+    << "           NaN, e.g. of 0/0, is written as 0 to an integer output type.\n"
+    << "  -out     outputFilename\n"
+    << "  [-z]     compression flag; if provided, the output image is compressed\n"
+    << "  [-s]     number of streams, default 1.\n"
+    << "  [-opct]  output component type, by default the largest of the input images\n"
+    << "             choose one of: {[unsigned_]{char,short,int,long},float,double}\n"
+    << "Supported: 2D, 3D, (unsigned) char, (unsigned) short, (unsigned) int, (unsigned) long, float, double.";
+
+  return ss.str();
+
+} // end GetHelpString()
+
+
+//-------------------------------------------------------------------------------------
+
+int main( int argc, char **argv )
+{
+  RegisterMevisDicomTiff();
+
+  /** Create a command line argument parser. */
+  itk::CommandLineArgumentParser::Pointer parser = itk::CommandLineArgumentParser::New();
+  parser->SetCommandLineArguments( argc, argv );
+  parser->SetProgramHelpText( GetHelpString() );
+
+  parser->MarkArgumentAsRequired( "-in", "The input filename." );
+  parser->MarkArgumentAsRequired( "-expr", "The expression." );
+  parser->MarkArgumentAsRequired( "-out", "The output filename." );
+
+  itk::CommandLineArgumentParser::ReturnValue validateArguments = parser->CheckForRequiredArguments();
+
+  if( validateArguments == itk::CommandLineArgumentParser::FAILED )
+  {
+    return EXIT_FAILURE;
+  }
+  else if( validateArguments == itk::CommandLineArgumentParser::HELPREQUESTED )
+  {
+    return EXIT_SUCCESS;
+  }
+
+  /** Get arguments. */
+  std::vector<std::string> inputs;
+  parser->GetCommandLineArgument( "-in", inputs );
+
+  std::string expression = "";
+  parser->GetCommandLineArgument( "-expr", expression );
+
+  std::string outputFileName = "";
+  parser->GetCommandLineArgument( "-out", outputFileName );
+
+  const bool useCompression = parser->ArgumentExists( "-z" );
+
+  unsigned int numberOfStreams = 1;
+  parser->GetCommandLineArgument( "-s", numberOfStreams );
+
+  std::string opct = "";
+  bool retopct = parser->GetCommandLineArgument( "-opct", opct );
+
+  /** Split the inputs in names and file names. */
+  std::vector<std::string> variableNames( inputs.size() );
+  std::vector<std::string> inputFileNames( inputs.size() );
+  for( unsigned int i = 0; i < inputs.size(); ++i )
+  {
+    const std::string::size_type pos = inputs[ i ].find( '=' );
+    if( pos != std::string::npos )
+    {
+      variableNames[ i ] = inputs[ i ].substr( 0, pos );
+      inputFileNames[ i ] = inputs[ i ].substr( pos + 1 );
+    }
+    else if( i < 26 )
+    {
+      variableNames[ i ] = std::string( 1, static_cast<char>( 'a' + i ) );
+      inputFileNames[ i ] = inputs[ i ];
+    }
+    else
+    {
+      std::cerr << "ERROR: please name input " << inputs[ i ] << " as name=filename." << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  /** Check the expression, before any image is read. */
+  try
+  {
+    itk::VoxelExpression voxelExpression;
+    voxelExpression.Compile( expression, variableNames );
+  }
+  catch( itk::ExceptionObject & excp )
+  {
+    std::cerr << "ERROR: " << excp.GetDescription() << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  /** Determine image properties. */
+  unsigned int dim = 2;
+  itk::ImageIOBase::IOComponentEnum componentType = itk::IOComponentEnum::UCHAR;
+  bool retgip = itktools::GetImageDimension( inputFileNames[ 0 ], dim );
+  if( !retgip ) return EXIT_FAILURE;
+  for( unsigned int i = 0; i < inputFileNames.size(); ++i )
+  {
+    itk::ImageIOBase::IOComponentEnum componentTypeIn;
+    retgip = itktools::GetImageComponentType( inputFileNames[ i ], componentTypeIn );
+    if( !retgip ) return EXIT_FAILURE;
+    componentType = i == 0 ? componentTypeIn
+      : itktools::GetLargestComponentType( componentType, componentTypeIn );
+  }
+
+  /** Let the user override the output component type. */
+  if( retopct )
+  {
+    componentType = itk::ImageIOBase::GetComponentTypeFromString( opct );
+    if( !itktools::ComponentTypeIsValid( componentType ) )
+    {
+      std::cerr << "ERROR: the you specified an invalid opct." << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+
+  /** Class that does the work. */
+  ITKToolsImageExpressionBase * filter = nullptr;
+
+  try
+  {
+    // now call all possible template combinations.
+    if( !filter ) filter = ITKToolsImageExpression< 2, char >::New( dim, componentType );
+    if( !filter ) filter = ITKToolsImageExpression< 2, unsigned char >::New( dim, componentType );
+    if( !filter ) filter = ITKToolsImageExpression< 2, short >::New( dim, componentType );
+    if( !filter ) filter = ITKToolsImageExpression< 2, unsigned short >::New( dim, componentType );
+    if( !filter ) filter = ITKToolsImageExpression< 2, int >::New( dim, componentType );
+    if( !filter ) filter = ITKToolsImageExpression< 2, unsigned int >::New( dim, componentType );
+    if( !filter ) filter = ITKToolsImageExpression< 2, long >::New( dim, componentType );
+    if( !filter ) filter = ITKToolsImageExpression< 2, unsigned long >::New( dim, componentType );
+    if( !filter ) filter = ITKToolsImageExpression< 2, float >::New( dim, componentType );
+    if( !filter ) filter = ITKToolsImageExpression< 2, double >::New( dim, componentType );
+
+#ifdef ITKTOOLS_3D_SUPPORT
+    if( !filter ) filter = ITKToolsImageExpression< 3, char >::New( dim, componentType );
+    if( !filter ) filter = ITKToolsImageExpression< 3, unsigned char >::New( dim, componentType );
+    if( !filter ) filter = ITKToolsImageExpression< 3, short >::New( dim, componentType );
+    if( !filter ) filter = ITKToolsImageExpression< 3, unsigned short >::New( dim, componentType );
+    if( !filter ) filter = ITKToolsImageExpression< 3, int >::New( dim, componentType );
+    if( !filter ) filter = ITKToolsImageExpression< 3, unsigned int >::New( dim, componentType );
+    if( !filter ) filter = ITKToolsImageExpression< 3, long >::New( dim, componentType );
+    if( !filter ) filter = ITKToolsImageExpression< 3, unsigned long >::New( dim, componentType );
+    if( !filter ) filter = ITKToolsImageExpression< 3, float >::New( dim, componentType );
+    if( !filter ) filter = ITKToolsImageExpression< 3, double >::New( dim, componentType );
+#endif
+    /** Check if filter was instantiated. */
+    bool supported = itktools::IsFilterSupportedCheck( filter, dim, componentType );
+    if( !supported ) return EXIT_FAILURE;
+
+    /** Set the filter arguments. */
+    filter->m_InputFileNames = inputFileNames;
+    filter->m_VariableNames = variableNames;
+    filter->m_OutputFileName = outputFileName;
+    filter->m_Expression = expression;
+    filter->m_UseCompression = useCompression;
+    filter->m_NumberOfStreams = numberOfStreams;
+
+    filter->Run();
+
+    delete filter;
+  }
+  catch( itk::ExceptionObject & excp )
+  {
+    std::cerr << "ERROR: Caught ITK exception: " << excp << std::endl;
+    delete filter;
+    return EXIT_FAILURE;
+  }
+
+  /** End program. */
+  return EXIT_SUCCESS;
+
+} // end main
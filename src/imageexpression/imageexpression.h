@@ -0,0 +1,157 @@
+/*=========================================================================
+*
+* Copyright Marius Staring, Stefan Klein, David Doria. 2011.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0.txt
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*=========================================================================*/
+#ifndef __imageexpression_h_
+#define __imageexpression_h_
+
+#include "ITKToolsBase.h"
+#include "ITKToolsHelpers.h"
+
+#include "itkImage.h"
+#include "itkImageFileReader.h"
+#include "itkImageFileWriter.h"
+#include "itkImageExpressionImageFilter.h"
+
+#include <vector>
+
+
+/** \class ITKToolsImageExpressionBase
+ *
+ * Untemplated pure virtual base class that holds
+ * the Run() function and all required parameters.
+ */
+
+class ITKToolsImageExpressionBase : public itktools::ITKToolsBase
+{
+public:
+  /** Constructor. */
+  ITKToolsImageExpressionBase()
+  {
+    this->m_OutputFileName = "";
+    this->m_Expression = "";
+    this->m_UseCompression = false;
+    this->m_NumberOfStreams = 1;
+  };
+  /** Destructor. */
+  ~ITKToolsImageExpressionBase(){};
+
+  /** Input member parameters. */
+  std::vector<std::string> m_InputFileNames;
+  std::vector<std::string> m_VariableNames;
+  std::string       m_OutputFileName;
+  std::string       m_Expression;
+  bool              m_UseCompression;
+  unsigned int      m_NumberOfStreams;
+
+}; // end class ITKToolsImageExpressionBase
+
+
+/** \class ITKToolsImageExpression
+ *
+ * Templated class that implements the Run() function
+ * and the New() function for its creation.
+ */
+
+template< unsigned int VDimension, class TComponentType >
+class ITKToolsImageExpression : public ITKToolsImageExpressionBase
+{
+public:
+  /** Standard ITKTools stuff. */
+  typedef ITKToolsImageExpression Self;
+  itktoolsOneTypeNewMacro( Self );
+
+  ITKToolsImageExpression(){};
+  ~ITKToolsImageExpression(){};
+
+  /** Typedefs. */
+  typedef itk::Image<TComponentType, VDimension>      OutputImageType;
+  typedef itk::ImageExpressionImageFilter<
+    OutputImageType >                                 ExpressionFilterType;
+  typedef itk::ImageFileWriter< OutputImageType >     WriterType;
+
+  /** Run function. */
+  void Run( void )
+  {
+    /** Set up the expression filter. */
+    typename ExpressionFilterType::Pointer expressionFilter = ExpressionFilterType::New();
+    expressionFilter->SetExpression( this->m_Expression );
+    expressionFilter->SetVariableNames( this->m_VariableNames );
+
+    /** Connect the readers. Each input is read in its own component type,
+     * and only converted to double per block during the evaluation.
+     */
+    std::vector< itk::ProcessObject::Pointer > readers( this->m_InputFileNames.size() );
+    for( unsigned int i = 0; i < this->m_InputFileNames.size(); ++i )
+    {
+      itk::ImageIOBase::IOComponentEnum componentType;
+      if( !itktools::GetImageComponentType( this->m_InputFileNames[ i ], componentType ) )
+      {
+        itkGenericExceptionMacro( << "Could not read " << this->m_InputFileNames[ i ] );
+      }
+      switch( componentType )
+      {
+      case itk::IOComponentEnum::UCHAR:
+        readers[ i ] = this->ConnectReader< unsigned char >( expressionFilter, i ); break;
+      case itk::IOComponentEnum::CHAR:
+        readers[ i ] = this->ConnectReader< char >( expressionFilter, i ); break;
+      case itk::IOComponentEnum::USHORT:
+        readers[ i ] = this->ConnectReader< unsigned short >( expressionFilter, i ); break;
+      case itk::IOComponentEnum::SHORT:
+        readers[ i ] = this->ConnectReader< short >( expressionFilter, i ); break;
+      case itk::IOComponentEnum::UINT:
+        readers[ i ] = this->ConnectReader< unsigned int >( expressionFilter, i ); break;
+      case itk::IOComponentEnum::INT:
+        readers[ i ] = this->ConnectReader< int >( expressionFilter, i ); break;
+      case itk::IOComponentEnum::ULONG:
+        readers[ i ] = this->ConnectReader< unsigned long >( expressionFilter, i ); break;
+      case itk::IOComponentEnum::LONG:
+        readers[ i ] = this->ConnectReader< long >( expressionFilter, i ); break;
+      case itk::IOComponentEnum::FLOAT:
+        readers[ i ] = this->ConnectReader< float >( expressionFilter, i ); break;
+      default:
+        readers[ i ] = this->ConnectReader< double >( expressionFilter, i ); break;
+      }
+    }
+
+    /** Write the image to disk, possibly streamed. */
+    typename WriterType::Pointer writer = WriterType::New();
+    writer->SetFileName( this->m_OutputFileName.c_str() );
+    writer->SetInput( expressionFilter->GetOutput() );
+    writer->SetUseCompression( this->m_UseCompression );
+    writer->SetNumberOfStreamDivisions( this->m_NumberOfStreams );
+    writer->Update();
+
+  } // end Run()
+
+  /** Read the i-th input as an image of TInputComponentType. */
+  template< class TInputComponentType >
+  itk::ProcessObject::Pointer ConnectReader(
+    ExpressionFilterType * expressionFilter, const unsigned int i )
+  {
+    typedef itk::Image<TInputComponentType, VDimension> InputImageType;
+    typedef itk::ImageFileReader< InputImageType >      ReaderType;
+
+    typename ReaderType::Pointer reader = ReaderType::New();
+    reader->SetFileName( this->m_InputFileNames[ i ] );
+    expressionFilter->SetInput( i, reader->GetOutput() );
+    return reader.GetPointer();
+
+  } // end ConnectReader()
+
+}; // end class ITKToolsImageExpression
+
+#endif // end #ifndef __imageexpression_h_
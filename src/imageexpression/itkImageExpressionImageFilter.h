@@ -0,0 +1,154 @@
+/*=========================================================================
+*
+* Copyright Marius Staring, Stefan Klein, David Doria. 2011.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0.txt
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*=========================================================================*/
+#ifndef __itkImageExpressionImageFilter_h_
+#define __itkImageExpressionImageFilter_h_
+
+#include "itkImageSource.h"
+#include "itkVoxelExpression.h"
+
+#include <string>
+#include <vector>
+
+
+namespace itk
+{
+
+/** \class ImageExpressionImageFilter
+ * \brief Evaluates a voxel wise expression of a number of images.
+ *
+ * The i-th input is known in the expression under the i-th variable name.
+ * The expression is compiled once by VoxelExpression, and evaluated per
+ * scan line, so compound expressions like (a+b)/2 > c ? a : 0 are computed
+ * in a single multi-threaded pass, without intermediate images. Since only
+ * the requested region of the inputs is used, the filter supports streaming.
+ *
+ * The inputs are scalar images that need not have the same pixel type.
+ * They are kept in their own pixel type, and converted to double per block
+ * of a scan line during the evaluation, so an input takes no more memory
+ * than its pixel type needs.
+ *
+ * The result is clamped to the range of the output pixel type. A NaN
+ * result, e.g. of 0/0 or log(-1), is written as 0 to an integer output
+ * type, and as NaN to a floating point output type.
+ *
+ * \ingroup IntensityImageFilters
+ * \ingroup MultiThreaded
+ */
+
+template < typename TOutputImage >
+class ITK_EXPORT ImageExpressionImageFilter:
+    public ImageSource< TOutputImage >
+{
+public:
+
+  /** Standard class typedefs. */
+  typedef ImageExpressionImageFilter                        Self;
+  typedef ImageSource< TOutputImage >                       Superclass;
+  typedef SmartPointer<Self>                                Pointer;
+  typedef SmartPointer<const Self>                          ConstPointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro( Self );
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro( ImageExpressionImageFilter, ImageSource );
+
+  /** Image dimension. */
+  itkStaticConstMacro( ImageDimension, unsigned int, TOutputImage::ImageDimension );
+
+  /** Typedefs. */
+  typedef TOutputImage                                      OutputImageType;
+  typedef typename OutputImageType::PixelType               OutputPixelType;
+  typedef typename OutputImageType::RegionType              OutputImageRegionType;
+  typedef typename OutputImageType::IndexType               IndexType;
+  typedef ImageBase< TOutputImage::ImageDimension >         InputImageBaseType;
+
+  /** Set the i-th input, a scalar image of any pixel type. */
+  template < typename TInputImage >
+  void SetInput( const unsigned int i, const TInputImage * image )
+  {
+    static_assert( TInputImage::ImageDimension == TOutputImage::ImageDimension,
+      "The inputs should have the dimension of the output." );
+    if( i >= this->m_ReadBlockFunctions.size() )
+    {
+      this->m_ReadBlockFunctions.resize( i + 1, nullptr );
+    }
+    this->m_ReadBlockFunctions[ i ] = &Self::template ReadBlock< TInputImage >;
+    this->ProcessObject::SetNthInput( i, const_cast< TInputImage * >( image ) );
+  }
+
+  /** Set the expression, e.g. "(a+b)/2 > c ? a : 0". */
+  itkSetStringMacro( Expression );
+  itkGetStringMacro( Expression );
+
+  /** Set the names of the inputs, as used in the expression. */
+  void SetVariableNames( const std::vector< std::string > & names )
+  {
+    this->m_VariableNames = names;
+    this->Modified();
+  }
+  const std::vector< std::string > & GetVariableNames( void ) const
+  {
+    return this->m_VariableNames;
+  }
+
+protected:
+  ImageExpressionImageFilter();
+  virtual ~ImageExpressionImageFilter() {};
+
+  /** Check that the inputs have the same size, spacing, origin and
+   * direction, as the ImageToImageFilter does. */
+  virtual void VerifyInputInformation( void ) ITKv5_CONST;
+
+  /** Of the inputs only the requested region of the output is needed. */
+  virtual void GenerateInputRequestedRegion( void );
+
+  /** Check the inputs, and compile the expression. */
+  virtual void BeforeThreadedGenerateData( void );
+
+  /** Evaluate the expression for a part of the output. */
+  virtual void DynamicThreadedGenerateData(
+    const OutputImageRegionType & outputRegionForThread );
+
+private:
+  ImageExpressionImageFilter(const Self&); //purposely not implemented
+  void operator=(const Self&); //purposely not implemented
+
+  /** Converts n voxels of an input to double, from the index on along
+   * a scan line; one function per input pixel type. */
+  typedef void ( *ReadBlockFunctionType )( const DataObject * input,
+    const IndexType & index, const SizeValueType n, double * values );
+
+  template < typename TInputImage >
+  static void ReadBlock( const DataObject * input,
+    const IndexType & index, const SizeValueType n, double * values );
+
+  std::string                           m_Expression;
+  std::vector< std::string >            m_VariableNames;
+  VoxelExpression                       m_VoxelExpression;
+  std::vector< ReadBlockFunctionType >  m_ReadBlockFunctions;
+
+}; // end class ImageExpressionImageFilter
+
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkImageExpressionImageFilter.hxx"
+#endif
+
+#endif // end #ifndef __itkImageExpressionImageFilter_h_
@@ -0,0 +1,263 @@
+/*=========================================================================
+*
+* Copyright Marius Staring, Stefan Klein, David Doria. 2011.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0.txt
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*=========================================================================*/
+#ifndef _itkImageExpressionImageFilter_hxx_
+#define _itkImageExpressionImageFilter_hxx_
+
+#include "itkImageExpressionImageFilter.h"
+
+#include "itkImageScanlineIterator.h"
+#include "itkNumericTraits.h"
+
+#include <algorithm>
+#include <cmath>
+#include <type_traits>
+
+
+namespace itk
+{
+
+/**
+ * ********************* Constructor ****************************
+ */
+
+template < typename TOutputImage >
+ImageExpressionImageFilter< TOutputImage >
+::ImageExpressionImageFilter()
+{
+  this->m_Expression = "";
+  this->DynamicMultiThreadingOn();
+} // end Constructor
+
+
+/**
+ * ********************* VerifyInputInformation ****************************
+ */
+
+template < typename TOutputImage >
+void
+ImageExpressionImageFilter< TOutputImage >
+::VerifyInputInformation( void ) ITKv5_CONST
+{
+  /** The ImageSource does not check the inputs, so inputs on other voxel
+   * grids would be combined voxel by voxel. */
+  const InputImageBaseType * input0
+    = dynamic_cast< const InputImageBaseType * >( this->ProcessObject::GetInput( 0 ) );
+  if( !input0 ) return;
+
+  for( unsigned int i = 1; i < this->GetNumberOfIndexedInputs(); ++i )
+  {
+    const InputImageBaseType * input
+      = dynamic_cast< const InputImageBaseType * >( this->ProcessObject::GetInput( i ) );
+    if( !input ) continue;
+
+    if( input->GetLargestPossibleRegion() != input0->GetLargestPossibleRegion() )
+    {
+      itkExceptionMacro( << "Input " << i << " has size "
+        << input->GetLargestPossibleRegion().GetSize() << ", but input 0 has size "
+        << input0->GetLargestPossibleRegion().GetSize() << "." );
+    }
+    if( !input->IsSameImageGeometryAs( input0 ) )
+    {
+      itkExceptionMacro( << "The spacing, origin or direction of input " << i
+        << " differs from input 0." );
+    }
+  }
+
+} // end VerifyInputInformation()
+
+
+/**
+ * ********************* GenerateInputRequestedRegion ****************************
+ */
+
+template < typename TOutputImage >
+void
+ImageExpressionImageFilter< TOutputImage >
+::GenerateInputRequestedRegion( void )
+{
+  Superclass::GenerateInputRequestedRegion();
+
+  const OutputImageRegionType & region = this->GetOutput()->GetRequestedRegion();
+  for( unsigned int i = 0; i < this->GetNumberOfIndexedInputs(); ++i )
+  {
+    InputImageBaseType * input
+      = dynamic_cast< InputImageBaseType * >( this->ProcessObject::GetInput( i ) );
+    if( input )
+    {
+      input->SetRequestedRegion( region );
+    }
+  }
+
+} // end GenerateInputRequestedRegion()
+
+
+/**
+ * ********************* BeforeThreadedGenerateData ****************************
+ */
+
+template < typename TOutputImage >
+void
+ImageExpressionImageFilter< TOutputImage >
+::BeforeThreadedGenerateData( void )
+{
+  if( this->GetNumberOfIndexedInputs() != this->m_VariableNames.size() )
+  {
+    itkExceptionMacro( << "The number of inputs (" << this->GetNumberOfIndexedInputs()
+      << ") does not match the number of variable names ("
+      << this->m_VariableNames.size() << ")." );
+  }
+
+  /** The scan lines are read from the buffers of the inputs. */
+  const OutputImageRegionType & region = this->GetOutput()->GetRequestedRegion();
+  for( unsigned int i = 0; i < this->GetNumberOfIndexedInputs(); ++i )
+  {
+    const InputImageBaseType * input
+      = dynamic_cast< const InputImageBaseType * >( this->ProcessObject::GetInput( i ) );
+    if( !input || i >= this->m_ReadBlockFunctions.size() || !this->m_ReadBlockFunctions[ i ] )
+    {
+      itkExceptionMacro( << "Input " << i << " is not set." );
+    }
+    if( !input->GetBufferedRegion().IsInside( region ) )
+    {
+      itkExceptionMacro( << "Input " << i << " is not buffered for the region of the output." );
+    }
+  }
+
+  /** Compile once; the threads share the byte code. */
+  this->m_VoxelExpression.Compile( this->m_Expression, this->m_VariableNames );
+
+} // end BeforeThreadedGenerateData()
+
+
+/**
+ * ********************* DynamicThreadedGenerateData ****************************
+ */
+
+template < typename TOutputImage >
+void
+ImageExpressionImageFilter< TOutputImage >
+::DynamicThreadedGenerateData( const OutputImageRegionType & outputRegionForThread )
+{
+  typedef ImageScanlineIterator< OutputImageType >    OutputIteratorType;
+
+  /** The scan lines are evaluated in blocks of this number of voxels,
+   * so that the workspace of the stack machine stays in cache.
+   */
+  const SizeValueType blockSize = 1024;
+
+  const unsigned int nrInputs = this->GetNumberOfIndexedInputs();
+  std::vector< const DataObject * > inputs( nrInputs );
+  for( unsigned int i = 0; i < nrInputs; ++i )
+  {
+    inputs[ i ] = this->ProcessObject::GetInput( i );
+  }
+  OutputImageType * output = this->GetOutput();
+
+  /** The blocks of the inputs, converted to double. */
+  const SizeValueType lineLength = outputRegionForThread.GetSize( 0 );
+  const SizeValueType maxBlockLength = std::min( lineLength, blockSize );
+  std::vector< double > workspace( this->m_VoxelExpression.GetStackDepth() * maxBlockLength );
+  std::vector< double > result( maxBlockLength );
+  std::vector< double > values( nrInputs * maxBlockLength );
+  std::vector< const double * > variables( nrInputs );
+  for( unsigned int i = 0; i < nrInputs; ++i )
+  {
+    variables[ i ] = &values[ i * maxBlockLength ];
+  }
+
+  const OutputPixelType outputMaximum = NumericTraits< OutputPixelType >::max();
+  const OutputPixelType outputMinimum = NumericTraits< OutputPixelType >::NonpositiveMin();
+  const bool outputIsInteger = std::is_integral< OutputPixelType >::value;
+
+  OutputIteratorType outIt( output, outputRegionForThread );
+  while( !outIt.IsAtEnd() )
+  {
+    /** A scan line is contiguous in the buffers of all images. */
+    const IndexType index = outIt.GetIndex();
+    OutputPixelType * outLine = &output->GetPixel( index );
+
+    for( SizeValueType start = 0; start < lineLength; start += blockSize )
+    {
+      const SizeValueType n = std::min( blockSize, lineLength - start );
+      IndexType blockIndex = index;
+      blockIndex[ 0 ] += static_cast< IndexValueType >( start );
+      for( unsigned int i = 0; i < nrInputs; ++i )
+      {
+        this->m_ReadBlockFunctions[ i ]( inputs[ i ], blockIndex, n,
+          &values[ i * maxBlockLength ] );
+      }
+
+      this->m_VoxelExpression.Evaluate( variables.data(), n, result.data(), workspace.data() );
+
+      /** Clamp to the output range, as the functors of pxbinaryimageoperator.
+       * The bounds are written as they are: the maximum of a 64-bit integer
+       * type rounds up to 2^63 or 2^64 as a double, which is out of range.
+       * NaN passes the clamp, and cannot be cast to an integer type. */
+      for( SizeValueType j = 0; j < n; ++j )
+      {
+        const double value = result[ j ];
+        OutputPixelType & out = outLine[ start + j ];
+        if( std::isnan( value ) )
+        {
+          out = outputIsInteger ? NumericTraits< OutputPixelType >::ZeroValue()
+            : static_cast< OutputPixelType >( value );
+        }
+        else if( value >= static_cast< double >( outputMaximum ) )
+        {
+          out = outputMaximum;
+        }
+        else if( value <= static_cast< double >( outputMinimum ) )
+        {
+          out = outputMinimum;
+        }
+        else
+        {
+          out = static_cast< OutputPixelType >( value );
+        }
+      }
+    }
+
+    outIt.NextLine();
+  }
+
+} // end DynamicThreadedGenerateData()
+
+
+/**
+ * ********************* ReadBlock ****************************
+ */
+
+template < typename TOutputImage >
+template < typename TInputImage >
+void
+ImageExpressionImageFilter< TOutputImage >
+::ReadBlock( const DataObject * input,
+  const IndexType & index, const SizeValueType n, double * values )
+{
+  const TInputImage * image = static_cast< const TInputImage * >( input );
+  const typename TInputImage::PixelType * in = &image->GetPixel( index );
+  for( SizeValueType j = 0; j < n; ++j )
+  {
+    values[ j ] = static_cast< double >( in[ j ] );
+  }
+
+} // end ReadBlock()
+
+} // end namespace itk
+
+#endif // end #ifndef _itkImageExpressionImageFilter_hxx_
@@ -0,0 +1,762 @@
+/*=========================================================================
+*
+* Copyright Marius Staring, Stefan Klein, David Doria. 2011.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0.txt
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*=========================================================================*/
+#include "itkVoxelExpression.h"
+
+#include "itkMacro.h"
+#include "itkBinaryFunctors.h"
+#include "itkBinaryLogicalFunctors.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <sstream>
+
+
+namespace itk {
+
+/** The maximum depth of the stack of the machine. */
+static const unsigned int VoxelExpressionMaximumStackDepth = 64;
+
+
+/**
+ * ******************* Constructor *******************
+ */
+
+VoxelExpression::VoxelExpression()
+{
+  this->m_Position = 0;
+  this->m_Depth = 0;
+  this->m_StackDepth = 0;
+} // end Constructor
+
+
+/**
+ * ******************* Compile *******************
+ */
+
+void VoxelExpression
+::Compile( const std::string & expression,
+  const std::vector< std::string > & variableNames )
+{
+  this->m_Expression = expression;
+  this->m_VariableNames = variableNames;
+  this->m_Position = 0;
+  this->m_Program.clear();
+  this->m_Depth = 0;
+  this->m_StackDepth = 0;
+
+  this->ParseTernary();
+  this->SkipWhiteSpace();
+  if( this->m_Position != this->m_Expression.size() )
+  {
+    this->ThrowSyntaxError( "unexpected character" );
+  }
+
+  if( this->m_StackDepth > VoxelExpressionMaximumStackDepth )
+  {
+    itkGenericExceptionMacro( << "The expression is nested too deeply." );
+  }
+
+} // end Compile()
+
+
+/**
+ * ******************* ParseTernary *******************
+ */
+
+void VoxelExpression
+::ParseTernary( void )
+{
+  this->ParseOr();
+  if( this->Accept( "?" ) )
+  {
+    this->ParseTernary();
+    this->Expect( ":" );
+    this->ParseTernary();
+    this->Emit( Select );
+  }
+} // end ParseTernary()
+
+
+/**
+ * ******************* ParseOr *******************
+ */
+
+void VoxelExpression
+::ParseOr( void )
+{
+  this->ParseAnd();
+  while( this->Accept( "||" ) )
+  {
+    this->ParseAnd();
+    this->Emit( Or );
+  }
+} // end ParseOr()
+
+
+/**
+ * ******************* ParseAnd *******************
+ */
+
+void VoxelExpression
+::ParseAnd( void )
+{
+  this->ParseEquality();
+  while( this->Accept( "&&" ) )
+  {
+    this->ParseEquality();
+    this->Emit( And );
+  }
+} // end ParseAnd()
+
+
+/**
+ * ******************* ParseEquality *******************
+ */
+
+void VoxelExpression
+::ParseEquality( void )
+{
+  this->ParseRelational();
+  while( true )
+  {
+    if( this->Accept( "==" ) ) { this->ParseRelational(); this->Emit( Equal ); }
+    else if( this->Accept( "!=" ) ) { this->ParseRelational(); this->Emit( NotEqual ); }
+    else break;
+  }
+} // end ParseEquality()
+
+
+/**
+ * ******************* ParseRelational *******************
+ */
+
+void VoxelExpression
+::ParseRelational( void )
+{
+  this->ParseAdditive();
+  while( true )
+  {
+    if( this->Accept( "<=" ) ) { this->ParseAdditive(); this->Emit( LessEqual ); }
+    else if( this->Accept( ">=" ) ) { this->ParseAdditive(); this->Emit( GreaterEqual ); }
+    else if( this->Accept( "<" ) ) { this->ParseAdditive(); this->Emit( Less ); }
+    else if( this->Accept( ">" ) ) { this->ParseAdditive(); this->Emit( Greater ); }
+    else break;
+  }
+} // end ParseRelational()
+
+
+/**
+ * ******************* ParseAdditive *******************
+ */
+
+void VoxelExpression
+::ParseAdditive( void )
+{
+  this->ParseMultiplicative();
+  while( true )
+  {
+    if( this->Accept( "+" ) ) { this->ParseMultiplicative(); this->Emit( Add ); }
+    else if( this->Accept( "-" ) ) { this->ParseMultiplicative(); this->Emit( Subtract ); }
+    else break;
+  }
+} // end ParseAdditive()
+
+
+/**
+ * ******************* ParseMultiplicative *******************
+ */
+
+void VoxelExpression
+::ParseMultiplicative( void )
+{
+  this->ParseUnary();
+  while( true )
+  {
+    if( this->Accept( "*" ) ) { this->ParseUnary(); this->Emit( Multiply ); }
+    else if( this->Accept( "/" ) ) { this->ParseUnary(); this->Emit( Divide ); }
+    else if( this->Accept( "%" ) ) { this->ParseUnary(); this->Emit( Modulo ); }
+    else break;
+  }
+} // end ParseMultiplicative()
+
+
+/**
+ * ******************* ParseUnary *******************
+ */
+
+void VoxelExpression
+::ParseUnary( void )
+{
+  this->SkipWhiteSpace();
+
+  /** Make sure "!=" is not taken for a "!". */
+  if( this->m_Expression.compare( this->m_Position, 2, "!=" ) != 0
+    && this->Accept( "!" ) )
+  {
+    this->ParseUnary();
+    this->Emit( Not );
+  }
+  else if( this->Accept( "-" ) )
+  {
+    this->ParseUnary();
+    this->Emit( Negate );
+  }
+  else if( this->Accept( "+" ) )
+  {
+    this->ParseUnary();
+  }
+  else
+  {
+    this->ParsePower();
+  }
+} // end ParseUnary()
+
+
+/**
+ * ******************* ParsePower *******************
+ */
+
+void VoxelExpression
+::ParsePower( void )
+{
+  this->ParsePrimary();
+  if( this->Accept( "^" ) )
+  {
+    /** Right associative, and -a^b == -(a^b). */
+    this->ParseUnary();
+    this->Emit( Power );
+  }
+} // end ParsePower()
+
+
+/**
+ * ******************* ParsePrimary *******************
+ */
+
+void VoxelExpression
+::ParsePrimary( void )
+{
+  this->SkipWhiteSpace();
+  if( this->m_Position >= this->m_Expression.size() )
+  {
+    this->ThrowSyntaxError( "unexpected end of expression" );
+  }
+
+  const char c = this->m_Expression[ this->m_Position ];
+
+  /** A parenthesized expression. */
+  if( this->Accept( "(" ) )
+  {
+    this->ParseTernary();
+    this->Expect( ")" );
+    return;
+  }
+
+  /** A number. */
+  if( std::isdigit( static_cast<unsigned char>( c ) ) || c == '.' )
+  {
+    const char * begin = this->m_Expression.c_str() + this->m_Position;
+    char * end = nullptr;
+    const double value = std::strtod( begin, &end );
+    if( end == begin ) this->ThrowSyntaxError( "invalid number" );
+    this->m_Position += end - begin;
+    this->Emit( PushConstant, 0, value );
+    return;
+  }
+
+  /** A variable or a function. */
+  if( std::isalpha( static_cast<unsigned char>( c ) ) || c == '_' )
+  {
+    const std::size_t begin = this->m_Position;
+    while( this->m_Position < this->m_Expression.size()
+      && ( std::isalnum( static_cast<unsigned char>( this->m_Expression[ this->m_Position ] ) )
+      || this->m_Expression[ this->m_Position ] == '_' ) )
+    {
+      ++this->m_Position;
+    }
+    const std::string name = this->m_Expression.substr( begin, this->m_Position - begin );
+
+    if( this->Accept( "(" ) )
+    {
+      this->ParseFunction( name );
+      return;
+    }
+
+    std::vector< std::string >::const_iterator it = std::find(
+      this->m_VariableNames.begin(), this->m_VariableNames.end(), name );
+    if( it == this->m_VariableNames.end() )
+    {
+      this->m_Position = begin;
+      this->ThrowSyntaxError( "unknown variable \"" + name + "\"" );
+    }
+    this->Emit( PushVariable, static_cast<unsigned int>( it - this->m_VariableNames.begin() ) );
+    return;
+  }
+
+  this->ThrowSyntaxError( "unexpected character" );
+
+} // end ParsePrimary()
+
+
+/**
+ * ******************* ParseFunction *******************
+ */
+
+void VoxelExpression
+::ParseFunction( const std::string & name )
+{
+  std::string lowerName = name;
+  std::transform( lowerName.begin(), lowerName.end(), lowerName.begin(), ::tolower );
+
+  /** Functions of one argument. */
+  std::map< std::string, OpCodeType > unaryFunctions;
+  unaryFunctions[ "abs" ] = Abs;
+  unaryFunctions[ "sign" ] = Sign;
+  unaryFunctions[ "floor" ] = Floor;
+  unaryFunctions[ "ceil" ] = Ceil;
+  unaryFunctions[ "round" ] = Round;
+  unaryFunctions[ "ln" ] = Ln;
+  unaryFunctions[ "log10" ] = Log10;
+  unaryFunctions[ "exp" ] = Exp;
+  unaryFunctions[ "sin" ] = Sin;
+  unaryFunctions[ "cos" ] = Cos;
+  unaryFunctions[ "tan" ] = Tan;
+  unaryFunctions[ "asin" ] = ArcSin;
+  unaryFunctions[ "acos" ] = ArcCos;
+  unaryFunctions[ "atan" ] = ArcTan;
+  unaryFunctions[ "erf" ] = ErrFunc;
+
+  /** Functions of two arguments. */
+  std::map< std::string, OpCodeType > binaryFunctions;
+  binaryFunctions[ "min" ] = Minimum;
+  binaryFunctions[ "max" ] = Maximum;
+  binaryFunctions[ "pow" ] = Power;
+  binaryFunctions[ "log" ] = Log;
+  binaryFunctions[ "absdiff" ] = AbsoluteDifference;
+  binaryFunctions[ "sqdiff" ] = SquaredDifference;
+  binaryFunctions[ "magnitude" ] = Magnitude;
+  binaryFunctions[ "mod" ] = Modulo;
+
+  /** Functions of a variable and two constant arguments. */
+  std::map< std::string, OpCodeType > parameterFunctions;
+  parameterFunctions[ "linear" ] = Linear;
+  parameterFunctions[ "normcdf" ] = NormCDF;
+  parameterFunctions[ "qfunc" ] = QFunc;
+
+  if( unaryFunctions.count( lowerName ) )
+  {
+    this->ParseTernary();
+    this->Expect( ")" );
+    this->Emit( unaryFunctions[ lowerName ] );
+  }
+  else if( binaryFunctions.count( lowerName ) )
+  {
+    this->ParseTernary();
+    this->Expect( "," );
+    this->ParseTernary();
+    this->Expect( ")" );
+    this->Emit( binaryFunctions[ lowerName ] );
+  }
+  else if( parameterFunctions.count( lowerName ) )
+  {
+    this->ParseTernary();
+    double arguments[ 2 ];
+    for( unsigned int i = 0; i < 2; ++i )
+    {
+      this->Expect( "," );
+      this->ParseTernary();
+      if( this->m_Program.back().m_OpCode != PushConstant )
+      {
+        this->ThrowSyntaxError( "the parameters of " + lowerName + " should be constant" );
+      }
+      arguments[ i ] = this->m_Program.back().m_Argument1;
+      this->m_Program.pop_back();
+      --this->m_Depth;
+    }
+    this->Expect( ")" );
+    this->Emit( parameterFunctions[ lowerName ], 0, arguments[ 0 ], arguments[ 1 ] );
+  }
+  else
+  {
+    this->ThrowSyntaxError( "unknown function \"" + name + "\"" );
+  }
+
+} // end ParseFunction()
+
+
+/**
+ * ******************* SkipWhiteSpace *******************
+ */
+
+void VoxelExpression
+::SkipWhiteSpace( void )
+{
+  while( this->m_Position < this->m_Expression.size()
+    && std::isspace( static_cast<unsigned char>( this->m_Expression[ this->m_Position ] ) ) )
+  {
+    ++this->m_Position;
+  }
+} // end SkipWhiteSpace()
+
+
+/**
+ * ******************* Accept *******************
+ */
+
+bool VoxelExpression
+::Accept( const std::string & token )
+{
+  this->SkipWhiteSpace();
+  if( this->m_Expression.compare( this->m_Position, token.size(), token ) == 0 )
+  {
+    this->m_Position += token.size();
+    return true;
+  }
+  return false;
+} // end Accept()
+
+
+/**
+ * ******************* Expect *******************
+ */
+
+void VoxelExpression
+::Expect( const std::string & token )
+{
+  if( !this->Accept( token ) )
+  {
+    this->ThrowSyntaxError( "expected \"" + token + "\"" );
+  }
+} // end Expect()
+
+
+/**
+ * ******************* ThrowSyntaxError *******************
+ */
+
+void VoxelExpression
+::ThrowSyntaxError( const std::string & description ) const
+{
+  itkGenericExceptionMacro( << "Syntax error in expression \"" << this->m_Expression
+    << "\" at position " << this->m_Position << ": " << description << "." );
+} // end ThrowSyntaxError()
+
+
+/**
+ * ******************* GetNumberOfOperands *******************
+ */
+
+unsigned int VoxelExpression
+::GetNumberOfOperands( OpCodeType opCode )
+{
+  if( opCode == PushVariable || opCode == PushConstant ) return 0;
+  if( opCode < Add ) return 1;
+  if( opCode < Select ) return 2;
+  return 3;
+} // end GetNumberOfOperands()
+
+
+/**
+ * ******************* Emit *******************
+ */
+
+void VoxelExpression
+::Emit( OpCodeType opCode, unsigned int index,
+  double argument1, double argument2 )
+{
+  InstructionType instruction;
+  instruction.m_OpCode = opCode;
+  instruction.m_Index = index;
+  instruction.m_Argument1 = argument1;
+  instruction.m_Argument2 = argument2;
+
+  const unsigned int numberOfOperands = GetNumberOfOperands( opCode );
+
+  /** The operands are the last instructions if those are all constants. */
+  bool constantOperands = numberOfOperands > 0
+    && this->m_Program.size() >= numberOfOperands;
+  for( unsigned int i = 0; constantOperands && i < numberOfOperands; ++i )
+  {
+    constantOperands = this->m_Program[ this->m_Program.size() - 1 - i ].m_OpCode == PushConstant;
+  }
+
+  if( !constantOperands )
+  {
+    this->m_Program.push_back( instruction );
+    if( numberOfOperands == 0 )
+    {
+      ++this->m_Depth;
+      this->m_StackDepth = std::max( this->m_StackDepth, this->m_Depth );
+    }
+    else
+    {
+      this->m_Depth -= numberOfOperands - 1;
+    }
+    return;
+  }
+
+  /** Fold the constants, by evaluating the instruction for a single voxel. */
+  double operands[ 3 ];
+  for( unsigned int i = 0; i < numberOfOperands; ++i )
+  {
+    operands[ numberOfOperands - 1 - i ] = this->m_Program.back().m_Argument1;
+    this->m_Program.pop_back();
+  }
+  double value = 0.0;
+  if( numberOfOperands == 1 )
+  {
+    EvaluateUnary( instruction, operands, &value, 1 );
+  }
+  else if( numberOfOperands == 2 )
+  {
+    EvaluateBinary( instruction, operands, operands + 1, &value, 1 );
+  }
+  else
+  {
+    value = operands[ 0 ] != 0.0 ? operands[ 1 ] : operands[ 2 ];
+  }
+
+  instruction.m_OpCode = PushConstant;
+  instruction.m_Index = 0;
+  instruction.m_Argument1 = value;
+  instruction.m_Argument2 = 0.0;
+  this->m_Program.push_back( instruction );
+  this->m_Depth -= numberOfOperands - 1;
+
+} // end Emit()
+
+
+/**
+ * ******************* Evaluate *******************
+ */
+
+void VoxelExpression
+::Evaluate( const double * const * variables, const std::size_t n,
+  double * output, double * workspace ) const
+{
+  /** The values on the stack point to either a variable, or a block of the
+   * workspace. The result of an instruction is stored in the block of the
+   * workspace that belongs to its position on the stack.
+   */
+  const double * stack[ VoxelExpressionMaximumStackDepth ];
+  unsigned int top = 0;
+
+  for( ProgramType::const_iterator it = this->m_Program.begin();
+    it != this->m_Program.end(); ++it )
+  {
+    switch( GetNumberOfOperands( it->m_OpCode ) )
+    {
+      case 0:
+      {
+        if( it->m_OpCode == PushVariable )
+        {
+          stack[ top ] = variables[ it->m_Index ];
+        }
+        else
+        {
+          double * block = workspace + top * n;
+          std::fill( block, block + n, it->m_Argument1 );
+          stack[ top ] = block;
+        }
+        ++top;
+        break;
+      }
+      case 1:
+      {
+        double * block = workspace + ( top - 1 ) * n;
+        EvaluateUnary( *it, stack[ top - 1 ], block, n );
+        stack[ top - 1 ] = block;
+        break;
+      }
+      case 2:
+      {
+        double * block = workspace + ( top - 2 ) * n;
+        EvaluateBinary( *it, stack[ top - 2 ], stack[ top - 1 ], block, n );
+        stack[ top - 2 ] = block;
+        --top;
+        break;
+      }
+      default:
+      {
+        double * block = workspace + ( top - 3 ) * n;
+        const double * c = stack[ top - 3 ];
+        const double * a = stack[ top - 2 ];
+        const double * b = stack[ top - 1 ];
+        for( std::size_t i = 0; i < n; ++i )
+        {
+          block[ i ] = c[ i ] != 0.0 ? a[ i ] : b[ i ];
+        }
+        stack[ top - 3 ] = block;
+        top -= 2;
+        break;
+      }
+    }
+  }
+
+  std::memcpy( output, stack[ 0 ], n * sizeof( double ) );
+
+} // end Evaluate()
+
+
+/**
+ * ******************* ApplyBinaryFunctor *******************
+ */
+
+template< class TFunctor >
+static void ApplyBinaryFunctor( const double * a, const double * b,
+  double * out, const std::size_t n )
+{
+  TFunctor functor;
+  for( std::size_t i = 0; i < n; ++i )
+  {
+    out[ i ] = functor( a[ i ], b[ i ] );
+  }
+} // end ApplyBinaryFunctor()
+
+
+/**
+ * ******************* ApplyBinaryLogicalFunctor *******************
+ */
+
+template< class TFunctor >
+static void ApplyBinaryLogicalFunctor( const double * a, const double * b,
+  double * out, const std::size_t n )
+{
+  /** The logical functors work bitwise, so pass them 0 or 1. */
+  TFunctor functor;
+  for( std::size_t i = 0; i < n; ++i )
+  {
+    out[ i ] = functor( static_cast< unsigned char >( a[ i ] != 0.0 ),
+      static_cast< unsigned char >( b[ i ] != 0.0 ) );
+  }
+} // end ApplyBinaryLogicalFunctor()
+
+
+/**
+ * ******************* EvaluateBinary *******************
+ */
+
+void VoxelExpression
+::EvaluateBinary( const InstructionType & instruction,
+  const double * a, const double * b, double * out, const std::size_t n )
+{
+  using namespace itk::Functor;
+
+  switch( instruction.m_OpCode )
+  {
+    case Add:
+      ApplyBinaryFunctor< ADDITION<double, double, double> >( a, b, out, n ); break;
+    case Subtract:
+      ApplyBinaryFunctor< MINUS<double, double, double> >( a, b, out, n ); break;
+    case Multiply:
+      ApplyBinaryFunctor< TIMES<double, double, double> >( a, b, out, n ); break;
+    case Divide:
+      ApplyBinaryFunctor< DIVIDE<double, double, double> >( a, b, out, n ); break;
+    case Power:
+      ApplyBinaryFunctor< POWER<double, double, double> >( a, b, out, n ); break;
+    case Minimum:
+      ApplyBinaryFunctor< MINIMUM<double, double, double> >( a, b, out, n ); break;
+    case Maximum:
+      ApplyBinaryFunctor< MAXIMUM<double, double, double> >( a, b, out, n ); break;
+    case AbsoluteDifference:
+      ApplyBinaryFunctor< ABSOLUTEDIFFERENCE<double, double, double> >( a, b, out, n ); break;
+    case SquaredDifference:
+      ApplyBinaryFunctor< SQUAREDDIFFERENCE<double, double, double> >( a, b, out, n ); break;
+    case Magnitude:
+      ApplyBinaryFunctor< BINARYMAGNITUDE<double, double, double> >( a, b, out, n ); break;
+    case Log:
+      ApplyBinaryFunctor< LOG<double, double, double> >( a, b, out, n ); break;
+    /** The same as RMODDOUBLE of pxunaryimageoperator, with a voxel wise argument. */
+    case Modulo:
+      for( std::size_t i = 0; i < n; ++i ) out[ i ] = std::fmod( a[ i ], b[ i ] );
+      break;
+    /** Comparison operators. */
+    case Less:
+      for( std::size_t i = 0; i < n; ++i ) out[ i ] = a[ i ] < b[ i ];
+      break;
+    case LessEqual:
+      for( std::size_t i = 0; i < n; ++i ) out[ i ] = a[ i ] <= b[ i ];
+      break;
+    case Greater:
+      for( std::size_t i = 0; i < n; ++i ) out[ i ] = a[ i ] > b[ i ];
+      break;
+    case GreaterEqual:
+      for( std::size_t i = 0; i < n; ++i ) out[ i ] = a[ i ] >= b[ i ];
+      break;
+    case Equal:
+      for( std::size_t i = 0; i < n; ++i ) out[ i ] = a[ i ] == b[ i ];
+      break;
+    case NotEqual:
+      for( std::size_t i = 0; i < n; ++i ) out[ i ] = a[ i ] != b[ i ];
+      break;
+    /** Logical operators, as AND and OR of pxlogicalimageoperator. */
+    case And:
+      ApplyBinaryLogicalFunctor< AND<unsigned char, unsigned char, double> >( a, b, out, n ); break;
+    case Or:
+      ApplyBinaryLogicalFunctor< OR<unsigned char, unsigned char, double> >( a, b, out, n ); break;
+    default:
+      itkGenericExceptionMacro( << "Instruction " << instruction.m_OpCode << " is not a binary operator." );
+  }
+
+} // end EvaluateBinary()
+
+
+/**
+ * ******************* GetProgramAsString *******************
+ */
+
+std::string VoxelExpression
+::GetProgramAsString( void ) const
+{
+  const char * names[] = {
+    "PushVariable", "PushConstant",
+    "Negate", "Not", "Abs", "Sign", "Floor", "Ceil", "Round", "Ln", "Log10", "Exp",
+    "Sin", "Cos", "Tan", "ArcSin", "ArcCos", "ArcTan", "ErrFunc", "Linear", "NormCDF", "QFunc",
+    "Add", "Subtract", "Multiply", "Divide", "Power", "Modulo", "Minimum", "Maximum",
+    "AbsoluteDifference", "SquaredDifference", "Magnitude", "Log",
+    "Less", "LessEqual", "Greater", "GreaterEqual", "Equal", "NotEqual", "And", "Or",
+    "Select" };
+
+  std::ostringstream ss;
+  for( ProgramType::const_iterator it = this->m_Program.begin();
+    it != this->m_Program.end(); ++it )
+  {
+    ss << names[ it->m_OpCode ];
+    if( it->m_OpCode == PushVariable )
+    {
+      ss << " " << this->m_VariableNames[ it->m_Index ];
+    }
+    else if( it->m_OpCode == PushConstant )
+    {
+      ss << " " << it->m_Argument1;
+    }
+    else if( it->m_OpCode == Linear || it->m_OpCode == NormCDF || it->m_OpCode == QFunc )
+    {
+      ss << " " << it->m_Argument1 << " " << it->m_Argument2;
+    }
+    ss << "\n";
+  }
+  return ss.str();
+
+} // end GetProgramAsString()
+
+} // end namespace itk
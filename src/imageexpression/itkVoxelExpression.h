@@ -0,0 +1,156 @@
+/*=========================================================================
+*
+* Copyright Marius Staring, Stefan Klein, David Doria. 2011.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0.txt
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*=========================================================================*/
+#ifndef __itkVoxelExpression_h_
+#define __itkVoxelExpression_h_
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace itk {
+
+/** \class VoxelExpression
+ *
+ * \brief Compiles an arithmetic and logical expression of a number of
+ * named variables, and evaluates it for many voxels at once.
+ *
+ * The expression is parsed once into a small byte code for a stack machine,
+ * where constant subexpressions are folded. The byte code is evaluated per
+ * block of voxels: each instruction runs a simple loop over the whole block,
+ * which the compiler can vectorize, instead of interpreting the expression
+ * for every voxel. All values are double, and the operators and functions
+ * use the functors of pxbinaryimageoperator, pxunaryimageoperator and
+ * pxlogicalimageoperator, so results match those tools.
+ *
+ * Grammar, from low to high precedence:
+ *   c ? a : b, ||, &&, == !=, < <= > >=, + -, * / %, unary - + !, ^
+ * Logical and comparison operators return 0 or 1, and treat nonzero as true.
+ * Functions:
+ *   abs, sign, floor, ceil, round, ln, log10, exp, sin, cos, tan,
+ *   asin, acos, atan, erf, with one argument,
+ *   min, max, pow, log (base b), absdiff, sqdiff, magnitude, mod,
+ *   with two arguments, and
+ *   linear( x, a, b ), normcdf( x, mean, std ), qfunc( x, mean, std ),
+ *   where a, b, mean and std must be constant.
+ *
+ * Evaluate() is const, so one compiled expression can be shared by threads.
+ */
+
+class VoxelExpression
+{
+public:
+  VoxelExpression();
+  ~VoxelExpression() {};
+
+  /** The instruction set of the stack machine. */
+  enum OpCodeType {
+    PushVariable, PushConstant,
+    /** Unary operators, see itkUnaryFunctors.h and itkUnaryLogicalFunctors.h. */
+    Negate, Not, Abs, Sign, Floor, Ceil, Round, Ln, Log10, Exp,
+    Sin, Cos, Tan, ArcSin, ArcCos, ArcTan, ErrFunc, Linear, NormCDF, QFunc,
+    /** Binary operators, see itkBinaryFunctors.h and itkBinaryLogicalFunctors.h. */
+    Add, Subtract, Multiply, Divide, Power, Modulo, Minimum, Maximum,
+    AbsoluteDifference, SquaredDifference, Magnitude, Log,
+    Less, LessEqual, Greater, GreaterEqual, Equal, NotEqual, And, Or,
+    /** Ternary operator. */
+    Select };
+
+  /** A single instruction, with an index for PushVariable and
+   * constant arguments for PushConstant, Linear, NormCDF and QFunc.
+   */
+  struct InstructionType
+  {
+    OpCodeType    m_OpCode;
+    unsigned int  m_Index;
+    double        m_Argument1;
+    double        m_Argument2;
+  };
+  typedef std::vector< InstructionType > ProgramType;
+
+  /** Parse the expression and compile it to byte code. The variables
+   * in the expression refer to the given names. Throws an
+   * itk::ExceptionObject for syntax errors and unknown names.
+   */
+  void Compile( const std::string & expression,
+    const std::vector< std::string > & variableNames );
+
+  /** Get the compiled program. */
+  const ProgramType & GetProgram( void ) const { return this->m_Program; }
+
+  /** The number of doubles needed as workspace per evaluated voxel. */
+  unsigned int GetStackDepth( void ) const { return this->m_StackDepth; }
+
+  /** Evaluate the expression for n voxels. variables[ i ] points to n
+   * values of the i-th variable. The workspace must hold at least
+   * GetStackDepth() * n doubles, and is used by one thread only.
+   */
+  void Evaluate( const double * const * variables, const std::size_t n,
+    double * output, double * workspace ) const;
+
+  /** Get the byte code as readable text, one instruction per line. */
+  std::string GetProgramAsString( void ) const;
+
+private:
+
+  /** Recursive descent parser, one function per precedence level. */
+  void ParseTernary( void );
+  void ParseOr( void );
+  void ParseAnd( void );
+  void ParseEquality( void );
+  void ParseRelational( void );
+  void ParseAdditive( void );
+  void ParseMultiplicative( void );
+  void ParseUnary( void );
+  void ParsePower( void );
+  void ParsePrimary( void );
+  void ParseFunction( const std::string & name );
+
+  /** Helpers of the parser. */
+  void SkipWhiteSpace( void );
+  bool Accept( const std::string & token );
+  void Expect( const std::string & token );
+  void ThrowSyntaxError( const std::string & description ) const;
+
+  /** Append an instruction, and fold it if all its operands are constant. */
+  void Emit( OpCodeType opCode, unsigned int index = 0,
+    double argument1 = 0.0, double argument2 = 0.0 );
+
+  /** The number of stack values an instruction consumes. */
+  static unsigned int GetNumberOfOperands( OpCodeType opCode );
+
+  /** Evaluate a single unary or binary instruction on n values. The unary
+   * instructions are implemented in itkVoxelExpressionUnary.cxx, since
+   * itkUnaryFunctors.h and itkBinaryFunctors.h can not be included together.
+   */
+  static void EvaluateUnary( const InstructionType & instruction,
+    const double * a, double * out, const std::size_t n );
+  static void EvaluateBinary( const InstructionType & instruction,
+    const double * a, const double * b, double * out, const std::size_t n );
+
+  std::string                 m_Expression;
+  std::size_t                 m_Position;
+  std::vector< std::string >  m_VariableNames;
+  ProgramType                 m_Program;
+  unsigned int                m_Depth;
+  unsigned int                m_StackDepth;
+
+}; // end class VoxelExpression
+
+} // end namespace itk
+
+#endif // end #ifndef __itkVoxelExpression_h_
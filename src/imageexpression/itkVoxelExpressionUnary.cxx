@@ -0,0 +1,133 @@
+/*=========================================================================
+*
+* Copyright Marius Staring, Stefan Klein, David Doria. 2011.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0.txt
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*=========================================================================*/
+#include "itkVoxelExpression.h"
+
+#include "itkMacro.h"
+#include "itkUnaryFunctorImageFilter.h"
+#include "itkUnaryFunctors.h"
+// The NOT functor of itkUnaryLogicalFunctors.h, which itself clashes with itkUnaryFunctors.h.
+#include "itkNotImageFilter.h"
+
+
+namespace itk {
+
+/**
+ * ******************* ApplyUnaryFunctor *******************
+ */
+
+template< class TFunctor >
+static void ApplyUnaryFunctor( TFunctor & functor, const double * a,
+  double * out, const std::size_t n )
+{
+  for( std::size_t i = 0; i < n; ++i )
+  {
+    out[ i ] = functor( a[ i ] );
+  }
+} // end ApplyUnaryFunctor()
+
+
+/**
+ * ******************* ApplyUnaryFunctor *******************
+ */
+
+template< class TFunctor >
+static void ApplyUnaryFunctor( const double * a, double * out, const std::size_t n )
+{
+  TFunctor functor;
+  ApplyUnaryFunctor( functor, a, out, n );
+} // end ApplyUnaryFunctor()
+
+
+/**
+ * ******************* ApplyUnaryFunctorWithArguments *******************
+ */
+
+template< class TFunctor >
+static void ApplyUnaryFunctorWithArguments( const double * a, double * out,
+  const std::size_t n, const double argument1, const double argument2 )
+{
+  TFunctor functor;
+  functor.SetArgument1( argument1 );
+  functor.SetArgument2( argument2 );
+  ApplyUnaryFunctor( functor, a, out, n );
+} // end ApplyUnaryFunctorWithArguments()
+
+
+/**
+ * ******************* EvaluateUnary *******************
+ */
+
+void VoxelExpression
+::EvaluateUnary( const InstructionType & instruction,
+  const double * a, double * out, const std::size_t n )
+{
+  using namespace itk::Functor;
+
+  switch( instruction.m_OpCode )
+  {
+    case Negate:
+      ApplyUnaryFunctor< NEG<double> >( a, out, n ); break;
+    case Abs:
+      ApplyUnaryFunctor< ABSDOUBLE<double> >( a, out, n ); break;
+    case Sign:
+      ApplyUnaryFunctor< SIGNDOUBLE<double> >( a, out, n ); break;
+    case Floor:
+      ApplyUnaryFunctor< FLOOR<double> >( a, out, n ); break;
+    case Ceil:
+      ApplyUnaryFunctor< CEIL<double> >( a, out, n ); break;
+    case Round:
+      ApplyUnaryFunctor< ROUND<double> >( a, out, n ); break;
+    case Ln:
+      ApplyUnaryFunctor< LN<double> >( a, out, n ); break;
+    case Log10:
+      ApplyUnaryFunctor< LOG10<double> >( a, out, n ); break;
+    case Exp:
+      ApplyUnaryFunctor< EXP<double> >( a, out, n ); break;
+    case Sin:
+      ApplyUnaryFunctor< SIN<double> >( a, out, n ); break;
+    case Cos:
+      ApplyUnaryFunctor< COS<double> >( a, out, n ); break;
+    case Tan:
+      ApplyUnaryFunctor< TAN<double> >( a, out, n ); break;
+    case ArcSin:
+      ApplyUnaryFunctor< ARCSIN<double> >( a, out, n ); break;
+    case ArcCos:
+      ApplyUnaryFunctor< ARCCOS<double> >( a, out, n ); break;
+    case ArcTan:
+      ApplyUnaryFunctor< ARCTAN<double> >( a, out, n ); break;
+    case ErrFunc:
+      ApplyUnaryFunctor< ERRFUNC<double> >( a, out, n ); break;
+    case Linear:
+      ApplyUnaryFunctorWithArguments< LINEAR<double> >( a, out, n,
+        instruction.m_Argument1, instruction.m_Argument2 ); break;
+    case NormCDF:
+      ApplyUnaryFunctorWithArguments< NORMCDF<double> >( a, out, n,
+        instruction.m_Argument1, instruction.m_Argument2 ); break;
+    case QFunc:
+      ApplyUnaryFunctorWithArguments< QFUNC<double> >( a, out, n,
+        instruction.m_Argument1, instruction.m_Argument2 ); break;
+    /** Logical not, as NOT of pxlogicalimageoperator. */
+    case Not:
+      ApplyUnaryFunctor< NOT<double, double> >( a, out, n ); break;
+    default:
+      itkGenericExceptionMacro( << "Instruction " << instruction.m_OpCode << " is not a unary operator." );
+  }
+
+} // end EvaluateUnary()
+
+} // end namespace itk
@@ -23,13 +23,10 @@
 #include "itkImageFileReader.h"
 #include "itkImageFileWriter.h"
 
-#include "itkStatisticsImageFilter.h"
 #include "itkInvertIntensityImageFilter.h"
+#include "itkUnaryComponentWiseVectorImageFilter.h"
 
-// Vector image support
-#include "itkVectorIndexSelectionCastImageFilter.h" // decompose
-#include "itkComposeImageFilter.h" // reassemble
-#include "itkChannelByChannelVectorImageFilter2.h"
+#include <algorithm>
 
 
 /** \class ITKToolsInvertIntensityBase
@@ -78,66 +75,36 @@ public:
   void Run( void )
   {
     /** Some typedef's. */
-    typedef itk::Image<TComponentType, VDimension>              ScalarImageType;
-    typedef typename ScalarImageType::PixelType                 InputPixelType;
-    typedef itk::VectorImage< InputPixelType,
-      ScalarImageType::ImageDimension >                         VectorImageType;
+    typedef itk::VectorImage< TComponentType, VDimension >      VectorImageType;
     typedef itk::ImageFileReader< VectorImageType >             ReaderType;
     typedef itk::ImageFileWriter< VectorImageType >             WriterType;
-    typedef itk::StatisticsImageFilter< ScalarImageType >       StatisticsFilterType;
-    typedef typename StatisticsFilterType::RealType             RealType;
-    typedef itk::InvertIntensityImageFilter< ScalarImageType >  InvertIntensityFilterType;
+    typedef itk::Functor::InvertIntensityTransform<
+      TComponentType, TComponentType >                          InvertIntensityFunctorType;
+    typedef itk::UnaryComponentWiseVectorImageFilter<
+      VectorImageType, VectorImageType,
+      InvertIntensityFunctorType >                              InvertIntensityFilterType;
 
-    /** Create reader. */
+    /** Read the image. */
     typename ReaderType::Pointer reader = ReaderType::New();
     reader->SetFileName( this->m_InputFileName.c_str() );
+    reader->Update();
 
-    // In this case, we must manually disassemble the image rather than use a
-    // ChannelByChannel filter because the image is not the output,
-    // but rather the GetMaximum() function is what we want.
-
-    // Create the disassembler
-    typedef itk::VectorIndexSelectionCastImageFilter<VectorImageType, ScalarImageType> IndexSelectionType;
-    typename IndexSelectionType::Pointer indexSelectionFilter = IndexSelectionType::New();
-    indexSelectionFilter->SetInput( reader->GetOutput() );
-
-    // Initialize so that any number will be bigger than this one
-    TComponentType max = std::numeric_limits<TComponentType>::min();
-
-    // Get the max of each channel, keeping the largest
-    for( unsigned int channel = 0; channel < reader->GetOutput()->GetNumberOfComponentsPerPixel(); channel++ )
-    {
-      // Extract the current channel
-      indexSelectionFilter->SetIndex( channel );
-      indexSelectionFilter->Update();
-
-      /** Create statistics filter. */
-      typename StatisticsFilterType::Pointer statistics = StatisticsFilterType::New();
-      statistics->SetInput( indexSelectionFilter->GetOutput() );
-      statistics->Update();
-      if( statistics->GetMaximum() > max )
-      {
-        max = statistics->GetMaximum();
-      }
-    }
-
-    /** Create invert filter. */
-    typename InvertIntensityFilterType::Pointer invertFilter = InvertIntensityFilterType::New();
-    invertFilter->SetMaximum( max );
+    /** Get the maximum over all channels, directly from the interleaved buffer. */
+    const VectorImageType * image = reader->GetOutput();
+    const TComponentType * buffer = image->GetBufferPointer();
+    const std::size_t bufferSize = image->GetBufferedRegion().GetNumberOfPixels()
+      * image->GetNumberOfComponentsPerPixel();
+    const TComponentType max = *std::max_element( buffer, buffer + bufferSize );
 
-    // Setup the filter to apply the invert filter to every channel
-    typedef itk::ChannelByChannelVectorImageFilter2<
-      VectorImageType, InvertIntensityFilterType >        ChannelByChannelInvertType;
-    typename ChannelByChannelInvertType::Pointer channelByChannelInvertFilter
-      = ChannelByChannelInvertType::New();
-    channelByChannelInvertFilter->SetInput( reader->GetOutput() );
-    channelByChannelInvertFilter->SetFilter( invertFilter );
-    channelByChannelInvertFilter->Update();
+    /** Invert every component, in a single pass. */
+    typename InvertIntensityFilterType::Pointer invertFilter = InvertIntensityFilterType::New();
+    invertFilter->SetInput( reader->GetOutput() );
+    invertFilter->GetFunctor().SetMaximum( max );
 
     /** Create writer. */
     typename WriterType::Pointer writer = WriterType::New();
     writer->SetFileName( this->m_OutputFileName.c_str() );
-    writer->SetInput( channelByChannelInvertFilter->GetOutput() );
+    writer->SetInput( invertFilter->GetOutput() );
     writer->Update();
 
   } // end Run()
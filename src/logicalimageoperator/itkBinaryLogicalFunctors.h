@@ -21,6 +21,7 @@
 #include "itkAndImageFilter.h"
 #include "itkOrImageFilter.h"
 #include "itkXorImageFilter.h"
+#include "itkBinaryFunctorImageFilter.h"
 
 
 enum BinaryFunctorEnum {AND, OR, XOR, ANDNOT, ORNOT, NOT_XOR, NOT_OR, NOT_AND, DUMMY};
@@ -124,7 +125,12 @@ public:
 
 
 
-template< class TImage >
+/** Creates the filter for a BinaryFunctorEnum. TFilter is the filter type
+ * that applies the functor, itk::BinaryFunctorImageFilter for scalar
+ * images, or itk::BinaryComponentWiseVectorImageFilter for vector images.
+ */
+template< class TImage,
+  template< class, class, class, class > class TFilter = itk::BinaryFunctorImageFilter >
 struct BinaryLogicalFunctorFactory
 {
   typename itk::InPlaceImageFilter<TImage, TImage>::Pointer
@@ -132,64 +138,64 @@ struct BinaryLogicalFunctorFactory
   {
     if( filterType == AND )
     {
-      typedef itk::BinaryFunctorImageFilter<TImage, TImage, TImage,
-        itk::Functor::AND<typename TImage::PixelType> >  FilterType;
+      typedef TFilter<TImage, TImage, TImage,
+        itk::Functor::AND<typename TImage::InternalPixelType> >  FilterType;
       typename FilterType::Pointer filter = FilterType::New();
       return filter.GetPointer();
     }
     else if( filterType == OR )
     {
-      typedef itk::BinaryFunctorImageFilter<TImage, TImage, TImage,
-        itk::Functor::OR<typename TImage::PixelType> >  FilterType;
+      typedef TFilter<TImage, TImage, TImage,
+        itk::Functor::OR<typename TImage::InternalPixelType> >  FilterType;
       typename FilterType::Pointer filter = FilterType::New();
       return filter.GetPointer();
     }
     else if( filterType == XOR )
     {
-      typedef itk::BinaryFunctorImageFilter<TImage, TImage, TImage,
-        itk::Functor::XOR<typename TImage::PixelType> >  FilterType;
+      typedef TFilter<TImage, TImage, TImage,
+        itk::Functor::XOR<typename TImage::InternalPixelType> >  FilterType;
       typename FilterType::Pointer filter = FilterType::New();
       return filter.GetPointer();
     }
     else if( filterType == ANDNOT )
     {
-      typedef itk::BinaryFunctorImageFilter<TImage, TImage, TImage,
-        itk::Functor::ANDNOT<typename TImage::PixelType> >  FilterType;
+      typedef TFilter<TImage, TImage, TImage,
+        itk::Functor::ANDNOT<typename TImage::InternalPixelType> >  FilterType;
       typename FilterType::Pointer filter = FilterType::New();
       return filter.GetPointer();
     }
     else if( filterType == ORNOT )
     {
-      typedef itk::BinaryFunctorImageFilter<TImage, TImage, TImage,
-        itk::Functor::ORNOT<typename TImage::PixelType> >  FilterType;
+      typedef TFilter<TImage, TImage, TImage,
+        itk::Functor::ORNOT<typename TImage::InternalPixelType> >  FilterType;
       typename FilterType::Pointer filter = FilterType::New();
       return filter.GetPointer();
     }
     else if( filterType == NOT_XOR )
     {
-      typedef itk::BinaryFunctorImageFilter<TImage, TImage, TImage,
-        itk::Functor::NOT_XOR<typename TImage::PixelType> >  FilterType;
+      typedef TFilter<TImage, TImage, TImage,
+        itk::Functor::NOT_XOR<typename TImage::InternalPixelType> >  FilterType;
       typename FilterType::Pointer filter = FilterType::New();
       return filter.GetPointer();
     }
     else if( filterType == NOT_OR )
     {
-      typedef itk::BinaryFunctorImageFilter<TImage, TImage, TImage,
-        itk::Functor::NOT_OR<typename TImage::PixelType> >  FilterType;
+      typedef TFilter<TImage, TImage, TImage,
+        itk::Functor::NOT_OR<typename TImage::InternalPixelType> >  FilterType;
       typename FilterType::Pointer filter = FilterType::New();
       return filter.GetPointer();
     }
     else if( filterType == NOT_AND )
     {
-      typedef itk::BinaryFunctorImageFilter<TImage, TImage, TImage,
-        itk::Functor::NOT_AND<typename TImage::PixelType> >  FilterType;
+      typedef TFilter<TImage, TImage, TImage,
+        itk::Functor::NOT_AND<typename TImage::InternalPixelType> >  FilterType;
       typename FilterType::Pointer filter = FilterType::New();
       return filter.GetPointer();
     }
     else if( filterType == DUMMY )
     {
-      typedef itk::BinaryFunctorImageFilter<TImage, TImage, TImage,
-        itk::Functor::DUMMY<typename TImage::PixelType> >  FilterType;
+      typedef TFilter<TImage, TImage, TImage,
+        itk::Functor::DUMMY<typename TImage::InternalPixelType> >  FilterType;
       typename FilterType::Pointer filter = FilterType::New();
       return filter.GetPointer();
     }
@@ -19,6 +19,7 @@
 #define __itkUnaryLogicalFunctors_h_
 
 #include "itkNotImageFilter.h"
+#include "itkUnaryFunctorImageFilter.h"
 
 enum UnaryFunctorEnum {EQUAL, NOT};
 
@@ -46,24 +47,29 @@ private:
 } // end itk namespace
 
 
-template< class TImage >
+/** Creates the filter for a UnaryFunctorEnum. TFilter is the filter type
+ * that applies the functor, itk::UnaryFunctorImageFilter for scalar
+ * images, or itk::UnaryComponentWiseVectorImageFilter for vector images.
+ */
+template< class TImage,
+  template< class, class, class > class TFilter = itk::UnaryFunctorImageFilter >
 struct UnaryLogicalFunctorFactory
 {
   typename itk::InPlaceImageFilter<TImage, TImage>::Pointer
-    GetFilter( UnaryFunctorEnum filterType, typename TImage::PixelType argument )
+    GetFilter( UnaryFunctorEnum filterType, typename TImage::InternalPixelType argument )
   {
     if( filterType == EQUAL )
     {
-      typedef itk::UnaryFunctorImageFilter<TImage, TImage,
-        itk::Functor::EQUAL<typename TImage::PixelType> >  FilterType;
+      typedef TFilter<TImage, TImage,
+        itk::Functor::EQUAL<typename TImage::InternalPixelType> >  FilterType;
       typename FilterType::Pointer filter = FilterType::New();
       filter->GetFunctor().SetArgument(argument);
       return filter.GetPointer();
     }
     else if( filterType == NOT )
     {
-      typedef itk::UnaryFunctorImageFilter<TImage, TImage,
-        itk::Functor::NOT<typename TImage::PixelType> >  FilterType;
+      typedef TFilter<TImage, TImage,
+        itk::Functor::NOT<typename TImage::InternalPixelType> >  FilterType;
       typename FilterType::Pointer filter = FilterType::New();
       // 'argument' not used for this filter
       return filter.GetPointer();
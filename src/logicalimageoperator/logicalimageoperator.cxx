@@ -42,6 +42,8 @@ std::string GetHelpString( void )
     << "An appropriate scaling must be performed either manually (with pxrescaleintensityimagefilter)\n"
     << "or with the application used to view the image.\n"
     << "In the case of a vector image, this is a componentwise logical operator.\n"
+    << "Scalar images that contain only the values 0 and 1 are processed as bit-packed masks,\n"
+    << "using one bit per voxel; other images are processed voxel wise, with bitwise operators.\n"
     << "Usage:" << std::endl << "pxlogicalimageoperator\n"
     << "  -in      inputFilename1 [inputFilename2]\n"
     << "  [-out]   outputFilename, default in1 + <ops> + in2 + .mhd\n"
@@ -64,6 +66,7 @@ std::string GetHelpString( void )
     << "  [-arg]   argument, necessary for some ops\n"
     << "  [-dim]   dimension, default: automatically determined from inputimage1\n"
     << "  [-pt]    pixelType, default: automatically determined from inputimage1\n"
+    << "  [-s]     number of streams for reading and writing bit-packed masks, default 1.\n"
     << "Supported: 2D, 3D, (unsigned) short, (unsigned) char.\n"
     << "NOTE: for historical reasons this functionality is not part of the unary or binary image operator." << std::endl;
 
@@ -108,6 +111,9 @@ int main( int argc, char **argv )
 
   const bool useCompression = parser->ArgumentExists( "-z" );
 
+  unsigned int numberOfStreams = 1;
+  parser->GetCommandLineArgument( "-s", numberOfStreams );
+
   /** Check if the required arguments are given. */
   if( inputFileNames.size() != 2 && ops != "NOT" && ops != "NOT_NOT" && ops != "EQUAL" )
   {
@@ -198,6 +204,8 @@ int main( int argc, char **argv )
     filter->m_UseCompression = useCompression;
     filter->m_Argument = argument;
     filter->m_Unary = unary;
+    filter->m_NumberOfComponents = numberOfComponents;
+    filter->m_NumberOfStreams = numberOfStreams;
 
     filter->Run();
 
@@ -25,10 +25,11 @@
 
 #include "itkVectorImage.h"
 #include "itkImageFileReader.h"
-#include "itkCastImageFilter.h"
-#include "itkVectorIndexSelectionCastImageFilter.h"
-#include "itkComposeImageFilter.h"
 #include "itkImageFileWriter.h"
+#include "itkUnaryComponentWiseVectorImageFilter.h"
+#include "itkBinaryComponentWiseVectorImageFilter.h"
+#include "itkBitPackedMaskToImageFilter.h"
+#include "ITKToolsImageReading.h"
 
 #include <map>
 #include <utility>
@@ -55,6 +56,8 @@ public:
     this->m_UseCompression = false;
     this->m_Argument = 0.0f;
     this->m_Unary = false;
+    this->m_NumberOfComponents = 1;
+    this->m_NumberOfStreams = 1;
   };
   /** Destructor. */
   ~ITKToolsLogicalImageOperatorBase(){};
@@ -67,6 +70,8 @@ public:
   bool m_UseCompression;
   double m_Argument;
   bool m_Unary; // is the operator to be performed unary? (else it is binary)
+  unsigned int m_NumberOfComponents;
+  unsigned int m_NumberOfStreams;
 
 }; // end class ITKToolsLogicalImageOperatorBase
 
@@ -88,6 +93,12 @@ public:
   ITKToolsLogicalImageOperator(){};
   ~ITKToolsLogicalImageOperator(){};
 
+  /** A pair indicating which functor should be used for an operator,
+   * and whether the arguments should be swapped.
+   */
+  typedef std::pair< BinaryFunctorEnum, bool >        BinaryOperatorType;
+  typedef std::map<std::string, BinaryOperatorType>   BinaryOperatorMapType;
+
   /** Run function. */
   void Run( void )
   {
@@ -101,10 +112,12 @@ public:
   {
     /** Typedefs. */
     typedef itk::VectorImage<TComponentType, VDimension>  VectorImageType;
-    typedef itk::Image<TComponentType, VDimension>        ScalarImageType;
     typedef itk::ImageFileReader< VectorImageType >       ReaderType;
     typedef itk::ImageFileWriter< VectorImageType >       WriterType;
 
+    /** Binary scalar images are negated as a bit-packed mask. */
+    if( this->m_Ops == "NOT" && this->RunUnaryPacked() ) return;
+
     /** Declarations. */
     typename ReaderType::Pointer reader1 = ReaderType::New();
     typename WriterType::Pointer writer = WriterType::New();
@@ -116,11 +129,11 @@ public:
     std::cout << "Done reading image1." << std::endl;
 
     UnaryFunctorEnum unaryOperation;
-    if( this->m_Ops.compare( "EQUAL" ) )
+    if( this->m_Ops == "EQUAL" )
     {
       unaryOperation = EQUAL;
     }
-    else if( this->m_Ops.compare( "NOT" ) )
+    else if( this->m_Ops == "NOT" )
     {
       unaryOperation = NOT;
     }
@@ -130,13 +143,12 @@ public:
       return;
     }
 
-    UnaryLogicalFunctorFactory<ScalarImageType> unaryFactory;
-    typename itk::InPlaceImageFilter<ScalarImageType, ScalarImageType>::Pointer logicalFilter
+    /** The operator works directly on the interleaved components. */
+    UnaryLogicalFunctorFactory<VectorImageType,
+      itk::UnaryComponentWiseVectorImageFilter> unaryFactory;
+    typename itk::InPlaceImageFilter<VectorImageType, VectorImageType>::Pointer logicalFilter
       = unaryFactory.GetFilter( unaryOperation, static_cast<TComponentType>( this->m_Argument ) );
-
-    // Create the filter which will assemble the component into the output image
-    typedef itk::ComposeImageFilter<ScalarImageType> ImageToVectorImageFilterType;
-    typename ImageToVectorImageFilterType::Pointer imageToVectorImageFilter = ImageToVectorImageFilterType::New();
+    logicalFilter->SetInput( reader1->GetOutput() );
 
     std::cout
       << "Performing logical operation, "
@@ -144,24 +156,9 @@ public:
       << ", on input image(s)..."
       << std::endl;
 
-    typedef itk::VectorIndexSelectionCastImageFilter<VectorImageType, ScalarImageType> ComponentExtractionType;
-
-    for( unsigned int component = 0; component < reader1->GetOutput()->GetNumberOfComponentsPerPixel(); component++)
-    {
-      typename ComponentExtractionType::Pointer componentExtractor1 = ComponentExtractionType::New();
-      componentExtractor1->SetIndex(component);
-      componentExtractor1->SetInput(reader1->GetOutput());
-      componentExtractor1->Update();
-      logicalFilter->SetInput( componentExtractor1->GetOutput() );
-
-      logicalFilter->Update();
-
-      imageToVectorImageFilter->SetInput( component, logicalFilter->GetOutput() );
-    } // end component loop
-
     /** Write the image to disk */
     writer->SetFileName( this->m_OutputFileName.c_str() );
-    writer->SetInput( imageToVectorImageFilter->GetOutput() );
+    writer->SetInput( logicalFilter->GetOutput() );
     writer->SetUseCompression( this->m_UseCompression );
     writer->Update();
 
@@ -172,21 +169,89 @@ public:
   {
     /** Typedefs. */
     typedef itk::VectorImage<TComponentType, VDimension>  VectorImageType;
-    typedef itk::Image<TComponentType, VDimension>        ScalarImageType;
     typedef itk::ImageFileReader< VectorImageType >       ReaderType;
     typedef itk::ImageFileWriter< VectorImageType >       WriterType;
 
-    /** A pair indicating which functor should be used for an operator,
-     * and whether the arguments should be swapped.
-     */
-    typedef std::pair< BinaryFunctorEnum, bool >        BinaryOperatorType;
-    typedef std::map<std::string, BinaryOperatorType>   BinaryOperatorMapType;
-
     /** Declarations. */
     typename ReaderType::Pointer reader1 = ReaderType::New();
     typename ReaderType::Pointer reader2 = ReaderType::New();
     typename WriterType::Pointer writer = WriterType::New();
 
+    /** Set up the logicalFilter */
+    BinaryOperatorMapType binaryOperatorMap = this->GetBinaryOperatorMap();
+    if( binaryOperatorMap.count( this->m_Ops ) == 0 )
+    {
+      std::cerr << "ERROR: The desired operator is unknown: " << this->m_Ops << std::endl;
+      return;
+    }
+
+    BinaryOperatorType logicalOperator;
+    logicalOperator = binaryOperatorMap[ this->m_Ops ];
+    bool swapArguments = logicalOperator.second;
+    std::string withswapping = "";
+    if( swapArguments )
+    {
+      withswapping = " with swapped arguments";
+    }
+    std::cout
+      << "The desired logical operation, "
+      << this->m_Ops
+      << ", is simplified to the "
+      << logicalOperator.first
+      << " operation"
+      << withswapping
+      << "."
+      << std::endl;
+
+    /** Binary scalar images are processed as bit-packed masks. */
+    if( this->RunBinaryPacked( logicalOperator.first, swapArguments ) ) return;
+
+    /** Read the images. */
+    reader1->SetFileName( this->m_InputFileName1.c_str() );
+    std::cout << "Reading image1: " << this->m_InputFileName1 << std::endl;
+    reader1->Update();
+    std::cout << "Done reading image1." << std::endl;
+
+    reader2->SetFileName( this->m_InputFileName2.c_str() );
+    std::cout << "Reading image2: " << this->m_InputFileName2 << std::endl;
+    reader2->Update();
+    std::cout << "Done reading image2." << std::endl;
+
+    /** The operator works directly on the interleaved components. */
+    BinaryLogicalFunctorFactory<VectorImageType,
+      itk::BinaryComponentWiseVectorImageFilter> binaryFactory;
+    typename itk::InPlaceImageFilter<VectorImageType, VectorImageType>::Pointer logicalFilter
+      = binaryFactory.GetFilter( logicalOperator.first );
+
+    if( swapArguments )
+    {
+      /** swap the input files */
+      logicalFilter->SetInput( 1, reader1->GetOutput() );
+      logicalFilter->SetInput( 0, reader2->GetOutput() );
+    }
+    else
+    {
+      logicalFilter->SetInput( 0, reader1->GetOutput() );
+      logicalFilter->SetInput( 1, reader2->GetOutput() );
+    }
+
+    std::cout
+      << "Performing logical operation, "
+      << this->m_Ops
+      << ", on input image(s)..."
+      << std::endl;
+
+    /** Write the image to disk */
+    writer->SetFileName( this->m_OutputFileName.c_str() );
+    writer->SetInput( logicalFilter->GetOutput() );
+    writer->SetUseCompression( this->m_UseCompression );
+    writer->Update();
+
+  } // end RunBinary()
+
+  /** Get the map from the operators to their simplified form. */
+  BinaryOperatorMapType GetBinaryOperatorMap( void ) const
+  {
     /** Available SimpleOperatorTypes are defined in itkLogicalFunctors.h:
      * AND, OR, XOR, NOT_AND, NOT_OR, NOT_XOR, ANDNOT, ORNOT
      *
@@ -232,93 +297,121 @@ public:
     binaryOperatorMap["NOT_NOTORNOT"]  = BinaryOperatorType(AND, false);
     binaryOperatorMap["NOT_NOTXORNOT"] = BinaryOperatorType(NOT_XOR, false);
 
-    /** Read the images. */
-    reader1->SetFileName( this->m_InputFileName1.c_str() );
-    std::cout << "Reading image1: " << this->m_InputFileName1 << std::endl;
-    reader1->Update();
-    std::cout << "Done reading image1." << std::endl;
+    return binaryOperatorMap;
 
-    reader2->SetFileName( this->m_InputFileName2.c_str() );
-    std::cout << "Reading image2: " << this->m_InputFileName2 << std::endl;
-    reader2->Update();
-    std::cout << "Done reading image2." << std::endl;
+  } // end GetBinaryOperatorMap()
 
-    /** Set up the logicalFilter */
-    if( binaryOperatorMap.count( this->m_Ops ) == 0 )
+  /** Read an image as a bit-packed mask. Returns null if the image
+   * is not binary, in which case the voxel wise path is taken, which
+   * applies the operators bitwise. Reading stops at the first stream
+   * that is not binary, so that such an image is not read twice in full.
+   */
+  typename itk::BitPackedMask< VDimension >::Pointer ReadMask(
+    const std::string & fileName ) const
+  {
+    typedef itk::Image<TComponentType, VDimension>  ScalarImageType;
+
+    std::cout << "Reading image as a bit-packed mask: " << fileName << std::endl;
+    bool isBinary = false;
+    typename itk::BitPackedMask< VDimension >::Pointer mask
+      = itktools::ReadBitPackedMask< ScalarImageType >(
+      fileName, this->m_NumberOfStreams, isBinary, true );
+    if( !isBinary )
     {
-      std::cerr << "ERROR: The desired operator is unknown: " << this->m_Ops << std::endl;
-      return;
+      std::cout << "The image is not binary, falling back to the voxel wise operator." << std::endl;
+      return nullptr;
     }
+    std::cout << "Done reading image." << std::endl;
+    return mask;
 
-    BinaryOperatorType logicalOperator;
-    logicalOperator = binaryOperatorMap[ this->m_Ops ];
-    bool swapArguments = logicalOperator.second;
-    std::string withswapping = "";
-    if( swapArguments )
+  } // end ReadMask()
+
+  /** Write a bit-packed mask, possibly streamed. */
+  void WriteMask( const itk::BitPackedMask< VDimension > * mask ) const
+  {
+    typedef itk::Image<TComponentType, VDimension>                ScalarImageType;
+    typedef itk::BitPackedMaskToImageFilter< ScalarImageType >    UnpackFilterType;
+    typedef itk::ImageFileWriter< ScalarImageType >               WriterType;
+
+    typename UnpackFilterType::Pointer unpacker = UnpackFilterType::New();
+    unpacker->SetMask( mask );
+
+    typename WriterType::Pointer writer = WriterType::New();
+    writer->SetFileName( this->m_OutputFileName.c_str() );
+    writer->SetInput( unpacker->GetOutput() );
+    writer->SetUseCompression( this->m_UseCompression );
+    writer->SetNumberOfStreamDivisions( this->m_NumberOfStreams );
+    writer->Update();
+
+  } // end WriteMask()
+
+  /** Negate a binary scalar image as a bit-packed mask.
+   * Returns false if this is not possible.
+   */
+  bool RunUnaryPacked( void )
+  {
+    if( this->m_NumberOfComponents != 1 ) return false;
+
+    typename itk::BitPackedMask< VDimension >::Pointer mask
+      = this->ReadMask( this->m_InputFileName1 );
+    if( mask.IsNull() ) return false;
+
+    std::cout << "Performing logical operation, NOT, on the bit-packed mask..." << std::endl;
+    mask->Not();
+    this->WriteMask( mask );
+    return true;
+
+  } // end RunUnaryPacked()
+
+  /** Perform a binary operator on two binary scalar images, as bit-packed
+   * masks, 64 voxels at a time. Returns false if this is not possible.
+   */
+  bool RunBinaryPacked( const BinaryFunctorEnum operation, const bool swapArguments )
+  {
+    typedef itk::BitPackedMask< VDimension >  MaskType;
+
+    if( this->m_NumberOfComponents != 1 ) return false;
+
+    typename MaskType::Pointer mask1 = this->ReadMask( this->m_InputFileName1 );
+    if( mask1.IsNull() ) return false;
+
+    /** The result of DUMMY does not depend on the second image. */
+    if( operation == DUMMY )
     {
-      withswapping = " with swapped arguments";
+      mask1->Fill( true );
+      this->WriteMask( mask1 );
+      return true;
     }
-    std::cout
-      << "The desired logical operation, "
-      << this->m_Ops
-      << ", is simplified to the "
-      << logicalOperator.first
-      << " operation"
-      << withswapping
-      << "."
-      << std::endl;
-
-    BinaryLogicalFunctorFactory<ScalarImageType> binaryFactory;
-    typename itk::InPlaceImageFilter<ScalarImageType, ScalarImageType>::Pointer logicalFilter
-      = binaryFactory.GetFilter( logicalOperator.first );
 
-    // Create the filter which will assemble the component into the output image
-    typedef itk::ComposeImageFilter<ScalarImageType> ImageToVectorImageFilterType;
-    typename ImageToVectorImageFilterType::Pointer imageToVectorImageFilter = ImageToVectorImageFilterType::New();
+    typename MaskType::Pointer mask2 = this->ReadMask( this->m_InputFileName2 );
+    if( mask2.IsNull() ) return false;
 
     std::cout
       << "Performing logical operation, "
       << this->m_Ops
-      << ", on input image(s)..."
+      << ", on the bit-packed masks..."
       << std::endl;
 
-    typedef itk::VectorIndexSelectionCastImageFilter<VectorImageType, ScalarImageType> ComponentExtractionType;
-
-    for( unsigned int component = 0; component < reader1->GetOutput()->GetNumberOfComponentsPerPixel(); component++)
+    /** The result is stored in the first argument. */
+    MaskType * a = swapArguments ? mask2.GetPointer() : mask1.GetPointer();
+    const MaskType * b = swapArguments ? mask1.GetPointer() : mask2.GetPointer();
+    switch( operation )
     {
-      typename ComponentExtractionType::Pointer componentExtractor1 = ComponentExtractionType::New();
-      componentExtractor1->SetIndex(component);
-      componentExtractor1->SetInput(reader1->GetOutput());
-      componentExtractor1->Update();
-
-      typename ComponentExtractionType::Pointer componentExtractor2 = ComponentExtractionType::New();
-      componentExtractor2->SetIndex(component);
-      componentExtractor2->SetInput(reader2->GetOutput());
-      componentExtractor2->Update();
-
-      if( swapArguments )
-      {
-        /** swap the input files */
-        logicalFilter->SetInput( 1, componentExtractor1->GetOutput() );
-        logicalFilter->SetInput( 0, componentExtractor2->GetOutput() );
-      }
-      else
-      {
-        logicalFilter->SetInput( 0, componentExtractor1->GetOutput() );
-        logicalFilter->SetInput( 1, componentExtractor2->GetOutput() );
-      }
-      logicalFilter->Update();
-
-      imageToVectorImageFilter->SetInput(component, logicalFilter->GetOutput());
-    } // end component loop
+    case AND:     a->And( b );              break;
+    case OR:      a->Or( b );               break;
+    case XOR:     a->Xor( b );              break;
+    case ANDNOT:  a->AndNot( b );           break;
+    case ORNOT:   a->OrNot( b );            break;
+    case NOT_XOR: a->Xor( b ); a->Not();    break;
+    case NOT_OR:  a->Or( b ); a->Not();     break;
+    case NOT_AND: a->And( b ); a->Not();    break;
+    case DUMMY:                             break;
+    }
 
-    /** Write the image to disk */
-    writer->SetFileName( this->m_OutputFileName.c_str() );
-    writer->SetInput( imageToVectorImageFilter->GetOutput() );
-    writer->SetUseCompression( this->m_UseCompression );
-    writer->Update();
+    this->WriteMask( a );
+    return true;
 
-  } // end RunBinary()
+  } // end RunBinaryPacked()
 
 }; // end class ITKToolsLogicalImageOperator
 
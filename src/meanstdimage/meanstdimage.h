@@ -82,6 +82,8 @@ public:
   /** Typedef. */
   typedef itk::Image< TComponentType, VDimension >  InputImageType;
   typedef itk::Image< float, VDimension >           OutputImageType;
+  typedef itk::Image< unsigned char, VDimension >   MaskImageType;
+  typedef itk::Image< double, VDimension >          AccumulatorImageType;
 
   /** Run function. */
   void Run( void )
@@ -18,8 +18,10 @@
 #ifndef __meanstdimage_hxx_
 #define __meanstdimage_hxx_
 
-#include "itkImageFileReader.h"
 #include "itkImageFileWriter.h"
+#include "itkImageRegionIterator.h"
+#include "itkMultiThreaderBase.h"
+#include "ITKToolsImageReading.h"
 
 template< unsigned int VDimension, class TComponentType >
 void
@@ -36,193 +38,218 @@ ITKToolsMeanStdImage< VDimension, TComponentType >
 {
   /** TYPEDEF's. */
   typedef typename InputImageType::Pointer              ImagePointer;
+  typedef typename MaskImageType::Pointer               MaskImagePointer;
+  typedef typename AccumulatorImageType::Pointer        AccumulatorImagePointer;
   typedef typename OutputImageType::Pointer             OutImagePointer;
-  typedef itk::ImageFileReader< InputImageType >        ReaderType;
   typedef itk::ImageFileWriter< OutputImageType >       WriterType;
-  typedef typename InputImageType::PixelType            PixelType;
-  typedef typename ReaderType::Pointer                  ReaderPointer;
   typedef typename WriterType::Pointer                  WriterPointer;
+  typedef typename InputImageType::RegionType           RegionType;
 
   /** DECLARATION'S. */
   const unsigned int nrInputs = inputFileNames.size();
-  const unsigned int nrMasks = inputMaskFileNames.size();
-  
-  ReaderPointer inReader;
-  ReaderPointer inMaskReader;
-  WriterPointer writer_mean = WriterType::New();
-  WriterPointer writer_std = WriterType::New();
-  
-  OutImagePointer mean = OutputImageType::New();
-  OutImagePointer sq_mean = OutputImageType::New();
-  OutImagePointer std = OutputImageType::New();
-  OutImagePointer nr_images = OutputImageType::New();
-  
-  itk::ImageRegionConstIterator<InputImageType> input_iterator;
-  itk::ImageRegionConstIterator<InputImageType> mask_iterator;
-  itk::ImageRegionIterator<OutputImageType> mean_iterator;
-  itk::ImageRegionIterator<OutputImageType> sq_mean_iterator;
-  itk::ImageRegionIterator<OutputImageType> std_iterator;
-  itk::ImageRegionIterator<OutputImageType> nr_images_iterator;
-
-  /** Create temporary & output images */
-  inReader = ReaderType::New();
-  inReader->SetFileName( inputFileNames[0].c_str() );
-  inReader->Update();
-
-  mean->CopyInformation( inReader->GetOutput() );
-  sq_mean->CopyInformation( inReader->GetOutput() );
-  std->CopyInformation( inReader->GetOutput() );
-
-  mean->SetRegions( inReader->GetOutput()->GetLargestPossibleRegion().GetSize() );
-  sq_mean->SetRegions( inReader->GetOutput()->GetLargestPossibleRegion().GetSize() );
-  std->SetRegions( inReader->GetOutput()->GetLargestPossibleRegion().GetSize() );
-
-  mean->Allocate();
-  sq_mean->Allocate();
-  std->Allocate();
-
-  mean->FillBuffer( 0.0 );
-  sq_mean->FillBuffer( 0.0 );
-  std->FillBuffer( 0.0 );
-  
-  mean_iterator = itk::ImageRegionIterator<OutputImageType>( mean, mean->GetRequestedRegion() );
-  sq_mean_iterator = itk::ImageRegionIterator<OutputImageType>( sq_mean, sq_mean->GetRequestedRegion() );
-  std_iterator = itk::ImageRegionIterator<OutputImageType>( std, std->GetRequestedRegion() );
-  
-  /** Checking if there are masks and initialising the iterator*/
-  if (nrMasks != 0 )
+  const bool useMasks = inputMaskFileNames.size() != 0;
+
+  /** The masks are read as double before they are thresholded, see
+   * itktools::ReadMaskImage(). Reading them in this number of streams
+   * keeps the temporary double buffer as small as the mask itself.
+   */
+  const unsigned int maskStreams
+    = sizeof( double ) / sizeof( typename MaskImageType::PixelType );
+
+  /** The per voxel state of Welford's algorithm:
+   * count = the number of samples so far, only needed with masks,
+   * mean  = the running mean,
+   * m2    = the running sum of squared differences from the mean.
+   */
+  AccumulatorImagePointer mean = AccumulatorImageType::New();
+  AccumulatorImagePointer m2 = AccumulatorImageType::New();
+  AccumulatorImagePointer count = AccumulatorImageType::New();
+
+  /** Start reading the first input and mask. The masks are read as
+   * 0 and 1, see itktools::ReadMaskImage(). */
+  std::future< ImagePointer > nextInput
+    = itktools::ReadImageAsynchronously< InputImageType >( inputFileNames[ 0 ] );
+  std::future< MaskImagePointer > nextMask;
+  if( useMasks )
   {
-    inMaskReader = ReaderType::New();
-    inMaskReader->SetFileName( inputMaskFileNames[0].c_str() );
-    inMaskReader->Update();
-	
-    nr_images->CopyInformation( inReader->GetOutput() );
-    nr_images->SetRegions( inReader->GetOutput()->GetLargestPossibleRegion().GetSize() );
-    nr_images->Allocate();
-    nr_images->FillBuffer(0);
-	nr_images_iterator = itk::ImageRegionIterator<OutputImageType>( nr_images, nr_images->GetRequestedRegion() );
+    nextMask = std::async( std::launch::async,
+      &itktools::ReadMaskImage< MaskImageType >, inputMaskFileNames[ 0 ], maskStreams );
   }
-  /** Loop over all images and create sum(X) and sum(X^2) which is required for E(X) and E(X^2) */
+
+  /** Loop over all images and update the mean and m2 per voxel. */
+  typename itk::MultiThreaderBase::Pointer threader = itk::MultiThreaderBase::New();
   for( unsigned int i = 0; i < nrInputs; ++i )
   {
     std::cout << "Reading image " << inputFileNames[ i ].c_str() << std::endl;
-    inReader = ReaderType::New();
-    inReader->SetFileName( inputFileNames[ i ].c_str() );
-    inReader->Update();
-	
-    input_iterator = itk::ImageRegionConstIterator<InputImageType>(
-      inReader->GetOutput(), inReader->GetOutput()->GetRequestedRegion() );	
-	  
-    input_iterator.GoToBegin();
-    mean_iterator.GoToBegin();
-    sq_mean_iterator.GoToBegin();
-	
-	/** Reading the masks if needed*/
-	if (nrMasks != 0 )
-	{
-	  std::cout << "Reading mask " << inputMaskFileNames[ i ].c_str() << std::endl;
-	  inMaskReader = ReaderType::New();
-      inMaskReader->SetFileName( inputMaskFileNames[ i ].c_str() );
-      inMaskReader->Update();
-	  
-
-	  mask_iterator = itk::ImageRegionConstIterator<InputImageType>(
-        inMaskReader->GetOutput(), inMaskReader->GetOutput()->GetRequestedRegion() );
-
-	  mask_iterator.GoToBegin();
-	  nr_images_iterator.GoToBegin();
-	}
-	/** Create two maps for calculating the mean and std: sum(X) and sum(X^2) */
-    for (; !mean_iterator.IsAtEnd(); ++mean_iterator, ++sq_mean_iterator, ++input_iterator)
-    {	
-      /** Calculating the mean if there are no masks or if the mask is not zero in current voxel*/  	
-	  if (nrMasks == 0 || mask_iterator.Get() !=0)
-	  {
-	    mean_iterator.Set( mean_iterator.Get() + input_iterator.Get() );
-	    if( calc_std )
-  	      sq_mean_iterator.Set( sq_mean_iterator.Get() + (input_iterator.Get() * input_iterator.Get()) );
-
-	  }
-	  if (nrMasks != 0)
-	  {
-	    /** If masks are used, the number of the images used for the mean for each voxel is updated*/
-	    if (mask_iterator.Get() != 0 )
-		{
-		  nr_images_iterator.Set( nr_images_iterator.Get() + 1);
-		}  
-		/** Update iterators if we are in fact using masks*/
-		++mask_iterator;
-		++nr_images_iterator;
-	  }
-	}
-  }
+    ImagePointer input = nextInput.get();
+    MaskImagePointer mask;
+    if( useMasks )
+    {
+      std::cout << "Reading mask " << inputMaskFileNames[ i ].c_str() << std::endl;
+      mask = nextMask.get();
+    }
 
-  /** Calculate mean and standard deviation using:
-      mean = ( SUM(X) / N )
-      std  = sqrt( E(X^2) - (E(X))^2 ) for population standard deviation
-      std  = sqrt(N / (N-1)) * sqrt( E(X^2) - (E(X))^2 ) for sample standard deviation
-  */
-  mean_iterator.GoToBegin();
-  sq_mean_iterator.GoToBegin();
-  std_iterator.GoToBegin();
-  nr_images_iterator.GoToBegin();
-  
-  /** Denominator for the 1/N calculations and sample_std_factor N/(N-1) to get sample std from population std */
-  float denominator( 1.0f / nrInputs );
-  float sample_std_factor = std::sqrt(((float) nrInputs) / ((float) nrInputs - 1));
-
-  for (; !mean_iterator.IsAtEnd(); ++mean_iterator, ++sq_mean_iterator, ++std_iterator)
-  {
-    if (nrMasks != 0)
-	{
-	  if (nr_images_iterator.Get() > 1)
-	  {
-	    denominator = 1 / nr_images_iterator.Get();
-	    sample_std_factor = std::sqrt(((float) nr_images_iterator.Get()) / ((float) nr_images_iterator.Get() - 1));
-	  }
-	  else
-	  {
-	    denominator = nr_images_iterator.Get();
-	    sample_std_factor = 0;
-	  }
-	  ++nr_images_iterator;
-	}
-	
-	/** Calculate mean and mean of squares */
-	mean_iterator.Set( denominator * mean_iterator.Get() );
-	sq_mean_iterator.Set( denominator * sq_mean_iterator.Get() );
-	
-	/** Calculate standard deviation */
-	
-	if (calc_std)
-	{
-	  if (population_std) // Calculate either sample or population standard deviation
-	  { 
-	    std_iterator.Set( std::sqrt(
-	      (float) std::abs( sq_mean_iterator.Get() - (mean_iterator.Get() * mean_iterator.Get() ) ) ) );
-	  } 
-	  else
-	  {
-	    std_iterator.Set( sample_std_factor * std::sqrt(
-	      (float) std::abs( sq_mean_iterator.Get() - (mean_iterator.Get() * mean_iterator.Get() ) ) ) );
-	  }
-	}
+    /** Prefetch the next input and mask, while processing the current. */
+    if( i + 1 < nrInputs )
+    {
+      nextInput = itktools::ReadImageAsynchronously< InputImageType >( inputFileNames[ i + 1 ] );
+      if( useMasks )
+      {
+        nextMask = std::async( std::launch::async,
+          &itktools::ReadMaskImage< MaskImageType >, inputMaskFileNames[ i + 1 ], maskStreams );
+      }
+    }
+
+    /** Create temporary images. */
+    if( i == 0 )
+    {
+      mean->CopyInformation( input );
+      mean->SetRegions( input->GetLargestPossibleRegion().GetSize() );
+      mean->Allocate();
+      mean->FillBuffer( 0.0 );
+
+      if( calc_std )
+      {
+        m2->CopyInformation( input );
+        m2->SetRegions( input->GetLargestPossibleRegion().GetSize() );
+        m2->Allocate();
+        m2->FillBuffer( 0.0 );
+      }
+
+      if( useMasks )
+      {
+        count->CopyInformation( input );
+        count->SetRegions( input->GetLargestPossibleRegion().GetSize() );
+        count->Allocate();
+        count->FillBuffer( 0.0 );
+      }
+    }
+
+    /** Update the accumulators in parallel.
+     * Without masks the number of samples is equal for all voxels.
+     */
+    const double n = i + 1;
+    threader->ParallelizeImageRegion< VDimension >(
+      mean->GetLargestPossibleRegion(),
+      [&]( const RegionType & region )
+      {
+        itk::ImageRegionConstIterator< InputImageType > input_iterator( input, region );
+        itk::ImageRegionIterator< AccumulatorImageType > mean_iterator( mean, region );
+        itk::ImageRegionIterator< AccumulatorImageType > m2_iterator;
+        itk::ImageRegionConstIterator< MaskImageType > mask_iterator;
+        itk::ImageRegionIterator< AccumulatorImageType > count_iterator;
+        if( calc_std ) m2_iterator = itk::ImageRegionIterator< AccumulatorImageType >( m2, region );
+        if( useMasks )
+        {
+          mask_iterator = itk::ImageRegionConstIterator< MaskImageType >( mask, region );
+          count_iterator = itk::ImageRegionIterator< AccumulatorImageType >( count, region );
+        }
+
+        for( ; !input_iterator.IsAtEnd(); ++input_iterator, ++mean_iterator )
+        {
+          double nrSamples = n;
+          bool useVoxel = true;
+          if( useMasks )
+          {
+            useVoxel = mask_iterator.Get() != 0;
+            if( useVoxel ) count_iterator.Set( count_iterator.Get() + 1.0 );
+            nrSamples = count_iterator.Get();
+            ++mask_iterator;
+            ++count_iterator;
+          }
+
+          if( useVoxel )
+          {
+            const double value = static_cast< double >( input_iterator.Get() );
+            const double delta = value - mean_iterator.Get();
+            mean_iterator.Set( mean_iterator.Get() + delta / nrSamples );
+            if( calc_std )
+            {
+              m2_iterator.Set( m2_iterator.Get() + delta * ( value - mean_iterator.Get() ) );
+            }
+          }
+          if( calc_std ) ++m2_iterator;
+        }
+      },
+      nullptr );
   }
-  
+
   /** Write the output images */
   if( calc_mean )
   {
+    OutImagePointer meanOut = OutputImageType::New();
+    meanOut->CopyInformation( mean );
+    meanOut->SetRegions( mean->GetLargestPossibleRegion().GetSize() );
+    meanOut->Allocate();
+    threader->ParallelizeImageRegion< VDimension >(
+      mean->GetLargestPossibleRegion(),
+      [&]( const RegionType & region )
+      {
+        itk::ImageRegionConstIterator< AccumulatorImageType > mean_iterator( mean, region );
+        itk::ImageRegionIterator< OutputImageType > out_iterator( meanOut, region );
+        for( ; !mean_iterator.IsAtEnd(); ++mean_iterator, ++out_iterator )
+        {
+          out_iterator.Set( static_cast< float >( mean_iterator.Get() ) );
+        }
+      },
+      nullptr );
+    mean = nullptr;
+
+    WriterPointer writer_mean = WriterType::New();
     writer_mean->SetFileName( outputFileNameMean.c_str() );
-    writer_mean->SetInput( mean );
-	writer_mean->SetUseCompression( use_compression );
+    writer_mean->SetInput( meanOut );
+    writer_mean->SetUseCompression( use_compression );
     writer_mean->Update();
   }
 
+  /** Calculate the standard deviation using:
+      std = sqrt( m2 / N ) for population standard deviation
+      std = sqrt( m2 / (N-1) ) for sample standard deviation
+      where N is the number of samples of a voxel. With less than
+      two samples the standard deviation is set to zero.
+  */
   if( calc_std )
   {
+    OutImagePointer std_image = OutputImageType::New();
+    std_image->CopyInformation( m2 );
+    std_image->SetRegions( m2->GetLargestPossibleRegion().GetSize() );
+    std_image->Allocate();
+    const double nrInputsAsDouble = nrInputs;
+    threader->ParallelizeImageRegion< VDimension >(
+      m2->GetLargestPossibleRegion(),
+      [&]( const RegionType & region )
+      {
+        itk::ImageRegionConstIterator< AccumulatorImageType > m2_iterator( m2, region );
+        itk::ImageRegionConstIterator< AccumulatorImageType > count_iterator;
+        itk::ImageRegionIterator< OutputImageType > std_iterator( std_image, region );
+        if( useMasks )
+        {
+          count_iterator = itk::ImageRegionConstIterator< AccumulatorImageType >( count, region );
+        }
+
+        for( ; !m2_iterator.IsAtEnd(); ++m2_iterator, ++std_iterator )
+        {
+          double nrSamples = nrInputsAsDouble;
+          if( useMasks )
+          {
+            nrSamples = count_iterator.Get();
+            ++count_iterator;
+          }
+
+          double variance = 0.0;
+          if( nrSamples > 1.0 )
+          {
+            variance = m2_iterator.Get() / ( population_std ? nrSamples : nrSamples - 1.0 );
+          }
+          std_iterator.Set( static_cast< float >( std::sqrt( variance ) ) );
+        }
+      },
+      nullptr );
+
+    WriterPointer writer_std = WriterType::New();
     writer_std->SetFileName( outputFileNameStd.c_str() );
-    writer_std->SetInput( std );
-	writer_std->SetUseCompression( use_compression );
+    writer_std->SetInput( std_image );
+    writer_std->SetUseCompression( use_compression );
     writer_std->Update();
   }
 
@@ -20,13 +20,14 @@
 
 #include "itkInPlaceImageFilter.h"
 
-enum NaryFilterEnum {ADDITION, MEAN, MINUS, TIMES, DIVIDE, MAXIMUM, MINIMUM, ABSOLUTEDIFFERENCE, NARYMAGNITUDE};
+enum NaryFilterEnum {ADDITION, MEAN, MINUS, TIMES, DIVIDE, MAXIMUM, MINIMUM, ABSOLUTEDIFFERENCE, NARYMAGNITUDE,
+  MEDIAN, PERCENTILE, STD, MODE};
 
 template< class TInputImage, class TOutputImage >
 class NaryFilterFactory
 {
 public:
-  typename itk::InPlaceImageFilter<TInputImage, TOutputImage>::Pointer GetFilter(NaryFilterEnum filterType)
+  typename itk::InPlaceImageFilter<TInputImage, TOutputImage>::Pointer GetFilter(NaryFilterEnum filterType, double argument = 0.0)
   {
     if(filterType == ADDITION)
     {
@@ -91,6 +92,37 @@ public:
       typename FilterType::Pointer filter = FilterType::New();
       return filter.GetPointer();
     }
+    else if(filterType == MEDIAN)
+    {
+      typedef itk::NaryFunctorImageFilter<TInputImage, TOutputImage,
+        itk::Functor::NaryMEDIAN<typename TInputImage::PixelType, typename TOutputImage::PixelType> >  FilterType;
+      typename FilterType::Pointer filter = FilterType::New();
+      return filter.GetPointer();
+    }
+    else if(filterType == PERCENTILE)
+    {
+      typedef itk::Functor::NaryPERCENTILE<typename TInputImage::PixelType, typename TOutputImage::PixelType> FunctorType;
+      typedef itk::NaryFunctorImageFilter<TInputImage, TOutputImage, FunctorType>  FilterType;
+      typename FilterType::Pointer filter = FilterType::New();
+      FunctorType functor;
+      functor.SetPercentile( argument );
+      filter->SetFunctor( functor );
+      return filter.GetPointer();
+    }
+    else if(filterType == STD)
+    {
+      typedef itk::NaryFunctorImageFilter<TInputImage, TOutputImage,
+        itk::Functor::NarySTD<typename TInputImage::PixelType, typename TOutputImage::PixelType> >  FilterType;
+      typename FilterType::Pointer filter = FilterType::New();
+      return filter.GetPointer();
+    }
+    else if(filterType == MODE)
+    {
+      typedef itk::NaryFunctorImageFilter<TInputImage, TOutputImage,
+        itk::Functor::NaryMODE<typename TInputImage::PixelType, typename TOutputImage::PixelType> >  FilterType;
+      typename FilterType::Pointer filter = FilterType::New();
+      return filter.GetPointer();
+    }
     else
     {
       std::cerr << "Invalid filter type specified!" << std::endl;
@@ -25,8 +25,26 @@
 #include "ITKToolsImageProperties.h"
 #include "ITKToolsHelpers.h"
 
+/**
+ * ******************* IsSignedComponentType *******************
+ */
+
+bool IsSignedComponentType( const itk::ImageIOBase::IOComponentEnum & componentType )
+{
+  return componentType != itk::IOComponentEnum::UCHAR
+    && componentType != itk::IOComponentEnum::USHORT
+    && componentType != itk::IOComponentEnum::UINT
+    && componentType != itk::IOComponentEnum::ULONG
+    && componentType != itk::IOComponentEnum::ULONGLONG;
+
+} // end IsSignedComponentType()
+
+
 /**
  * ******************* DetermineImageProperties *******************
+ *
+ * On return componentTypeIn holds the largest native input type and
+ * componentTypeOut the default output type.
  */
 
 int DetermineImageProperties(
@@ -59,6 +77,14 @@ int DetermineImageProperties(
   unsigned int inputDimension_i = 2;
   unsigned int numberOfComponents_i = 1;
   std::vector<unsigned int> imagesize_i;
+  /** The largest signed and the largest unsigned input type, if any. */
+  bool anyInputIsSigned = false;
+  bool anyInputIsUnsigned = false;
+  itk::ImageIOBase::IOComponentEnum largestSignedType = componentTypeIn;
+  itk::ImageIOBase::IOComponentEnum largestUnsignedType = componentTypeIn;
+  if( IsSignedComponentType( componentTypeIn ) ) anyInputIsSigned = true;
+  else anyInputIsUnsigned = true;
+  componentTypeOut = itktools::GetLargestComponentType( componentTypeOut, componentTypeIn );
   for( unsigned int i = 1; i < inputFileNames.size(); i++ )
   {
     bool retgip_i = itktools::GetImageProperties(
@@ -102,17 +128,39 @@ int DetermineImageProperties(
 
     /** The output type is the largest of the input types. */
     componentTypeOut = itktools::GetLargestComponentType( componentTypeOut, componentTypeIn_i );
-  }
 
-  /** The input type is set to long or double, depending on the output type. */
-  bool outIsInteger = itktools::ComponentTypeIsInteger( componentTypeOut );
-  if( outIsInteger )
-  {
-    componentTypeIn = itk::IOComponentEnum::LONG;
+    /** The input type is the largest of the input types as well. */
+    componentTypeIn = itktools::GetLargestComponentType( componentTypeIn, componentTypeIn_i );
+    if( IsSignedComponentType( componentTypeIn_i ) )
+    {
+      largestSignedType = anyInputIsSigned
+        ? itktools::GetLargestComponentType( largestSignedType, componentTypeIn_i )
+        : componentTypeIn_i;
+      anyInputIsSigned = true;
+    }
+    else
+    {
+      largestUnsignedType = anyInputIsUnsigned
+        ? itktools::GetLargestComponentType( largestUnsignedType, componentTypeIn_i )
+        : componentTypeIn_i;
+      anyInputIsUnsigned = true;
+    }
   }
-  else
+
+  /** When signed and unsigned inputs are mixed, the input type should be
+   * signed, larger than the largest unsigned type, and at least as large as
+   * the largest signed type, whatever the order of the inputs. E.g. unsigned
+   * char and char inputs are read as short, unsigned short and short as long.
+   * Note that GetLargestComponentType() returns its first argument for types
+   * of equal size, so componentTypeIn itself depends on the input order.
+   */
+  if( anyInputIsSigned && anyInputIsUnsigned )
   {
-    componentTypeIn = itk::IOComponentEnum::DOUBLE;
+    const itk::ImageIOBase::IOComponentEnum promotedUnsignedType
+      = largestUnsignedType == itk::IOComponentEnum::UCHAR
+      ? itk::IOComponentEnum::SHORT : itk::IOComponentEnum::LONG;
+    componentTypeIn = itktools::GetLargestComponentType(
+      promotedUnsignedType, largestSignedType );
   }
 
   /** Return a value indicating success. */
@@ -121,6 +169,43 @@ int DetermineImageProperties(
 } // end DetermineImageProperties()
 
 
+/**
+ * ******************* GetAccumulationComponentType *******************
+ *
+ * The inputs are read in their native type when possible, so that the memory
+ * needed scales with the size on disk. Widening to the output type only takes
+ * place inside the functors. For the less common combinations that are not
+ * instantiated, the input is read as long or double, depending on the output.
+ */
+
+itk::ImageIOBase::IOComponentEnum GetAccumulationComponentType(
+  const itk::ImageIOBase::IOComponentEnum & nativeComponentType,
+  const itk::ImageIOBase::IOComponentEnum & componentTypeOut )
+{
+  const bool outIsInteger = itktools::ComponentTypeIsInteger( componentTypeOut );
+  const itk::ImageIOBase::IOComponentEnum nativeCleaned
+    = itktools::RemoveUnsignedFromComponentType( nativeComponentType );
+
+  /** Small integer types are supported for all output types. */
+  if( nativeCleaned == itk::IOComponentEnum::CHAR
+    || nativeCleaned == itk::IOComponentEnum::SHORT )
+  {
+    return nativeComponentType;
+  }
+
+  /** Float is supported for floating point output types. */
+  if( nativeComponentType == itk::IOComponentEnum::FLOAT && !outIsInteger )
+  {
+    return nativeComponentType;
+  }
+
+  /** Fall back to long or double, depending on the output type. */
+  if( outIsInteger ) return itk::IOComponentEnum::LONG;
+  return itk::IOComponentEnum::DOUBLE;
+
+} // end GetAccumulationComponentType()
+
+
 /**
  * ******************* CheckOperator *******************
  */
@@ -184,11 +269,31 @@ int CheckOperator( std::string & operatoR )
     operatoR = "SQUAREDDIFFERENCE";
     return 0;
   }
-  else if( operatoR == "BINARYMAGNITUDE" || operatoR == "BINARYMAG"
+  else if( operatoR == "NARYMAGNITUDE" || operatoR == "NARYMAG"
+    || operatoR == "BINARYMAGNITUDE" || operatoR == "BINARYMAG"
     || operatoR == "BINMAGNITUDE" || operatoR == "BINMAG"
     || operatoR == "MAGNITUDE" || operatoR == "MAG" )
   {
-    operatoR = "BINARYMAGNITUDE";
+    operatoR = "NARYMAGNITUDE";
+    return 0;
+  }
+  else if( operatoR == "MEDIAN" )
+  {
+    return 0;
+  }
+  else if( operatoR == "PERCENTILE" || operatoR == "PERC" )
+  {
+    operatoR = "PERCENTILE";
+    return 0;
+  }
+  else if( operatoR == "STD" || operatoR == "STANDARDDEVIATION" )
+  {
+    operatoR = "STD";
+    return 0;
+  }
+  else if( operatoR == "MODE" || operatoR == "MAJORITY" )
+  {
+    operatoR = "MODE";
     return 0;
   }
   else if( operatoR == "MASK" )
@@ -244,11 +349,15 @@ bool OperatorNeedsArgument( const std::string & operatoR )
   operatorMap["MINIMUM"]            = false;
   operatorMap["ABSOLUTEDIFFERENCE"] = false;
   operatorMap["SQUAREDDIFFERENCE"]  = false;
-  operatorMap["BINARYMAGNITUDE"]    = false;
+  operatorMap["NARYMAGNITUDE"]      = false;
   operatorMap["MASK"]               = true;
   operatorMap["MASKNEGATED"]        = true;
   operatorMap["MODULO"]             = false;
   operatorMap["LOG"]                = false;
+  operatorMap["MEDIAN"]             = false;
+  operatorMap["PERCENTILE"]         = true;
+  operatorMap["STD"]                = false;
+  operatorMap["MODE"]               = false;
 
   /** Return true or false. */
   if( operatorMap.count( operatoR ) ) return operatorMap[ operatoR ];
@@ -257,6 +366,18 @@ bool OperatorNeedsArgument( const std::string & operatoR )
 } // end OperatorNeedsArgument()
 
 
+/**
+ * ******************* OperatorSupportsRunningReduction *******************
+ */
+
+bool OperatorSupportsRunningReduction( const std::string & operatoR )
+{
+  return operatoR == "ADDITION" || operatoR == "MEAN" || operatoR == "TIMES"
+    || operatoR == "MAXIMUM" || operatoR == "MINIMUM" || operatoR == "NARYMAGNITUDE";
+
+} // end OperatorSupportsRunningReduction()
+
+
 /**
  * ******************* CheckOperatorAndArgument *******************
  */
@@ -296,6 +417,14 @@ bool CheckOperatorAndArgument(
         return false;
       }
     }
+    else if( operatoR == "PERCENTILE" )
+    {
+      if( arg < 0.0 || arg > 100.0 )
+      {
+        std::cerr << "ERROR: the percentile should be between 0.0 and 100.0." << std::endl;
+        return false;
+      }
+    }
   }
 
   return true;
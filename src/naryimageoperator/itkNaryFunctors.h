@@ -19,12 +19,42 @@
 #define __itkNaryFunctors_h_
 
 #include "itkNumericTraits.h"
+#include <algorithm>
+#include <cmath>
+#include <vector>
 
 namespace itk {
 
 namespace Functor {
 
 
+/** Cast a value to the output type, clamped to the range of the output
+ * type, since a cast of a value outside it is undefined. The bounds are
+ * returned as they are, instead of cast from double: the maximum of a
+ * 64-bit integer type is not representable as a double, and rounds up
+ * to a value outside the range. NaN is cast to zero for integer types.
+ * All functors below return through it, so that the single pass and the
+ * running reduction give the same result.
+ */
+template< class TOutput >
+inline TOutput NaryClampCast( const double & value )
+{
+  if( !NumericTraits< TOutput >::is_integer && sizeof( TOutput ) >= sizeof( double ) )
+  {
+    return static_cast< TOutput >( value );
+  }
+  const TOutput minimum = NumericTraits< TOutput >::NonpositiveMin();
+  const TOutput maximum = NumericTraits< TOutput >::max();
+  if( NumericTraits< TOutput >::is_integer && !( value == value ) )
+  {
+    return NumericTraits< TOutput >::ZeroValue();
+  }
+  if( value <= static_cast< double >( minimum ) ) return minimum;
+  if( value >= static_cast< double >( maximum ) ) return maximum;
+  return static_cast< TOutput >( value );
+}
+
+
 template< class TInput, class TOutput = TInput >
 class NaryADDITION
 {
@@ -42,7 +72,7 @@ public:
     {
       result += B[ i ];
     }
-    return static_cast< TOutput >( result );
+    return NaryClampCast< TOutput >( result );
   }
 };
 
@@ -63,7 +93,7 @@ public:
     {
       result += B[ i ];
     }
-    return static_cast< TOutput >( result / B.size() );
+    return NaryClampCast< TOutput >( result / B.size() );
   }
 };
 
@@ -84,7 +114,7 @@ public:
     {
       result -= B[ i ];
     }
-    return static_cast< TOutput >( result );
+    return NaryClampCast< TOutput >( result );
   }
 };
 
@@ -106,7 +136,7 @@ public:
     {
       result *= B[ i ];
     }
-    return static_cast< TOutput >( result );
+    return NaryClampCast< TOutput >( result );
   }
 };
 
@@ -128,7 +158,7 @@ public:
     {
       result = B[ i ] != 0 ? result / B[ i ] : result;
     }
-    return static_cast< TOutput >( result );
+    return NaryClampCast< TOutput >( result );
   }
 };
 
@@ -147,9 +177,9 @@ public:
     AccumulateType result = static_cast< AccumulateType >( B[ 0 ] );
     for( unsigned int i = 1; i < B.size(); i++ )
     {
-      result = std::max( result, B[ i ] );
+      result = std::max( result, static_cast< AccumulateType >( B[ i ] ) );
     }
-    return static_cast< TOutput >( result );
+    return NaryClampCast< TOutput >( result );
   }
 };
 
@@ -169,9 +199,9 @@ public:
     AccumulateType result = static_cast< AccumulateType >( B[ 0 ] );
     for( unsigned int i = 1; i < B.size(); i++ )
     {
-      result = std::min( result, B[ i ] );
+      result = std::min( result, static_cast< AccumulateType >( B[ i ] ) );
     }
-    return static_cast< TOutput >( result );
+    return NaryClampCast< TOutput >( result );
   }
 };
 
@@ -193,7 +223,7 @@ public:
     {
       result -= B[ i ];
     }
-    return static_cast< TOutput >( result > 0.0 ? result : -result );
+    return NaryClampCast< TOutput >( result > 0.0 ? result : -result );
   }
 };
 
@@ -213,10 +243,357 @@ public:
     ScalarRealType result = NumericTraits< ScalarRealType >::Zero;
     for( unsigned int i = 0; i < B.size(); i++ )
     {
-      result += B[ i ] * B[ i ];
+      const ScalarRealType value = static_cast< ScalarRealType >( B[ i ] );
+      result += value * value;
+    }
+    return NaryClampCast< TOutput >( std::sqrt( result ) );
+  }
+};
+
+/** \class NaryOrderStatistics
+ * Helper for the order statistic functors below.
+ *
+ * The values are copied to a scratch buffer that is owned by the calling
+ * thread, so no memory is allocated per voxel. Up to SmallSize values are
+ * kept on the stack and sorted with a Batcher odd-even merge sorting network,
+ * which is branch free. For more values the k-th element is found with a
+ * partial selection.
+ */
+
+template< class TInput >
+class NaryOrderStatistics
+{
+public:
+  static constexpr unsigned int SmallSize = 16;
+
+  /** Sort v[0..n) in place with a compare-exchange network. */
+  static inline void SortingNetwork( TInput * v, const unsigned int n )
+  {
+    for( unsigned int p = 1; p < n; p <<= 1 )
+    {
+      for( unsigned int k = p; k >= 1; k >>= 1 )
+      {
+        for( unsigned int j = k % p; j + k < n; j += 2 * k )
+        {
+          const unsigned int iEnd = std::min( k, n - j - k );
+          for( unsigned int i = 0; i < iEnd; ++i )
+          {
+            if( ( i + j ) / ( 2 * p ) == ( i + j + k ) / ( 2 * p ) )
+            {
+              const TInput a = v[ i + j ];
+              const TInput b = v[ i + j + k ];
+              v[ i + j ] = std::min( a, b );
+              v[ i + j + k ] = std::max( a, b );
+            }
+          }
+        }
+      }
     }
-    return static_cast< TOutput >( std::sqrt( result ) );
   }
+
+  /** Return the interpolated order statistic at fractional position
+   * pos in [0, n-1] of the values in B. */
+  static inline double Select( const std::vector< TInput > & B, const double & pos )
+  {
+    const unsigned int n = B.size();
+    const unsigned int lo = static_cast< unsigned int >( pos );
+    const unsigned int hi = std::min( lo + 1, n - 1 );
+    const double frac = pos - lo;
+    double vlo, vhi;
+
+    if( n <= SmallSize )
+    {
+      TInput v[ SmallSize ];
+      std::copy( B.begin(), B.end(), v );
+      SortingNetwork( v, n );
+      vlo = static_cast< double >( v[ lo ] );
+      vhi = static_cast< double >( v[ hi ] );
+    }
+    else
+    {
+      std::vector< TInput > & v = GetScratch( B );
+      std::nth_element( v.begin(), v.begin() + lo, v.end() );
+      vlo = static_cast< double >( v[ lo ] );
+      vhi = hi == lo ? vlo
+        : static_cast< double >( *std::min_element( v.begin() + hi, v.end() ) );
+    }
+
+    return vlo + frac * ( vhi - vlo );
+  }
+
+  /** Return the most frequent value in B. Ties are resolved by taking
+   * the smallest value. */
+  static inline TInput Mode( const std::vector< TInput > & B )
+  {
+    const unsigned int n = B.size();
+    TInput small[ SmallSize ];
+    TInput * v = small;
+    if( n <= SmallSize )
+    {
+      std::copy( B.begin(), B.end(), v );
+      SortingNetwork( v, n );
+    }
+    else
+    {
+      std::vector< TInput > & scratch = GetScratch( B );
+      std::sort( scratch.begin(), scratch.end() );
+      v = &scratch[ 0 ];
+    }
+
+    /** Find the longest run in the sorted values. */
+    TInput mode = v[ 0 ];
+    unsigned int modeCount = 0;
+    unsigned int runStart = 0;
+    for( unsigned int i = 1; i <= n; ++i )
+    {
+      if( i == n || v[ i ] != v[ runStart ] )
+      {
+        if( i - runStart > modeCount )
+        {
+          modeCount = i - runStart;
+          mode = v[ runStart ];
+        }
+        runStart = i;
+      }
+    }
+    return mode;
+  }
+
+private:
+  /** Copy B to a buffer owned by the calling thread. It only
+   * reallocates when the number of inputs grows. */
+  static inline std::vector< TInput > & GetScratch( const std::vector< TInput > & B )
+  {
+    static thread_local std::vector< TInput > scratch;
+    scratch.assign( B.begin(), B.end() );
+    return scratch;
+  }
+};
+
+
+template< class TInput, class TOutput = TInput >
+class NaryMEDIAN
+{
+public:
+  NaryMEDIAN() {};
+  ~NaryMEDIAN() {};
+  bool operator!=( const NaryMEDIAN & ) const{ return false; }
+  bool operator==( const NaryMEDIAN & other ) const{ return !(*this != other); }
+  inline TOutput operator()( const std::vector< TInput > & B ) const
+  {
+    const double pos = 0.5 * ( B.size() - 1 );
+    return NaryClampCast< TOutput >( NaryOrderStatistics< TInput >::Select( B, pos ) );
+  }
+};
+
+
+template< class TInput, class TOutput = TInput >
+class NaryPERCENTILE
+{
+public:
+  NaryPERCENTILE() { this->m_Percentile = 50.0; };
+  ~NaryPERCENTILE() {};
+  bool operator!=( const NaryPERCENTILE & other ) const
+  {
+    return this->m_Percentile != other.m_Percentile;
+  }
+  bool operator==( const NaryPERCENTILE & other ) const{ return !(*this != other); }
+  inline TOutput operator()( const std::vector< TInput > & B ) const
+  {
+    const double pos = this->m_Percentile / 100.0 * ( B.size() - 1 );
+    return NaryClampCast< TOutput >( NaryOrderStatistics< TInput >::Select( B, pos ) );
+  }
+  /** Set the percentile, in the range [0, 100]. */
+  void SetPercentile( const double & p ) { this->m_Percentile = p; }
+private:
+  double m_Percentile;
+};
+
+
+template< class TInput, class TOutput = TInput >
+class NarySTD
+{
+public:
+  typedef typename NumericTraits< TInput >::ScalarRealType ScalarRealType;
+  NarySTD() {};
+  ~NarySTD() {};
+  bool operator!=( const NarySTD & ) const{ return false; }
+  bool operator==( const NarySTD & other ) const{ return !(*this != other); }
+  inline TOutput operator()( const std::vector< TInput > & B ) const
+  {
+    /** Welford's update, and the sample standard deviation. */
+    ScalarRealType mean = NumericTraits< ScalarRealType >::Zero;
+    ScalarRealType m2 = NumericTraits< ScalarRealType >::Zero;
+    for( unsigned int i = 0; i < B.size(); i++ )
+    {
+      const ScalarRealType value = static_cast< ScalarRealType >( B[ i ] );
+      const ScalarRealType delta = value - mean;
+      mean += delta / ( i + 1 );
+      m2 += delta * ( value - mean );
+    }
+    return NaryClampCast< TOutput >( std::sqrt( m2 / ( B.size() - 1 ) ) );
+  }
+};
+
+
+template< class TInput, class TOutput = TInput >
+class NaryMODE
+{
+public:
+  NaryMODE() {};
+  ~NaryMODE() {};
+  bool operator!=( const NaryMODE & ) const{ return false; }
+  bool operator==( const NaryMODE & other ) const{ return !(*this != other); }
+  inline TOutput operator()( const std::vector< TInput > & B ) const
+  {
+    return NaryClampCast< TOutput >( NaryOrderStatistics< TInput >::Mode( B ) );
+  }
+};
+
+
+/** Running counterparts of the associative n-ary functors.
+ * They allow to reduce the inputs one at a time: Initialize() is applied
+ * to the first input, Accumulate() folds in every next input, and
+ * Finalize() converts the accumulator to the result, given the number
+ * of inputs. The semantics equal those of the Nary functors above.
+ */
+
+template< class TInput, class TAccumulate = double >
+class NaryRunningADDITION
+{
+public:
+  static inline TAccumulate Initialize( const TInput & A )
+  {
+    return static_cast< TAccumulate >( A );
+  }
+  static inline TAccumulate Accumulate( const TAccumulate & acc, const TInput & A )
+  {
+    return acc + static_cast< TAccumulate >( A );
+  }
+  static inline TAccumulate Finalize( const TAccumulate & acc, const unsigned int & )
+  {
+    return acc;
+  }
+};
+
+template< class TInput, class TAccumulate = double >
+class NaryRunningMEAN
+{
+public:
+  static inline TAccumulate Initialize( const TInput & A )
+  {
+    return static_cast< TAccumulate >( A );
+  }
+  static inline TAccumulate Accumulate( const TAccumulate & acc, const TInput & A )
+  {
+    return acc + static_cast< TAccumulate >( A );
+  }
+  static inline TAccumulate Finalize( const TAccumulate & acc, const unsigned int & n )
+  {
+    return acc / static_cast< TAccumulate >( n );
+  }
+};
+
+template< class TInput, class TAccumulate = double >
+class NaryRunningTIMES
+{
+public:
+  static inline TAccumulate Initialize( const TInput & A )
+  {
+    return static_cast< TAccumulate >( A );
+  }
+  static inline TAccumulate Accumulate( const TAccumulate & acc, const TInput & A )
+  {
+    return acc * static_cast< TAccumulate >( A );
+  }
+  static inline TAccumulate Finalize( const TAccumulate & acc, const unsigned int & )
+  {
+    return acc;
+  }
+};
+
+template< class TInput, class TAccumulate = double >
+class NaryRunningMAXIMUM
+{
+public:
+  static inline TAccumulate Initialize( const TInput & A )
+  {
+    return static_cast< TAccumulate >( A );
+  }
+  static inline TAccumulate Accumulate( const TAccumulate & acc, const TInput & A )
+  {
+    return std::max( acc, static_cast< TAccumulate >( A ) );
+  }
+  static inline TAccumulate Finalize( const TAccumulate & acc, const unsigned int & )
+  {
+    return acc;
+  }
+};
+
+template< class TInput, class TAccumulate = double >
+class NaryRunningMINIMUM
+{
+public:
+  static inline TAccumulate Initialize( const TInput & A )
+  {
+    return static_cast< TAccumulate >( A );
+  }
+  static inline TAccumulate Accumulate( const TAccumulate & acc, const TInput & A )
+  {
+    return std::min( acc, static_cast< TAccumulate >( A ) );
+  }
+  static inline TAccumulate Finalize( const TAccumulate & acc, const unsigned int & )
+  {
+    return acc;
+  }
+};
+
+template< class TInput, class TAccumulate = double >
+class NaryRunningNARYMAGNITUDE
+{
+public:
+  static inline TAccumulate Initialize( const TInput & A )
+  {
+    const TAccumulate value = static_cast< TAccumulate >( A );
+    return value * value;
+  }
+  static inline TAccumulate Accumulate( const TAccumulate & acc, const TInput & A )
+  {
+    const TAccumulate value = static_cast< TAccumulate >( A );
+    return acc + value * value;
+  }
+  static inline TAccumulate Finalize( const TAccumulate & acc, const unsigned int & )
+  {
+    return std::sqrt( acc );
+  }
+};
+
+
+/** \class NaryRunningFinalize
+ * Converts the accumulator of a running functor to the output type,
+ * clamped to its range with NaryClampCast().
+ */
+
+template< class TRunningFunctor, class TOutput, class TAccumulate = double >
+class NaryRunningFinalize
+{
+public:
+  NaryRunningFinalize() { this->m_NumberOfInputs = 1; };
+  ~NaryRunningFinalize() {};
+  bool operator!=( const NaryRunningFinalize & other ) const
+  {
+    return this->m_NumberOfInputs != other.m_NumberOfInputs;
+  }
+  bool operator==( const NaryRunningFinalize & other ) const{ return !(*this != other); }
+  inline TOutput operator()( const TAccumulate & acc ) const
+  {
+    return NaryClampCast< TOutput >( static_cast< double >(
+      TRunningFunctor::Finalize( acc, this->m_NumberOfInputs ) ) );
+  }
+  /** Set the number of inputs that were accumulated. */
+  void SetNumberOfInputs( const unsigned int & n ) { this->m_NumberOfInputs = n; }
+private:
+  unsigned int m_NumberOfInputs;
 };
 
 } // end namespace Functor
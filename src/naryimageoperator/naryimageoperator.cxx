@@ -49,18 +49,30 @@ std::string GetHelpString( void )
     << "             {ADDITION, MINUS, TIMES, DIVIDE,\n"
     << "             MEAN,\n"
     << "             MAXIMUM, MINIMUM, ABSOLUTEDIFFERENCE,\n"
-    << "             NARYMAGNITUDE }\n"
+    << "             NARYMAGNITUDE,\n"
+    << "             MEDIAN, PERCENTILE, STD, MODE }\n"
     << "           notation examples:\n"
     << "             MINUS = I_0 - I_1 - ... - I_n \n"
     << "             ABSDIFF = |I_0 - I_1 - ... - I_n|\n"
     << "             MIN = min( I_0, ..., I_n )\n"
     << "             MAGNITUDE = sqrt( I_0 * I_0 + ... + I_n * I_n )\n"
+    << "             PERCENTILE = the arg-th percentile of I_0, ..., I_n\n"
+    << "             STD = the sample standard deviation of I_0, ..., I_n\n"
+    << "             MODE = the most frequent value of I_0, ..., I_n\n"
+    << "  [-arg]   argument, necessary for some ops\n"
+    << "             PERCENTILE: 0.0 <= percentile <= 100.0\n"
 //   std::cout << "  [-arg]   argument, necessary for some ops\n"
 //             << "             WEIGHTEDADDITION: 0.0 < weight alpha < 1.0\n"
 //             << "             MASK[NEG]: background value, e.g. 0.\n";
+    << "  [-running] reduce the inputs one at a time into a running accumulator,\n"
+    << "             while the next input is read in the background. Then only two\n"
+    << "             inputs are in memory at a time. Only for the associative operators\n"
+    << "             {ADDITION, MEAN, TIMES, MAXIMUM, MINIMUM, NARYMAGNITUDE}.\n"
+    << "             Results outside the range of the output type are clamped.\n"
     << "  [-z]     compression flag; if provided, the output image is compressed\n"
     << "  [-s]     number of streams, default equals number of inputs.\n"
-    << "  [-opct]  output component type, by default the largest of the two input images\n"
+    << "  [-opct]  output component type, by default the largest of the input images\n"
+    << "             and at least long; the inputs are read in their native type\n"
     << "             choose one of: {[unsigned_]{char,short,int,long},float,double}\n"
     << "Supported: 2D, 3D, (unsigned) char, (unsigned) short, (unsigned) int, (unsigned) long, float, double.";
 
@@ -111,6 +123,7 @@ int main( int argc, char **argv )
   bool retopct = parser->GetCommandLineArgument( "-opct", opct );
 
   const bool useCompression = parser->ArgumentExists( "-z" );
+  const bool useRunningReduction = parser->ArgumentExists( "-running" );
 
   /** Support for streaming. */
   unsigned int numberOfStreams = inputFileNames.size();
@@ -140,13 +153,11 @@ int main( int argc, char **argv )
       std::cerr << "ERROR: the you specified an invalid opct." << std::endl;
       return EXIT_FAILURE;
     }
-
-    if( !itktools::ComponentTypeIsInteger( componentTypeOut ) )
-    {
-      componentTypeIn = itk::IOComponentEnum::DOUBLE;
-    }
   }
 
+  /** Read the inputs in their native type where possible. */
+  componentTypeIn = GetAccumulationComponentType( componentTypeIn, componentTypeOut );
+
   /** Check if a valid operator is given. */
   std::string opsCopy = ops;
   int retCO  = CheckOperator( ops );
@@ -156,6 +167,13 @@ int main( int argc, char **argv )
   bool retCOA = CheckOperatorAndArgument( ops, argument, retarg );
   if( !retCOA ) return EXIT_FAILURE;
 
+  /** Only associative operators can be reduced one input at a time. */
+  if( useRunningReduction && !OperatorSupportsRunningReduction( ops ) )
+  {
+    std::cerr << "ERROR: operator " << ops << " does not support \"-running\"." << std::endl;
+    return EXIT_FAILURE;
+  }
+
   /** Class that does the work. */
   ITKToolsNaryImageOperatorBase * filter = nullptr;
 
@@ -172,6 +190,48 @@ int main( int argc, char **argv )
     if( !filter ) filter = ITKToolsNaryImageOperator< 2, long, unsigned long >::New( dim, componentTypeIn, componentTypeOut );
     if( !filter ) filter = ITKToolsNaryImageOperator< 2, double, float >::New( dim, componentTypeIn, componentTypeOut );
     if( !filter ) filter = ITKToolsNaryImageOperator< 2, double, double >::New( dim, componentTypeIn, componentTypeOut );
+    if( !filter ) filter = ITKToolsNaryImageOperator< 2, char, char >::New( dim, componentTypeIn, componentTypeOut );
+    if( !filter ) filter = ITKToolsNaryImageOperator< 2, char, unsigned char >::New( dim, componentTypeIn, componentTypeOut );
+    if( !filter ) filter = ITKToolsNaryImageOperator< 2, char, short >::New( dim, componentTypeIn, componentTypeOut );
+    if( !filter ) filter = ITKToolsNaryImageOperator< 2, char, unsigned short >::New( dim, componentTypeIn, componentTypeOut );
+    if( !filter ) filter = ITKToolsNaryImageOperator< 2, char, int >::New( dim, componentTypeIn, componentTypeOut );
+    if( !filter ) filter = ITKToolsNaryImageOperator< 2, char, unsigned int >::New( dim, componentTypeIn, componentTypeOut );
+    if( !filter ) filter = ITKToolsNaryImageOperator< 2, char, long >::New( dim, componentTypeIn, componentTypeOut );
+    if( !filter ) filter = ITKToolsNaryImageOperator< 2, char, unsigned long >::New( dim, componentTypeIn, componentTypeOut );
+    if( !filter ) filter = ITKToolsNaryImageOperator< 2, char, float >::New( dim, componentTypeIn, componentTypeOut );
+    if( !filter ) filter = ITKToolsNaryImageOperator< 2, char, double >::New( dim, componentTypeIn, componentTypeOut );
+    if( !filter ) filter = ITKToolsNaryImageOperator< 2, unsigned char, char >::New( dim, componentTypeIn, componentTypeOut );
+    if( !filter ) filter = ITKToolsNaryImageOperator< 2, unsigned char, unsigned char >::New( dim, componentTypeIn, componentTypeOut );
+    if( !filter ) filter = ITKToolsNaryImageOperator< 2, unsigned char, short >::New( dim, componentTypeIn, componentTypeOut );
+    if( !filter ) filter = ITKToolsNaryImageOperator< 2, unsigned char, unsigned short >::New( dim, componentTypeIn, componentTypeOut );
+    if( !filter ) filter = ITKToolsNaryImageOperator< 2, unsigned char, int >::New( dim, componentTypeIn, componentTypeOut );
+    if( !filter ) filter = ITKToolsNaryImageOperator< 2, unsigned char, unsigned int >::New( dim, componentTypeIn, componentTypeOut );
+    if( !filter ) filter = ITKToolsNaryImageOperator< 2, unsigned char, long >::New( dim, componentTypeIn, componentTypeOut );
+    if( !filter ) filter = ITKToolsNaryImageOperator< 2, unsigned char, unsigned long >::New( dim, componentTypeIn, componentTypeOut );
+    if( !filter ) filter = ITKToolsNaryImageOperator< 2, unsigned char, float >::New( dim, componentTypeIn, componentTypeOut );
+    if( !filter ) filter = ITKToolsNaryImageOperator< 2, unsigned char, double >::New( dim, componentTypeIn, componentTypeOut );
+    if( !filter ) filter = ITKToolsNaryImageOperator< 2, short, char >::New( dim, componentTypeIn, componentTypeOut );
+    if( !filter ) filter = ITKToolsNaryImageOperator< 2, short, unsigned char >::New( dim, componentTypeIn, componentTypeOut );
+    if( !filter ) filter = ITKToolsNaryImageOperator< 2, short, short >::New( dim, componentTypeIn, componentTypeOut );
+    if( !filter ) filter = ITKToolsNaryImageOperator< 2, short, unsigned short >::New( dim, componentTypeIn, componentTypeOut );
+    if( !filter ) filter = ITKToolsNaryImageOperator< 2, short, int >::New( dim, componentTypeIn, componentTypeOut );
+    if( !filter ) filter = ITKToolsNaryImageOperator< 2, short, unsigned int >::New( dim, componentTypeIn, componentTypeOut );
+    if( !filter ) filter = ITKToolsNaryImageOperator< 2, short, long >::New( dim, componentTypeIn, componentTypeOut );
+    if( !filter ) filter = ITKToolsNaryImageOperator< 2, short, unsigned long >::New( dim, componentTypeIn, componentTypeOut );
+    if( !filter ) filter = ITKToolsNaryImageOperator< 2, short, float >::New( dim, componentTypeIn, componentTypeOut );
+    if( !filter ) filter = ITKToolsNaryImageOperator< 2, short, double >::New( dim, componentTypeIn, componentTypeOut );
+    if( !filter ) filter = ITKToolsNaryImageOperator< 2, unsigned short, char >::New( dim, componentTypeIn, componentTypeOut );
+    if( !filter ) filter = ITKToolsNaryImageOperator< 2, unsigned short, unsigned char >::New( dim, componentTypeIn, componentTypeOut );
+    if( !filter ) filter = ITKToolsNaryImageOperator< 2, unsigned short, short >::New( dim, componentTypeIn, componentTypeOut );
+    if( !filter ) filter = ITKToolsNaryImageOperator< 2, unsigned short, unsigned short >::New( dim, componentTypeIn, componentTypeOut );
+    if( !filter ) filter = ITKToolsNaryImageOperator< 2, unsigned short, int >::New( dim, componentTypeIn, componentTypeOut );
+    if( !filter ) filter = ITKToolsNaryImageOperator< 2, unsigned short, unsigned int >::New( dim, componentTypeIn, componentTypeOut );
+    if( !filter ) filter = ITKToolsNaryImageOperator< 2, unsigned short, long >::New( dim, componentTypeIn, componentTypeOut );
+    if( !filter ) filter = ITKToolsNaryImageOperator< 2, unsigned short, unsigned long >::New( dim, componentTypeIn, componentTypeOut );
+    if( !filter ) filter = ITKToolsNaryImageOperator< 2, unsigned short, float >::New( dim, componentTypeIn, componentTypeOut );
+    if( !filter ) filter = ITKToolsNaryImageOperator< 2, unsigned short, double >::New( dim, componentTypeIn, componentTypeOut );
+    if( !filter ) filter = ITKToolsNaryImageOperator< 2, float, float >::New( dim, componentTypeIn, componentTypeOut );
+    if( !filter ) filter = ITKToolsNaryImageOperator< 2, float, double >::New( dim, componentTypeIn, componentTypeOut );
 
 #ifdef ITKTOOLS_3D_SUPPORT
     if( !filter ) filter = ITKToolsNaryImageOperator< 3, long, char >::New( dim, componentTypeIn, componentTypeOut );
@@ -184,6 +244,48 @@ int main( int argc, char **argv )
     if( !filter ) filter = ITKToolsNaryImageOperator< 3, long, unsigned long >::New( dim, componentTypeIn, componentTypeOut );
     if( !filter ) filter = ITKToolsNaryImageOperator< 3, double, float >::New( dim, componentTypeIn, componentTypeOut );
     if( !filter ) filter = ITKToolsNaryImageOperator< 3, double, double >::New( dim, componentTypeIn, componentTypeOut );
+    if( !filter ) filter = ITKToolsNaryImageOperator< 3, char, char >::New( dim, componentTypeIn, componentTypeOut );
+    if( !filter ) filter = ITKToolsNaryImageOperator< 3, char, unsigned char >::New( dim, componentTypeIn, componentTypeOut );
+    if( !filter ) filter = ITKToolsNaryImageOperator< 3, char, short >::New( dim, componentTypeIn, componentTypeOut );
+    if( !filter ) filter = ITKToolsNaryImageOperator< 3, char, unsigned short >::New( dim, componentTypeIn, componentTypeOut );
+    if( !filter ) filter = ITKToolsNaryImageOperator< 3, char, int >::New( dim, componentTypeIn, componentTypeOut );
+    if( !filter ) filter = ITKToolsNaryImageOperator< 3, char, unsigned int >::New( dim, componentTypeIn, componentTypeOut );
+    if( !filter ) filter = ITKToolsNaryImageOperator< 3, char, long >::New( dim, componentTypeIn, componentTypeOut );
+    if( !filter ) filter = ITKToolsNaryImageOperator< 3, char, unsigned long >::New( dim, componentTypeIn, componentTypeOut );
+    if( !filter ) filter = ITKToolsNaryImageOperator< 3, char, float >::New( dim, componentTypeIn, componentTypeOut );
+    if( !filter ) filter = ITKToolsNaryImageOperator< 3, char, double >::New( dim, componentTypeIn, componentTypeOut );
+    if( !filter ) filter = ITKToolsNaryImageOperator< 3, unsigned char, char >::New( dim, componentTypeIn, componentTypeOut );
+    if( !filter ) filter = ITKToolsNaryImageOperator< 3, unsigned char, unsigned char >::New( dim, componentTypeIn, componentTypeOut );
+    if( !filter ) filter = ITKToolsNaryImageOperator< 3, unsigned char, short >::New( dim, componentTypeIn, componentTypeOut );
+    if( !filter ) filter = ITKToolsNaryImageOperator< 3, unsigned char, unsigned short >::New( dim, componentTypeIn, componentTypeOut );
+    if( !filter ) filter = ITKToolsNaryImageOperator< 3, unsigned char, int >::New( dim, componentTypeIn, componentTypeOut );
+    if( !filter ) filter = ITKToolsNaryImageOperator< 3, unsigned char, unsigned int >::New( dim, componentTypeIn, componentTypeOut );
+    if( !filter ) filter = ITKToolsNaryImageOperator< 3, unsigned char, long >::New( dim, componentTypeIn, componentTypeOut );
+    if( !filter ) filter = ITKToolsNaryImageOperator< 3, unsigned char, unsigned long >::New( dim, componentTypeIn, componentTypeOut );
+    if( !filter ) filter = ITKToolsNaryImageOperator< 3, unsigned char, float >::New( dim, componentTypeIn, componentTypeOut );
+    if( !filter ) filter = ITKToolsNaryImageOperator< 3, unsigned char, double >::New( dim, componentTypeIn, componentTypeOut );
+    if( !filter ) filter = ITKToolsNaryImageOperator< 3, short, char >::New( dim, componentTypeIn, componentTypeOut );
+    if( !filter ) filter = ITKToolsNaryImageOperator< 3, short, unsigned char >::New( dim, componentTypeIn, componentTypeOut );
+    if( !filter ) filter = ITKToolsNaryImageOperator< 3, short, short >::New( dim, componentTypeIn, componentTypeOut );
+    if( !filter ) filter = ITKToolsNaryImageOperator< 3, short, unsigned short >::New( dim, componentTypeIn, componentTypeOut );
+    if( !filter ) filter = ITKToolsNaryImageOperator< 3, short, int >::New( dim, componentTypeIn, componentTypeOut );
+    if( !filter ) filter = ITKToolsNaryImageOperator< 3, short, unsigned int >::New( dim, componentTypeIn, componentTypeOut );
+    if( !filter ) filter = ITKToolsNaryImageOperator< 3, short, long >::New( dim, componentTypeIn, componentTypeOut );
+    if( !filter ) filter = ITKToolsNaryImageOperator< 3, short, unsigned long >::New( dim, componentTypeIn, componentTypeOut );
+    if( !filter ) filter = ITKToolsNaryImageOperator< 3, short, float >::New( dim, componentTypeIn, componentTypeOut );
+    if( !filter ) filter = ITKToolsNaryImageOperator< 3, short, double >::New( dim, componentTypeIn, componentTypeOut );
+    if( !filter ) filter = ITKToolsNaryImageOperator< 3, unsigned short, char >::New( dim, componentTypeIn, componentTypeOut );
+    if( !filter ) filter = ITKToolsNaryImageOperator< 3, unsigned short, unsigned char >::New( dim, componentTypeIn, componentTypeOut );
+    if( !filter ) filter = ITKToolsNaryImageOperator< 3, unsigned short, short >::New( dim, componentTypeIn, componentTypeOut );
+    if( !filter ) filter = ITKToolsNaryImageOperator< 3, unsigned short, unsigned short >::New( dim, componentTypeIn, componentTypeOut );
+    if( !filter ) filter = ITKToolsNaryImageOperator< 3, unsigned short, int >::New( dim, componentTypeIn, componentTypeOut );
+    if( !filter ) filter = ITKToolsNaryImageOperator< 3, unsigned short, unsigned int >::New( dim, componentTypeIn, componentTypeOut );
+    if( !filter ) filter = ITKToolsNaryImageOperator< 3, unsigned short, long >::New( dim, componentTypeIn, componentTypeOut );
+    if( !filter ) filter = ITKToolsNaryImageOperator< 3, unsigned short, unsigned long >::New( dim, componentTypeIn, componentTypeOut );
+    if( !filter ) filter = ITKToolsNaryImageOperator< 3, unsigned short, float >::New( dim, componentTypeIn, componentTypeOut );
+    if( !filter ) filter = ITKToolsNaryImageOperator< 3, unsigned short, double >::New( dim, componentTypeIn, componentTypeOut );
+    if( !filter ) filter = ITKToolsNaryImageOperator< 3, float, float >::New( dim, componentTypeIn, componentTypeOut );
+    if( !filter ) filter = ITKToolsNaryImageOperator< 3, float, double >::New( dim, componentTypeIn, componentTypeOut );
 #endif
     /** Check if filter was instantiated. */
     bool supported = itktools::IsFilterSupportedCheck( filter, dim, componentTypeIn, componentTypeOut );
@@ -196,6 +298,7 @@ int main( int argc, char **argv )
     filter->m_UseCompression = useCompression;
     filter->m_NumberOfStreams = numberOfStreams;
     filter->m_Arg = argument;
+    filter->m_UseRunningReduction = useRunningReduction;
 
     filter->Run();
 
@@ -21,10 +21,14 @@
 #include "itkImage.h"
 #include "itkNaryFunctors.h"
 #include "itkNaryFunctorImageFilter.h"
+#include "itkUnaryFunctorImageFilter.h"
 #include "itkImageFileReader.h"
 #include "itkImageFileWriter.h"
+#include "itkImageRegionIterator.h"
+#include "itkMultiThreaderBase.h"
 
 #include "NaryFilterFactory.h"
+#include "ITKToolsImageReading.h"
 
 #include <vector>
 #include <itksys/SystemTools.hxx>
@@ -47,6 +51,7 @@ public:
     this->m_UseCompression = false;
     this->m_NumberOfStreams = 0;
     this->m_Arg = "";
+    this->m_UseRunningReduction = false;
   };
   /** Destructor. */
   ~ITKToolsNaryImageOperatorBase(){};
@@ -58,6 +63,7 @@ public:
   bool              m_UseCompression;
   unsigned int      m_NumberOfStreams;
   std::string       m_Arg;
+  bool              m_UseRunningReduction;
 
 }; // end class ITKToolsNaryImageOperatorBase
 
@@ -79,14 +85,52 @@ public:
   ITKToolsNaryImageOperator(){};
   ~ITKToolsNaryImageOperator(){};
 
+  /** Typedefs. */
+  typedef itk::Image< TInputComponentType, VDimension >   InputImageType;
+  typedef itk::Image< TOutputComponentType, VDimension >  OutputImageType;
+  typedef itk::Image< double, VDimension >                AccumulatorImageType;
+  typedef itk::ImageFileReader< InputImageType >          ReaderType;
+  typedef itk::ImageFileWriter< OutputImageType >         WriterType;
+  typedef typename InputImageType::RegionType             RegionType;
+
   /** Run function. */
   void Run( void )
   {
-    /** Typedefs. */
-    typedef itk::Image< TInputComponentType, VDimension >   InputImageType;
-    typedef itk::Image< TOutputComponentType, VDimension >  OutputImageType;
-    typedef itk::ImageFileReader< InputImageType >          ReaderType;
-    typedef itk::ImageFileWriter< OutputImageType >         WriterType;
+    /** Associative operators can be reduced one input at a time. */
+    if( this->m_UseRunningReduction )
+    {
+      const std::string & name = this->m_NaryOperatorName;
+      if( name == "ADDITION" )
+      {
+        this->template RunningReduction< itk::Functor::NaryRunningADDITION< TInputComponentType > >();
+      }
+      else if( name == "MEAN" )
+      {
+        this->template RunningReduction< itk::Functor::NaryRunningMEAN< TInputComponentType > >();
+      }
+      else if( name == "TIMES" )
+      {
+        this->template RunningReduction< itk::Functor::NaryRunningTIMES< TInputComponentType > >();
+      }
+      else if( name == "MAXIMUM" )
+      {
+        this->template RunningReduction< itk::Functor::NaryRunningMAXIMUM< TInputComponentType > >();
+      }
+      else if( name == "MINIMUM" )
+      {
+        this->template RunningReduction< itk::Functor::NaryRunningMINIMUM< TInputComponentType > >();
+      }
+      else if( name == "NARYMAGNITUDE" )
+      {
+        this->template RunningReduction< itk::Functor::NaryRunningNARYMAGNITUDE< TInputComponentType > >();
+      }
+      else
+      {
+        itkGenericExceptionMacro( << "The operator " << name
+          << " does not support a running reduction." );
+      }
+      return;
+    }
 
     /** Read the input images. */
     std::vector<typename ReaderType::Pointer> readers( this->m_InputFileNames.size() );
@@ -107,12 +151,17 @@ public:
     naryOperatorMap["MINIMUM"] = MINIMUM;
     naryOperatorMap["ABSOLUTEDIFFERENCE"] = ABSOLUTEDIFFERENCE;
     naryOperatorMap["NARYMAGNITUDE"] = NARYMAGNITUDE;
+    naryOperatorMap["MEDIAN"] = MEDIAN;
+    naryOperatorMap["PERCENTILE"] = PERCENTILE;
+    naryOperatorMap["STD"] = STD;
+    naryOperatorMap["MODE"] = MODE;
 
     /** Set up the binaryFilter. */
     NaryFilterFactory< InputImageType, OutputImageType > naryFilterFactory;
     typedef itk::InPlaceImageFilter< InputImageType, OutputImageType > BaseFilterType;
     typename BaseFilterType::Pointer naryFilter
-      = naryFilterFactory.GetFilter( naryOperatorMap[ this->m_NaryOperatorName ] );
+      = naryFilterFactory.GetFilter( naryOperatorMap[ this->m_NaryOperatorName ],
+      atof( this->m_Arg.c_str() ) );
 
     //InstantiateNaryFilterNoArg( POWER );
     //InstantiateNaryFilterNoArg( SQUAREDDIFFERENCE );
@@ -139,6 +188,95 @@ public:
 
   } // end Run()
 
+
+  /** Reduce the inputs one at a time into a single accumulator image,
+   * while the next input is read in a background thread. This way only
+   * two inputs and the accumulator are in memory at any time. The
+   * accumulator is converted to the output type stream by stream while
+   * it is written, so then only a part of the output is in memory.
+   */
+  template< class TRunningFunctor >
+  void RunningReduction( void )
+  {
+    const unsigned int numberOfInputs = this->m_InputFileNames.size();
+
+    /** Start reading the first input. */
+    std::future< typename InputImageType::Pointer > nextInput
+      = itktools::ReadImageAsynchronously< InputImageType >( this->m_InputFileNames[ 0 ] );
+
+    typename AccumulatorImageType::Pointer accumulator;
+    for( unsigned int i = 0; i < numberOfInputs; ++i )
+    {
+      /** Wait for the current input, and prefetch the next one. */
+      typename InputImageType::Pointer input = nextInput.get();
+      if( i + 1 < numberOfInputs )
+      {
+        nextInput = itktools::ReadImageAsynchronously< InputImageType >(
+          this->m_InputFileNames[ i + 1 ] );
+      }
+
+      if( i == 0 )
+      {
+        accumulator = AccumulatorImageType::New();
+        accumulator->CopyInformation( input );
+        accumulator->SetRegions( input->GetLargestPossibleRegion() );
+        accumulator->Allocate();
+      }
+      else if( input->GetLargestPossibleRegion() != accumulator->GetLargestPossibleRegion()
+        || !input->IsSameImageGeometryAs( accumulator ) )
+      {
+        itkGenericExceptionMacro( << "The size, spacing, origin or direction of input "
+          << this->m_InputFileNames[ i ] << " differs from the first input." );
+      }
+
+      /** Fold the input into the accumulator. */
+      const bool initialize = ( i == 0 );
+      typename itk::MultiThreaderBase::Pointer threader = itk::MultiThreaderBase::New();
+      threader->ParallelizeImageRegion< VDimension >(
+        accumulator->GetLargestPossibleRegion(),
+        [&accumulator, &input, initialize]( const RegionType & region )
+        {
+          itk::ImageRegionConstIterator< InputImageType > itIn( input, region );
+          itk::ImageRegionIterator< AccumulatorImageType > itAcc( accumulator, region );
+          if( initialize )
+          {
+            for( ; !itIn.IsAtEnd(); ++itIn, ++itAcc )
+            {
+              itAcc.Set( TRunningFunctor::Initialize( itIn.Get() ) );
+            }
+          }
+          else
+          {
+            for( ; !itIn.IsAtEnd(); ++itIn, ++itAcc )
+            {
+              itAcc.Set( TRunningFunctor::Accumulate( itAcc.Get(), itIn.Get() ) );
+            }
+          }
+        },
+        nullptr );
+    }
+
+    /** Convert the accumulator to the output, clamped to its range. */
+    typedef itk::Functor::NaryRunningFinalize<
+      TRunningFunctor, TOutputComponentType >                 FinalizeFunctorType;
+    typedef itk::UnaryFunctorImageFilter< AccumulatorImageType,
+      OutputImageType, FinalizeFunctorType >                  FinalizeFilterType;
+    FinalizeFunctorType finalizeFunctor;
+    finalizeFunctor.SetNumberOfInputs( numberOfInputs );
+    typename FinalizeFilterType::Pointer finalizer = FinalizeFilterType::New();
+    finalizer->SetFunctor( finalizeFunctor );
+    finalizer->SetInput( accumulator );
+
+    /** Write the image to disk */
+    typename WriterType::Pointer writer = WriterType::New();
+    writer->SetFileName( this->m_OutputFileName.c_str() );
+    writer->SetInput( finalizer->GetOutput() );
+    writer->SetUseCompression( this->m_UseCompression );
+    writer->SetNumberOfStreamDivisions( this->m_NumberOfStreams );
+    writer->Update();
+
+  } // end RunningReduction()
+
 }; // end class ITKToolsNaryImageOperator
 
 
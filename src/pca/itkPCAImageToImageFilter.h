@@ -24,6 +24,7 @@
 #include "itkImageToImageFilter.h"
 #include "itkImageRegionIterator.h"
 #include "itkImageRegionConstIterator.h"
+#include "itkMersenneTwisterRandomVariateGenerator.h"
 
 
 namespace itk
@@ -43,6 +44,35 @@ namespace itk
  * to perform some matrix manipulations. This filter gives the same output
  * as the Matlab function princomp.
  *
+ * The mean and covariance matrix are accumulated in one multi-threaded pass
+ * over the input images, and the principal components are computed in a
+ * second multi-threaded pass, directly into the outputs. The centered data
+ * matrix of size number of pixels x number of feature images is never
+ * formed. Both passes stream. The first pass requests the inputs from the
+ * pipeline in NumberOfStreamDivisions pieces, one after the other. The
+ * second pass only requests the region of the outputs that is requested,
+ * so a writer can stream the principal components. The statistics are
+ * computed again only when the filter or its inputs are modified, and not
+ * for every piece of the outputs.
+ *
+ * Optionally, a mask restricts the analysis to the pixels inside it. The
+ * outputs are 0 outside the mask.
+ *
+ * The sign of each eigen vector is chosen such that its element of largest
+ * magnitude is positive, whichever eigen analysis is used. Before, the sign
+ * was that of vnl_symmetric_eigensystem, so principal components may be
+ * negated compared to those of older versions.
+ *
+ * When only a few principal components are required, by default only those
+ * are computed, with a truncated eigen analysis: a block subspace iteration
+ * with a random start and Rayleigh-Ritz projections, iterated until the
+ * residuals of the required eigen pairs are negligible. It is used when
+ * the block, the required number plus 10, is at most half the number of
+ * feature images; otherwise the full eigen system is solved. The eigen
+ * values and vectors are then only those of the required components, and
+ * the normalised eigen values are normalised with the Frobenius norm of the
+ * covariance matrix, which is the norm of all eigen values.
+ *
  * \ingroup ??
  */
 
@@ -71,6 +101,7 @@ public:
   typedef typename InputImageType::Pointer          InputImagePointer;
   typedef typename InputImageType::ConstPointer     InputImageConstPointer;
   typedef typename InputImageType::PixelType        InputImagePixelType;
+  typedef typename InputImageType::RegionType       InputImageRegionType;
   typedef TOutputImage                              OutputImageType;
   typedef typename OutputImageType::PixelType       OutputImagePixelType;
   typedef typename OutputImageType::Pointer         OutputImagePointer;
@@ -81,12 +112,20 @@ public:
   /** Input Image dimension. */
   itkStaticConstMacro( InputImageDimension, unsigned int, TInputImage::ImageDimension );
 
+  /** Typedefs for mask support. */
+  typedef unsigned char                               MaskPixelType;
+  typedef Image< MaskPixelType, InputImageDimension > MaskImageType;
+  typedef typename MaskImageType::Pointer             MaskImagePointer;
+
   /** Type definition for a vnl double matrix. */
   typedef vnl_matrix<double> MatrixOfDoubleType;
 
   /** Type definition for a vnl double vector. */
   typedef vnl_vector<double> VectorOfDoubleType;
 
+  /** Type definition for the random generator of the truncated eigen analysis. */
+  typedef Statistics::MersenneTwisterRandomVariateGenerator GeneratorType;
+
   /** Set/Get the number of feature images in the input. */
   virtual void SetNumberOfFeatureImages( unsigned int n );
   itkGetConstMacro( NumberOfFeatureImages, unsigned int );
@@ -98,6 +137,15 @@ public:
   virtual void SetNumberOfPrincipalComponentsRequired( unsigned int n );
   itkGetConstMacro( NumberOfPrincipalComponentsRequired, unsigned int );
 
+  /** Set/Get whether to compute only the required principal components,
+   * if that is cheaper than the full eigen analysis. If the truncated
+   * eigen analysis does not converge, the full one is performed.
+   * Default true.
+   */
+  itkSetMacro( TruncatedEigenAnalysis, bool );
+  itkGetConstMacro( TruncatedEigenAnalysis, bool );
+  itkBooleanMacro( TruncatedEigenAnalysis );
+
   /** Get the eigen values. */
   itkGetConstReferenceMacro( EigenValues, VectorOfDoubleType );
 
@@ -107,6 +155,23 @@ public:
   /** Get the eigen values. */
   itkGetConstReferenceMacro( EigenVectors, MatrixOfDoubleType );
 
+  /** Get the mean of the feature images and their covariance matrix. */
+  itkGetConstReferenceMacro( MeanOfFeatureImages, VectorOfDoubleType );
+  itkGetConstReferenceMacro( CovarianceMatrix, MatrixOfDoubleType );
+
+  /** Set/Get the mask, optional. It should be buffered completely, with the
+   * size of the first input.
+   */
+  itkSetObjectMacro( Mask, MaskImageType );
+  itkGetObjectMacro( Mask, MaskImageType );
+
+  /** Set/Get the number of pieces in which the inputs are requested for
+   * the computation of the mean and the covariance matrix. Default 1.
+   */
+  itkSetClampMacro( NumberOfStreamDivisions, unsigned int,
+    1, NumericTraits<unsigned int>::max() );
+  itkGetConstMacro( NumberOfStreamDivisions, unsigned int );
+
 protected:
 
   /** Constructor. */
@@ -118,16 +183,9 @@ protected:
   /** PrintSelf. */
   virtual void PrintSelf( std::ostream& os, Indent indent ) const;
 
-  /** This filter must produce all of the outputs at once, as such it
-   * must override the EnlargeOutputRequestedRegion method to enlarge the
-   * output request region.
-   */
-  virtual void EnlargeOutputRequestedRegion( DataObject * );
-
-  /** This filter requires all the input image at once, as such it
-   * must override the GenerateInputRequestedRegion method. Additionally,
-   * this filter assumes that the input images are at least the size as
-   * the first input image.
+  /** The inputs are requested for the requested region of the outputs.
+   * Additionally, this filter assumes that the input images are at least
+   * the size of the first input image.
    */
   virtual void GenerateInputRequestedRegion( void );
 
@@ -145,22 +203,29 @@ private:
 
   /** Private functions to perform the PCA. */
   virtual void PerformPCA( void );
-  virtual void CalculateMeanOfFeatureImages( void );
-  virtual void CenterFeatureImages( void );
-  virtual void CalculateCovarianceMatrix( void );
+  virtual void CalculateMeanAndCovarianceMatrix( void );
   virtual void PerformEigenAnalysis( void );
+  virtual bool PerformTruncatedEigenAnalysis(
+    const unsigned int numberOfEigenPairs, const unsigned int blockSize );
+  static void OrthonormalizeColumns( MatrixOfDoubleType & matrix, GeneratorType * generator );
+  virtual void ComputePrincipalComponents( void );
+
+  /** Update all inputs for the given region. */
+  virtual void UpdateInputs( const InputImageRegionType & region );
 
   /** Private variables to store results. */
   VectorOfDoubleType    m_MeanOfFeatureImages;
-  MatrixOfDoubleType    m_CenteredFeatureImages;
 
   MatrixOfDoubleType    m_CovarianceMatrix;
   MatrixOfDoubleType    m_EigenVectors;
   VectorOfDoubleType    m_EigenValues;
   VectorOfDoubleType    m_NormalisedEigenValues;
-  MatrixOfDoubleType    m_PrincipalComponents;
 
-  unsigned int          m_NumberOfPixels;
+  MaskImagePointer      m_Mask;
+  bool                  m_TruncatedEigenAnalysis;
+  unsigned int          m_NumberOfStreamDivisions;
+  TimeStamp             m_StatisticsTime;
+  SizeValueType         m_NumberOfPixels;
   unsigned int          m_NumberOfFeatureImages;
   unsigned int          m_NumberOfPrincipalComponentsRequired;
 
@@ -22,7 +22,9 @@
 
 #include "vnl/vnl_math.h"
 #include <vnl/algo/vnl_symmetric_eigensystem.h>
-#include <vnl/vnl_fastops.h>
+
+#include <algorithm>
+#include <cmath>
 
 namespace itk
 {
@@ -36,42 +38,21 @@ namespace itk
     ::PCAImageToImageFilter( void )
   {
     this->m_MeanOfFeatureImages.set_size( 0 );
-    this->m_CenteredFeatureImages.set_size( 0, 0 );
 
     this->m_CovarianceMatrix.set_size( 0, 0 );
     this->m_EigenVectors.set_size( 0, 0 );
     this->m_EigenValues.set_size( 0 );
     this->m_NormalisedEigenValues.set_size( 0 );
-    this->m_PrincipalComponents.set_size( 0, 0 );
 
     this->m_NumberOfPixels = 0;
     this->m_NumberOfFeatureImages = 0;
     this->m_NumberOfPrincipalComponentsRequired = 0;
+    this->m_TruncatedEigenAnalysis = true;
+    this->m_NumberOfStreamDivisions = 1;
 
   } // end Constructor()
 
 
-  /**
-   * ********************* EnlargeOutputRequestedRegion ****************************
-   */
-
-  template< class TInputImage, class TOutputImage >
-    void
-    PCAImageToImageFilter< TInputImage, TOutputImage >
-    ::EnlargeOutputRequestedRegion( DataObject * itkNotUsed(output) )
-  {
-    /** This filter requires the all of the output images to be in the buffer. */
-    for( unsigned int i = 0; i < this->GetNumberOfOutputs(); ++i )
-    {
-      if( this->GetOutput( i ) )
-      {
-        this->GetOutput( i )->SetRequestedRegionToLargestPossibleRegion();
-      }
-    }
-
-  } // end EnlargeOutputRequestedRegion()
-
-
   /**
    * ********************* GenerateInputRequestedRegion ****************************
    */
@@ -81,38 +62,21 @@ namespace itk
     PCAImageToImageFilter< TInputImage, TOutputImage >
     ::GenerateInputRequestedRegion( void )
   {
+    /** Request the requested region of the outputs from all inputs. */
     Superclass::GenerateInputRequestedRegion();
 
     if( this->GetInput( 0 ) )
     {
-      /** Set the requested region of the first input to largest possible region. */
-      InputImagePointer input = const_cast< TInputImage *>( this->GetInput( 0 ) );
-      input->SetRequestedRegionToLargestPossibleRegion();
-      //this->GetInput( 0 )->SetRequestedRegionToLargestPossibleRegion();
-
-      /** Set the requested region of the remaining input to the
-       * largest possible region of the first input.
-       */
+      /** Check that the remaining inputs contain the first one. */
+      const InputImageRegionType largestRegion
+        = this->GetInput( 0 )->GetLargestPossibleRegion();
       for( unsigned int i = 1; i < this->GetNumberOfInputs(); ++i )
       {
-        if( this->GetInput( i ) )
+        if( this->GetInput( i )
+          && !this->GetInput( i )->GetLargestPossibleRegion().IsInside( largestRegion ) )
         {
-          typename TInputImage::RegionType requestedRegion =
-            this->GetInput( 0 )->GetLargestPossibleRegion();
-
-          typename TInputImage::RegionType largestRegion =
-            this->GetInput( i )->GetLargestPossibleRegion();
-
-          if( !largestRegion.IsInside( requestedRegion ) )
-          {
-            itkExceptionMacro( << "LargestPossibleRegion of input " << i
-              << " is not a superset of the LargestPossibleRegion of input 0" );
-          }
-
-          InputImagePointer ptr = const_cast<TInputImage *>( this->GetInput( i ) );
-          ptr->SetRequestedRegion( requestedRegion );
-          //this->GetInput( i )->SetRequestedRegion( requestedRegion );
-
+          itkExceptionMacro( << "LargestPossibleRegion of input " << i
+            << " is not a superset of the LargestPossibleRegion of input 0" );
         }
       }
     }
@@ -204,8 +168,27 @@ namespace itk
     PCAImageToImageFilter< TInputImage, TOutputImage >
     ::GenerateData( void )
   {
-    /** Do the principal component analysis. */
-    this->PerformPCA();
+    /** The principal component analysis needs all pixels, so it is only
+     * performed again when the filter or its inputs have been modified,
+     * and not for every piece of the outputs that is requested.
+     */
+    ModifiedTimeType statisticsMTime = this->GetMTime();
+    for( unsigned int i = 0; i < this->GetNumberOfInputs(); ++i )
+    {
+      statisticsMTime = std::max( statisticsMTime, this->GetInput( i )->GetPipelineMTime() );
+    }
+    if( this->m_Mask )
+    {
+      statisticsMTime = std::max( statisticsMTime, this->m_Mask->GetMTime() );
+    }
+    if( this->m_StatisticsTime.GetMTime() < statisticsMTime )
+    {
+      this->PerformPCA();
+      this->m_StatisticsTime.Modified();
+
+      /** The inputs are now buffered for the last piece of the analysis. */
+      this->UpdateInputs( this->GetOutput( 0 )->GetRequestedRegion() );
+    }
 
     /** Allocate memory for each output. ??Why here? */
     unsigned int numberOfOutputs =
@@ -218,32 +201,8 @@ namespace itk
       output->Allocate();
     }
 
-    /** Create the output images. This is a matter of converting
-     * the vnl_matrix of principal components to images.
-     */
-    for( unsigned int i = 0; i < numberOfOutputs; ++i )
-    {
-      /** Extract one column vector at a time. This is faster
-       * than extracting the column every time, but comes at
-       * the cost of some additional memory use.
-       */
-
-      /** Create iterator. */
-      OutputImageIterator iter( this->GetOutput( i ), this->GetOutput( i )->GetRequestedRegion() );
-      iter.GoToBegin();
-      unsigned int pix = 0;
-
-      /** Fill this output with a principal component. */
-      while ( !iter.IsAtEnd() )
-      {
-        iter.Set( static_cast< OutputImagePixelType >( this->m_PrincipalComponents[ pix ][ i ] ) );
-        ++iter;
-        ++pix;
-      }
-    }
-
-    /** Maybe remove principal components? */
-    //this->m_PrincipalComponents.set_size( 0, 0 );
+    /** Compute the principal components directly into the outputs. */
+    this->ComputePrincipalComponents();
 
   } // end GenerateData()
 
@@ -257,13 +216,8 @@ namespace itk
     PCAImageToImageFilter< TInputImage, TOutputImage >
     ::PerformPCA( void )
   {
-    /** Get the number of pixels. */
-    this->m_NumberOfPixels = this->GetInput( 0 )->GetBufferedRegion().GetNumberOfPixels();
-
     this->CheckNumberOfOutputs();
-    this->CalculateMeanOfFeatureImages();
-    this->CenterFeatureImages();
-    this->CalculateCovarianceMatrix();
+    this->CalculateMeanAndCovarianceMatrix();
     this->PerformEigenAnalysis();
 
   } // end PerformPCA()
@@ -301,152 +255,488 @@ namespace itk
 
 
   /**
-   * ********************* CalculateMeanOfFeatureImages ****************************
+   * ********************* CalculateMeanAndCovarianceMatrix ****************************
+   *
+   * One pass over the inputs, which are requested piece by piece. Each
+   * thread accumulates the count, the mean and the co-moment matrix of its
+   * chunk with Welford's update, which is accurate also when the mean is
+   * large compared to the spread. The chunks are merged with the pairwise
+   * update of Chan et al., in the order of the pieces and chunks and not in
+   * the order in which the threads finish, so that the result is
+   * reproducible for a given number of pieces and work units.
    */
 
   template< class TInputImage, class TOutputImage >
     void
     PCAImageToImageFilter< TInputImage, TOutputImage >
-    ::CalculateMeanOfFeatureImages( void )
+    ::CalculateMeanAndCovarianceMatrix( void )
   {
-    /** Get pointers to the input and setup iterators. */
-    std::vector< InputImageConstPointer >   inputImages( this->m_NumberOfFeatureImages );
-    std::vector< InputImageConstIterator >  iterators( this->m_NumberOfFeatureImages );
+    typedef ImageRegionConstIterator< MaskImageType >   MaskImageConstIterator;
 
-    for( unsigned int i = 0; i < this->m_NumberOfFeatureImages; i++ )
+    /** Get pointers to the inputs and the mask. */
+    const unsigned int n = this->m_NumberOfFeatureImages;
+    const InputImageRegionType region = this->GetInput( 0 )->GetLargestPossibleRegion();
+    std::vector< const InputImageType * > inputImages( n );
+    for( unsigned int i = 0; i < n; ++i )
     {
       inputImages[ i ] = this->GetInput( i );
-
-      iterators[ i ] = InputImageConstIterator(
-        inputImages[ i ], inputImages[ i ]->GetBufferedRegion() );
-      iterators[ i ].GoToBegin();
+    }
+    const MaskImageType * mask = this->m_Mask.GetPointer();
+    if( mask && !mask->GetBufferedRegion().IsInside( region ) )
+    {
+      itkExceptionMacro( << "The mask should be buffered for the region of the first input." );
     }
 
-    /** Calculate for each training image its mean. */
-    this->m_MeanOfFeatureImages.set_size( this->m_NumberOfFeatureImages );
-    this->m_MeanOfFeatureImages.fill( 0.0 );
+    /** The count, the mean and the upper triangle of the co-moment matrix of all pieces. */
+    SizeValueType count = 0;
+    std::vector< double > mean( n, 0.0 );
+    std::vector< double > comoment( n * n, 0.0 );
+    std::vector< double > delta( n );
+
+    /** Request the inputs piece by piece. */
+    const ImageRegionSplitterBase * splitter = this->GetImageRegionSplitter();
+    const unsigned int numberOfPieces
+      = splitter->GetNumberOfSplits( region, this->m_NumberOfStreamDivisions );
+    for( unsigned int piece = 0; piece < numberOfPieces; ++piece )
+    {
+      InputImageRegionType pieceRegion = region;
+      splitter->GetSplit( piece, numberOfPieces, pieceRegion );
+      this->UpdateInputs( pieceRegion );
+
+      /** Split the piece in fixed chunks, a few per work unit for load balancing. */
+      const unsigned int numberOfChunks
+        = splitter->GetNumberOfSplits( pieceRegion, 4 * this->GetNumberOfWorkUnits() );
+      std::vector< InputImageRegionType > chunks( numberOfChunks, pieceRegion );
+      for( unsigned int c = 0; c < numberOfChunks; ++c )
+      {
+        splitter->GetSplit( c, numberOfChunks, chunks[ c ] );
+      }
+
+      /** Per chunk the count, the mean and the upper triangle of the co-moment matrix. */
+      std::vector< SizeValueType > chunkCounts( numberOfChunks, 0 );
+      std::vector< std::vector< double > > chunkMeans( numberOfChunks );
+      std::vector< std::vector< double > > chunkComoments( numberOfChunks );
 
-    for( unsigned int im = 0; im < this->m_NumberOfFeatureImages; ++im )
+      this->GetMultiThreader()->ParallelizeArray( 0, numberOfChunks,
+        [n, &inputImages, mask, &chunks, &chunkCounts, &chunkMeans, &chunkComoments]( SizeValueType c )
+        {
+          const InputImageRegionType & chunk = chunks[ c ];
+          std::vector< InputImageConstIterator > iterators( n );
+          for( unsigned int i = 0; i < n; ++i )
+          {
+            iterators[ i ] = InputImageConstIterator( inputImages[ i ], chunk );
+          }
+          MaskImageConstIterator maskIterator;
+          if( mask ) maskIterator = MaskImageConstIterator( mask, chunk );
+
+          SizeValueType localCount = 0;
+          std::vector< double > localMean( n, 0.0 );
+          std::vector< double > localComoment( n * n, 0.0 );
+          std::vector< double > delta( n );
+
+          const SizeValueType numberOfPixels = chunk.GetNumberOfPixels();
+          for( SizeValueType pix = 0; pix < numberOfPixels; ++pix )
+          {
+            const bool inside = !mask || maskIterator.Get() != 0;
+            if( mask ) ++maskIterator;
+            if( !inside )
+            {
+              for( unsigned int i = 0; i < n; ++i ) ++iterators[ i ];
+              continue;
+            }
+
+            /** mean += delta / k, comoment += delta ( x - mean )^T. */
+            ++localCount;
+            const double weight = 1.0 / static_cast< double >( localCount );
+            for( unsigned int i = 0; i < n; ++i )
+            {
+              delta[ i ] = static_cast< double >( iterators[ i ].Get() ) - localMean[ i ];
+              localMean[ i ] += delta[ i ] * weight;
+              ++iterators[ i ];
+            }
+            const double factor = 1.0 - weight;
+            for( unsigned int i = 0; i < n; ++i )
+            {
+              const double deltaI = delta[ i ] * factor;
+              double * row = &localComoment[ i * n ];
+              for( unsigned int j = i; j < n; ++j )
+              {
+                row[ j ] += deltaI * delta[ j ];
+              }
+            }
+          }
+          chunkCounts[ c ] = localCount;
+          chunkMeans[ c ].swap( localMean );
+          chunkComoments[ c ].swap( localComoment );
+        }, nullptr );
+
+      /** Merge the statistics of the chunks, in the order of the chunks. */
+      for( unsigned int c = 0; c < numberOfChunks; ++c )
+      {
+        const SizeValueType localCount = chunkCounts[ c ];
+        if( localCount == 0 ) continue;
+        const std::vector< double > & localMean = chunkMeans[ c ];
+        const std::vector< double > & localComoment = chunkComoments[ c ];
+
+        const SizeValueType total = count + localCount;
+        const double factor = static_cast< double >( count )
+          * static_cast< double >( localCount ) / static_cast< double >( total );
+        for( unsigned int i = 0; i < n; ++i )
+        {
+          delta[ i ] = localMean[ i ] - mean[ i ];
+        }
+        for( unsigned int i = 0; i < n; ++i )
+        {
+          for( unsigned int j = i; j < n; ++j )
+          {
+            comoment[ i * n + j ] += localComoment[ i * n + j ] + factor * delta[ i ] * delta[ j ];
+          }
+          mean[ i ] += delta[ i ] * static_cast< double >( localCount ) / static_cast< double >( total );
+        }
+        count = total;
+      }
+    } // end for pieces
+
+    if( count == 0 )
+    {
+      itkExceptionMacro( << "There are no pixels inside the mask." );
+    }
+    this->m_NumberOfPixels = count;
+
+    /** Store the mean and the symmetric covariance matrix. */
+    this->m_MeanOfFeatureImages.set_size( n );
+    this->m_CovarianceMatrix.set_size( n, n );
+    const double divisor = count != 1 ? static_cast< double >( count - 1 ) : 0.0;
+    for( unsigned int i = 0; i < n; ++i )
     {
-      for( unsigned int pix = 0; pix < this->m_NumberOfPixels; pix++ )
+      this->m_MeanOfFeatureImages[ i ] = mean[ i ];
+      for( unsigned int j = i; j < n; ++j )
       {
-        this->m_MeanOfFeatureImages[ im ] += iterators[ im ].Get();
-        ++iterators[ im ];
+        const double covariance = divisor > 0.0 ? comoment[ i * n + j ] / divisor : 0.0;
+        this->m_CovarianceMatrix[ i ][ j ] = covariance;
+        this->m_CovarianceMatrix[ j ][ i ] = covariance;
       }
     }
-    this->m_MeanOfFeatureImages /= this->m_NumberOfPixels;
 
-  } // end CalculateMeanOfFeatureImages()
+  } // end CalculateMeanAndCovarianceMatrix()
 
 
   /**
-   * ********************* CenterFeatureImages ****************************
+   * ********************* PerformEigenAnalysis ****************************
    */
 
   template< class TInputImage, class TOutputImage >
     void
     PCAImageToImageFilter< TInputImage, TOutputImage >
-    ::CenterFeatureImages( void )
+    ::PerformEigenAnalysis( void )
   {
-    /** Get pointers to the input and setup iterators. */
-    std::vector< InputImageConstIterator >  iterators( this->m_NumberOfFeatureImages );
+    /** Only compute the required eigen pairs, if that is cheaper. */
+    const unsigned int numberOfEigenPairs = this->GetNumberOfOutputs();
+    const unsigned int blockSize = std::min(
+      this->m_NumberOfFeatureImages, numberOfEigenPairs + 10 );
+    if( this->m_TruncatedEigenAnalysis && 2 * blockSize <= this->m_NumberOfFeatureImages
+      && this->PerformTruncatedEigenAnalysis( numberOfEigenPairs, blockSize ) )
+    {
+      /** The norm of all eigen values is the Frobenius norm. */
+      const double norm = this->m_CovarianceMatrix.frobenius_norm();
+      this->m_NormalisedEigenValues = this->m_EigenValues;
+      if( norm > 0.0 ) this->m_NormalisedEigenValues /= norm;
+    }
+    else
+    {
+      /** Perform the full eigen analysis. */
+      vnl_symmetric_eigensystem< double > eigenSystem( this->m_CovarianceMatrix );
+
+      /** Get the eigen vectors. */
+      this->m_EigenVectors = eigenSystem.V;
+      this->m_EigenVectors.fliplr();
+
+      /** Get the eigen values. */
+      this->m_EigenValues = (eigenSystem.D).diagonal();
+      this->m_EigenValues.flip();
 
-    for( unsigned int i = 0; i < this->m_NumberOfFeatureImages; i++ )
+      /** Also get a normalised version. */
+      this->m_NormalisedEigenValues = this->m_EigenValues;
+      this->m_NormalisedEigenValues.normalize();
+    }
+
+    /** The sign of an eigen vector is arbitrary, and differs between the
+     * truncated and the full eigen analysis. Make the largest element
+     * of each eigen vector positive, so that both give the same result.
+     */
+    for( unsigned int j = 0; j < this->m_EigenVectors.cols(); ++j )
     {
-      iterators[ i ] = InputImageConstIterator(
-        this->GetInput( i ), this->GetInput( i )->GetBufferedRegion() );
-      iterators[ i ].GoToBegin();
+      unsigned int largest = 0;
+      for( unsigned int i = 1; i < this->m_EigenVectors.rows(); ++i )
+      {
+        if( std::abs( this->m_EigenVectors[ i ][ j ] )
+          > std::abs( this->m_EigenVectors[ largest ][ j ] ) )
+        {
+          largest = i;
+        }
+      }
+      if( this->m_EigenVectors[ largest ][ j ] < 0.0 )
+      {
+        this->m_EigenVectors.scale_column( j, -1.0 );
+      }
     }
 
-    /** Set the proper size of the centered training images. */
-    this->m_CenteredFeatureImages.set_size(
-      this->m_NumberOfPixels, this->m_NumberOfFeatureImages );
+  } // end PerformEigenAnalysis()
 
-    /** Center the training images by subtracting the mean. */
-    for( unsigned int i = 0; i < this->m_NumberOfFeatureImages; ++i )
+
+  /**
+   * ********************* PerformTruncatedEigenAnalysis ****************************
+   *
+   * Block subspace iteration: Q = orth( C Q ), starting from a random block.
+   * In each iteration the Ritz pairs are computed from the small eigen
+   * problem Q^T C Q, and the iteration stops when the residuals
+   * || C v - lambda v || of the largest numberOfEigenPairs Ritz pairs are
+   * negligible compared to the norm of C. The extra vectors of the block
+   * speed up the convergence of the required pairs.
+   *
+   * An iteration costs about 2 n^2 blockSize flops, and the full eigen
+   * analysis about 9 n^3, so the number of iterations is limited to
+   * 4 n / blockSize, which keeps the cost of a failed attempt below that of
+   * the full eigen analysis. Returns false if the iteration did not
+   * converge; the eigen pairs are then not set.
+   */
+
+  template< class TInputImage, class TOutputImage >
+    bool
+    PCAImageToImageFilter< TInputImage, TOutputImage >
+    ::PerformTruncatedEigenAnalysis(
+      const unsigned int numberOfEigenPairs, const unsigned int blockSize )
+  {
+    const MatrixOfDoubleType & covariance = this->m_CovarianceMatrix;
+    const unsigned int n = covariance.rows();
+    const double tolerance = 1e-10 * covariance.frobenius_norm();
+    const unsigned int maximumNumberOfIterations = 4 * n / blockSize;
+
+    /** A random start, reproducible. */
+    GeneratorType::Pointer generator = GeneratorType::New();
+    generator->SetSeed( 0 );
+    MatrixOfDoubleType basis( n, blockSize );
+    for( unsigned int i = 0; i < n; ++i )
     {
-      for( unsigned int pix = 0; pix < this->m_NumberOfPixels; pix++ )
+      for( unsigned int j = 0; j < blockSize; ++j )
       {
+        basis[ i ][ j ] = generator->GetNormalVariate();
+      }
+    }
+    OrthonormalizeColumns( basis, generator );
 
-        this->m_CenteredFeatureImages[ pix ][ i ] =
-          (iterators[ i ]).Get() - this->m_MeanOfFeatureImages[ i ];
-        ++iterators[ i ];
+    MatrixOfDoubleType ritzVectors;
+    VectorOfDoubleType ritzValues;
+    bool converged = false;
+    for( unsigned int iteration = 0; iteration < maximumNumberOfIterations && !converged; ++iteration )
+    {
+      /** Rayleigh-Ritz, the Ritz values in ascending order. */
+      const MatrixOfDoubleType image = covariance * basis;
+      MatrixOfDoubleType projection = basis.transpose() * image;
+      projection = ( projection + projection.transpose() ) * 0.5;
+      vnl_symmetric_eigensystem< double > eigenSystem( projection );
+      ritzVectors = basis * eigenSystem.V;
+      ritzValues = eigenSystem.D.diagonal();
+      const MatrixOfDoubleType ritzImage = image * eigenSystem.V;
+
+      /** Check the residuals of the required pairs, the last columns. */
+      converged = true;
+      for( unsigned int i = 0; i < numberOfEigenPairs && converged; ++i )
+      {
+        const unsigned int column = blockSize - 1 - i;
+        const VectorOfDoubleType residual = ritzImage.get_column( column )
+          - ritzValues[ column ] * ritzVectors.get_column( column );
+        converged = residual.two_norm() <= tolerance;
       }
+
+      /** The next basis spans C Q, with the largest Ritz vectors first. */
+      if( !converged )
+      {
+        for( unsigned int j = 0; j < blockSize; ++j )
+        {
+          basis.set_column( j, ritzImage.get_column( blockSize - 1 - j ) );
+        }
+        OrthonormalizeColumns( basis, generator );
+      }
+    }
+    if( !converged )
+    {
+      itkDebugMacro( << "The truncated eigen analysis did not converge in "
+        << maximumNumberOfIterations << " iterations, performing the full one." );
+      return false;
     }
 
-    /** TODO: Try to remove the input images, for memory efficiency.
-     * However, this also depends on other references to the input.
-     * We could try an InPlaceImageFilter.
-     */
+    /** Store the required pairs, in descending order. */
+    this->m_EigenVectors.set_size( n, numberOfEigenPairs );
+    this->m_EigenValues.set_size( numberOfEigenPairs );
+    for( unsigned int i = 0; i < numberOfEigenPairs; ++i )
+    {
+      const unsigned int column = blockSize - 1 - i;
+      this->m_EigenVectors.set_column( i, ritzVectors.get_column( column ) );
+      this->m_EigenValues[ i ] = ritzValues[ column ];
+    }
+
+    return true;
 
-  } // end CenterFeatureImages()
+  } // end PerformTruncatedEigenAnalysis()
 
 
   /**
-   * ********************* CalculateCovarianceMatrix ****************************
+   * ********************* OrthonormalizeColumns ****************************
+   *
+   * Modified Gram-Schmidt, twice for accuracy. A column that vanishes,
+   * because C is rank deficient, is replaced by a random vector.
    */
 
   template< class TInputImage, class TOutputImage >
     void
     PCAImageToImageFilter< TInputImage, TOutputImage >
-    ::CalculateCovarianceMatrix( void )
+    ::OrthonormalizeColumns( MatrixOfDoubleType & matrix, GeneratorType * generator )
   {
-    /** Calculate the inner product of the centered training data.
-     * The slow and memory consuming alternative is:
-     * this->m_CovarianceMatrix =
-     *   this->m_CenteredTrainingImages.transpose() *
-     *   this->m_CenteredTrainingImages;
-     * The vnl function AtA is fast and memory efficient.
-     */
-    vnl_fastops::AtA( this->m_CovarianceMatrix, this->m_CenteredFeatureImages );
-
-    /** Divide. */
-    if( this->m_NumberOfPixels != 1 )
-    {
-      this->m_CovarianceMatrix /= ( this->m_NumberOfPixels - 1 );
-    }
-    else
+    const unsigned int rows = matrix.rows();
+    for( unsigned int j = 0; j < matrix.cols(); ++j )
     {
-      this->m_CovarianceMatrix.fill( 0.0 );
+      VectorOfDoubleType column = matrix.get_column( j );
+      double originalNorm = column.two_norm();
+      for( unsigned int attempt = 0; ; ++attempt )
+      {
+        for( unsigned int pass = 0; pass < 2; ++pass )
+        {
+          for( unsigned int k = 0; k < j; ++k )
+          {
+            const VectorOfDoubleType previous = matrix.get_column( k );
+            column -= dot_product( previous, column ) * previous;
+          }
+        }
+        const double norm = column.two_norm();
+        if( norm > 1e-8 * originalNorm || attempt > 10 )
+        {
+          matrix.set_column( j, column / norm );
+          break;
+        }
+        for( unsigned int i = 0; i < rows; ++i )
+        {
+          column[ i ] = generator->GetNormalVariate();
+        }
+        originalNorm = column.two_norm();
+      }
     }
 
-  } // end CalculateCovarianceMatrix()
+  } // end OrthonormalizeColumns()
 
 
   /**
-   * ********************* PerformEigenAnalysis ****************************
+   * ********************* ComputePrincipalComponents ****************************
+   *
+   * The principal components are the centered feature vectors multiplied
+   * with the eigen vectors. They are computed pixel by pixel, in parallel,
+   * and only for the outputs and their requested region.
    */
 
   template< class TInputImage, class TOutputImage >
     void
     PCAImageToImageFilter< TInputImage, TOutputImage >
-    ::PerformEigenAnalysis( void )
+    ::ComputePrincipalComponents( void )
   {
-    /** Perform the eigen analysis. */
-    vnl_symmetric_eigensystem< double > eigenSystem( this->m_CovarianceMatrix );
+    typedef ImageRegionConstIterator< MaskImageType >   MaskImageConstIterator;
+
+    /** Get pointers to the inputs, outputs and the mask. */
+    const unsigned int n = this->m_NumberOfFeatureImages;
+    const unsigned int numberOfOutputs = this->GetNumberOfOutputs();
+    const InputImageRegionType region = this->GetOutput( 0 )->GetRequestedRegion();
+    std::vector< const InputImageType * > inputImages( n );
+    for( unsigned int i = 0; i < n; ++i )
+    {
+      inputImages[ i ] = this->GetInput( i );
+    }
+    std::vector< OutputImageType * > outputImages( numberOfOutputs );
+    for( unsigned int i = 0; i < numberOfOutputs; ++i )
+    {
+      outputImages[ i ] = this->GetOutput( i );
+    }
+    const MaskImageType * mask = this->m_Mask.GetPointer();
 
-    /** Get the eigen vectors. */
-    this->m_EigenVectors = eigenSystem.V;
-    this->m_EigenVectors.fliplr();
+    /** The mean, and the eigen vectors of the outputs, contiguously. */
+    const std::vector< double > mean(
+      this->m_MeanOfFeatureImages.begin(), this->m_MeanOfFeatureImages.end() );
+    std::vector< double > eigenVectors( numberOfOutputs * n );
+    for( unsigned int i = 0; i < numberOfOutputs; ++i )
+    {
+      for( unsigned int k = 0; k < n; ++k )
+      {
+        eigenVectors[ i * n + k ] = this->m_EigenVectors[ k ][ i ];
+      }
+    }
 
-    /** Get the eigen values. */
-    this->m_EigenValues = (eigenSystem.D).diagonal();
-    this->m_EigenValues.flip();
+    this->GetMultiThreader()->template ParallelizeImageRegion< InputImageDimension >(
+      region,
+      [n, numberOfOutputs, &inputImages, &outputImages, mask, &mean, &eigenVectors]
+      ( const InputImageRegionType & chunk )
+      {
+        std::vector< InputImageConstIterator > iterators( n );
+        for( unsigned int i = 0; i < n; ++i )
+        {
+          iterators[ i ] = InputImageConstIterator( inputImages[ i ], chunk );
+        }
+        std::vector< OutputImageIterator > outputIterators( numberOfOutputs );
+        for( unsigned int i = 0; i < numberOfOutputs; ++i )
+        {
+          outputIterators[ i ] = OutputImageIterator( outputImages[ i ], chunk );
+        }
+        MaskImageConstIterator maskIterator;
+        if( mask ) maskIterator = MaskImageConstIterator( mask, chunk );
 
-    /** Also get a normalised version. */
-    this->m_NormalisedEigenValues = this->m_EigenValues;
-    this->m_NormalisedEigenValues.normalize();
+        std::vector< double > centered( n );
+        const SizeValueType numberOfPixels = chunk.GetNumberOfPixels();
+        for( SizeValueType pix = 0; pix < numberOfPixels; ++pix )
+        {
+          const bool inside = !mask || maskIterator.Get() != 0;
+          if( mask ) ++maskIterator;
 
-    /** Calculate the principal components.
-     * This is done by multiplying the training data with the eigen vectors.
-     */
-    this->m_PrincipalComponents =
-      this->m_CenteredFeatureImages * this->m_EigenVectors;
+          for( unsigned int k = 0; k < n; ++k )
+          {
+            centered[ k ] = static_cast< double >( iterators[ k ].Get() ) - mean[ k ];
+            ++iterators[ k ];
+          }
+          for( unsigned int i = 0; i < numberOfOutputs; ++i )
+          {
+            double component = 0.0;
+            if( inside )
+            {
+              const double * eigenVector = &eigenVectors[ i * n ];
+              for( unsigned int k = 0; k < n; ++k )
+              {
+                component += centered[ k ] * eigenVector[ k ];
+              }
+            }
+            outputIterators[ i ].Set( static_cast< OutputImagePixelType >( component ) );
+            ++outputIterators[ i ];
+          }
+        }
+      }, nullptr );
 
-    /** The CenteredFeatureImages can now be removed for memory efficiency. */
-    this->m_CenteredFeatureImages.set_size( 0, 0 );
+  } // end ComputePrincipalComponents()
 
-  } // end PerformEigenAnalysis()
+
+  /**
+   * ********************* UpdateInputs ****************************
+   */
+
+  template< class TInputImage, class TOutputImage >
+    void
+    PCAImageToImageFilter< TInputImage, TOutputImage >
+    ::UpdateInputs( const InputImageRegionType & region )
+  {
+    /** As itk::StreamingImageFilter, request the region and update. */
+    for( unsigned int i = 0; i < this->m_NumberOfFeatureImages; ++i )
+    {
+      InputImagePointer input = const_cast< InputImageType * >( this->GetInput( i ) );
+      input->SetRequestedRegion( region );
+      input->PropagateRequestedRegion();
+      input->UpdateOutputData();
+    }
+
+  } // end UpdateInputs()
 
 
   /**
@@ -468,6 +758,8 @@ namespace itk
       << this->m_NumberOfFeatureImages << std::endl;
     os << indent << "NumberOfPixels: "
       << this->m_NumberOfPixels << std::endl;
+    os << indent << "Mask: "
+      << this->m_Mask.GetPointer() << std::endl;
 
     os << indent << "CovarianceMatrix: " << std::endl;
     for( unsigned int i = 0; i < this->m_CovarianceMatrix.size(); i++ )
@@ -480,8 +772,13 @@ namespace itk
     os << indent << "NormalisedEigenValues: "
       << this->m_NormalisedEigenValues << std::endl;
 
+    os << indent << "TruncatedEigenAnalysis: "
+      << this->m_TruncatedEigenAnalysis << std::endl;
+    os << indent << "NumberOfStreamDivisions: "
+      << this->m_NumberOfStreamDivisions << std::endl;
+
     os << indent << "Eigenvectors: " << std::endl;
-    for( unsigned int i = 0; i < this->m_EigenValues.size(); i++ )
+    for( unsigned int i = 0; i < this->m_EigenVectors.rows(); i++ )
     {
       os << indent << this->m_EigenVectors.get_row( i ) << std::endl;
     }
@@ -42,8 +42,15 @@ std::string GetHelpString( void )
     << "  -in      inputFilenames\n"
     << "  [-out]   outputDirectory, default equal to the inputFilename directory\n"
     << "  [-of]    outputFormat, default mhd\n"
+    << "  [-mask]  maskFilename, only the pixels inside the mask are used, the outputs are 0 elsewhere\n"
     << "  [-opc]   the number of principal components that you want to output, default all\n"
     << "  [-opct]  output pixel component type, default derived from the input image\n"
+    << "  [-full]  always perform the full eigen analysis; by default only the required\n"
+    << "           principal components are computed, if that is cheaper\n"
+    << "  [-s]     number of streams, default 1. The inputs are read in this many\n"
+    << "           pieces for the analysis, and again for each principal component\n"
+    << "The sign of each principal component is chosen such that the largest weight of\n"
+    << "its eigen vector is positive; older versions may give negated components.\n"
     << "Supported: 2D, 3D, (unsigned) char, (unsigned) short, (unsigned) int, (unsigned) long, float, double.";
 
   return ss.str();
@@ -85,6 +92,9 @@ int main( int argc, char **argv )
   bool endslash = itksys::SystemTools::StringEndsWith( outputDirectory.c_str(), "/" );
   if( !endslash ) outputDirectory += "/";
 
+  std::string maskFileName = "";
+  parser->GetCommandLineArgument( "-mask", maskFileName );
+
   std::string outputFormat = "mhd";
   bool retof = parser->GetCommandLineArgument( "-of", outputFormat );
 
@@ -94,6 +104,11 @@ int main( int argc, char **argv )
   std::string componentTypeString = "";
   bool retopct = parser->GetCommandLineArgument( "-opct", componentTypeString );
 
+  const bool fullEigenAnalysis = parser->ArgumentExists( "-full" );
+
+  unsigned int numberOfStreams = 1;
+  parser->GetCommandLineArgument( "-s", numberOfStreams );
+
   /** Check that numberOfOutputs <= numberOfInputs. */
   if( numberOfPCs > inputFileNames.size() )
   {
@@ -159,7 +174,10 @@ int main( int argc, char **argv )
     filter->m_InputFileNames = inputFileNames;
     filter->m_OutputDirectory = outputDirectory;
     filter->m_OutputFormat = outputFormat;
+    filter->m_MaskFileName = maskFileName;
     filter->m_NumberOfPCs = numberOfPCs;
+    filter->m_FullEigenAnalysis = fullEigenAnalysis;
+    filter->m_NumberOfStreams = numberOfStreams;
 
     filter->Run();
 
@@ -41,7 +41,10 @@ public:
   {
     this->m_OutputDirectory = "";
     this->m_OutputFormat = "mhd";
+    this->m_MaskFileName = "";
     this->m_NumberOfPCs = 0;
+    this->m_FullEigenAnalysis = false;
+    this->m_NumberOfStreams = 1;
   };
   /** Destructor. */
   ~ITKToolsPCABase(){};
@@ -50,7 +53,10 @@ public:
   std::vector< std::string > m_InputFileNames;
   std::string m_OutputFormat;
   std::string m_OutputDirectory;
+  std::string m_MaskFileName;
   unsigned int m_NumberOfPCs;
+  bool m_FullEigenAnalysis;
+  unsigned int m_NumberOfStreams;
 
 }; // end class ITKToolsPCABase
 
@@ -82,7 +88,9 @@ public:
       DoubleImageType, OutputImageType >                  PCAEstimatorType;
     typedef typename PCAEstimatorType::VectorOfDoubleType VectorOfDoubleType;
     typedef typename PCAEstimatorType::MatrixOfDoubleType MatrixOfDoubleType;
+    typedef typename PCAEstimatorType::MaskImageType      MaskImageType;
     typedef itk::ImageFileReader< DoubleImageType >       ReaderType;
+    typedef itk::ImageFileReader< MaskImageType >         MaskReaderType;
     typedef typename ReaderType::Pointer                  ReaderPointer;
     typedef itk::ImageFileWriter< OutputImageType >       WriterType;
     typedef typename WriterType::Pointer                  WriterPointer;
@@ -94,42 +102,32 @@ public:
     typename PCAEstimatorType::Pointer pcaEstimator = PCAEstimatorType::New();
     pcaEstimator->SetNumberOfFeatureImages( noInputs );
     pcaEstimator->SetNumberOfPrincipalComponentsRequired( this->m_NumberOfPCs );
+    pcaEstimator->SetTruncatedEigenAnalysis( !this->m_FullEigenAnalysis );
+    pcaEstimator->SetNumberOfStreamDivisions( this->m_NumberOfStreams );
 
-    /** For all inputs... */
+    /** For all inputs... The inputs are read in pieces by the PCA estimator. */
     std::vector<ReaderPointer> readers( noInputs );
     for( unsigned int i = 0; i < noInputs; ++i )
     {
-      /** Read in the input images. */
       readers[ i ] = ReaderType::New();
       readers[ i ]->SetFileName( this->m_InputFileNames[ i ] );
-      readers[ i ]->Update();
 
       /** Setup PCA estimator. */
       pcaEstimator->SetInput( i, readers[ i ]->GetOutput() );
     }
 
-    /** Do the PCA analysis. */
-    pcaEstimator->Update();
-
-    /** Get eigenvalues and vectors, and print it to screen. */
-    //pcaEstimator->Print( std::cout );
-    VectorOfDoubleType vec = pcaEstimator->GetEigenValues();
-    MatrixOfDoubleType mat = pcaEstimator->GetEigenVectors();
-
-    std::cout << "Eigenvalues: " << std::endl;
-    for( unsigned int i = 0; i < vec.size(); ++i )
+    /** Read the mask, if given. It is needed completely. */
+    if( this->m_MaskFileName != "" )
     {
-      std::cout << vec[ i ] << " ";
-    }
-    std::cout << std::endl;
-
-    std::cout << "Eigenvectors: " << std::endl;
-    for( unsigned int i = 0; i < vec.size(); ++i )
-    {
-      std::cout << mat.get_row( i ) << std::endl;
+      typename MaskReaderType::Pointer maskReader = MaskReaderType::New();
+      maskReader->SetFileName( this->m_MaskFileName.c_str() );
+      maskReader->Update();
+      pcaEstimator->SetMask( maskReader->GetOutput() );
     }
 
-    /** Setup and process the pipeline. */
+    /** Setup and process the pipeline. The first writer performs the PCA
+     * analysis, and each writer streams its principal component.
+     */
     unsigned int noo = pcaEstimator->GetNumberOfOutputs();
     std::vector<WriterPointer> writers( noo );
     for( unsigned int i = 0; i < noo; ++i )
@@ -143,8 +141,27 @@ public:
       writers[ i ] = WriterType::New();
       writers[ i ]->SetFileName( makeFileName.str().c_str() );
       writers[ i ]->SetInput( pcaEstimator->GetOutput( i ) );
+      writers[ i ]->SetNumberOfStreamDivisions( this->m_NumberOfStreams );
       writers[ i ]->Update();
     }
+
+    /** Get eigenvalues and vectors, and print it to screen. */
+    //pcaEstimator->Print( std::cout );
+    VectorOfDoubleType vec = pcaEstimator->GetEigenValues();
+    MatrixOfDoubleType mat = pcaEstimator->GetEigenVectors();
+
+    std::cout << "Eigenvalues: " << std::endl;
+    for( unsigned int i = 0; i < vec.size(); ++i )
+    {
+      std::cout << vec[ i ] << " ";
+    }
+    std::cout << std::endl;
+
+    std::cout << "Eigenvectors: " << std::endl;
+    for( unsigned int i = 0; i < mat.rows(); ++i )
+    {
+      std::cout << mat.get_row( i ) << std::endl;
+    }
   } // end Run()
 
 }; // end class ITKToolsPCA
@@ -0,0 +1,369 @@
+/*=========================================================================
+*
+* Copyright Marius Staring, Stefan Klein, David Doria. 2011.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0.txt
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*=========================================================================*/
+#ifndef __itkImageStatisticsAndHistogramCalculator_h_
+#define __itkImageStatisticsAndHistogramCalculator_h_
+
+#include "itkObject.h"
+#include "itkObjectFactory.h"
+#include "itkImage.h"
+#include "itkVector.h"
+#include "itkHistogram.h"
+#include "itkNumericTraits.h"
+#include "itkStatisticsAccumulation.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+
+namespace itk
+{
+
+/** \class ImageStatisticsAndHistogramCalculator
+ * \brief Computes the statistics and the histogram of an image in
+ * multi-threaded passes over its buffer, without intermediate images.
+ *
+ * Compute() determines in a single pass the minimum, maximum, sum,
+ * absolute mean, mean, variance and sigma of the voxel values, and, unless
+ * switched off with SetComputeGeometricStatistics(), the same statistics of
+ * their logarithm, for the geometric mean and sigma.
+ * ComputeHistogram() then bins the values in a second pass over the same
+ * buffer, in a range that is typically derived from the minimum and maximum
+ * of the first pass.
+ *
+ * ComputeExactQuantiles() determines quantiles that do not depend on a bin
+ * size, in a few more passes: a coarse histogram locates the bin of each
+ * requested rank. A bin with more than GetMaximumNumberOfGatheredValues()
+ * values, e.g. the bin of nearly all values next to a single outlier, is
+ * divided in bins again in a next pass, until the bin of each rank is small
+ * enough. Only the values in those bins are then gathered, and the ranks
+ * are selected with std::nth_element. The whole image is never copied or
+ * sorted.
+ *
+ * Each chunk of the image is accumulated in local variables and a local
+ * histogram, which are merged in the order of the chunks. The mean and the
+ * variance are accumulated with Welford's update, see RunningMoments. The mask, if set,
+ * is applied while iterating: voxels where the mask is zero are skipped.
+ * For vector images the magnitude of each vector is used, computed on the
+ * fly, so no magnitude image is created.
+ */
+
+template< class TInputImage, class TMaskImage >
+class ITK_EXPORT ImageStatisticsAndHistogramCalculator : public Object
+{
+public:
+  /** Standard class typedefs. */
+  typedef ImageStatisticsAndHistogramCalculator Self;
+  typedef Object                                Superclass;
+  typedef SmartPointer< Self >                  Pointer;
+  typedef SmartPointer< const Self >            ConstPointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro( Self );
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro( ImageStatisticsAndHistogramCalculator, Object );
+
+  /** Dimension of the images. */
+  itkStaticConstMacro( ImageDimension, unsigned int, TInputImage::ImageDimension );
+
+  /** Typedefs. */
+  typedef TInputImage                             InputImageType;
+  typedef typename InputImageType::PixelType      InputPixelType;
+  typedef typename InputImageType::RegionType     RegionType;
+  typedef TMaskImage                              MaskImageType;
+  typedef double                                  RealType;
+  typedef Statistics::Histogram< RealType >       HistogramType;
+  typedef typename HistogramType::Pointer         HistogramPointer;
+
+  /** Set the input image. */
+  itkSetConstObjectMacro( Input, InputImageType );
+
+  /** Set the mask, optional. It should have the same size as the input. */
+  itkSetConstObjectMacro( Mask, MaskImageType );
+
+  /** Set the number of work units, default 0 to use the global default. */
+  itkSetMacro( NumberOfWorkUnits, unsigned int );
+
+  /** Compute the geometric statistics as well, which costs a logarithm per
+   * voxel; default true. */
+  itkSetMacro( ComputeGeometricStatistics, bool );
+  itkGetConstMacro( ComputeGeometricStatistics, bool );
+
+  /** Compute the arithmetic and geometric statistics, in one pass. */
+  void Compute( void );
+
+  /** Compute a histogram of numberOfBins equal bins in [minimum, maximum).
+   * Values outside this range are not counted, as with the clipped bins of
+   * the itk::Statistics::SampleToHistogramFilter.
+   */
+  void ComputeHistogram( const unsigned int numberOfBins,
+    const RealType minimum, const RealType maximum );
+
+  /** Compute the exact quantiles of the values, for probabilities in
+   * [0, 1]. A quantile is interpolated linearly between the two nearest
+   * ranks, as the default of R and numpy: for n values sorted as x_0 ... x_n-1
+   * the quantile p is x_h with h = p * ( n - 1 ). Call Compute() first, for
+   * the minimum and maximum.
+   */
+
+  /** Set/Get the maximum number of values in a bin that ComputeExactQuantiles()
+   * gathers; a bin with more values is refined first. Default 65536.
+   */
+  itkSetMacro( MaximumNumberOfGatheredValues, SizeValueType );
+  itkGetConstMacro( MaximumNumberOfGatheredValues, SizeValueType );
+  std::vector< RealType > ComputeExactQuantiles( const std::vector< RealType > & probabilities );
+
+  /** Get the arithmetic statistics. */
+  SizeValueType GetCount( void ) const { return this->m_Count; }
+  RealType GetMinimum( void ) const { return this->m_Minimum; }
+  RealType GetMaximum( void ) const { return this->m_Maximum; }
+  RealType GetSum( void ) const { return this->m_Sum; }
+  RealType GetMean( void ) const { return this->m_Mean; }
+  RealType GetAbsoluteMean( void ) const { return this->m_AbsoluteMean; }
+  RealType GetVariance( void ) const { return this->m_Variance; }
+  RealType GetSigma( void ) const { return this->m_Sigma; }
+
+  /** Get the geometric statistics: the exponent of the mean and the sigma
+   * of the logarithm of the values. Only valid if ComputeGeometricStatistics.
+   */
+  RealType GetGeometricMean( void ) const { return this->m_GeometricMean; }
+  RealType GetGeometricSigma( void ) const { return this->m_GeometricSigma; }
+
+  /** Get the histogram. */
+  const HistogramType * GetHistogram( void ) const { return this->m_Histogram.GetPointer(); }
+
+protected:
+  ImageStatisticsAndHistogramCalculator();
+  virtual ~ImageStatisticsAndHistogramCalculator() {};
+
+  /** PrintSelf. */
+  virtual void PrintSelf( std::ostream & os, Indent indent ) const;
+
+  /** The value of a voxel: the value itself, or the magnitude of a vector. */
+  template< class TValue >
+  static RealType GetValue( const TValue & value )
+  {
+    return static_cast< RealType >( value );
+  }
+  template< class TValue, unsigned int VLength >
+  static RealType GetValue( const Vector< TValue, VLength > & value )
+  {
+    return static_cast< RealType >( value.GetNorm() );
+  }
+
+  /** Check the inputs. */
+  void CheckInputs( void ) const;
+
+  /** Apply a functor to the values in a region of the input, inside the mask. */
+  template< class TFunctor >
+  void VisitRegion( const RegionType & region, TFunctor & functor ) const;
+
+  /** Run an accumulator over the image in parallel, see AccumulateInParallel(). */
+  template< class TAccumulator >
+  void Accumulate( TAccumulator & accumulator ) const;
+
+  /** The sums and moments of one chunk of the image. */
+  struct StatisticsAccumulator
+  {
+    StatisticsAccumulator( const bool computeLogarithms )
+      : m_ComputeLogarithms( computeLogarithms ),
+      m_Minimum( NumericTraits< RealType >::max() ),
+      m_Maximum( NumericTraits< RealType >::NonpositiveMin() ),
+      m_Sum( 0.0 ), m_AbsoluteSum( 0.0 )
+    {}
+
+    void operator()( const RealType value )
+    {
+      this->m_Minimum = std::min( this->m_Minimum, value );
+      this->m_Maximum = std::max( this->m_Maximum, value );
+      this->m_Sum += value;
+      this->m_AbsoluteSum += std::abs( value );
+      this->m_Moments.Add( value );
+      if( this->m_ComputeLogarithms )
+      {
+        this->m_LogMoments.Add( std::log( value ) );
+      }
+    }
+
+    void Merge( const StatisticsAccumulator & other )
+    {
+      this->m_Minimum = std::min( this->m_Minimum, other.m_Minimum );
+      this->m_Maximum = std::max( this->m_Maximum, other.m_Maximum );
+      this->m_Sum += other.m_Sum;
+      this->m_AbsoluteSum += other.m_AbsoluteSum;
+      this->m_Moments.Merge( other.m_Moments );
+      this->m_LogMoments.Merge( other.m_LogMoments );
+    }
+
+    bool m_ComputeLogarithms;
+    RealType m_Minimum, m_Maximum;
+    RealType m_Sum, m_AbsoluteSum;
+    RunningMoments m_Moments, m_LogMoments;
+  };
+
+  /** The bins of one chunk of the image. */
+  struct HistogramAccumulator
+  {
+    HistogramAccumulator( const unsigned int numberOfBins,
+      const RealType minimum, const RealType maximum )
+      : m_Frequencies( numberOfBins, 0 ), m_Minimum( minimum ), m_Maximum( maximum ),
+      m_Scale( numberOfBins / ( maximum - minimum ) )
+    {}
+
+    void operator()( const RealType value )
+    {
+      if( !( value >= this->m_Minimum && value < this->m_Maximum ) ) return;
+      const SizeValueType bin = std::min(
+        static_cast< SizeValueType >( ( value - this->m_Minimum ) * this->m_Scale ),
+        static_cast< SizeValueType >( this->m_Frequencies.size() - 1 ) );
+      ++this->m_Frequencies[ bin ];
+    }
+
+    void Merge( const HistogramAccumulator & other )
+    {
+      for( SizeValueType i = 0; i < this->m_Frequencies.size(); ++i )
+      {
+        this->m_Frequencies[ i ] += other.m_Frequencies[ i ];
+      }
+    }
+
+    std::vector< SizeValueType > m_Frequencies;
+    RealType m_Minimum, m_Maximum, m_Scale;
+  };
+
+  /** The bins of one chunk of the image, for the exact quantiles: a number
+   * of bins in each of a few disjoint ranges [minimum, maximum], including
+   * the maximum, sorted by value. The bins are stored in one flat array, in
+   * the order of the values, with the range of the values per bin, so that
+   * a bin of equal values needs not be refined or gathered.
+   */
+  struct QuantileBinAccumulator
+  {
+    QuantileBinAccumulator( const unsigned int numberOfBins,
+      const std::vector< RealType > & minima, const std::vector< RealType > & maxima )
+      : m_NumberOfBins( numberOfBins ),
+      m_Frequencies( numberOfBins * minima.size(), 0 ),
+      m_BinMinimum( numberOfBins * minima.size(), NumericTraits< RealType >::max() ),
+      m_BinMaximum( numberOfBins * minima.size(), NumericTraits< RealType >::NonpositiveMin() ),
+      m_Minimum( minima ), m_Maximum( maxima ), m_Scale( minima.size() )
+    {
+      for( SizeValueType j = 0; j < minima.size(); ++j )
+      {
+        this->m_Scale[ j ] = numberOfBins / ( maxima[ j ] - minima[ j ] );
+      }
+    }
+
+    /** The flat bin of a value, or -1 outside the ranges. */
+    OffsetValueType GetBin( const RealType value ) const
+    {
+      const OffsetValueType j = std::upper_bound( this->m_Minimum.begin(),
+        this->m_Minimum.end(), value ) - this->m_Minimum.begin() - 1;
+      if( j < 0 || !( value <= this->m_Maximum[ j ] ) ) return -1;
+      const SizeValueType bin = std::min(
+        static_cast< SizeValueType >( ( value - this->m_Minimum[ j ] ) * this->m_Scale[ j ] ),
+        static_cast< SizeValueType >( this->m_NumberOfBins - 1 ) );
+      return j * this->m_NumberOfBins + bin;
+    }
+
+    void operator()( const RealType value )
+    {
+      const OffsetValueType bin = this->GetBin( value );
+      if( bin < 0 ) return;
+      ++this->m_Frequencies[ bin ];
+      this->m_BinMinimum[ bin ] = std::min( this->m_BinMinimum[ bin ], value );
+      this->m_BinMaximum[ bin ] = std::max( this->m_BinMaximum[ bin ], value );
+    }
+
+    void Merge( const QuantileBinAccumulator & other )
+    {
+      for( SizeValueType i = 0; i < this->m_Frequencies.size(); ++i )
+      {
+        this->m_Frequencies[ i ] += other.m_Frequencies[ i ];
+        this->m_BinMinimum[ i ] = std::min( this->m_BinMinimum[ i ], other.m_BinMinimum[ i ] );
+        this->m_BinMaximum[ i ] = std::max( this->m_BinMaximum[ i ], other.m_BinMaximum[ i ] );
+      }
+    }
+
+    unsigned int m_NumberOfBins;
+    std::vector< SizeValueType > m_Frequencies;
+    std::vector< RealType > m_BinMinimum, m_BinMaximum;
+    std::vector< RealType > m_Minimum, m_Maximum, m_Scale;
+  };
+
+  /** The values of one chunk of the image in a few disjoint ranges
+   * [minimum, maximum], sorted by value.
+   */
+  struct QuantileGatherer
+  {
+    QuantileGatherer( const std::vector< RealType > & minima, const std::vector< RealType > & maxima )
+      : m_Minimum( minima ), m_Maximum( maxima ), m_Values( minima.size() )
+    {}
+
+    void operator()( const RealType value )
+    {
+      const OffsetValueType j = std::upper_bound( this->m_Minimum.begin(),
+        this->m_Minimum.end(), value ) - this->m_Minimum.begin() - 1;
+      if( j < 0 || !( value <= this->m_Maximum[ j ] ) ) return;
+      this->m_Values[ j ].push_back( value );
+    }
+
+    void Merge( const QuantileGatherer & other )
+    {
+      for( SizeValueType i = 0; i < this->m_Values.size(); ++i )
+      {
+        this->m_Values[ i ].insert( this->m_Values[ i ].end(),
+          other.m_Values[ i ].begin(), other.m_Values[ i ].end() );
+      }
+    }
+
+    std::vector< RealType > m_Minimum, m_Maximum;
+    std::vector< std::vector< RealType > > m_Values;
+  };
+
+private:
+  ImageStatisticsAndHistogramCalculator( const Self & ); // purposely not implemented
+  void operator=( const Self & ); // purposely not implemented
+
+  typename InputImageType::ConstPointer   m_Input;
+  typename MaskImageType::ConstPointer    m_Mask;
+  unsigned int                            m_NumberOfWorkUnits;
+  bool                                    m_ComputeGeometricStatistics;
+  SizeValueType                           m_MaximumNumberOfGatheredValues;
+
+  SizeValueType     m_Count;
+  RealType          m_Minimum;
+  RealType          m_Maximum;
+  RealType          m_Sum;
+  RealType          m_Mean;
+  RealType          m_AbsoluteMean;
+  RealType          m_Variance;
+  RealType          m_Sigma;
+  RealType          m_GeometricMean;
+  RealType          m_GeometricSigma;
+  HistogramPointer  m_Histogram;
+
+}; // end class ImageStatisticsAndHistogramCalculator
+
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkImageStatisticsAndHistogramCalculator.hxx"
+#endif
+
+#endif // end #ifndef __itkImageStatisticsAndHistogramCalculator_h_
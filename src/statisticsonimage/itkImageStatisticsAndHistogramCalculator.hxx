@@ -0,0 +1,434 @@
+/*=========================================================================
+*
+* Copyright Marius Staring, Stefan Klein, David Doria. 2011.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0.txt
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*=========================================================================*/
+#ifndef _itkImageStatisticsAndHistogramCalculator_hxx_
+#define _itkImageStatisticsAndHistogramCalculator_hxx_
+
+#include "itkImageStatisticsAndHistogramCalculator.h"
+
+#include "itkImageScanlineConstIterator.h"
+#include "itkNumericTraits.h"
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <numeric>
+#include <set>
+
+
+namespace itk
+{
+
+/**
+ * ********************* Constructor ****************************
+ */
+
+template< class TInputImage, class TMaskImage >
+ImageStatisticsAndHistogramCalculator< TInputImage, TMaskImage >
+::ImageStatisticsAndHistogramCalculator()
+{
+  this->m_NumberOfWorkUnits = 0;
+  this->m_ComputeGeometricStatistics = true;
+  this->m_MaximumNumberOfGatheredValues = 65536;
+
+  this->m_Count = 0;
+  this->m_Minimum = NumericTraits< RealType >::max();
+  this->m_Maximum = NumericTraits< RealType >::NonpositiveMin();
+  this->m_Sum = 0.0;
+  this->m_Mean = NumericTraits< RealType >::max();
+  this->m_AbsoluteMean = NumericTraits< RealType >::max();
+  this->m_Variance = NumericTraits< RealType >::max();
+  this->m_Sigma = NumericTraits< RealType >::max();
+  this->m_GeometricMean = NumericTraits< RealType >::max();
+  this->m_GeometricSigma = NumericTraits< RealType >::max();
+} // end Constructor
+
+
+/**
+ * ********************* CheckInputs ****************************
+ */
+
+template< class TInputImage, class TMaskImage >
+void
+ImageStatisticsAndHistogramCalculator< TInputImage, TMaskImage >
+::CheckInputs( void ) const
+{
+  if( this->m_Input.IsNull() )
+  {
+    itkExceptionMacro( << "The input image is not set." );
+  }
+  if( this->m_Mask.IsNotNull()
+    && this->m_Mask->GetBufferedRegion() != this->m_Input->GetBufferedRegion() )
+  {
+    itkExceptionMacro( << "The mask should have the same size as the input image." );
+  }
+} // end CheckInputs()
+
+
+/**
+ * ********************* VisitRegion ****************************
+ */
+
+template< class TInputImage, class TMaskImage >
+template< class TFunctor >
+void
+ImageStatisticsAndHistogramCalculator< TInputImage, TMaskImage >
+::VisitRegion( const RegionType & region, TFunctor & functor ) const
+{
+  typedef ImageScanlineConstIterator< InputImageType >  InputIteratorType;
+  typedef ImageScanlineConstIterator< MaskImageType >   MaskIteratorType;
+
+  InputIteratorType it( this->m_Input, region );
+  if( this->m_Mask.IsNull() )
+  {
+    while( !it.IsAtEnd() )
+    {
+      while( !it.IsAtEndOfLine() )
+      {
+        functor( GetValue( it.Get() ) );
+        ++it;
+      }
+      it.NextLine();
+    }
+    return;
+  }
+
+  MaskIteratorType itMask( this->m_Mask, region );
+  while( !it.IsAtEnd() )
+  {
+    while( !it.IsAtEndOfLine() )
+    {
+      if( itMask.Get() )
+      {
+        functor( GetValue( it.Get() ) );
+      }
+      ++it;
+      ++itMask;
+    }
+    it.NextLine();
+    itMask.NextLine();
+  }
+
+} // end VisitRegion()
+
+
+/**
+ * ********************* Accumulate ****************************
+ */
+
+template< class TInputImage, class TMaskImage >
+template< class TAccumulator >
+void
+ImageStatisticsAndHistogramCalculator< TInputImage, TMaskImage >
+::Accumulate( TAccumulator & accumulator ) const
+{
+  AccumulateInParallel( this->m_Input->GetBufferedRegion(), this->m_NumberOfWorkUnits,
+    [this]( const RegionType & region, TAccumulator & local )
+    {
+      this->VisitRegion( region, local );
+    }, accumulator );
+
+} // end Accumulate()
+
+
+/**
+ * ********************* Compute ****************************
+ */
+
+template< class TInputImage, class TMaskImage >
+void
+ImageStatisticsAndHistogramCalculator< TInputImage, TMaskImage >
+::Compute( void )
+{
+  this->CheckInputs();
+
+  /** Accumulate chunk by chunk, and merge the sums of each chunk. */
+  StatisticsAccumulator total( this->m_ComputeGeometricStatistics );
+  this->Accumulate( total );
+
+  /** Derive the statistics from the sums and the moments. */
+  const double n = static_cast< double >( total.m_Moments.m_Count );
+  this->m_Count = total.m_Moments.m_Count;
+  this->m_Minimum = total.m_Minimum;
+  this->m_Maximum = total.m_Maximum;
+  this->m_Sum = total.m_Sum;
+  this->m_Mean = total.m_Moments.m_Mean;
+  this->m_AbsoluteMean = total.m_AbsoluteSum / n;
+  this->m_Variance = total.m_Moments.GetVariance();
+  this->m_Sigma = std::sqrt( this->m_Variance );
+  this->m_GeometricMean = NumericTraits< RealType >::max();
+  this->m_GeometricSigma = NumericTraits< RealType >::max();
+  if( this->m_ComputeGeometricStatistics )
+  {
+    this->m_GeometricMean = std::exp( total.m_LogMoments.m_Mean );
+    this->m_GeometricSigma = std::exp( std::sqrt( total.m_LogMoments.GetVariance() ) );
+  }
+
+  this->Modified();
+
+} // end Compute()
+
+
+/**
+ * ********************* ComputeHistogram ****************************
+ */
+
+template< class TInputImage, class TMaskImage >
+void
+ImageStatisticsAndHistogramCalculator< TInputImage, TMaskImage >
+::ComputeHistogram( const unsigned int numberOfBins,
+  const RealType minimum, const RealType maximum )
+{
+  this->CheckInputs();
+  if( numberOfBins == 0 || !( maximum > minimum ) )
+  {
+    itkExceptionMacro( << "Invalid histogram: " << numberOfBins
+      << " bins in [" << minimum << ", " << maximum << ")." );
+  }
+
+  /** Bin chunk by chunk, and add the bins of each chunk. */
+  HistogramAccumulator total( numberOfBins, minimum, maximum );
+  this->Accumulate( total );
+
+  /** Store the bins in an itk::Statistics::Histogram. */
+  typename HistogramType::SizeType size( 1 );
+  size[ 0 ] = numberOfBins;
+  typename HistogramType::MeasurementVectorType lowerBound( 1 );
+  typename HistogramType::MeasurementVectorType upperBound( 1 );
+  lowerBound[ 0 ] = minimum;
+  upperBound[ 0 ] = maximum;
+
+  this->m_Histogram = HistogramType::New();
+  this->m_Histogram->SetMeasurementVectorSize( 1 );
+  this->m_Histogram->Initialize( size, lowerBound, upperBound );
+  for( unsigned int i = 0; i < numberOfBins; ++i )
+  {
+    this->m_Histogram->SetFrequency( i, total.m_Frequencies[ i ] );
+  }
+
+  this->Modified();
+
+} // end ComputeHistogram()
+
+
+/**
+ * ********************* ComputeExactQuantiles ****************************
+ */
+
+template< class TInputImage, class TMaskImage >
+std::vector< typename ImageStatisticsAndHistogramCalculator< TInputImage, TMaskImage >::RealType >
+ImageStatisticsAndHistogramCalculator< TInputImage, TMaskImage >
+::ComputeExactQuantiles( const std::vector< RealType > & probabilities )
+{
+  /** The number of bins per range, and the maximum number of refinements
+   * of a bin. Each refinement divides the width of a bin by about
+   * numberOfBins, so the last level only remains for pathological data.
+   */
+  const unsigned int numberOfBins = 4096;
+  const unsigned int maximumNumberOfLevels = 8;
+
+  this->CheckInputs();
+  for( unsigned int i = 0; i < probabilities.size(); ++i )
+  {
+    if( !( probabilities[ i ] >= 0.0 && probabilities[ i ] <= 1.0 ) )
+    {
+      itkExceptionMacro( << "Invalid probability " << probabilities[ i ]
+        << ", it should be in [0, 1]." );
+    }
+  }
+  if( this->m_Count == 0 )
+  {
+    itkExceptionMacro( << "No statistics: call Compute() first, "
+      << "and make sure the mask is not empty." );
+  }
+  if( !std::isfinite( this->m_Minimum ) || !std::isfinite( this->m_Maximum ) )
+  {
+    itkExceptionMacro( << "Exact quantiles can not be computed, "
+      << "the image contains infinite values." );
+  }
+
+  std::vector< RealType > quantiles( probabilities.size(), this->m_Minimum );
+  if( this->m_Maximum == this->m_Minimum ) return quantiles;
+
+  /** The ranges of the current level, sorted by value, and the rank of the
+   * first value of each; the first level is a single range of all values.
+   */
+  std::vector< RealType > minima( 1, this->m_Minimum );
+  std::vector< RealType > maxima( 1, this->m_Maximum );
+  std::vector< SizeValueType > bases( 1, 0 );
+
+  /** The two ranks around each quantile, and their value: that of a bin of
+   * equal values, or selected from the gathered bin with that minimum.
+   */
+  SizeValueType n = 0;
+  std::vector< SizeValueType > ranks( 2 * probabilities.size() );
+  std::vector< RealType > rankValues( ranks.size() );
+  std::vector< bool > rankIsGathered( ranks.size(), false );
+  std::vector< unsigned int > pending( ranks.size() );
+  for( unsigned int i = 0; i < ranks.size(); ++i )
+  {
+    pending[ i ] = i;
+  }
+
+  /** The bins to gather, by minimum, with the rank of their first value. */
+  std::map< RealType, std::pair< RealType, SizeValueType > > gatheredBins;
+
+  /** Locate the ranks in the bins of the ranges, level by level, one pass
+   * per level. A bin that is too large becomes a range of the next level.
+   */
+  for( unsigned int level = 0; !pending.empty(); ++level )
+  {
+    QuantileBinAccumulator bins( numberOfBins, minima, maxima );
+    this->Accumulate( bins );
+
+    /** The rank of the first value of each flat bin. */
+    const SizeValueType numberOfFlatBins = bins.m_Frequencies.size();
+    std::vector< SizeValueType > binStart( numberOfFlatBins );
+    for( unsigned int j = 0; j < minima.size(); ++j )
+    {
+      SizeValueType start = bases[ j ];
+      for( unsigned int b = j * numberOfBins; b < ( j + 1 ) * numberOfBins; ++b )
+      {
+        binStart[ b ] = start;
+        start += bins.m_Frequencies[ b ];
+      }
+    }
+
+    if( level == 0 )
+    {
+      n = std::accumulate( bins.m_Frequencies.begin(), bins.m_Frequencies.end(), SizeValueType( 0 ) );
+      for( unsigned int i = 0; i < ranks.size(); ++i )
+      {
+        const SizeValueType lower = static_cast< SizeValueType >(
+          std::floor( probabilities[ i / 2 ] * static_cast< RealType >( n - 1 ) ) );
+        ranks[ i ] = std::min( lower + i % 2, n - 1 );
+      }
+    }
+
+    /** The bin of each pending rank: the last bin that starts at or before
+     * it, which is not empty. The bins to refine are kept in the order of
+     * the values, and their ranks stay pending.
+     */
+    std::set< SizeValueType > refinedBins;
+    std::vector< unsigned int > nextPending;
+    for( unsigned int k = 0; k < pending.size(); ++k )
+    {
+      const unsigned int i = pending[ k ];
+      const unsigned int j = static_cast< unsigned int >(
+        std::upper_bound( bases.begin(), bases.end(), ranks[ i ] ) - bases.begin() - 1 );
+      const SizeValueType bin = std::upper_bound( binStart.begin() + j * numberOfBins,
+        binStart.begin() + ( j + 1 ) * numberOfBins, ranks[ i ] ) - binStart.begin() - 1;
+
+      const RealType binMinimum = bins.m_BinMinimum[ bin ];
+      const RealType binMaximum = bins.m_BinMaximum[ bin ];
+      if( binMinimum == binMaximum )
+      {
+        rankValues[ i ] = binMinimum;
+      }
+      else if( bins.m_Frequencies[ bin ] > this->m_MaximumNumberOfGatheredValues
+        && level + 1 < maximumNumberOfLevels
+        && std::isfinite( numberOfBins / ( binMaximum - binMinimum ) ) )
+      {
+        refinedBins.insert( bin );
+        nextPending.push_back( i );
+      }
+      else
+      {
+        gatheredBins[ binMinimum ] = std::make_pair( binMaximum, binStart[ bin ] );
+        rankValues[ i ] = binMinimum;
+        rankIsGathered[ i ] = true;
+      }
+    }
+
+    /** The refined bins are the ranges of the next level. */
+    minima.clear();
+    maxima.clear();
+    bases.clear();
+    for( std::set< SizeValueType >::const_iterator it = refinedBins.begin();
+      it != refinedBins.end(); ++it )
+    {
+      minima.push_back( bins.m_BinMinimum[ *it ] );
+      maxima.push_back( bins.m_BinMaximum[ *it ] );
+      bases.push_back( binStart[ *it ] );
+    }
+    pending.swap( nextPending );
+  }
+
+  /** The last pass: gather the values of the selected bins. */
+  std::vector< RealType > gatherMinima, gatherMaxima;
+  std::vector< SizeValueType > gatherBases;
+  for( typename std::map< RealType, std::pair< RealType, SizeValueType > >::const_iterator
+    it = gatheredBins.begin(); it != gatheredBins.end(); ++it )
+  {
+    gatherMinima.push_back( it->first );
+    gatherMaxima.push_back( it->second.first );
+    gatherBases.push_back( it->second.second );
+  }
+  QuantileGatherer gatherer( gatherMinima, gatherMaxima );
+  if( !gatherMinima.empty() )
+  {
+    this->Accumulate( gatherer );
+  }
+
+  /** Select the ranks within their bins, and interpolate. */
+  for( unsigned int i = 0; i < ranks.size(); ++i )
+  {
+    if( !rankIsGathered[ i ] ) continue;
+    const SizeValueType slot = std::lower_bound( gatherMinima.begin(),
+      gatherMinima.end(), rankValues[ i ] ) - gatherMinima.begin();
+    std::vector< RealType > & values = gatherer.m_Values[ slot ];
+    typename std::vector< RealType >::iterator nth = values.begin() + ( ranks[ i ] - gatherBases[ slot ] );
+    std::nth_element( values.begin(), nth, values.end() );
+    rankValues[ i ] = *nth;
+  }
+
+  for( unsigned int i = 0; i < probabilities.size(); ++i )
+  {
+    const RealType h = probabilities[ i ] * static_cast< RealType >( n - 1 );
+    const RealType fraction = h - std::floor( h );
+    quantiles[ i ] = rankValues[ 2 * i ] + fraction * ( rankValues[ 2 * i + 1 ] - rankValues[ 2 * i ] );
+  }
+
+  return quantiles;
+
+} // end ComputeExactQuantiles()
+
+
+/**
+ * ********************* PrintSelf ****************************
+ */
+
+template< class TInputImage, class TMaskImage >
+void
+ImageStatisticsAndHistogramCalculator< TInputImage, TMaskImage >
+::PrintSelf( std::ostream & os, Indent indent ) const
+{
+  Superclass::PrintSelf( os, indent );
+
+  os << indent << "ComputeGeometricStatistics: " << this->m_ComputeGeometricStatistics << std::endl;
+  os << indent << "MaximumNumberOfGatheredValues: " << this->m_MaximumNumberOfGatheredValues << std::endl;
+  os << indent << "Count: " << this->m_Count << std::endl;
+  os << indent << "Minimum: " << this->m_Minimum << std::endl;
+  os << indent << "Maximum: " << this->m_Maximum << std::endl;
+  os << indent << "Mean: " << this->m_Mean << std::endl;
+  os << indent << "Sigma: " << this->m_Sigma << std::endl;
+
+} // end PrintSelf()
+
+} // end namespace itk
+
+#endif // end #ifndef _itkImageStatisticsAndHistogramCalculator_hxx_
@@ -0,0 +1,275 @@
+/*=========================================================================
+*
+* Copyright Marius Staring, Stefan Klein, David Doria. 2011.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0.txt
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*=========================================================================*/
+#ifndef __itkLabelStatisticsCalculator_h_
+#define __itkLabelStatisticsCalculator_h_
+
+#include "itkObject.h"
+#include "itkObjectFactory.h"
+#include "itkImage.h"
+#include "itkVector.h"
+#include "itkHistogram.h"
+#include "itkNumericTraits.h"
+#include "itkStatisticsAccumulation.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+
+namespace itk
+{
+
+/** \class LabelStatisticsCalculator
+ * \brief Computes the statistics of an image for all labels of a label
+ * image at once.
+ *
+ * Compute() first determines which labels occur, in a pass over the label
+ * image only, and numbers them 0, 1, ... in increasing order of the label
+ * values. A single multi-threaded pass over both images then computes the
+ * count, minimum, maximum, sum, mean, variance and sigma of every label,
+ * and those of the logarithm of the values, for the geometric mean and sigma.
+ * The accumulators are flat arrays indexed by this dense number, local to
+ * each chunk of the image and merged in the order of the chunks. The mean
+ * and the variance are accumulated with Welford's update, see
+ * RunningMoments. The dense
+ * number of a label is looked up in a table over the range of the labels,
+ * or, if that range is much larger than the number of labels, by a binary
+ * search in the sorted labels.
+ *
+ * ComputeHistograms() then bins the values of all labels in one more pass,
+ * each label in its own range, typically derived from its minimum and maximum.
+ *
+ * For vector images the magnitude of each vector is used, computed on the fly.
+ * The label image should have the same size as the input image.
+ */
+
+template< class TInputImage, class TLabelImage >
+class ITK_EXPORT LabelStatisticsCalculator : public Object
+{
+public:
+  /** Standard class typedefs. */
+  typedef LabelStatisticsCalculator   Self;
+  typedef Object                      Superclass;
+  typedef SmartPointer< Self >        Pointer;
+  typedef SmartPointer< const Self >  ConstPointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro( Self );
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro( LabelStatisticsCalculator, Object );
+
+  /** Dimension of the images. */
+  itkStaticConstMacro( ImageDimension, unsigned int, TInputImage::ImageDimension );
+
+  /** Typedefs. */
+  typedef TInputImage                             InputImageType;
+  typedef typename InputImageType::RegionType     RegionType;
+  typedef TLabelImage                             LabelImageType;
+  typedef typename LabelImageType::PixelType      LabelPixelType;
+  typedef double                                  RealType;
+  typedef Statistics::Histogram< RealType >       HistogramType;
+  typedef typename HistogramType::Pointer         HistogramPointer;
+
+  /** Set the input image. */
+  itkSetConstObjectMacro( Input, InputImageType );
+
+  /** Set the label image. */
+  itkSetConstObjectMacro( LabelImage, LabelImageType );
+
+  /** Set the number of work units, default 0 to use the global default. */
+  itkSetMacro( NumberOfWorkUnits, unsigned int );
+
+  /** Compute the geometric statistics as well, which costs a logarithm per
+   * voxel; default true. */
+  itkSetMacro( ComputeGeometricStatistics, bool );
+  itkGetConstMacro( ComputeGeometricStatistics, bool );
+
+  /** Compute the statistics of all labels. */
+  void Compute( void );
+
+  /** Compute a histogram per label, of numberOfBins[ i ] equal bins in
+   * [minima[ i ], maxima[ i ]) for label i. Values outside this range are
+   * not counted. Call Compute() first, for the labels.
+   */
+  void ComputeHistograms( const std::vector< unsigned int > & numberOfBins,
+    const std::vector< RealType > & minima, const std::vector< RealType > & maxima );
+
+  /** Get the labels that occur, in increasing order. */
+  const std::vector< LabelPixelType > & GetLabels( void ) const { return this->m_Labels; }
+  unsigned int GetNumberOfLabels( void ) const { return this->m_Labels.size(); }
+
+  /** Get the statistics of label i, in the order of GetLabels(). */
+  SizeValueType GetCount( const unsigned int i ) const { return this->m_Count[ i ]; }
+  RealType GetMinimum( const unsigned int i ) const { return this->m_Minimum[ i ]; }
+  RealType GetMaximum( const unsigned int i ) const { return this->m_Maximum[ i ]; }
+  RealType GetSum( const unsigned int i ) const { return this->m_Sum[ i ]; }
+  RealType GetMean( const unsigned int i ) const;
+  RealType GetVariance( const unsigned int i ) const;
+  RealType GetSigma( const unsigned int i ) const { return std::sqrt( this->GetVariance( i ) ); }
+  /** Only valid if ComputeGeometricStatistics. */
+  RealType GetGeometricMean( const unsigned int i ) const;
+  RealType GetGeometricSigma( const unsigned int i ) const;
+
+  /** Get the histogram of label i. */
+  const HistogramType * GetHistogram( const unsigned int i ) const
+  {
+    return this->m_Histograms[ i ].GetPointer();
+  }
+
+protected:
+  LabelStatisticsCalculator();
+  virtual ~LabelStatisticsCalculator() {};
+
+  /** PrintSelf. */
+  virtual void PrintSelf( std::ostream & os, Indent indent ) const;
+
+  /** The value of a voxel: the value itself, or the magnitude of a vector. */
+  template< class TValue >
+  static RealType GetValue( const TValue & value )
+  {
+    return static_cast< RealType >( value );
+  }
+  template< class TValue, unsigned int VLength >
+  static RealType GetValue( const Vector< TValue, VLength > & value )
+  {
+    return static_cast< RealType >( value.GetNorm() );
+  }
+
+  /** Check the inputs. */
+  void CheckInputs( void ) const;
+
+  /** Determine the labels, and the lookup table from label to dense number. */
+  void ComputeLabels( void );
+
+  /** Apply a functor to the dense label and the value of each voxel of a region. */
+  template< class TFunctor >
+  void VisitRegion( const RegionType & region, TFunctor & functor ) const;
+
+  /** Run an accumulator over the images in parallel, see AccumulateInParallel(). */
+  template< class TAccumulator >
+  void Accumulate( TAccumulator & accumulator ) const;
+
+  /** The sums and moments per label of one chunk of the image. */
+  struct StatisticsAccumulator
+  {
+    StatisticsAccumulator( const unsigned int numberOfLabels, const bool computeLogarithms )
+      : m_ComputeLogarithms( computeLogarithms ),
+      m_Minimum( numberOfLabels, NumericTraits< RealType >::max() ),
+      m_Maximum( numberOfLabels, NumericTraits< RealType >::NonpositiveMin() ),
+      m_Sum( numberOfLabels, 0.0 ),
+      m_Moments( numberOfLabels ), m_LogMoments( numberOfLabels )
+    {}
+
+    void operator()( const unsigned int label, const RealType value )
+    {
+      this->m_Minimum[ label ] = std::min( this->m_Minimum[ label ], value );
+      this->m_Maximum[ label ] = std::max( this->m_Maximum[ label ], value );
+      this->m_Sum[ label ] += value;
+      this->m_Moments[ label ].Add( value );
+      if( this->m_ComputeLogarithms )
+      {
+        this->m_LogMoments[ label ].Add( std::log( value ) );
+      }
+    }
+
+    void Merge( const StatisticsAccumulator & other )
+    {
+      for( SizeValueType i = 0; i < this->m_Sum.size(); ++i )
+      {
+        this->m_Minimum[ i ] = std::min( this->m_Minimum[ i ], other.m_Minimum[ i ] );
+        this->m_Maximum[ i ] = std::max( this->m_Maximum[ i ], other.m_Maximum[ i ] );
+        this->m_Sum[ i ] += other.m_Sum[ i ];
+        this->m_Moments[ i ].Merge( other.m_Moments[ i ] );
+        this->m_LogMoments[ i ].Merge( other.m_LogMoments[ i ] );
+      }
+    }
+
+    bool m_ComputeLogarithms;
+    std::vector< RealType > m_Minimum, m_Maximum;
+    std::vector< RealType > m_Sum;
+    std::vector< RunningMoments > m_Moments, m_LogMoments;
+  };
+
+  /** The bins of all labels of one chunk of the image, in one flat array. */
+  struct HistogramAccumulator
+  {
+    HistogramAccumulator( const std::vector< SizeValueType > & binOffsets,
+      const std::vector< RealType > & minima, const std::vector< RealType > & maxima )
+      : m_Frequencies( binOffsets.back(), 0 ), m_BinOffsets( binOffsets ),
+      m_Minimum( minima ), m_Maximum( maxima ), m_Scale( minima.size() )
+    {
+      for( SizeValueType i = 0; i < minima.size(); ++i )
+      {
+        this->m_Scale[ i ] = ( binOffsets[ i + 1 ] - binOffsets[ i ] ) / ( maxima[ i ] - minima[ i ] );
+      }
+    }
+
+    void operator()( const unsigned int label, const RealType value )
+    {
+      if( !( value >= this->m_Minimum[ label ] && value < this->m_Maximum[ label ] ) ) return;
+      const SizeValueType numberOfBins = this->m_BinOffsets[ label + 1 ] - this->m_BinOffsets[ label ];
+      const SizeValueType bin = std::min( numberOfBins - 1,
+        static_cast< SizeValueType >( ( value - this->m_Minimum[ label ] ) * this->m_Scale[ label ] ) );
+      ++this->m_Frequencies[ this->m_BinOffsets[ label ] + bin ];
+    }
+
+    void Merge( const HistogramAccumulator & other )
+    {
+      for( SizeValueType i = 0; i < this->m_Frequencies.size(); ++i )
+      {
+        this->m_Frequencies[ i ] += other.m_Frequencies[ i ];
+      }
+    }
+
+    std::vector< SizeValueType > m_Frequencies;
+    std::vector< SizeValueType > m_BinOffsets;
+    std::vector< RealType > m_Minimum, m_Maximum, m_Scale;
+  };
+
+private:
+  LabelStatisticsCalculator( const Self & ); // purposely not implemented
+  void operator=( const Self & ); // purposely not implemented
+
+  typename InputImageType::ConstPointer   m_Input;
+  typename LabelImageType::ConstPointer   m_LabelImage;
+  unsigned int                            m_NumberOfWorkUnits;
+  bool                                    m_ComputeGeometricStatistics;
+
+  /** The labels, and the lookup table from label - m_Labels[ 0 ] to dense
+   * number, which is empty for sparse labels. */
+  std::vector< LabelPixelType >   m_Labels;
+  std::vector< unsigned int >     m_LabelToDense;
+
+  std::vector< SizeValueType >    m_Count;
+  std::vector< RealType >         m_Minimum;
+  std::vector< RealType >         m_Maximum;
+  std::vector< RealType >         m_Sum;
+  std::vector< RunningMoments >   m_Moments;
+  std::vector< RunningMoments >   m_LogMoments;
+  std::vector< HistogramPointer > m_Histograms;
+
+}; // end class LabelStatisticsCalculator
+
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkLabelStatisticsCalculator.hxx"
+#endif
+
+#endif // end #ifndef __itkLabelStatisticsCalculator_h_
@@ -0,0 +1,431 @@
+/*=========================================================================
+*
+* Copyright Marius Staring, Stefan Klein, David Doria. 2011.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0.txt
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*=========================================================================*/
+#ifndef _itkLabelStatisticsCalculator_hxx_
+#define _itkLabelStatisticsCalculator_hxx_
+
+#include "itkLabelStatisticsCalculator.h"
+
+#include "itkImageScanlineConstIterator.h"
+#include "itkMultiThreaderBase.h"
+
+#include <mutex>
+#include <set>
+
+
+namespace itk
+{
+
+/**
+ * ********************* Constructor ****************************
+ */
+
+template< class TInputImage, class TLabelImage >
+LabelStatisticsCalculator< TInputImage, TLabelImage >
+::LabelStatisticsCalculator()
+{
+  this->m_NumberOfWorkUnits = 0;
+  this->m_ComputeGeometricStatistics = true;
+} // end Constructor
+
+
+/**
+ * ********************* CheckInputs ****************************
+ */
+
+template< class TInputImage, class TLabelImage >
+void
+LabelStatisticsCalculator< TInputImage, TLabelImage >
+::CheckInputs( void ) const
+{
+  if( this->m_Input.IsNull() )
+  {
+    itkExceptionMacro( << "The input image is not set." );
+  }
+  if( this->m_LabelImage.IsNull() )
+  {
+    itkExceptionMacro( << "The label image is not set." );
+  }
+  if( this->m_LabelImage->GetBufferedRegion() != this->m_Input->GetBufferedRegion() )
+  {
+    itkExceptionMacro( << "The label image should have the same size as the input image." );
+  }
+} // end CheckInputs()
+
+
+/**
+ * ********************* ComputeLabels ****************************
+ *
+ * Two cheap passes over the label image: one for the range of the labels,
+ * one to collect the labels that occur. Each chunk collects its labels in a
+ * set, which stays small, whatever the range of the labels. A lookup table
+ * over the range is only built if the range is not much larger than the
+ * number of labels; sparse labels are looked up in the sorted labels.
+ */
+
+template< class TInputImage, class TLabelImage >
+void
+LabelStatisticsCalculator< TInputImage, TLabelImage >
+::ComputeLabels( void )
+{
+  typedef ImageScanlineConstIterator< LabelImageType >  LabelIteratorType;
+
+  /** The size of the lookup table that is always allowed, and the maximum
+   * number of table entries per label beyond that.
+   */
+  const double minimumTableSize = 1 << 16;
+  const double maximumEntriesPerLabel = 16.0;
+
+  std::mutex mutex;
+  MultiThreaderBase::Pointer threader = MultiThreaderBase::New();
+  if( this->m_NumberOfWorkUnits > 0 )
+  {
+    threader->SetNumberOfWorkUnits( this->m_NumberOfWorkUnits );
+  }
+
+  /** Pass 1: the range of the labels. */
+  LabelPixelType minimumLabel = NumericTraits< LabelPixelType >::max();
+  LabelPixelType maximumLabel = NumericTraits< LabelPixelType >::NonpositiveMin();
+  threader->template ParallelizeImageRegion< ImageDimension >(
+    this->m_LabelImage->GetBufferedRegion(),
+    [this, &minimumLabel, &maximumLabel, &mutex]( const RegionType & region )
+    {
+      LabelPixelType localMinimum = NumericTraits< LabelPixelType >::max();
+      LabelPixelType localMaximum = NumericTraits< LabelPixelType >::NonpositiveMin();
+      LabelIteratorType it( this->m_LabelImage, region );
+      while( !it.IsAtEnd() )
+      {
+        while( !it.IsAtEndOfLine() )
+        {
+          const LabelPixelType label = it.Get();
+          localMinimum = std::min( localMinimum, label );
+          localMaximum = std::max( localMaximum, label );
+          ++it;
+        }
+        it.NextLine();
+      }
+      std::lock_guard< std::mutex > lock( mutex );
+      minimumLabel = std::min( minimumLabel, localMinimum );
+      maximumLabel = std::max( maximumLabel, localMaximum );
+    }, nullptr );
+
+  if( maximumLabel < minimumLabel )
+  {
+    itkExceptionMacro( << "The label image is empty." );
+  }
+
+  /** Pass 2: collect the labels that occur. Neighbouring voxels mostly
+   * have the same label, which needs not be looked up again.
+   */
+  std::set< LabelPixelType > labels;
+  threader->template ParallelizeImageRegion< ImageDimension >(
+    this->m_LabelImage->GetBufferedRegion(),
+    [this, &labels, &mutex]( const RegionType & region )
+    {
+      std::set< LabelPixelType > localLabels;
+      LabelIteratorType it( this->m_LabelImage, region );
+      if( it.IsAtEnd() ) return;
+      LabelPixelType previousLabel = it.Get();
+      localLabels.insert( previousLabel );
+      while( !it.IsAtEnd() )
+      {
+        while( !it.IsAtEndOfLine() )
+        {
+          const LabelPixelType label = it.Get();
+          if( label != previousLabel )
+          {
+            localLabels.insert( label );
+            previousLabel = label;
+          }
+          ++it;
+        }
+        it.NextLine();
+      }
+      std::lock_guard< std::mutex > lock( mutex );
+      labels.insert( localLabels.begin(), localLabels.end() );
+    }, nullptr );
+
+  /** Number the labels that occur, in increasing order. */
+  this->m_Labels.assign( labels.begin(), labels.end() );
+  this->m_LabelToDense.clear();
+  const double range = static_cast< double >( maximumLabel )
+    - static_cast< double >( minimumLabel ) + 1.0;
+  if( range <= std::max( minimumTableSize,
+    maximumEntriesPerLabel * static_cast< double >( this->m_Labels.size() ) ) )
+  {
+    this->m_LabelToDense.assign( static_cast< std::size_t >( range ), 0 );
+    for( unsigned int i = 0; i < this->m_Labels.size(); ++i )
+    {
+      this->m_LabelToDense[ static_cast< long long >( this->m_Labels[ i ] )
+        - static_cast< long long >( minimumLabel ) ] = i;
+    }
+  }
+
+} // end ComputeLabels()
+
+
+/**
+ * ********************* VisitRegion ****************************
+ */
+
+template< class TInputImage, class TLabelImage >
+template< class TFunctor >
+void
+LabelStatisticsCalculator< TInputImage, TLabelImage >
+::VisitRegion( const RegionType & region, TFunctor & functor ) const
+{
+  typedef ImageScanlineConstIterator< InputImageType >  InputIteratorType;
+  typedef ImageScanlineConstIterator< LabelImageType >  LabelIteratorType;
+
+  InputIteratorType it( this->m_Input, region );
+  LabelIteratorType itLabel( this->m_LabelImage, region );
+
+  /** Dense labels: the lookup table. */
+  if( !this->m_LabelToDense.empty() )
+  {
+    const long long minimumLabel = this->m_Labels[ 0 ];
+    const unsigned int * labelToDense = &this->m_LabelToDense[ 0 ];
+    while( !it.IsAtEnd() )
+    {
+      while( !it.IsAtEndOfLine() )
+      {
+        functor( labelToDense[ static_cast< long long >( itLabel.Get() ) - minimumLabel ],
+          GetValue( it.Get() ) );
+        ++it;
+        ++itLabel;
+      }
+      it.NextLine();
+      itLabel.NextLine();
+    }
+    return;
+  }
+
+  /** Sparse labels: a binary search in the sorted labels. Neighbouring
+   * voxels mostly have the same label, which needs not be looked up again.
+   */
+  LabelPixelType previousLabel = this->m_Labels[ 0 ];
+  unsigned int previousDense = 0;
+  while( !it.IsAtEnd() )
+  {
+    while( !it.IsAtEndOfLine() )
+    {
+      const LabelPixelType label = itLabel.Get();
+      if( label != previousLabel )
+      {
+        previousDense = std::lower_bound( this->m_Labels.begin(),
+          this->m_Labels.end(), label ) - this->m_Labels.begin();
+        previousLabel = label;
+      }
+      functor( previousDense, GetValue( it.Get() ) );
+      ++it;
+      ++itLabel;
+    }
+    it.NextLine();
+    itLabel.NextLine();
+  }
+
+} // end VisitRegion()
+
+
+/**
+ * ********************* Accumulate ****************************
+ */
+
+template< class TInputImage, class TLabelImage >
+template< class TAccumulator >
+void
+LabelStatisticsCalculator< TInputImage, TLabelImage >
+::Accumulate( TAccumulator & accumulator ) const
+{
+  AccumulateInParallel( this->m_Input->GetBufferedRegion(), this->m_NumberOfWorkUnits,
+    [this]( const RegionType & region, TAccumulator & local )
+    {
+      this->VisitRegion( region, local );
+    }, accumulator );
+
+} // end Accumulate()
+
+
+/**
+ * ********************* Compute ****************************
+ */
+
+template< class TInputImage, class TLabelImage >
+void
+LabelStatisticsCalculator< TInputImage, TLabelImage >
+::Compute( void )
+{
+  this->CheckInputs();
+  this->ComputeLabels();
+
+  /** Accumulate chunk by chunk, and merge the sums of each chunk. */
+  StatisticsAccumulator total( this->m_Labels.size(), this->m_ComputeGeometricStatistics );
+  this->Accumulate( total );
+
+  this->m_Count.resize( this->m_Labels.size() );
+  for( unsigned int i = 0; i < this->m_Labels.size(); ++i )
+  {
+    this->m_Count[ i ] = total.m_Moments[ i ].m_Count;
+  }
+  this->m_Minimum.swap( total.m_Minimum );
+  this->m_Maximum.swap( total.m_Maximum );
+  this->m_Sum.swap( total.m_Sum );
+  this->m_Moments.swap( total.m_Moments );
+  this->m_LogMoments.swap( total.m_LogMoments );
+  this->m_Histograms.clear();
+
+  this->Modified();
+
+} // end Compute()
+
+
+/**
+ * ********************* ComputeHistograms ****************************
+ */
+
+template< class TInputImage, class TLabelImage >
+void
+LabelStatisticsCalculator< TInputImage, TLabelImage >
+::ComputeHistograms( const std::vector< unsigned int > & numberOfBins,
+  const std::vector< RealType > & minima, const std::vector< RealType > & maxima )
+{
+  const unsigned int numberOfLabels = this->m_Labels.size();
+  if( numberOfLabels == 0 )
+  {
+    itkExceptionMacro( << "No labels: call Compute() first." );
+  }
+  if( numberOfBins.size() != numberOfLabels || minima.size() != numberOfLabels
+    || maxima.size() != numberOfLabels )
+  {
+    itkExceptionMacro( << "Specify the histogram of each of the "
+      << numberOfLabels << " labels." );
+  }
+
+  /** The bins of label i start at binOffsets[ i ] in one flat array. */
+  std::vector< SizeValueType > binOffsets( numberOfLabels + 1, 0 );
+  for( unsigned int i = 0; i < numberOfLabels; ++i )
+  {
+    if( numberOfBins[ i ] == 0 || !( maxima[ i ] > minima[ i ] ) )
+    {
+      itkExceptionMacro( << "Invalid histogram for label " << this->m_Labels[ i ]
+        << ": " << numberOfBins[ i ] << " bins in ["
+        << minima[ i ] << ", " << maxima[ i ] << ")." );
+    }
+    binOffsets[ i + 1 ] = binOffsets[ i ] + numberOfBins[ i ];
+  }
+
+  /** Bin chunk by chunk, and add the bins of each chunk. */
+  HistogramAccumulator total( binOffsets, minima, maxima );
+  this->Accumulate( total );
+
+  /** Store the bins in an itk::Statistics::Histogram per label. */
+  this->m_Histograms.resize( numberOfLabels );
+  for( unsigned int i = 0; i < numberOfLabels; ++i )
+  {
+    typename HistogramType::SizeType size( 1 );
+    size[ 0 ] = numberOfBins[ i ];
+    typename HistogramType::MeasurementVectorType lowerBound( 1 );
+    typename HistogramType::MeasurementVectorType upperBound( 1 );
+    lowerBound[ 0 ] = minima[ i ];
+    upperBound[ 0 ] = maxima[ i ];
+
+    this->m_Histograms[ i ] = HistogramType::New();
+    this->m_Histograms[ i ]->SetMeasurementVectorSize( 1 );
+    this->m_Histograms[ i ]->Initialize( size, lowerBound, upperBound );
+    for( unsigned int j = 0; j < numberOfBins[ i ]; ++j )
+    {
+      this->m_Histograms[ i ]->SetFrequency( j, total.m_Frequencies[ binOffsets[ i ] + j ] );
+    }
+  }
+
+  this->Modified();
+
+} // end ComputeHistograms()
+
+
+/**
+ * ********************* GetMean ****************************
+ */
+
+template< class TInputImage, class TLabelImage >
+typename LabelStatisticsCalculator< TInputImage, TLabelImage >::RealType
+LabelStatisticsCalculator< TInputImage, TLabelImage >
+::GetMean( const unsigned int i ) const
+{
+  return this->m_Moments[ i ].m_Mean;
+} // end GetMean()
+
+
+/**
+ * ********************* GetVariance ****************************
+ */
+
+template< class TInputImage, class TLabelImage >
+typename LabelStatisticsCalculator< TInputImage, TLabelImage >::RealType
+LabelStatisticsCalculator< TInputImage, TLabelImage >
+::GetVariance( const unsigned int i ) const
+{
+  return this->m_Moments[ i ].GetVariance();
+} // end GetVariance()
+
+
+/**
+ * ********************* GetGeometricMean ****************************
+ */
+
+template< class TInputImage, class TLabelImage >
+typename LabelStatisticsCalculator< TInputImage, TLabelImage >::RealType
+LabelStatisticsCalculator< TInputImage, TLabelImage >
+::GetGeometricMean( const unsigned int i ) const
+{
+  return std::exp( this->m_LogMoments[ i ].m_Mean );
+} // end GetGeometricMean()
+
+
+/**
+ * ********************* GetGeometricSigma ****************************
+ */
+
+template< class TInputImage, class TLabelImage >
+typename LabelStatisticsCalculator< TInputImage, TLabelImage >::RealType
+LabelStatisticsCalculator< TInputImage, TLabelImage >
+::GetGeometricSigma( const unsigned int i ) const
+{
+  return std::exp( std::sqrt( this->m_LogMoments[ i ].GetVariance() ) );
+} // end GetGeometricSigma()
+
+
+/**
+ * ********************* PrintSelf ****************************
+ */
+
+template< class TInputImage, class TLabelImage >
+void
+LabelStatisticsCalculator< TInputImage, TLabelImage >
+::PrintSelf( std::ostream & os, Indent indent ) const
+{
+  Superclass::PrintSelf( os, indent );
+
+  os << indent << "NumberOfWorkUnits: " << this->m_NumberOfWorkUnits << std::endl;
+  os << indent << "ComputeGeometricStatistics: " << this->m_ComputeGeometricStatistics << std::endl;
+  os << indent << "NumberOfLabels: " << this->m_Labels.size() << std::endl;
+
+} // end PrintSelf()
+
+} // end namespace itk
+
+#endif // end #ifndef _itkLabelStatisticsCalculator_hxx_
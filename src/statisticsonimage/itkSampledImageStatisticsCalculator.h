@@ -0,0 +1,212 @@
+/*=========================================================================
+*
+* Copyright Marius Staring, Stefan Klein, David Doria. 2011.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0.txt
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*=========================================================================*/
+#ifndef __itkSampledImageStatisticsCalculator_h_
+#define __itkSampledImageStatisticsCalculator_h_
+
+#include "itkObject.h"
+#include "itkObjectFactory.h"
+#include "itkImage.h"
+#include "itkVector.h"
+#include "itkMersenneTwisterRandomVariateGenerator.h"
+
+#include <vector>
+
+
+namespace itk
+{
+
+/** \class SampledImageStatisticsCalculator
+ * \brief Estimates the mean, sigma and quantiles of an image from a random
+ * sample of its voxels, with confidence intervals.
+ *
+ * The sample is reproducible: it only depends on the seed. There are two
+ * sampling schemes:
+ *
+ * - Slabs: a random subset of the slices along the last dimension is drawn,
+ *   without replacement. The slices are requested from the pipeline one by
+ *   one, so when the input is the output of a reader with a streaming
+ *   ImageIO only the sampled slices are read from disk. The confidence
+ *   interval of the mean is that of a cluster sample, and the intervals of
+ *   sigma and the quantiles are widened by the design effect, to account
+ *   for the correlation of the voxels within a slice.
+ * - Voxels: single voxels are drawn at random, with replacement, from the
+ *   complete image, which is updated first. This is meant for an ImageIO
+ *   that can not stream, which reads the complete image anyway.
+ *
+ * The confidence interval of the mean uses the normal approximation, that
+ * of sigma the standard error of the variance including the kurtosis of the
+ * sample, and those of the quantiles the order statistics of the sample.
+ *
+ * A sample size smaller than 1 is a fraction of the number of voxels,
+ * otherwise it is the number of voxels. In slab mode the number of slabs is
+ * the number needed for that number of voxels, and at least 2. If there is
+ * only a single slab, the confidence intervals are those of independent
+ * voxels. With a mask only the sampled voxels inside the mask are used; the
+ * mask is requested slab by slab like the input, so it can be the output of
+ * a reader as well.
+ *
+ * For vector images the magnitude of each vector is used.
+ */
+
+template< class TInputImage, class TMaskImage >
+class ITK_EXPORT SampledImageStatisticsCalculator : public Object
+{
+public:
+  /** Standard class typedefs. */
+  typedef SampledImageStatisticsCalculator  Self;
+  typedef Object                            Superclass;
+  typedef SmartPointer< Self >              Pointer;
+  typedef SmartPointer< const Self >        ConstPointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro( Self );
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro( SampledImageStatisticsCalculator, Object );
+
+  /** Dimension of the images. */
+  itkStaticConstMacro( ImageDimension, unsigned int, TInputImage::ImageDimension );
+
+  /** Typedefs. */
+  typedef TInputImage                             InputImageType;
+  typedef typename InputImageType::RegionType     RegionType;
+  typedef typename InputImageType::IndexType      IndexType;
+  typedef TMaskImage                              MaskImageType;
+  typedef double                                  RealType;
+  typedef Statistics::MersenneTwisterRandomVariateGenerator GeneratorType;
+
+  /** An estimate and its confidence interval. */
+  struct EstimateType
+  {
+    RealType m_Value;
+    RealType m_Lower;
+    RealType m_Upper;
+  };
+
+  /** Set the input image. It is not const, because in slab mode the slabs
+   * are requested from its source one by one.
+   */
+  itkSetObjectMacro( Input, InputImageType );
+
+  /** Set the mask, optional. It should have the same size as the input. It
+   * is not const, because its sampled slabs are requested from its source.
+   */
+  itkSetObjectMacro( Mask, MaskImageType );
+
+  /** Set the sample size: a fraction if < 1, a number of voxels otherwise. */
+  itkSetMacro( SampleSize, double );
+
+  /** Set the seed of the random generator, default 0. */
+  itkSetMacro( Seed, unsigned int );
+
+  /** Sample slabs along the last dimension instead of voxels, default true. */
+  itkSetMacro( SampleSlabs, bool );
+  itkBooleanMacro( SampleSlabs );
+
+  /** Set the confidence level of the intervals, default 0.95. */
+  itkSetMacro( ConfidenceLevel, double );
+  itkGetConstMacro( ConfidenceLevel, double );
+
+  /** Draw the sample and compute the estimates, including the quantiles of
+   * the given probabilities.
+   */
+  void Compute( const std::vector< RealType > & probabilities );
+
+  /** Get the size of the sample. */
+  itkGetConstMacro( NumberOfSampledVoxels, SizeValueType );
+  itkGetConstMacro( NumberOfSampledSlabs, SizeValueType );
+  itkGetConstMacro( NumberOfSlabs, SizeValueType );
+
+  /** Get the estimates. */
+  const EstimateType & GetMean( void ) const { return this->m_Mean; }
+  const EstimateType & GetSigma( void ) const { return this->m_Sigma; }
+  const std::vector< EstimateType > & GetQuantiles( void ) const { return this->m_Quantiles; }
+
+  /** Get the design effect: the variance of the estimated mean relative to
+   * that of a sample of independent voxels of the same size. 1 for voxels.
+   */
+  itkGetConstMacro( DesignEffect, RealType );
+
+protected:
+  SampledImageStatisticsCalculator();
+  virtual ~SampledImageStatisticsCalculator() {};
+
+  /** PrintSelf. */
+  virtual void PrintSelf( std::ostream & os, Indent indent ) const;
+
+  /** The value of a voxel: the value itself, or the magnitude of a vector. */
+  template< class TValue >
+  static RealType GetValue( const TValue & value )
+  {
+    return static_cast< RealType >( value );
+  }
+  template< class TValue, unsigned int VLength >
+  static RealType GetValue( const Vector< TValue, VLength > & value )
+  {
+    return static_cast< RealType >( value.GetNorm() );
+  }
+
+  /** A random number in [0, n), also for more than 2^32 voxels. */
+  static SizeValueType RandomIndex( GeneratorType * generator, const SizeValueType n );
+
+  /** Draw the sample. Fills m_Values, and for slabs m_SlabCounts and m_SlabSums. */
+  void SampleSlabs( const RegionType & largestRegion, const SizeValueType sampleSize,
+    GeneratorType * generator );
+  void SampleVoxels( const RegionType & largestRegion, const SizeValueType sampleSize,
+    GeneratorType * generator );
+
+  /** Update the mask for a region, and check that it is buffered. */
+  void UpdateMask( const RegionType & region );
+
+  /** Compute the estimates from the sample. */
+  void ComputeEstimates( const std::vector< RealType > & probabilities );
+
+private:
+  SampledImageStatisticsCalculator( const Self & ); // purposely not implemented
+  void operator=( const Self & ); // purposely not implemented
+
+  typename InputImageType::Pointer      m_Input;
+  typename MaskImageType::Pointer       m_Mask;
+  double                                m_SampleSize;
+  unsigned int                          m_Seed;
+  bool                                  m_SampleSlabs;
+  double                                m_ConfidenceLevel;
+
+  /** The sample. */
+  std::vector< RealType >       m_Values;
+  std::vector< SizeValueType >  m_SlabCounts;
+  std::vector< RealType >       m_SlabSums;
+
+  /** The estimates. */
+  SizeValueType                 m_NumberOfSampledVoxels;
+  SizeValueType                 m_NumberOfSampledSlabs;
+  SizeValueType                 m_NumberOfSlabs;
+  RealType                      m_DesignEffect;
+  EstimateType                  m_Mean;
+  EstimateType                  m_Sigma;
+  std::vector< EstimateType >   m_Quantiles;
+
+}; // end class SampledImageStatisticsCalculator
+
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkSampledImageStatisticsCalculator.hxx"
+#endif
+
+#endif // end #ifndef __itkSampledImageStatisticsCalculator_h_
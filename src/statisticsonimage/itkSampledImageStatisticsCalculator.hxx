@@ -0,0 +1,436 @@
+/*=========================================================================
+*
+* Copyright Marius Staring, Stefan Klein, David Doria. 2011.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0.txt
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*=========================================================================*/
+#ifndef _itkSampledImageStatisticsCalculator_hxx_
+#define _itkSampledImageStatisticsCalculator_hxx_
+
+#include "itkSampledImageStatisticsCalculator.h"
+
+#include "itkImageScanlineConstIterator.h"
+#include "itkGaussianDistribution.h"
+
+#include <algorithm>
+#include <cmath>
+
+
+namespace itk
+{
+
+/**
+ * ********************* Constructor ****************************
+ */
+
+template< class TInputImage, class TMaskImage >
+SampledImageStatisticsCalculator< TInputImage, TMaskImage >
+::SampledImageStatisticsCalculator()
+{
+  this->m_SampleSize = 0.01;
+  this->m_Seed = 0;
+  this->m_SampleSlabs = true;
+  this->m_ConfidenceLevel = 0.95;
+
+  this->m_NumberOfSampledVoxels = 0;
+  this->m_NumberOfSampledSlabs = 0;
+  this->m_NumberOfSlabs = 0;
+  this->m_DesignEffect = 1.0;
+  this->m_Mean.m_Value = this->m_Mean.m_Lower = this->m_Mean.m_Upper = 0.0;
+  this->m_Sigma = this->m_Mean;
+} // end Constructor
+
+
+/**
+ * ********************* RandomIndex ****************************
+ */
+
+template< class TInputImage, class TMaskImage >
+SizeValueType
+SampledImageStatisticsCalculator< TInputImage, TMaskImage >
+::RandomIndex( GeneratorType * generator, const SizeValueType n )
+{
+  /** Two 32 bit variates, the bias of the modulo is negligible. */
+  const unsigned long long high = generator->GetIntegerVariate();
+  const unsigned long long low = generator->GetIntegerVariate();
+  return static_cast< SizeValueType >( ( ( high << 32 ) | low ) % n );
+} // end RandomIndex()
+
+
+/**
+ * ********************* Compute ****************************
+ */
+
+template< class TInputImage, class TMaskImage >
+void
+SampledImageStatisticsCalculator< TInputImage, TMaskImage >
+::Compute( const std::vector< RealType > & probabilities )
+{
+  /** Check the inputs. */
+  if( this->m_Input.IsNull() )
+  {
+    itkExceptionMacro( << "The input image is not set." );
+  }
+  if( !( this->m_SampleSize > 0.0 ) )
+  {
+    itkExceptionMacro( << "The sample size should be > 0, not " << this->m_SampleSize << "." );
+  }
+  if( !( this->m_ConfidenceLevel > 0.0 && this->m_ConfidenceLevel < 1.0 ) )
+  {
+    itkExceptionMacro( << "The confidence level should be in (0, 1), not "
+      << this->m_ConfidenceLevel << "." );
+  }
+  for( unsigned int i = 0; i < probabilities.size(); ++i )
+  {
+    if( !( probabilities[ i ] >= 0.0 && probabilities[ i ] <= 1.0 ) )
+    {
+      itkExceptionMacro( << "Invalid probability " << probabilities[ i ]
+        << ", it should be in [0, 1]." );
+    }
+  }
+
+  /** Only the image information is needed to draw the sample. */
+  this->m_Input->UpdateOutputInformation();
+  const RegionType largestRegion = this->m_Input->GetLargestPossibleRegion();
+  if( this->m_Mask.IsNotNull() )
+  {
+    this->m_Mask->UpdateOutputInformation();
+    if( this->m_Mask->GetLargestPossibleRegion() != largestRegion )
+    {
+      itkExceptionMacro( << "The mask should have the same size as the input image." );
+    }
+  }
+
+  /** The number of voxels to sample. */
+  const SizeValueType numberOfVoxels = largestRegion.GetNumberOfPixels();
+  SizeValueType sampleSize = static_cast< SizeValueType >( this->m_SampleSize );
+  if( this->m_SampleSize < 1.0 )
+  {
+    sampleSize = static_cast< SizeValueType >(
+      std::ceil( this->m_SampleSize * static_cast< double >( numberOfVoxels ) ) );
+  }
+  sampleSize = std::min( std::max( sampleSize, static_cast< SizeValueType >( 2 ) ), numberOfVoxels );
+
+  /** Draw the sample. */
+  GeneratorType::Pointer generator = GeneratorType::New();
+  generator->SetSeed( this->m_Seed );
+  this->m_Values.clear();
+  this->m_SlabCounts.clear();
+  this->m_SlabSums.clear();
+  if( this->m_SampleSlabs )
+  {
+    this->SampleSlabs( largestRegion, sampleSize, generator );
+  }
+  else
+  {
+    this->SampleVoxels( largestRegion, sampleSize, generator );
+  }
+
+  if( this->m_Values.size() < 2 )
+  {
+    itkExceptionMacro( << "Only " << this->m_Values.size()
+      << " sampled voxels are inside the mask, increase the sample size." );
+  }
+
+  this->ComputeEstimates( probabilities );
+
+  /** The sample itself is not needed anymore. */
+  std::vector< RealType >().swap( this->m_Values );
+
+  this->Modified();
+
+} // end Compute()
+
+
+/**
+ * ********************* SampleSlabs ****************************
+ */
+
+template< class TInputImage, class TMaskImage >
+void
+SampledImageStatisticsCalculator< TInputImage, TMaskImage >
+::SampleSlabs( const RegionType & largestRegion, const SizeValueType sampleSize,
+  GeneratorType * generator )
+{
+  typedef ImageScanlineConstIterator< InputImageType >  InputIteratorType;
+  typedef ImageScanlineConstIterator< MaskImageType >   MaskIteratorType;
+
+  /** The number of slabs, along the last dimension. */
+  const unsigned int last = ImageDimension - 1;
+  const SizeValueType numberOfSlabs = largestRegion.GetSize( last );
+  const SizeValueType voxelsPerSlab = largestRegion.GetNumberOfPixels() / numberOfSlabs;
+  SizeValueType numberOfSampledSlabs = ( sampleSize + voxelsPerSlab - 1 ) / voxelsPerSlab;
+  numberOfSampledSlabs = std::max( numberOfSampledSlabs,
+    std::min( static_cast< SizeValueType >( 2 ), numberOfSlabs ) );
+  numberOfSampledSlabs = std::min( numberOfSampledSlabs, numberOfSlabs );
+
+  /** Draw the slabs without replacement, by a partial Fisher-Yates shuffle,
+   * and visit them in order, to read the file front to back.
+   */
+  std::vector< SizeValueType > slabs( numberOfSlabs );
+  for( SizeValueType i = 0; i < numberOfSlabs; ++i ) slabs[ i ] = i;
+  for( SizeValueType i = 0; i < numberOfSampledSlabs; ++i )
+  {
+    std::swap( slabs[ i ], slabs[ i + RandomIndex( generator, numberOfSlabs - i ) ] );
+  }
+  slabs.resize( numberOfSampledSlabs );
+  std::sort( slabs.begin(), slabs.end() );
+
+  /** Request the slabs one by one. For a reader with a streaming ImageIO
+   * only this slab is read.
+   */
+  for( SizeValueType i = 0; i < numberOfSampledSlabs; ++i )
+  {
+    RegionType slab = largestRegion;
+    slab.SetIndex( last, largestRegion.GetIndex( last ) + slabs[ i ] );
+    slab.SetSize( last, 1 );
+    this->m_Input->SetRequestedRegion( slab );
+    this->m_Input->Update();
+    this->UpdateMask( slab );
+
+    SizeValueType count = 0;
+    RealType sum = 0.0;
+    InputIteratorType it( this->m_Input, slab );
+    if( this->m_Mask.IsNull() )
+    {
+      while( !it.IsAtEnd() )
+      {
+        while( !it.IsAtEndOfLine() )
+        {
+          const RealType value = GetValue( it.Get() );
+          this->m_Values.push_back( value );
+          sum += value;
+          ++count;
+          ++it;
+        }
+        it.NextLine();
+      }
+    }
+    else
+    {
+      MaskIteratorType itMask( this->m_Mask, slab );
+      while( !it.IsAtEnd() )
+      {
+        while( !it.IsAtEndOfLine() )
+        {
+          if( itMask.Get() )
+          {
+            const RealType value = GetValue( it.Get() );
+            this->m_Values.push_back( value );
+            sum += value;
+            ++count;
+          }
+          ++it;
+          ++itMask;
+        }
+        it.NextLine();
+        itMask.NextLine();
+      }
+    }
+    this->m_SlabCounts.push_back( count );
+    this->m_SlabSums.push_back( sum );
+  }
+
+  this->m_NumberOfSlabs = numberOfSlabs;
+  this->m_NumberOfSampledSlabs = numberOfSampledSlabs;
+
+} // end SampleSlabs()
+
+
+/**
+ * ********************* SampleVoxels ****************************
+ */
+
+template< class TInputImage, class TMaskImage >
+void
+SampledImageStatisticsCalculator< TInputImage, TMaskImage >
+::SampleVoxels( const RegionType & largestRegion, const SizeValueType sampleSize,
+  GeneratorType * generator )
+{
+  this->m_Input->SetRequestedRegion( largestRegion );
+  this->m_Input->Update();
+  this->UpdateMask( largestRegion );
+
+  /** Draw the voxels with replacement, and visit them in memory order. */
+  const SizeValueType numberOfVoxels = largestRegion.GetNumberOfPixels();
+  std::vector< SizeValueType > offsets( sampleSize );
+  for( SizeValueType i = 0; i < sampleSize; ++i )
+  {
+    offsets[ i ] = RandomIndex( generator, numberOfVoxels );
+  }
+  std::sort( offsets.begin(), offsets.end() );
+
+  this->m_Values.reserve( sampleSize );
+  for( SizeValueType i = 0; i < sampleSize; ++i )
+  {
+    IndexType index;
+    SizeValueType rest = offsets[ i ];
+    for( unsigned int d = 0; d < ImageDimension; ++d )
+    {
+      index[ d ] = largestRegion.GetIndex( d ) + static_cast< IndexValueType >( rest % largestRegion.GetSize( d ) );
+      rest /= largestRegion.GetSize( d );
+    }
+    if( this->m_Mask.IsNull() || this->m_Mask->GetPixel( index ) )
+    {
+      this->m_Values.push_back( GetValue( this->m_Input->GetPixel( index ) ) );
+    }
+  }
+
+  this->m_NumberOfSlabs = 0;
+  this->m_NumberOfSampledSlabs = 0;
+
+} // end SampleVoxels()
+
+
+/**
+ * ********************* UpdateMask ****************************
+ */
+
+template< class TInputImage, class TMaskImage >
+void
+SampledImageStatisticsCalculator< TInputImage, TMaskImage >
+::UpdateMask( const RegionType & region )
+{
+  if( this->m_Mask.IsNull() ) return;
+
+  /** A mask without source keeps its buffer, which should contain the region. */
+  this->m_Mask->SetRequestedRegion( region );
+  this->m_Mask->Update();
+  if( !this->m_Mask->GetBufferedRegion().IsInside( region ) )
+  {
+    itkExceptionMacro( << "The mask is not buffered in the sampled region "
+      << region.GetIndex() << region.GetSize() << "." );
+  }
+
+} // end UpdateMask()
+
+
+/**
+ * ********************* ComputeEstimates ****************************
+ */
+
+template< class TInputImage, class TMaskImage >
+void
+SampledImageStatisticsCalculator< TInputImage, TMaskImage >
+::ComputeEstimates( const std::vector< RealType > & probabilities )
+{
+  std::vector< RealType > & values = this->m_Values;
+  const SizeValueType count = values.size();
+  const RealType n = static_cast< RealType >( count );
+  const RealType z = Statistics::GaussianDistribution::InverseCDF(
+    0.5 + 0.5 * this->m_ConfidenceLevel );
+
+  /** Central moments of the sample. */
+  RealType sum = 0.0;
+  for( SizeValueType i = 0; i < count; ++i ) sum += values[ i ];
+  const RealType mean = sum / n;
+  RealType m2 = 0.0;
+  RealType m4 = 0.0;
+  for( SizeValueType i = 0; i < count; ++i )
+  {
+    const RealType d2 = ( values[ i ] - mean ) * ( values[ i ] - mean );
+    m2 += d2;
+    m4 += d2 * d2;
+  }
+  const RealType variance = m2 / ( n - 1.0 );
+  const RealType sigma = std::sqrt( variance );
+
+  /** The variance of the mean. For slabs that of the ratio estimator of a
+   * cluster sample without replacement, relative to independent voxels.
+   * The variance between slabs needs at least two slabs; a single slab is
+   * treated as independent voxels.
+   */
+  const RealType independentVarianceOfMean = variance / n;
+  RealType varianceOfMean = independentVarianceOfMean;
+  this->m_DesignEffect = 1.0;
+  if( this->m_SampleSlabs && this->m_NumberOfSampledSlabs > 1 )
+  {
+    const RealType k = static_cast< RealType >( this->m_NumberOfSampledSlabs );
+    const RealType fpc = 1.0 - k / static_cast< RealType >( this->m_NumberOfSlabs );
+    const RealType meanCount = n / k;
+    RealType residuals = 0.0;
+    for( SizeValueType i = 0; i < this->m_SlabCounts.size(); ++i )
+    {
+      const RealType r = this->m_SlabSums[ i ]
+        - mean * static_cast< RealType >( this->m_SlabCounts[ i ] );
+      residuals += r * r;
+    }
+    varianceOfMean = fpc * residuals / ( k - 1.0 ) / ( k * meanCount * meanCount );
+    this->m_DesignEffect = independentVarianceOfMean > 0.0
+      ? varianceOfMean / independentVarianceOfMean : 1.0;
+  }
+
+  this->m_NumberOfSampledVoxels = count;
+  const RealType halfWidthMean = z * std::sqrt( varianceOfMean );
+  this->m_Mean.m_Value = mean;
+  this->m_Mean.m_Lower = mean - halfWidthMean;
+  this->m_Mean.m_Upper = mean + halfWidthMean;
+
+  /** The standard error of sigma, from that of the variance, which
+   * depends on the fourth central moment.
+   */
+  const RealType varianceOfVariance = std::max( 0.0,
+    ( m4 / n - variance * variance * ( n - 3.0 ) / ( n - 1.0 ) ) / n ) * this->m_DesignEffect;
+  const RealType halfWidthSigma = sigma > 0.0
+    ? z * std::sqrt( varianceOfVariance ) / ( 2.0 * sigma ) : 0.0;
+  this->m_Sigma.m_Value = sigma;
+  this->m_Sigma.m_Lower = std::max( 0.0, sigma - halfWidthSigma );
+  this->m_Sigma.m_Upper = sigma + halfWidthSigma;
+
+  /** The quantiles, interpolated between ranks, and their intervals from
+   * the ranks n p -/+ z sqrt( n p ( 1 - p ) ).
+   */
+  std::sort( values.begin(), values.end() );
+  this->m_Quantiles.resize( probabilities.size() );
+  for( unsigned int i = 0; i < probabilities.size(); ++i )
+  {
+    const RealType p = probabilities[ i ];
+    const RealType h = p * ( n - 1.0 );
+    const SizeValueType lower = static_cast< SizeValueType >( std::floor( h ) );
+    const SizeValueType upper = std::min( lower + 1, count - 1 );
+    const RealType halfWidthRank = z * std::sqrt( n * p * ( 1.0 - p ) * this->m_DesignEffect );
+
+    EstimateType & quantile = this->m_Quantiles[ i ];
+    quantile.m_Value = values[ lower ] + ( h - std::floor( h ) ) * ( values[ upper ] - values[ lower ] );
+    quantile.m_Lower = values[ static_cast< SizeValueType >(
+      std::max( 0.0, std::floor( h - halfWidthRank ) ) ) ];
+    quantile.m_Upper = values[ static_cast< SizeValueType >(
+      std::min( n - 1.0, std::ceil( h + halfWidthRank ) ) ) ];
+  }
+
+} // end ComputeEstimates()
+
+
+/**
+ * ********************* PrintSelf ****************************
+ */
+
+template< class TInputImage, class TMaskImage >
+void
+SampledImageStatisticsCalculator< TInputImage, TMaskImage >
+::PrintSelf( std::ostream & os, Indent indent ) const
+{
+  Superclass::PrintSelf( os, indent );
+
+  os << indent << "SampleSize: " << this->m_SampleSize << std::endl;
+  os << indent << "Seed: " << this->m_Seed << std::endl;
+  os << indent << "SampleSlabs: " << this->m_SampleSlabs << std::endl;
+  os << indent << "ConfidenceLevel: " << this->m_ConfidenceLevel << std::endl;
+  os << indent << "NumberOfSampledVoxels: " << this->m_NumberOfSampledVoxels << std::endl;
+
+} // end PrintSelf()
+
+} // end namespace itk
+
+#endif // end #ifndef _itkSampledImageStatisticsCalculator_hxx_
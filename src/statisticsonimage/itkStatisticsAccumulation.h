@@ -0,0 +1,126 @@
+/*=========================================================================
+*
+* Copyright Marius Staring, Stefan Klein, David Doria. 2011.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0.txt
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*=========================================================================*/
+#ifndef __itkStatisticsAccumulation_h_
+#define __itkStatisticsAccumulation_h_
+
+#include "itkImageRegion.h"
+#include "itkImageRegionSplitterSlowDimension.h"
+#include "itkIntTypes.h"
+#include "itkMultiThreaderBase.h"
+
+#include <algorithm>
+#include <vector>
+
+
+namespace itk
+{
+
+/** Run an accumulator over a region of an image in parallel, the shared part
+ * of the statistics calculators. The region is split in a fixed chunk per
+ * work unit. Each chunk gets a copy of the initial accumulator, which
+ * visitRegion( chunk, copy ) fills. After the parallel loop the copies are
+ * merged into the accumulator with its Merge(), in the order of the chunks
+ * and not in the order in which the threads finish, so that the result is
+ * reproducible for a given number of work units.
+ * A numberOfWorkUnits of 0 uses the global default.
+ */
+template< unsigned int VDimension, class TAccumulator, class TVisitRegion >
+void AccumulateInParallel( const ImageRegion< VDimension > & region,
+  const unsigned int numberOfWorkUnits, TVisitRegion visitRegion,
+  TAccumulator & accumulator )
+{
+  MultiThreaderBase::Pointer threader = MultiThreaderBase::New();
+  if( numberOfWorkUnits > 0 )
+  {
+    threader->SetNumberOfWorkUnits( numberOfWorkUnits );
+  }
+
+  /** Split the region in fixed chunks, one per work unit. */
+  ImageRegionSplitterSlowDimension::Pointer splitter
+    = ImageRegionSplitterSlowDimension::New();
+  const unsigned int numberOfChunks
+    = splitter->GetNumberOfSplits( region, threader->GetNumberOfWorkUnits() );
+  std::vector< ImageRegion< VDimension > > chunks( numberOfChunks, region );
+  for( unsigned int c = 0; c < numberOfChunks; ++c )
+  {
+    splitter->GetSplit( c, numberOfChunks, chunks[ c ] );
+  }
+
+  /** Accumulate each chunk in its own slot. */
+  std::vector< TAccumulator > slots( numberOfChunks, accumulator );
+  threader->ParallelizeArray( 0, numberOfChunks,
+    [&visitRegion, &chunks, &slots]( SizeValueType c )
+    {
+      visitRegion( chunks[ c ], slots[ c ] );
+    }, nullptr );
+
+  /** Merge the slots, in the order of the chunks. */
+  for( unsigned int c = 0; c < numberOfChunks; ++c )
+  {
+    accumulator.Merge( slots[ c ] );
+  }
+
+} // end AccumulateInParallel()
+
+
+/** \class RunningMoments
+ * The count, the mean and the sum of squared deviations from the mean (M2)
+ * of a series of values. Values are added with Welford's update, and two
+ * series are merged with the pairwise update of Chan et al. Unlike the sum
+ * of squares minus the squared sum, this stays accurate when the mean is
+ * large compared to the spread, e.g. for CT images stored in float.
+ */
+struct RunningMoments
+{
+  RunningMoments() : m_Count( 0 ), m_Mean( 0.0 ), m_M2( 0.0 ) {}
+
+  void Add( const double value )
+  {
+    ++this->m_Count;
+    const double delta = value - this->m_Mean;
+    this->m_Mean += delta / static_cast< double >( this->m_Count );
+    this->m_M2 += delta * ( value - this->m_Mean );
+  }
+
+  void Merge( const RunningMoments & other )
+  {
+    if( other.m_Count == 0 ) return;
+    const SizeValueType total = this->m_Count + other.m_Count;
+    const double delta = other.m_Mean - this->m_Mean;
+    const double fraction = static_cast< double >( other.m_Count ) / static_cast< double >( total );
+    this->m_M2 += other.m_M2 + delta * delta * static_cast< double >( this->m_Count ) * fraction;
+    this->m_Mean += delta * fraction;
+    this->m_Count = total;
+  }
+
+  /** The unbiased variance, as the itk::StatisticsImageFilter, and 0 for
+   * less than two values. */
+  double GetVariance( void ) const
+  {
+    if( this->m_Count < 2 ) return 0.0;
+    return std::max( 0.0, this->m_M2 / static_cast< double >( this->m_Count - 1 ) );
+  }
+
+  SizeValueType m_Count;
+  double        m_Mean;
+  double        m_M2;
+};
+
+} // end namespace itk
+
+#endif // end #ifndef __itkStatisticsAccumulation_h_
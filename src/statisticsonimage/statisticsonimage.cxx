@@ -19,7 +19,8 @@
  \brief Compute statistics on an image. For vector images, the magnitude is used.
 
  This program determines the minimum, maximum,
- mean, sigma, variance, and sum of an image, or its magnitude/jacobian.
+ mean, sigma, variance, and sum of an image, or its magnitude/jacobian,
+ optionally for all labels of a label image at once.
  \verbinclude statisticsonimage.help
  */
 
@@ -48,12 +49,30 @@ std::string GetHelpString( void )
     << "  [-mask]  MaskFileName, mask should have the same size as the input image\n"
     << "           and be of pixeltype (convertable to) unsigned char,\n"
     << "           1 = within mask, 0 = outside mask;\n"
+    << "  [-labels] LabelFileName, label image of the same size as the input image\n"
+    << "           and of an integer pixeltype; the statistics of all labels are\n"
+    << "           computed at once and written as comma separated values,\n"
+    << "           one line per label; the histograms of all labels are only computed\n"
+    << "           with \"-s histogram\" or -out, and written to -out;\n"
+    << "           can not be combined with -mask and -exact.\n"
+    << "  [-csv]   outputFileName for the label statistics; default: to the screen.\n"
+    << "  [-sample] estimate the mean, stdev, median, quartiles and percentiles\n"
+    << "           with 95% confidence intervals from a random sample:\n"
+    << "           a fraction of the voxels if < 1, a number of voxels otherwise;\n"
+    << "           if the file format can stream, random slices of the image and the mask\n"
+    << "           are read and nothing else, otherwise the complete image is read\n"
+    << "           into memory and random voxels are drawn;\n"
+    << "           can not be combined with -labels, -exact, -out and -s.\n"
+    << "  [-seed]  the seed of the random sample, default 0.\n"
     << "  [-b]     NumberOfBins to use for histogram, default: 100;\n"
     << "           for an accurate estimate of median and quartiles\n"
     << "           for integer images, choose the number of bins\n"
-    << "           much larger (~100x) than the number of gray values.\n"
+    << "           much larger (~100x) than the number of gray values, or use -exact.\n"
     << "           if equal 0, then the intensity range (max - min) is chosen.\n"
     << "  [-s]     select which to compute {arithmetic, geometric, histogram}, default all;\n"
+    << "  [-exact] compute the exact median, quartiles and percentiles, independent\n"
+    << "           of the number of bins, in a few extra passes over the image;\n"
+    << "           the histogram is then only computed for -out.\n"
     << "Supported: 2D, 3D, 4D, float, (unsigned) short, (unsigned) char, 1, 2 or 3 components per pixel.\n"
     << "For 4D, only 1 or 4 components per pixel are supported.";
 
@@ -93,6 +112,12 @@ int main( int argc, char ** argv )
   std::string maskFileName = "";
   parser->GetCommandLineArgument( "-mask", maskFileName );
 
+  std::string labelFileName = "";
+  parser->GetCommandLineArgument( "-labels", labelFileName );
+
+  std::string csvOutputFileName = "";
+  parser->GetCommandLineArgument( "-csv", csvOutputFileName );
+
   std::string histogramOutputFileName = "";
   parser->GetCommandLineArgument( "-out", histogramOutputFileName );
 
@@ -102,6 +127,14 @@ int main( int argc, char ** argv )
   std::string select = "";
   bool rets = parser->GetCommandLineArgument( "-s", select );
 
+  const bool exactQuantiles = parser->ArgumentExists( "-exact" );
+
+  double sampleSize = 0.0;
+  const bool retsample = parser->GetCommandLineArgument( "-sample", sampleSize );
+
+  unsigned int seed = 0;
+  parser->GetCommandLineArgument( "-seed", seed );
+
   /** Check selection. */
   if( rets && ( select != "arithmetic" && select != "geometric"
     && select != "histogram" ) )
@@ -111,6 +144,33 @@ int main( int argc, char ** argv )
     return EXIT_FAILURE;
   }
 
+  /** Check label options. */
+  if( labelFileName != "" && ( maskFileName != "" || exactQuantiles ) )
+  {
+    std::cerr << "ERROR: -labels can not be combined with -mask or -exact."
+      << std::endl;
+    return EXIT_FAILURE;
+  }
+  if( labelFileName == "" && csvOutputFileName != "" )
+  {
+    std::cerr << "ERROR: -csv requires -labels." << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  /** Check sample options. */
+  if( retsample && !( sampleSize > 0.0 ) )
+  {
+    std::cerr << "ERROR: -sample should be > 0." << std::endl;
+    return EXIT_FAILURE;
+  }
+  if( retsample && ( labelFileName != "" || exactQuantiles
+    || histogramOutputFileName != "" || rets ) )
+  {
+    std::cerr << "ERROR: -sample can not be combined with -labels, -exact, -out or -s."
+      << std::endl;
+    return EXIT_FAILURE;
+  }
+
   /** Determine image properties. */
   itk::IOPixelEnum pixelType = itk::IOPixelEnum::UNKNOWNPIXELTYPE;
   itk::ImageIOBase::IOComponentEnum componentType = itk::IOComponentEnum::UNKNOWNCOMPONENTTYPE;
@@ -155,9 +215,14 @@ int main( int argc, char ** argv )
     /** Set the filter arguments. */
     filter->m_InputFileName = inputFileName;
     filter->m_MaskFileName = maskFileName;
+    filter->m_LabelFileName = labelFileName;
     filter->m_HistogramOutputFileName = histogramOutputFileName;
+    filter->m_CSVOutputFileName = csvOutputFileName;
     filter->m_NumberOfBins = numberOfBins;
     filter->m_Select = select;
+    filter->m_ExactQuantiles = exactQuantiles;
+    filter->m_SampleSize = sampleSize;
+    filter->m_Seed = seed;
 
     filter->Run();
 
@@ -20,9 +20,11 @@
 
 #include "ITKToolsBase.h"
 
-#include "itkImageToImageFilter.h"
-#include "itkStatisticsImageFilterWithMask.h"
-#include "itkScalarImageToHistogramGenerator2.h"
+#include "itkImage.h"
+#include "itkVector.h"
+#include "itkImageStatisticsAndHistogramCalculator.h"
+#include "itkLabelStatisticsCalculator.h"
+#include "itkSampledImageStatisticsCalculator.h"
 
 
 /** \class ITKToolsStatisticsOnImageBase
@@ -39,9 +41,14 @@ public:
   {
     this->m_InputFileName = "";
     this->m_MaskFileName = "";
+    this->m_LabelFileName = "";
     this->m_HistogramOutputFileName = "";
+    this->m_CSVOutputFileName = "";
     this->m_NumberOfBins = 0;
     this->m_Select = "";
+    this->m_ExactQuantiles = false;
+    this->m_SampleSize = 0.0;
+    this->m_Seed = 0;
   };
   /** Destructor. */
   ~ITKToolsStatisticsOnImageBase(){};
@@ -49,9 +56,14 @@ public:
   /** Input member parameters. */
   std::string m_InputFileName;
   std::string m_MaskFileName;
+  std::string m_LabelFileName;
   std::string m_HistogramOutputFileName;
+  std::string m_CSVOutputFileName;
   unsigned int m_NumberOfBins;
   std::string m_Select;
+  bool m_ExactQuantiles;
+  double m_SampleSize;
+  unsigned int m_Seed;
 
 }; // end class StatisticsOnImageBase
 
@@ -85,25 +97,32 @@ public:
   /** Typedefs */
   typedef double                                      InternalPixelType;
   typedef itk::Image<InternalPixelType, VDimension>   InternalImageType;
-  typedef itk::ImageToImageFilter<
-    InternalImageType, InternalImageType>             BaseFilterType;
-  typedef itk::StatisticsImageFilter<
-    InternalImageType >                               StatisticsFilterType;
-  typedef itk::Statistics::ScalarImageToHistogramGenerator2<
-    InternalImageType >                               HistogramGeneratorType;
+  typedef itk::Vector<TComponentType, VNumberOfComponents> VectorPixelType;
+  typedef itk::Image<VectorPixelType, VDimension>     VectorImageType;
+  typedef itk::Image<unsigned char, VDimension>       MaskImageType;
+  typedef itk::Image<int, VDimension>                 LabelImageType;
 
   /** Run function. */
   void Run( void );
 
-  /** Helper function. */
+  /** Helper function, for scalar and vector images. */
+  template< class TImage >
   void ComputeStatistics(
-    InternalImageType * inputImage,
-    BaseFilterType * maskerOrCopier,
-    StatisticsFilterType * statistics,
-    HistogramGeneratorType * histogramGenerator,
-    unsigned int numberOfBins, // Type is defined in ScalarImageToHistogramGenerator2
-    const std::string & histogramOutputFileName,
-    const std::string & select );
+    const TImage * inputImage,
+    const MaskImageType * mask );
+
+  /** Helper function, the statistics of all labels, for scalar and vector images. */
+  template< class TImage >
+  void ComputeLabelStatistics(
+    const TImage * inputImage,
+    const LabelImageType * labels );
+
+  /** Helper function, estimates from a sample of the image of a reader,
+   * within the optional mask, which is read slab by slab as well. */
+  template< class TReader >
+  void ComputeSampledStatistics(
+    TReader * reader,
+    MaskImageType * mask );
 
   /** Helper function. */
   void DetermineHistogramMaximum(
@@ -19,10 +19,6 @@
 #define __statisticsonimage_hxx_
 
 #include "itkImageFileReader.h"
-#include "itkCastImageFilter.h"
-#include "itkVectorMagnitudeImageFilter.h"
-#include "itkMaskImageFilter.h"
-#include "itkLogImageFilter.h"
 
 #include "statisticsprinters.h"
 
@@ -37,60 +33,34 @@ ITKToolsStatisticsOnImage< VDimension, VNumberOfComponents, TComponentType >
 ::Run( void )
 {
   /** Typedefs. */
-  typedef TComponentType ScalarPixelType;
-
-  typedef unsigned char MaskPixelType;
-  typedef itk::Vector<TComponentType, VNumberOfComponents>  VectorPixelType;
-  typedef itk::Image<ScalarPixelType, VDimension>     ScalarImageType;
-  typedef itk::Image<VectorPixelType, VDimension>     VectorImageType;
-  typedef itk::Image<MaskPixelType, VDimension>       MaskImageType;
-
-  typedef itk::ImageFileReader< ScalarImageType >     ScalarReaderType;
   typedef itk::ImageFileReader< InternalImageType >   InternalScalarReaderType;
   typedef itk::ImageFileReader< VectorImageType >     VectorReaderType;
   typedef itk::ImageFileReader< MaskImageType >       MaskReaderType;
-  typedef itk::CastImageFilter<
-    InternalImageType, InternalImageType>             CopierType;
-  typedef itk::VectorMagnitudeImageFilter<
-    VectorImageType, InternalImageType >              MagnitudeFilterType;
-
-  typedef itk::MaskImageFilter< InternalImageType,
-    MaskImageType, InternalImageType >                MaskerType;
-  typedef typename
-    HistogramGeneratorType::HistogramType             HistogramType;
+  typedef itk::ImageFileReader< LabelImageType >      LabelReaderType;
 
-  /** Create StatisticsFilter. */
-  typename StatisticsFilterType::Pointer statistics
-    = StatisticsFilterType::New();
-
-  /** Read mask */
+  /** Read mask. It is applied while computing, no masked copy is made.
+   * For a sample only the sampled slabs of the mask are read.
+   */
   typename MaskReaderType::Pointer maskReader;
-  typename BaseFilterType::Pointer maskerOrCopier
-    = (CopierType::New()).GetPointer();
+  MaskImageType * mask = nullptr;
   if( this->m_MaskFileName != "" )
   {
-    /** Read mask */
     maskReader = MaskReaderType::New();
     maskReader->SetFileName( this->m_MaskFileName.c_str() );
-    maskReader->Update();
-
-    /** Set mask. */
-    statistics->SetMask( maskReader->GetOutput() );
-
-    /** Prepare filter that applies masking to an image by
-    * replacing all pixels that fall outside the mask by
-    * -infinity. Needed for histogram.
-    */
-    typename MaskerType::Pointer maskFilter = MaskerType::New();
-    maskFilter->SetInput2( maskReader->GetOutput() );
-    maskFilter->SetOutsideValue(
-      itk::NumericTraits<InternalPixelType>::NonpositiveMin() );
-    maskerOrCopier = maskFilter.GetPointer();
+    if( !( this->m_SampleSize > 0.0 ) ) maskReader->Update();
+    mask = maskReader->GetOutput();
   }
 
-  /** Create histogram generator. */
-  typename HistogramGeneratorType::Pointer histogramGenerator
-    = HistogramGeneratorType::New();
+  /** Read the label image. */
+  typename LabelReaderType::Pointer labelReader;
+  const LabelImageType * labels = nullptr;
+  if( this->m_LabelFileName != "" )
+  {
+    labelReader = LabelReaderType::New();
+    labelReader->SetFileName( this->m_LabelFileName.c_str() );
+    labelReader->Update();
+    labels = labelReader->GetOutput();
+  }
 
   /** For scalar images. */
   if( VNumberOfComponents == 1 )
@@ -100,17 +70,16 @@ ITKToolsStatisticsOnImage< VDimension, VNumberOfComponents, TComponentType >
     typename InternalScalarReaderType::Pointer reader
       = InternalScalarReaderType::New();
     reader->SetFileName( this->m_InputFileName.c_str() );
+    if( this->m_SampleSize > 0.0 )
+    {
+      this->ComputeSampledStatistics( reader.GetPointer(), mask );
+      return;
+    }
     reader->Update();
 
     /** Call the generic ComputeStatistics function. */
-    this->ComputeStatistics(
-      reader->GetOutput(),
-      maskerOrCopier,
-      statistics,
-      histogramGenerator,
-      this->m_NumberOfBins,
-      this->m_HistogramOutputFileName,
-      this->m_Select );
+    if( labels ) this->ComputeLabelStatistics( reader->GetOutput(), labels );
+    else this->ComputeStatistics( reader->GetOutput(), mask );
 
   } // end scalar images
   /** For vector images. */
@@ -120,21 +89,18 @@ ITKToolsStatisticsOnImage< VDimension, VNumberOfComponents, TComponentType >
 
     typename VectorReaderType::Pointer reader = VectorReaderType::New();
     reader->SetFileName( this->m_InputFileName.c_str() );
+    if( this->m_SampleSize > 0.0 )
+    {
+      this->ComputeSampledStatistics( reader.GetPointer(), mask );
+      return;
+    }
+    reader->Update();
 
-    typename MagnitudeFilterType::Pointer magnitudeFilter = MagnitudeFilterType::New();
-    magnitudeFilter->SetInput( reader->GetOutput() );
-    std::cout << "Computing magnitude image ..." << std::endl;
-    magnitudeFilter->Update();
-
-    /** Call the generic ComputeStatistics function */
-    this->ComputeStatistics(
-      magnitudeFilter->GetOutput(),
-      maskerOrCopier,
-      statistics,
-      histogramGenerator,
-      this->m_NumberOfBins,
-      this->m_HistogramOutputFileName,
-      this->m_Select );
+    /** Call the generic ComputeStatistics function. The magnitude is
+     * computed on the fly.
+     */
+    if( labels ) this->ComputeLabelStatistics( reader->GetOutput(), labels );
+    else this->ComputeStatistics( reader->GetOutput(), mask );
 
   } // end vector images
 } // end Run()
@@ -143,113 +109,202 @@ ITKToolsStatisticsOnImage< VDimension, VNumberOfComponents, TComponentType >
 /**
  * ************************ ComputeStatistics **************************
  *
- * Generic template function that computes statistics on an input image
- * Assumes that the number of histogram bins and the marginal scale are set
- * in the histogramGenerator, that the maskerOrCopier has been initialized
- * to a (dummy) caster or to a MaskFilterType with mask set, and that the
- * statistics filter has been initialized.
- *
- * This function is only to be used by the StatisticsOnImage function.
- * It is quite specific and not really well over thought. Introduced to avoid
- * duplication of code.
+ * Generic template function that computes statistics on an input image,
+ * scalar or vector, within an optional mask. The arithmetic and geometric
+ * statistics are computed in a single multi-threaded pass over the image,
+ * the histogram in a second pass, as its range depends on the first.
  */
 
 template< unsigned int VDimension, unsigned int VNumberOfComponents, class TComponentType >
+template< class TImage >
 void
 ITKToolsStatisticsOnImage< VDimension, VNumberOfComponents, TComponentType >
 ::ComputeStatistics(
-  InternalImageType * inputImage,
-  BaseFilterType * maskerOrCopier,
-  StatisticsFilterType * statistics,
-  HistogramGeneratorType * histogramGenerator,
-  unsigned int numberOfBins, // Type is defined in ScalarImageToHistogramGenerator2
-  const std::string & histogramOutputFileName,
-  const std::string & select )
+  const TImage * inputImage,
+  const MaskImageType * mask )
 {
-  typedef typename
-    HistogramGeneratorType::HistogramType             HistogramType;
-  typedef typename HistogramGeneratorType::RealPixelType   RealPixelType;
-  typedef typename StatisticsFilterType::PixelType    PixelType;
-  typedef InternalImageType                           InputImageType;
-  typedef itk::LogImageFilter<
-    InputImageType, InputImageType>                   LogFilterType;
+  typedef itk::ImageStatisticsAndHistogramCalculator<
+    TImage, MaskImageType >                           CalculatorType;
+  typedef typename CalculatorType::HistogramType      HistogramType;
 
-  /** Arithmetic mean */
-  PixelType maxPixelValue = 1;
-  PixelType minPixelValue = 0;
-  if( select == "arithmetic" || select == "" || select == "histogram" )
-  {
-    std::cout << "Computing arithmetic statistics ..." << std::endl;
+  const std::string & select = this->m_Select;
+  unsigned int numberOfBins = this->m_NumberOfBins;
 
-    statistics->SetInput( inputImage );
-    statistics->Update();
+  /** Arithmetic and geometric statistics, in one pass. */
+  std::cout << "Computing statistics ..." << std::endl;
+  typename CalculatorType::Pointer calculator = CalculatorType::New();
+  calculator->SetInput( inputImage );
+  calculator->SetMask( mask );
+  calculator->SetComputeGeometricStatistics( select == "geometric" || select == "" );
+  calculator->Compute();
 
-    /** Only print if not histogram selected. */
-    if( select != "histogram" )
-    {
-      PrintStatistics<StatisticsFilterType>( statistics );
-    }
+  /** Arithmetic mean */
+  if( select == "arithmetic" || select == "" )
+  {
+    PrintStatistics<CalculatorType>( calculator );
     if( select == "arithmetic" ) return;
-
-    /** Save for later use for the histogram bin size. */
-    maxPixelValue = statistics->GetMaximum();
-    minPixelValue = statistics->GetMinimum();
   }
 
   /** Geometric mean/std: */
   if( select == "geometric" || select == "" )
   {
-    std::cout << "Computing geometric statistics ..." << std::endl;
-
-    typename LogFilterType::Pointer logger = LogFilterType::New();
-    logger->SetInput( inputImage );
-    statistics->SetInput( logger->GetOutput() );
-    statistics->Update();
+    PrintGeometricStatistics<CalculatorType>( calculator );
+    if( select == "geometric" ) return;
+  }
 
-    PrintGeometricStatistics<StatisticsFilterType>( statistics );
+  /** Exact quantiles, selected from the values in a few passes. */
+  if( this->m_ExactQuantiles )
+  {
+    std::cout << "Computing exact quantiles ..." << std::endl;
+    PrintExactQuantiles<CalculatorType>( calculator,
+      calculator->ComputeExactQuantiles( GetQuantileProbabilities() ) );
 
-    if( select == "geometric" ) return;
+    /** The histogram is only needed for the output file. */
+    if( this->m_HistogramOutputFileName == "" ) return;
   }
 
   /** Histogram statistics. */
-  if( select == "histogram" || select == "" )
+  const InternalPixelType maxPixelValue = calculator->GetMaximum();
+  const InternalPixelType minPixelValue = calculator->GetMinimum();
+
+  /** If the user specified 0, the number of bins is equal to the intensity range. */
+  if( numberOfBins == 0 )
+  {
+    numberOfBins = static_cast<unsigned int>( maxPixelValue - minPixelValue );
+  }
+
+  /** Determine histogram maximum. */
+  InternalPixelType histogramMax;
+  this->DetermineHistogramMaximum( maxPixelValue, minPixelValue, numberOfBins, histogramMax );
+
+  /** Computing histogram statistics. */
+  std::cout << "Computing histogram statistics ..." << std::endl;
+  calculator->ComputeHistogram( numberOfBins, minPixelValue, histogramMax );
+
+  if( this->m_ExactQuantiles )
   {
-    /** Prepare for the histogram. */
-    maskerOrCopier->SetInput( inputImage );
-    std::string maskerOrCopierName = maskerOrCopier->GetNameOfClass();
-    if( maskerOrCopierName == "MaskImageFilter" )
+    WriteHistogram<HistogramType>(
+      calculator->GetHistogram(), this->m_HistogramOutputFileName );
+  }
+  else
+  {
+    PrintHistogramStatistics<HistogramType>(
+      calculator->GetHistogram(), this->m_HistogramOutputFileName );
+  }
+
+} // end ComputeStatistics()
+
+
+/**
+ * ************************ ComputeLabelStatistics **************************
+ *
+ * Generic template function that computes the statistics of all labels of
+ * a label image at once, in a single multi-threaded pass over the image.
+ * The histograms of all labels cost a second pass, and memory for the bins
+ * of every label, so they are only computed with "-s histogram" or -out.
+ * The results are written as comma separated values, one line per label.
+ */
+
+template< unsigned int VDimension, unsigned int VNumberOfComponents, class TComponentType >
+template< class TImage >
+void
+ITKToolsStatisticsOnImage< VDimension, VNumberOfComponents, TComponentType >
+::ComputeLabelStatistics(
+  const TImage * inputImage,
+  const LabelImageType * labels )
+{
+  typedef itk::LabelStatisticsCalculator<
+    TImage, LabelImageType >                          CalculatorType;
+
+  const std::string & select = this->m_Select;
+  const bool arithmetic = select == "arithmetic" || select == "";
+  const bool geometric = select == "geometric" || select == "";
+  const bool histogram = select == "histogram" || this->m_HistogramOutputFileName != "";
+
+  /** Arithmetic and geometric statistics of all labels, in one pass. */
+  std::cout << "Computing label statistics ..." << std::endl;
+  typename CalculatorType::Pointer calculator = CalculatorType::New();
+  calculator->SetInput( inputImage );
+  calculator->SetLabelImage( labels );
+  calculator->SetComputeGeometricStatistics( geometric );
+  calculator->Compute();
+  const unsigned int numberOfLabels = calculator->GetNumberOfLabels();
+  std::cout << "\tnumber of labels: " << numberOfLabels << std::endl;
+
+  /** Histograms of all labels, each over its own range, in one pass. */
+  if( histogram )
+  {
+    std::vector<unsigned int> numberOfBins( numberOfLabels, this->m_NumberOfBins );
+    std::vector<double> minima( numberOfLabels );
+    std::vector<double> maxima( numberOfLabels );
+    for( unsigned int i = 0; i < numberOfLabels; ++i )
     {
-      std::cout << "Replacing all pixels outside the mask by -infinity,\n  ";
-      std::cout << "to make sure they are not included in the histogram ..."
-        << std::endl;
+      minima[ i ] = calculator->GetMinimum( i );
+
+      /** If the user specified 0, the number of bins is equal to the intensity range. */
+      if( numberOfBins[ i ] == 0 )
+      {
+        numberOfBins[ i ] = std::max( 1u, static_cast<unsigned int>(
+          calculator->GetMaximum( i ) - calculator->GetMinimum( i ) ) );
+      }
+      this->DetermineHistogramMaximum( calculator->GetMaximum( i ),
+        calculator->GetMinimum( i ), numberOfBins[ i ], maxima[ i ] );
     }
-    maskerOrCopier->Update();
 
-    /** If the user specified 0, the number of bins is equal to the intensity range. */
-    if( numberOfBins == 0 )
+    std::cout << "Computing label histograms ..." << std::endl;
+    calculator->ComputeHistograms( numberOfBins, minima, maxima );
+
+    if( this->m_HistogramOutputFileName != "" )
     {
-      numberOfBins = static_cast<unsigned int>( maxPixelValue - minPixelValue );
+      WriteLabelHistograms<CalculatorType>(
+        calculator, this->m_HistogramOutputFileName );
     }
+  }
 
-    /** Determine histogram maximum. */
-    PixelType histogramMax;
-    this->DetermineHistogramMaximum( maxPixelValue, minPixelValue, numberOfBins, histogramMax );
+  WriteLabelStatistics<CalculatorType>(
+    calculator, arithmetic, geometric, histogram, this->m_CSVOutputFileName );
 
-    /** Computing histogram statistics. */
-    std::cout << "Computing histogram statistics ..." << std::endl;
+} // end ComputeLabelStatistics()
 
-    histogramGenerator->SetAutoMinMax( false );
-    histogramGenerator->SetNumberOfBins( numberOfBins );
-    histogramGenerator->SetHistogramMin( static_cast<RealPixelType>( minPixelValue ) );
-    histogramGenerator->SetHistogramMax( histogramMax );
-    histogramGenerator->SetInput( maskerOrCopier->GetOutput() );
-    histogramGenerator->Compute();
 
-    PrintHistogramStatistics<HistogramType>(
-      histogramGenerator->GetOutput(), histogramOutputFileName );
-  }
+/**
+ * ************************ ComputeSampledStatistics **************************
+ *
+ * Estimates the mean, sigma and quantiles from a reproducible random sample,
+ * with confidence intervals. If the ImageIO can stream, random slabs are
+ * read, and nothing else of the image; otherwise the ImageIO reads the
+ * complete image anyway, and random voxels are drawn from it.
+ */
 
-} // end ComputeStatistics()
+template< unsigned int VDimension, unsigned int VNumberOfComponents, class TComponentType >
+template< class TReader >
+void
+ITKToolsStatisticsOnImage< VDimension, VNumberOfComponents, TComponentType >
+::ComputeSampledStatistics(
+  TReader * reader,
+  MaskImageType * mask )
+{
+  typedef itk::SampledImageStatisticsCalculator<
+    typename TReader::OutputImageType, MaskImageType >  CalculatorType;
+
+  reader->UpdateOutputInformation();
+  const bool sampleSlabs = reader->GetImageIO()->CanStreamRead();
+
+  std::cout << "Estimating statistics from a sample of "
+    << ( sampleSlabs ? "slabs" : "voxels" ) << " ..." << std::endl;
+  typename CalculatorType::Pointer calculator = CalculatorType::New();
+  calculator->SetInput( reader->GetOutput() );
+  calculator->SetMask( mask );
+  calculator->SetSampleSize( this->m_SampleSize );
+  calculator->SetSeed( this->m_Seed );
+  calculator->SetSampleSlabs( sampleSlabs );
+
+  /** The same quantiles as the histogram statistics. */
+  calculator->Compute( GetQuantileProbabilities() );
+
+  PrintSampledStatistics<CalculatorType>( calculator );
+
+} // end ComputeSampledStatistics()
 
 
 /**
@@ -309,9 +364,9 @@ ITKToolsStatisticsOnImage< VDimension, VNumberOfComponents, TComponentType >
   if( histogramMax <= maxPixelValue )
   {
     /** Overflow occurred; maximum was already maximum of pixeltype;
-     * We could solve this somehow (by adding a ClipBinsAtUpperBound(bool)
-     * function to the itkScalarImageToHistogramGenerator2, and calling it
-     * with argument 'false'), but the situation is quite unlikely; anyway,
+     * We could solve this somehow (by not clipping the upper bin in
+     * ImageStatisticsAndHistogramCalculator::ComputeHistogram()),
+     * but the situation is quite unlikely; anyway,
      * mostly something is going wrong when a float image has value
      * infinity somewhere.
      */
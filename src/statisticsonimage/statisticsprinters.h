@@ -21,11 +21,12 @@
 
 #include <fstream>
 #include <iomanip>
+#include <vector>
 
-/** this file defines three function that print statistics information */
+/** this file defines the functions that print statistics information */
 
 /**
- * Print the results of an itk::StatisticsImageFilter
+ * Print the arithmetic statistics of an itk::ImageStatisticsAndHistogramCalculator
  */
 
 template<class TStatisticsFilter>
@@ -45,9 +46,8 @@ void PrintStatistics( const TStatisticsFilter * statistics )
 
 
 /**
- * Print the results of an itk::StatisticsImageFilter
- * Assume that statistics were calculated on the log
- * of the actual image. exp gives the Geometric mean.
+ * Print the geometric statistics of an itk::ImageStatisticsAndHistogramCalculator,
+ * the exponent of the mean and sigma of the log of the image.
  */
 
 template<class TStatisticsFilter>
@@ -55,8 +55,8 @@ void PrintGeometricStatistics( const TStatisticsFilter * statistics )
 {
   /** Print to screen. */
   std::cout << std::setprecision(10);
-  double geometricmean = std::exp( statistics->GetMean() );
-  double geometricstdev = std::exp( statistics->GetSigma() );
+  double geometricmean = statistics->GetGeometricMean();
+  double geometricstdev = statistics->GetGeometricSigma();
   std::cout << "\tgeometric mean : " << geometricmean << std::endl;
   std::cout << "\tgeometric stdev: " << geometricstdev << std::endl;
 
@@ -64,35 +64,16 @@ void PrintGeometricStatistics( const TStatisticsFilter * statistics )
 
 
 /**
- * Print histogram statistics
+ * Write a histogram to a file, one bin per line
  */
 
 template<class THistogram>
-void PrintHistogramStatistics( const THistogram * histogram,
+void WriteHistogram( const THistogram * histogram,
   const std::string & histogramOutputFileName )
 {
-  /** Print to screen. */
-  //median, quartiles, histogram, percentiles.
-
   typedef typename THistogram::AbsoluteFrequencyType AbsoluteFrequencyType;
   typename THistogram::TotalAbsoluteFrequencyType nrOfPixels = histogram->GetTotalFrequency();
-  double median = histogram->Quantile(0, 0.5);
-  double fifteenthpercentile = histogram->Quantile( 0, 0.15 );
-  double firstquartile = histogram->Quantile( 0, 0.25 );
-  double thirdquartile = histogram->Quantile( 0, 0.75 );
-  double eightyfivequartile = histogram->Quantile(0, 0.85);
-  double binsize = histogram->GetBinMax( 0, 0 ) - histogram->GetBinMin( 0, 0 );
-
-  std::cout << std::setprecision( 10 );
-  std::cout << "\tnumber of pixels:\t" << nrOfPixels << std::endl;
-  std::cout << "\tbinsize:         \t" << binsize << std::endl;
-  std::cout << "\tmedian:          \t" << median << std::endl;
-  std::cout << "\t1st quartile:    \t" << firstquartile << std::endl;
-  std::cout << "\t3rd quartile:    \t" << thirdquartile << std::endl;
-  std::cout << "\t15th percentile: \t" << fifteenthpercentile << std::endl;
-  std::cout << "\t85th percentile: \t" << eightyfivequartile << std::endl;
 
-  /** Print histogram to output file */
   if( histogramOutputFileName != "" )
   {
     std::cout << "Histogram is written to file: " <<
@@ -137,7 +118,235 @@ void PrintHistogramStatistics( const THistogram * histogram,
     std::cout << "Done writing histogram to file." << std::endl;
   } // end if
 
+} // end WriteHistogram()
+
+
+/**
+ * Print histogram statistics
+ */
+
+template<class THistogram>
+void PrintHistogramStatistics( const THistogram * histogram,
+  const std::string & histogramOutputFileName )
+{
+  /** Print to screen. */
+  //median, quartiles, histogram, percentiles.
+
+  typename THistogram::TotalAbsoluteFrequencyType nrOfPixels = histogram->GetTotalFrequency();
+  double median = histogram->Quantile(0, 0.5);
+  double fifteenthpercentile = histogram->Quantile( 0, 0.15 );
+  double firstquartile = histogram->Quantile( 0, 0.25 );
+  double thirdquartile = histogram->Quantile( 0, 0.75 );
+  double eightyfivequartile = histogram->Quantile(0, 0.85);
+  double binsize = histogram->GetBinMax( 0, 0 ) - histogram->GetBinMin( 0, 0 );
+
+  std::cout << std::setprecision( 10 );
+  std::cout << "\tnumber of pixels:\t" << nrOfPixels << std::endl;
+  std::cout << "\tbinsize:         \t" << binsize << std::endl;
+  std::cout << "\tmedian:          \t" << median << std::endl;
+  std::cout << "\t1st quartile:    \t" << firstquartile << std::endl;
+  std::cout << "\t3rd quartile:    \t" << thirdquartile << std::endl;
+  std::cout << "\t15th percentile: \t" << fifteenthpercentile << std::endl;
+  std::cout << "\t85th percentile: \t" << eightyfivequartile << std::endl;
+
+  /** Print histogram to output file */
+  WriteHistogram<THistogram>( histogram, histogramOutputFileName );
+
 } // end PrintHistogramStatistics()
 
 
+/**
+ * The probabilities of the median, quartiles and percentiles that are
+ * printed by PrintExactQuantiles() and PrintSampledStatistics().
+ */
+
+inline std::vector<double> GetQuantileProbabilities( void )
+{
+  std::vector<double> probabilities( 5 );
+  probabilities[ 0 ] = 0.5;
+  probabilities[ 1 ] = 0.25;
+  probabilities[ 2 ] = 0.75;
+  probabilities[ 3 ] = 0.15;
+  probabilities[ 4 ] = 0.85;
+  return probabilities;
+
+} // end GetQuantileProbabilities()
+
+
+/**
+ * Print the exact median, quartiles and percentiles, in the same
+ * order and format as PrintHistogramStatistics().
+ */
+
+template<class TStatisticsFilter>
+void PrintExactQuantiles( const TStatisticsFilter * statistics,
+  const std::vector<double> & quantiles )
+{
+  /** The quantiles are of the probabilities 0.5, 0.25, 0.75, 0.15, 0.85. */
+  std::cout << std::setprecision( 10 );
+  std::cout << "\tnumber of pixels:\t" << statistics->GetCount() << std::endl;
+  std::cout << "\tmedian:          \t" << quantiles[ 0 ] << std::endl;
+  std::cout << "\t1st quartile:    \t" << quantiles[ 1 ] << std::endl;
+  std::cout << "\t3rd quartile:    \t" << quantiles[ 2 ] << std::endl;
+  std::cout << "\t15th percentile: \t" << quantiles[ 3 ] << std::endl;
+  std::cout << "\t85th percentile: \t" << quantiles[ 4 ] << std::endl;
+
+} // end PrintExactQuantiles()
+
+
+/**
+ * Write the statistics of all labels of an itk::LabelStatisticsCalculator
+ * as comma separated values, one label per line, to a file or to the screen.
+ * The histogram quantiles need ComputeHistograms().
+ */
+
+template<class TLabelStatisticsCalculator>
+void WriteLabelStatistics( const TLabelStatisticsCalculator * statistics,
+  const bool arithmetic, const bool geometric, const bool histogram,
+  const std::string & outputFileName )
+{
+  std::ofstream outputFile;
+  if( outputFileName != "" )
+  {
+    std::cout << "Label statistics are written to file: " <<
+      outputFileName << " ..." << std::endl;
+    outputFile.open( outputFileName.c_str() );
+    if( !outputFile.is_open() )
+    {
+      itkGenericExceptionMacro(<< "ERROR: Output file for label statistics cannot be opened!");
+    }
+  }
+  std::ostream & out = outputFileName != "" ? outputFile : std::cout;
+
+  out << std::setprecision( 10 );
+  out << "label,count";
+  if( arithmetic ) out << ",min,max,mean,stdev,var,sum";
+  if( geometric ) out << ",geometric mean,geometric stdev";
+  if( histogram ) out << ",median,1st quartile,3rd quartile,15th percentile,85th percentile";
+  out << std::endl;
+
+  for( unsigned int i = 0; i < statistics->GetNumberOfLabels(); ++i )
+  {
+    out << static_cast<long long>( statistics->GetLabels()[ i ] )
+      << "," << statistics->GetCount( i );
+    if( arithmetic )
+    {
+      out << "," << statistics->GetMinimum( i )
+        << "," << statistics->GetMaximum( i )
+        << "," << statistics->GetMean( i )
+        << "," << statistics->GetSigma( i )
+        << "," << statistics->GetVariance( i )
+        << "," << statistics->GetSum( i );
+    }
+    if( geometric )
+    {
+      out << "," << statistics->GetGeometricMean( i )
+        << "," << statistics->GetGeometricSigma( i );
+    }
+    if( histogram )
+    {
+      const typename TLabelStatisticsCalculator::HistogramType * labelHistogram
+        = statistics->GetHistogram( i );
+      out << "," << labelHistogram->Quantile( 0, 0.5 )
+        << "," << labelHistogram->Quantile( 0, 0.25 )
+        << "," << labelHistogram->Quantile( 0, 0.75 )
+        << "," << labelHistogram->Quantile( 0, 0.15 )
+        << "," << labelHistogram->Quantile( 0, 0.85 );
+    }
+    out << std::endl;
+  }
+
+} // end WriteLabelStatistics()
+
+
+/**
+ * Write the histograms of all labels to a file, one bin per line,
+ * as WriteHistogram() with the label in front.
+ */
+
+template<class TLabelStatisticsCalculator>
+void WriteLabelHistograms( const TLabelStatisticsCalculator * statistics,
+  const std::string & histogramOutputFileName )
+{
+  typedef typename TLabelStatisticsCalculator::HistogramType HistogramType;
+  typedef typename HistogramType::AbsoluteFrequencyType AbsoluteFrequencyType;
+
+  std::cout << "Histograms are written to file: " <<
+    histogramOutputFileName << " ..." << std::endl;
+  std::ofstream histogramOutputFile;
+  histogramOutputFile.open( histogramOutputFileName.c_str() );
+  if( !histogramOutputFile.is_open() )
+  {
+    itkGenericExceptionMacro(<< "ERROR: Output file for histogram cannot be opened!");
+  }
+  histogramOutputFile << std::fixed;
+  histogramOutputFile << std::showpoint;
+  histogramOutputFile << std::setprecision(16);
+  histogramOutputFile << "label\tnr\tmin\tmax\tfreq\tprob" << std::endl;
+  for( unsigned int l = 0; l < statistics->GetNumberOfLabels(); ++l )
+  {
+    const long long label = static_cast<long long>( statistics->GetLabels()[ l ] );
+    const HistogramType * histogram = statistics->GetHistogram( l );
+    const double nrOfPixels = static_cast<double>( histogram->GetTotalFrequency() );
+    for( unsigned long i = 0; i < histogram->GetSize(0); ++i )
+    {
+      AbsoluteFrequencyType freq = histogram->GetFrequency(i,0);
+      histogramOutputFile
+        << label
+        << "\t" << i
+        << "\t" << histogram->GetBinMin(0,i)
+        << "\t" << histogram->GetBinMax(0,i)
+        << "\t" << freq
+        << "\t" << static_cast<double>(freq) / nrOfPixels
+        << std::endl;
+    }
+  }
+  histogramOutputFile.close();
+  std::cout << "Done writing histograms to file." << std::endl;
+
+} // end WriteLabelHistograms()
+
+
+/**
+ * Print the estimates of an itk::SampledImageStatisticsCalculator,
+ * with their confidence intervals.
+ */
+
+template<class TSampledStatisticsCalculator>
+void PrintSampledStatistics( const TSampledStatisticsCalculator * statistics )
+{
+  typedef typename TSampledStatisticsCalculator::EstimateType EstimateType;
+
+  const EstimateType & mean = statistics->GetMean();
+  const EstimateType & sigma = statistics->GetSigma();
+  const std::vector<EstimateType> & quantiles = statistics->GetQuantiles();
+
+  std::cout << std::setprecision( 10 );
+  std::cout << "\tnumber of sampled pixels:\t" << statistics->GetNumberOfSampledVoxels();
+  if( statistics->GetNumberOfSlabs() > 0 )
+  {
+    std::cout << ", in " << statistics->GetNumberOfSampledSlabs()
+      << " of " << statistics->GetNumberOfSlabs() << " slabs";
+  }
+  std::cout << std::endl;
+  std::cout << "\tdesign effect:   \t" << statistics->GetDesignEffect() << std::endl;
+  std::cout << "\testimate [" << 100.0 * statistics->GetConfidenceLevel()
+    << "% confidence interval]" << std::endl;
+  std::cout << "\tarithmetic mean :\t" << mean.m_Value
+    << " [" << mean.m_Lower << ", " << mean.m_Upper << "]" << std::endl;
+  std::cout << "\tarithmetic stdev:\t" << sigma.m_Value
+    << " [" << sigma.m_Lower << ", " << sigma.m_Upper << "]" << std::endl;
+
+  /** The quantiles are of the probabilities 0.5, 0.25, 0.75, 0.15, 0.85. */
+  const char * names[] = { "median:          ", "1st quartile:    ",
+    "3rd quartile:    ", "15th percentile: ", "85th percentile: " };
+  for( unsigned int i = 0; i < quantiles.size() && i < 5; ++i )
+  {
+    std::cout << "\t" << names[ i ] << "\t" << quantiles[ i ].m_Value
+      << " [" << quantiles[ i ].m_Lower << ", " << quantiles[ i ].m_Upper << "]" << std::endl;
+  }
+
+} // end PrintSampledStatistics()
+
+
 #endif // #ifndef __statisticsprinters_h
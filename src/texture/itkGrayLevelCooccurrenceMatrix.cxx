@@ -0,0 +1,277 @@
+/*=========================================================================
+*
+* Copyright Marius Staring, Stefan Klein, David Doria. 2011.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0.txt
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*=========================================================================*/
+#include "itkGrayLevelCooccurrenceMatrix.h"
+
+#include <algorithm>
+#include <cmath>
+
+
+namespace itk {
+namespace Statistics {
+
+/**
+ * ********************* Constructor ****************************
+ */
+
+GrayLevelCooccurrenceMatrix
+::GrayLevelCooccurrenceMatrix( const unsigned int binsPerAxis )
+{
+  this->SetNumberOfBinsPerAxis( binsPerAxis );
+} // end Constructor()
+
+
+/**
+ * ********************* SetNumberOfBinsPerAxis ****************************
+ */
+
+void
+GrayLevelCooccurrenceMatrix
+::SetNumberOfBinsPerAxis( const unsigned int binsPerAxis )
+{
+  this->m_BinsPerAxis = binsPerAxis;
+  this->m_Frequencies.assign( binsPerAxis * binsPerAxis, 0 );
+  this->m_RowFrequencies.assign( binsPerAxis, 0 );
+  this->m_ColumnFrequencies.assign( binsPerAxis, 0 );
+  this->m_TotalFrequency = 0;
+
+  this->m_OccurringRows.reserve( binsPerAxis );
+  this->m_OccurringColumns.reserve( binsPerAxis );
+  this->m_MarginalSums.resize( binsPerAxis );
+
+} // end SetNumberOfBinsPerAxis()
+
+
+/**
+ * ********************* SetToZero ****************************
+ */
+
+void
+GrayLevelCooccurrenceMatrix
+::SetToZero( void )
+{
+  std::fill( this->m_Frequencies.begin(), this->m_Frequencies.end(), 0 );
+  std::fill( this->m_RowFrequencies.begin(), this->m_RowFrequencies.end(), 0 );
+  std::fill( this->m_ColumnFrequencies.begin(), this->m_ColumnFrequencies.end(), 0 );
+  this->m_TotalFrequency = 0;
+
+} // end SetToZero()
+
+
+/**
+ * ********************* HasSingleElement ****************************
+ *
+ * If a row and a column each hold the total frequency, then so does the
+ * element where they cross.
+ */
+
+bool
+GrayLevelCooccurrenceMatrix
+::HasSingleElement( void ) const
+{
+  if( this->m_TotalFrequency == 0 ) return false;
+
+  bool fullRow = false, fullColumn = false;
+  for( unsigned int i = 0; i < this->m_BinsPerAxis; ++i )
+  {
+    fullRow |= this->m_RowFrequencies[ i ] == this->m_TotalFrequency;
+    fullColumn |= this->m_ColumnFrequencies[ i ] == this->m_TotalFrequency;
+  }
+  return fullRow && fullColumn;
+
+} // end HasSingleElement()
+
+
+/**
+ * ********************* ComputeFeatures ****************************
+ *
+ * The formulas of GrayLevelCooccurrenceMatrixTextureCoefficientsCalculator::Compute(),
+ * evaluated in the same order over the non-zero elements, but only for
+ * the rows and columns that occur, and only the sums that are needed.
+ */
+
+void
+GrayLevelCooccurrenceMatrix
+::ComputeFeatures( const unsigned int numberOfFeatures, double * features ) const
+{
+  const unsigned int maximumNumberOfFeatures = NumberOfFeatures;
+  const unsigned int n = std::min( numberOfFeatures, maximumNumberOfFeatures );
+  for( unsigned int f = 0; f < n; ++f ) features[ f ] = 0.0;
+  if( n == 0 ) return;
+
+  /** Which sums are needed. */
+  const bool needMoments = n > Correlation;
+  const bool needThirdMoments = n > ClusterShade;
+  const bool needFourthMoments = n > ClusterProminence;
+  const bool needMarginals = n > HaralickCorrelation;
+
+  /** The rows and columns that occur, in increasing order. */
+  const unsigned int binsPerAxis = this->m_BinsPerAxis;
+  this->m_OccurringRows.clear();
+  this->m_OccurringColumns.clear();
+  for( unsigned int i = 0; i < binsPerAxis; ++i )
+  {
+    if( this->m_RowFrequencies[ i ] > 0 ) this->m_OccurringRows.push_back( i );
+    if( this->m_ColumnFrequencies[ i ] > 0 ) this->m_OccurringColumns.push_back( i );
+  }
+  if( needMarginals )
+  {
+    std::fill( this->m_MarginalSums.begin(), this->m_MarginalSums.end(), 0.0 );
+  }
+
+  /** Temporary variables. */
+  const double totalFrequency = static_cast< double >( this->m_TotalFrequency );
+  const double log2 = std::log( 2. );
+  double energy = 0.0, entropy = 0.0, inverseDifferenceMoment = 0.0,
+    inertia = 0.0, haralickCorrelation = 0.0;
+  double pixelSum_0, pixelSum_00, pixelSum_01, pixelSum_11,
+    pixelSum_000, pixelSum_001, pixelSum_011, pixelSum_111,
+    pixelSum_0000, pixelSum_0001, pixelSum_0011, pixelSum_0111, pixelSum_1111;
+  pixelSum_0
+    = pixelSum_00 = pixelSum_01 = pixelSum_11
+    = pixelSum_000 = pixelSum_001 = pixelSum_011 = pixelSum_111
+    = pixelSum_0000 = pixelSum_0001 = pixelSum_0011
+    = pixelSum_0111 = pixelSum_1111 = 0.0;
+
+  /** Walk over the occurring elements, in the order of the histogram. */
+  for( unsigned int jj = 0; jj < this->m_OccurringColumns.size(); ++jj )
+  {
+    const IndexValueType j = this->m_OccurringColumns[ jj ];
+    const FrequencyType * column = &this->m_Frequencies[ j * binsPerAxis ];
+    for( unsigned int ii = 0; ii < this->m_OccurringRows.size(); ++ii )
+    {
+      const IndexValueType i = this->m_OccurringRows[ ii ];
+      const FrequencyType frequencyCount = column[ i ];
+
+      /** No use doing these calculations if we're just multiplying by zero. */
+      if( frequencyCount == 0 ) continue;
+
+      const double frequency = static_cast< double >( frequencyCount ) / totalFrequency;
+
+      energy += frequency * frequency;
+      if( n > Entropy )
+      {
+        entropy -= ( frequency > 0.0001 ) ? frequency * std::log( frequency ) / log2 : 0.0;
+      }
+      if( needMoments )
+      {
+        pixelSum_0  += i * frequency;
+        pixelSum_00 += i * i * frequency;
+        pixelSum_01 += i * j * frequency;
+      }
+      if( n > InverseDifferenceMoment )
+      {
+        inverseDifferenceMoment += frequency / ( 1.0 + ( i - j ) * ( i - j ) );
+      }
+      if( n > Inertia )
+      {
+        inertia += ( i - j ) * ( i - j ) * frequency;
+      }
+      if( needThirdMoments )
+      {
+        pixelSum_11  += j * j * frequency;
+        pixelSum_000 += i * i * i * frequency;
+        pixelSum_001 += i * i * j * frequency;
+        pixelSum_011 += i * j * j * frequency;
+        pixelSum_111 += j * j * j * frequency;
+      }
+      if( needFourthMoments )
+      {
+        pixelSum_0000 += i * i * i * i * frequency;
+        pixelSum_0001 += i * i * i * j * frequency;
+        pixelSum_0011 += i * i * j * j * frequency;
+        pixelSum_0111 += i * j * j * j * frequency;
+        pixelSum_1111 += j * j * j * j * frequency;
+      }
+      if( needMarginals )
+      {
+        this->m_MarginalSums[ i ] += frequency;
+        haralickCorrelation += i * j * frequency;
+      }
+    }
+  }
+
+  /** The features of the loop. */
+  features[ Energy ] = energy;
+  if( n > Entropy ) features[ Entropy ] = entropy;
+  if( n > InverseDifferenceMoment ) features[ InverseDifferenceMoment ] = inverseDifferenceMoment;
+  if( n > Inertia ) features[ Inertia ] = inertia;
+
+  /** Compute intermediate values. */
+  if( !needMoments ) return;
+  const double pixelMean = pixelSum_0;
+  const double pixelMean2 = pixelMean * pixelMean;
+  const double pixelMean3 = pixelMean2 * pixelMean;
+  const double pixelMean4 = pixelMean3 * pixelMean;
+  const double pixelVariance = pixelSum_00 - pixelMean * pixelMean;
+
+  features[ Correlation ] = ( pixelSum_01 - pixelMean * pixelMean ) / pixelVariance;
+
+  if( needThirdMoments )
+  {
+    features[ ClusterShade ] =
+      + 16 * pixelMean3
+      -  6 * pixelMean * pixelSum_00
+      +      pixelSum_000
+      - 12 * pixelMean * pixelSum_01
+      +  3 * pixelSum_001
+      -  6 * pixelMean * pixelSum_11
+      +  3 * pixelSum_011
+      + pixelSum_111;
+  }
+
+  if( needFourthMoments )
+  {
+    features[ ClusterProminence ] =
+      - 48 * pixelMean4
+      + 24 * pixelMean2 * pixelSum_00
+      -  8 * pixelMean  * pixelSum_000
+      +      pixelSum_0000
+      + 48 * pixelMean2 * pixelSum_01
+      - 24 * pixelMean  * pixelSum_001
+      +  4 * pixelSum_0001
+      + 24 * pixelMean2 * pixelSum_11
+      - 24 * pixelMean  * pixelSum_011
+      +  6 * pixelSum_0011
+      -  8 * pixelMean  * pixelSum_111
+      +  4 * pixelSum_0111
+      +      pixelSum_1111;
+  }
+
+  /** Compute marginal mean and variance needed for the HaralickCorrelation. */
+  if( needMarginals )
+  {
+    double marginalMean = 0.0;
+    double marginalSquareMean = 0.0;
+    for( unsigned int i = 0; i < binsPerAxis; ++i )
+    {
+      marginalMean += this->m_MarginalSums[ i ];
+      marginalSquareMean += this->m_MarginalSums[ i ] * this->m_MarginalSums[ i ];
+    }
+    double marginalVariance = marginalSquareMean - marginalMean * marginalMean / binsPerAxis;
+    marginalVariance /= binsPerAxis;
+    marginalMean /= binsPerAxis;
+
+    features[ HaralickCorrelation ]
+      = ( haralickCorrelation - marginalMean * marginalMean ) / marginalVariance;
+  }
+
+} // end ComputeFeatures()
+
+
+} // end of namespace Statistics
+} // end of namespace itk
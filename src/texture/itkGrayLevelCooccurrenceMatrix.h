@@ -0,0 +1,124 @@
+/*=========================================================================
+*
+* Copyright Marius Staring, Stefan Klein, David Doria. 2011.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0.txt
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*=========================================================================*/
+#ifndef __itkGrayLevelCooccurrenceMatrix_h_
+#define __itkGrayLevelCooccurrenceMatrix_h_
+
+#include "itkIntTypes.h"
+#include "itkGrayLevelCooccurrenceMatrixTextureCoefficientsCalculator.h"
+
+#include <vector>
+
+
+namespace itk {
+namespace Statistics {
+
+/** \class GrayLevelCooccurrenceMatrix
+ * \brief A dense gray level co-occurrence matrix, with the texture features
+ * computed directly from it.
+ *
+ * The frequencies are stored in one flat array of binsPerAxis x binsPerAxis
+ * counts, element ( i, j ) at i + j * binsPerAxis, which is the order of the
+ * instance identifiers of an itk::Statistics::Histogram. The row and column
+ * marginal counts and the total count are updated with each change, so that
+ * the bins that do not occur can be skipped when computing the features.
+ *
+ * ComputeFeatures() computes the first n features, in the order of
+ * TextureFeatureName, with the formulas of and in the same order as
+ * GrayLevelCooccurrenceMatrixTextureCoefficientsCalculator, so the values
+ * are identical. Only the sums needed for those n features are computed.
+ *
+ * This is a plain class without reference counting, intended to be used
+ * per thread in the inner loop of a filter.
+ *
+ * \sa GrayLevelCooccurrenceMatrixTextureCoefficientsCalculator
+ */
+
+class GrayLevelCooccurrenceMatrix
+{
+public:
+  typedef SizeValueType  FrequencyType;
+
+  /** The number of texture features. */
+  itkStaticConstMacro( NumberOfFeatures, unsigned int, 8 );
+
+  /** Constructor. */
+  GrayLevelCooccurrenceMatrix( const unsigned int binsPerAxis = 0 );
+
+  /** Destructor. */
+  ~GrayLevelCooccurrenceMatrix(){};
+
+  /** Set the number of bins along each axis, and set all frequencies to zero. */
+  void SetNumberOfBinsPerAxis( const unsigned int binsPerAxis );
+  unsigned int GetNumberOfBinsPerAxis( void ) const { return this->m_BinsPerAxis; }
+
+  /** Set all frequencies to zero. */
+  void SetToZero( void );
+
+  /** Increase or decrease the frequency of element ( i, j ). */
+  void IncreaseFrequency( const unsigned int i, const unsigned int j, const FrequencyType n = 1 )
+  {
+    this->m_Frequencies[ i + j * this->m_BinsPerAxis ] += n;
+    this->m_RowFrequencies[ i ] += n;
+    this->m_ColumnFrequencies[ j ] += n;
+    this->m_TotalFrequency += n;
+  }
+  void DecreaseFrequency( const unsigned int i, const unsigned int j, const FrequencyType n = 1 )
+  {
+    this->m_Frequencies[ i + j * this->m_BinsPerAxis ] -= n;
+    this->m_RowFrequencies[ i ] -= n;
+    this->m_ColumnFrequencies[ j ] -= n;
+    this->m_TotalFrequency -= n;
+  }
+
+  /** Get the frequencies. */
+  FrequencyType GetFrequency( const unsigned int i, const unsigned int j ) const
+  {
+    return this->m_Frequencies[ i + j * this->m_BinsPerAxis ];
+  }
+  FrequencyType GetRowFrequency( const unsigned int i ) const { return this->m_RowFrequencies[ i ]; }
+  FrequencyType GetColumnFrequency( const unsigned int j ) const { return this->m_ColumnFrequencies[ j ]; }
+  FrequencyType GetTotalFrequency( void ) const { return this->m_TotalFrequency; }
+
+  /** Whether one element holds the total frequency, and all others are zero. */
+  bool HasSingleElement( void ) const;
+
+  /** Compute the first numberOfFeatures features, in the order of
+   * TextureFeatureName, into features[ 0 ] ... features[ numberOfFeatures - 1 ].
+   */
+  void ComputeFeatures( const unsigned int numberOfFeatures, double * features ) const;
+
+private:
+
+  unsigned int                  m_BinsPerAxis;
+  std::vector< FrequencyType >  m_Frequencies;
+  std::vector< FrequencyType >  m_RowFrequencies;
+  std::vector< FrequencyType >  m_ColumnFrequencies;
+  FrequencyType                 m_TotalFrequency;
+
+  /** Work space of ComputeFeatures(), to avoid allocations. */
+  mutable std::vector< unsigned int > m_OccurringRows;
+  mutable std::vector< unsigned int > m_OccurringColumns;
+  mutable std::vector< double >       m_MarginalSums;
+
+}; // end class GrayLevelCooccurrenceMatrix
+
+
+} // end of namespace Statistics
+} // end of namespace itk
+
+#endif // end #ifndef __itkGrayLevelCooccurrenceMatrix_h_
@@ -21,7 +21,7 @@
 #include "itkImageToImageFilter.h"
 
 #include "itkScalarImageToGrayLevelCooccurrenceMatrixGenerator.h"
-#include "itkGrayLevelCooccurrenceMatrixTextureCoefficientsCalculator.h"
+#include "itkGrayLevelCooccurrenceMatrix.h"
 
 
 namespace itk
@@ -32,13 +32,20 @@ namespace itk
  * on an image.
  *
  * The operations this filter performs several steps:\n
- * - for each pixel a neighborhood around that pixel is copied to an image \n
- * - from this local image a co-occurrence matrix is constructed, using the
- *   itk::kScalarImageToGreyLevelCooccurrenceMatrixGenerator class \n
- * - from the co-occurrence matrix several features are computed, using
- *   the itk::GreyLevelCooccurrenceMatrixTextureCoefficientsCalculator class \n
+ * - for each pixel the co-occurrence matrix of a neighborhood around that
+ *   pixel is constructed, as the itk::ScalarImageToGrayLevelCooccurrenceMatrixGenerator
+ *   class would; along a line it is updated incrementally, by the slabs
+ *   of pixels that leave and enter the neighborhood \n
+ * - from the co-occurrence matrix several features are computed, with the
+ *   formulas of the itk::GreyLevelCooccurrenceMatrixTextureCoefficientsCalculator
+ *   class; the matrix is a dense itk::Statistics::GrayLevelCooccurrenceMatrix,
+ *   and only the features of the requested outputs are computed \n
  * - each feature value is copied to the corresponding output image.
  *
+ * The input is quantized once, before the threads start, into an image of
+ * bin indices, from which the co-occurrence matrices are filled. Optionally
+ * a mask restricts the computation to the pixels inside it.
+ *
  * This last class is based on several papers from Haralick and Conners:
  *
  * Haralick, R.M., K. Shanmugam and I. Dinstein. 1973.  Textural Features for
@@ -96,6 +103,7 @@ public:
     InputImageType >                                CooccurrenceMatrixGeneratorType;
   typedef typename CooccurrenceMatrixGeneratorType
     ::HistogramType                                 HistogramType;
+  typedef typename HistogramType::Pointer           HistogramPointer;
   typedef typename CooccurrenceMatrixGeneratorType
     ::OffsetType                                    OffsetType;
   typedef typename CooccurrenceMatrixGeneratorType
@@ -105,12 +113,21 @@ public:
   typedef typename CooccurrenceMatrixGeneratorType
     ::OffsetVectorConstPointer                      OffsetVectorConstPointer;
 
-  typedef Statistics::GrayLevelCooccurrenceMatrixTextureCoefficientsCalculator<
-    HistogramType >                                 TextureCalculatorType;
+  typedef Statistics::GrayLevelCooccurrenceMatrix  CooccurrenceMatrixType;
 
   /** Input Image dimension. */
   itkStaticConstMacro( InputImageDimension, unsigned int, TInputImage::ImageDimension );
 
+  /** Typedefs for mask support. */
+  typedef unsigned char                               MaskPixelType;
+  typedef Image< MaskPixelType, InputImageDimension > MaskImageType;
+  typedef typename MaskImageType::Pointer             MaskImagePointer;
+
+  /** Typedefs for the quantized input: the bin index of each pixel. */
+  typedef unsigned short                              BinIndexType;
+  typedef Image< BinIndexType, InputImageDimension >  BinIndexImageType;
+  typedef typename BinIndexImageType::Pointer         BinIndexImagePointer;
+
   /** *****
    * Functions for this class.
    *  *****
@@ -155,6 +172,14 @@ public:
   itkGetConstMacro( HistogramMinimum, InputImagePixelType );
   itkGetConstMacro( HistogramMaximum, InputImagePixelType );
 
+  /** Set the mask, optional. The texture features are only computed for
+   * the pixels inside the mask, the outputs are 0 elsewhere. The
+   * neighborhoods do include the pixels outside the mask. The mask
+   * should have the size of the input and be buffered completely.
+   */
+  itkSetObjectMacro( Mask, MaskImageType );
+  itkGetObjectMacro( Mask, MaskImageType );
+
 protected:
 
   /** Constructor. */
@@ -175,6 +200,7 @@ protected:
   /** Starts the image modeling process. */
   void BeforeThreadedGenerateData( void );
   void ThreadedGenerateData( const OutputImageRegionType & region, ThreadIdType threadId );
+  void AfterThreadedGenerateData( void );
 
 private:
 
@@ -184,6 +210,12 @@ private:
   /** Private function to control the output. */
   virtual void SetAndCreateOutputs( unsigned int n );
 
+  /** Private functions for the local co-occurrence matrix. */
+  HistogramPointer CreateBinningHistogram( void ) const;
+  void QuantizeInput( void );
+  void UpdateCooccurrenceMatrix( const InputImageRegionType & region,
+    CooccurrenceMatrixType & matrix, const bool add ) const;
+
   /** Private function to compute sensible defaults. */
   virtual void ComputeDefaultOffsets( std::vector<unsigned int> scales );
   virtual void ComputeHistogramMinimumAndMaximum( void );
@@ -205,6 +237,10 @@ private:
   bool                      m_HistogramMaximumSetManually;
   bool                      m_NormalizeHistogram;
 
+  /** Private variables for the mask and the quantized input. */
+  MaskImagePointer          m_Mask;
+  BinIndexImagePointer      m_BinIndexImage;
+
 }; // end class TextureImageToImageFilter
 
 
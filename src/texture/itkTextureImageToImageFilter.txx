@@ -21,10 +21,14 @@
 #include "itkTextureImageToImageFilter.h"
 
 #include "../statisticsonimage/itkStatisticsImageFilterWithMask.h"
-#include "itkConstNeighborhoodIterator.h"
 #include "itkImageRegionIterator.h"
+#include "itkImageRegionConstIterator.h"
+#include "itkImageRegionConstIteratorWithIndex.h"
+#include "itkImageScanlineConstIterator.h"
 #include "itkProgressReporter.h"
 
+#include <algorithm>
+
 
 namespace itk
 {
@@ -207,11 +211,34 @@ TextureImageToImageFilter< TInputImage, TOutputImage >
   /** Compute the offsets. */
   this->ComputeDefaultOffsets( this->m_OffsetScales );
 
+  /** Check the mask. */
+  if( this->m_Mask.IsNotNull()
+    && this->m_Mask->GetBufferedRegion() != inputPtr->GetLargestPossibleRegion() )
+  {
+    itkExceptionMacro( << "The mask should have the same size as the input image." );
+  }
+
+  /** Quantize the input once, instead of binning the pixels of each neighborhood. */
+  this->QuantizeInput();
+
 } // end BeforeThreadedGenerateData()
 
 
 /**
  * ********************* ThreadedGenerateData ****************************
+ *
+ * The co-occurrence matrix of a neighborhood is the sum of the contributions
+ * of its pixels, where the contribution of a pixel are its pairs with the
+ * pixels at the offsets, if inside the image. It does not depend on the
+ * neighborhood. Therefore, when the neighborhood slides one pixel along a
+ * line, the matrix is updated by removing the contributions of the slab of
+ * pixels that leaves the neighborhood, and adding those of the slab that
+ * enters it. The matrix, and thus the features, are exactly those of
+ * computing the matrix of each neighborhood from scratch.
+ *
+ * With a mask, the pixels outside the mask are skipped. The matrix then
+ * slides to the next pixel inside the mask on the same line if that is at
+ * most a radius away, otherwise it is computed from scratch.
  */
 
 template< class TInputImage, class TOutputImage >
@@ -222,32 +249,28 @@ TextureImageToImageFilter< TInputImage, TOutputImage >
   /** Support for progress methods/callbacks. */
   ProgressReporter progress( this, threadId, regionForThread.GetNumberOfPixels() );
 
-  /** Setup the local co-occurrence matrix generator. */
-  typename CooccurrenceMatrixGeneratorType::Pointer cmGenerator
-    = CooccurrenceMatrixGeneratorType::New();
-  cmGenerator->SetInput( this->GetInput() );
-  cmGenerator->SetOffsets( this->m_Offsets );
-  cmGenerator->SetNumberOfBinsPerAxis( this->m_NumberOfHistogramBins );
-  cmGenerator->SetPixelValueMinMax( this->m_HistogramMinimum, this->m_HistogramMaximum );
-  cmGenerator->SetNormalize( this->m_NormalizeHistogram );
-
-  /** Setup local texture feature calculator. */
-  typename TextureCalculatorType::Pointer cmCalculator
-    = TextureCalculatorType::New();
-
   /** Typedefs. */
-  typedef ConstNeighborhoodIterator< InputImageType >         ConstNeighborhoodIteratorType;
-  typedef typename ConstNeighborhoodIteratorType::RadiusType  RadiusType;
-  typedef ImageRegionIterator< OutputImageType >              OutputIteratorType;
-
-  /** Setup a neigborhood iterator over the input image. */
-  RadiusType radius;
-  radius.Fill( this->m_NeighborhoodRadius );
-  ConstNeighborhoodIteratorType nit( radius, this->GetInput(), regionForThread );
-  nit.GoToBegin();
+  typedef ImageScanlineConstIterator< BinIndexImageType > LineIteratorType;
+  typedef ImageRegionIterator< OutputImageType >          OutputIteratorType;
+  typedef typename InputImageType::IndexType              IndexType;
+
+  const InputImageRegionType & largestRegion = this->GetInput()->GetLargestPossibleRegion();
+  const IndexValueType radius = static_cast< IndexValueType >( this->m_NeighborhoodRadius );
+  const IndexValueType firstColumn = largestRegion.GetIndex( 0 );
+  const IndexValueType lastColumn = firstColumn
+    + static_cast< IndexValueType >( largestRegion.GetSize( 0 ) ) - 1;
+  const MaskImageType * mask = this->m_Mask.GetPointer();
+
+  /** Setup the local co-occurrence matrix. */
+  const unsigned int binsPerAxis = this->m_NumberOfHistogramBins;
+  CooccurrenceMatrixType matrix( binsPerAxis );
+  const CooccurrenceMatrixType emptyMatrix( this->m_NormalizeHistogram ? binsPerAxis : 0 );
+
+  /** Only the requested features are computed. */
+  const unsigned int noo = this->GetNumberOfOutputs();
+  double features[ CooccurrenceMatrixType::NumberOfFeatures ];
 
   /** Setup iterators over the output images. */
-  const unsigned int noo = this->GetNumberOfOutputs();
   std::vector< OutputIteratorType > outputIterators( noo );
   for( unsigned int i = 0; i < noo; ++i )
   {
@@ -255,42 +278,276 @@ TextureImageToImageFilter< TInputImage, TOutputImage >
     outputIterators[ i ].GoToBegin();
   }
 
-  /** Loop over the input region. */
-  InputImageRegionType localRegion;
-  while ( !nit.IsAtEnd() )
+  /** Loop over the lines of the region, in the order of the output iterators. */
+  LineIteratorType lineIt( this->m_BinIndexImage, regionForThread );
+  InputImageRegionType slab;
+  while( !lineIt.IsAtEnd() )
   {
-    /** Construct a local neighborhood over which GLCM computation takes place.
-     * The regions have to be cropped with the largest possible region
-     * of the input image, to avoid problems at the border.
-     * Note that a larger subimage than localRegion is actually used for
-     * computing the co-occurrence matrix, because of the offsets.
+    IndexType index = lineIt.GetIndex();
+    const IndexValueType lineBegin = index[ 0 ];
+    const IndexValueType lineEnd = lineBegin
+      + static_cast< IndexValueType >( regionForThread.GetSize( 0 ) );
+
+    /** The neighborhoods of the pixels of the line, across the whole line,
+     * cropped with the largest possible region of the input image, to avoid
+     * problems at the border.
      */
-    localRegion = nit.GetBoundingBoxAsImageRegion();
-    localRegion.Crop( this->GetInput()->GetLargestPossibleRegion() );
-
-    /** Generate the co-occurrence over a local region only. */
-    cmGenerator->SetComputeRegion( localRegion );
-    cmGenerator->Compute();
+    InputImageRegionType lineRegion;
+    IndexType lineRegionStart;
+    typename InputImageType::SizeType lineRegionSize;
+    for( unsigned int d = 0; d < InputImageDimension; ++d )
+    {
+      lineRegionStart[ d ] = index[ d ] - radius;
+      lineRegionSize[ d ] = 2 * this->m_NeighborhoodRadius + 1;
+    }
+    lineRegion.SetIndex( lineRegionStart );
+    lineRegion.SetSize( lineRegionSize );
+    lineRegion.Crop( largestRegion );
 
-    /** Compute texture features from this co-occurrence matrix. */
-    cmCalculator->SetHistogram( cmGenerator->GetOutput() );
-    cmCalculator->Compute();
+    /** The column of the neighborhood that the matrix holds, none yet. */
+    bool matrixIsValid = false;
+    IndexValueType matrixColumn = 0;
 
-    /** Copy the requested texture features to the outputs and update iterators. */
-    for( unsigned int ii = 0; ii < noo; ++ii )
+    for( IndexValueType x = lineBegin; x < lineEnd; ++x )
     {
-      outputIterators[ ii ].Set( cmCalculator->GetFeature( ii ) );
-      ++outputIterators[ ii ];
+      index[ 0 ] = x;
+      if( mask && !mask->GetPixel( index ) )
+      {
+        for( unsigned int ii = 0; ii < noo; ++ii )
+        {
+          outputIterators[ ii ].Set( NumericTraits< OutputImagePixelType >::ZeroValue() );
+          ++outputIterators[ ii ];
+        }
+        progress.CompletedPixel();
+        continue;
+      }
+
+      if( matrixIsValid && x - matrixColumn <= radius )
+      {
+        /** Slide the neighborhood: remove the leaving slab, add the entering slab. */
+        slab = lineRegion;
+        slab.SetSize( 0, 1 );
+        for( IndexValueType column = matrixColumn + 1; column <= x; ++column )
+        {
+          if( column - 1 - radius >= firstColumn )
+          {
+            slab.SetIndex( 0, column - 1 - radius );
+            this->UpdateCooccurrenceMatrix( slab, matrix, false );
+          }
+          if( column + radius <= lastColumn )
+          {
+            slab.SetIndex( 0, column + radius );
+            this->UpdateCooccurrenceMatrix( slab, matrix, true );
+          }
+        }
+      }
+      else
+      {
+        /** Compute the matrix of the neighborhood from scratch. */
+        InputImageRegionType localRegion = lineRegion;
+        const IndexValueType localBegin = std::max( x - radius, firstColumn );
+        const IndexValueType localEnd = std::min( x + radius, lastColumn );
+        localRegion.SetIndex( 0, localBegin );
+        localRegion.SetSize( 0, static_cast< SizeValueType >( localEnd - localBegin + 1 ) );
+        matrix.SetToZero();
+        this->UpdateCooccurrenceMatrix( localRegion, matrix, true );
+      }
+      matrixIsValid = true;
+      matrixColumn = x;
+
+      /** Compute texture features from this co-occurrence matrix. The
+       * normalization is that of the generator, which divides the integer
+       * frequencies by the total frequency. That leaves only an element that
+       * holds the total frequency, with the same features as the matrix,
+       * and otherwise an empty matrix.
+       */
+      if( this->m_NormalizeHistogram && !matrix.HasSingleElement() )
+      {
+        emptyMatrix.ComputeFeatures( noo, features );
+      }
+      else
+      {
+        matrix.ComputeFeatures( noo, features );
+      }
+
+      /** Copy the requested texture features to the outputs and update iterators. */
+      for( unsigned int ii = 0; ii < noo; ++ii )
+      {
+        outputIterators[ ii ].Set( features[ ii ] );
+        ++outputIterators[ ii ];
+      }
+
+      progress.CompletedPixel();
     }
-    ++nit;
 
-    progress.CompletedPixel();
+    lineIt.NextLine();
 
   } // end while
 
 } // end ThreadedGenerateData()
 
 
+/**
+ * ********************* AfterThreadedGenerateData ****************************
+ */
+
+template< class TInputImage, class TOutputImage >
+void
+TextureImageToImageFilter< TInputImage, TOutputImage >
+::AfterThreadedGenerateData( void )
+{
+  /** The quantized input is not needed anymore. */
+  this->m_BinIndexImage = nullptr;
+
+} // end AfterThreadedGenerateData()
+
+
+/**
+ * ********************* CreateBinningHistogram ****************************
+ */
+
+template< class TInputImage, class TOutputImage >
+typename TextureImageToImageFilter< TInputImage, TOutputImage >::HistogramPointer
+TextureImageToImageFilter< TInputImage, TOutputImage >
+::CreateBinningHistogram( void ) const
+{
+  /** The same bounds as ScalarImageToGrayLevelCooccurrenceMatrixGenerator::SetPixelValueMinMax(). */
+  typename HistogramType::MeasurementVectorType lowerBound( 2 );
+  typename HistogramType::MeasurementVectorType upperBound( 2 );
+  lowerBound.Fill( this->m_HistogramMinimum );
+  upperBound.Fill( this->m_HistogramMaximum + 1 );
+
+  typename HistogramType::SizeType size;
+  size.SetSize( 2 );
+  size.Fill( this->m_NumberOfHistogramBins );
+
+  HistogramPointer histogram = HistogramType::New();
+  histogram->SetMeasurementVectorSize( 2 );
+  histogram->Initialize( size, lowerBound, upperBound );
+  return histogram;
+
+} // end CreateBinningHistogram()
+
+
+/**
+ * ********************* QuantizeInput ****************************
+ *
+ * Stores the bin of each pixel, as the histogram of the generator bins it,
+ * or the maximum BinIndexType for values outside the histogram range.
+ */
+
+template< class TInputImage, class TOutputImage >
+void
+TextureImageToImageFilter< TInputImage, TOutputImage >
+::QuantizeInput( void )
+{
+  typedef ImageRegionConstIterator< InputImageType >  InputIteratorType;
+  typedef ImageRegionIterator< BinIndexImageType >    BinIndexIteratorType;
+
+  /** The maximum is reserved for values outside the range. */
+  const BinIndexType outsideBin = NumericTraits< BinIndexType >::max();
+  if( this->m_NumberOfHistogramBins >= outsideBin )
+  {
+    itkExceptionMacro( << "The number of histogram bins should be smaller than "
+      << outsideBin << ", not " << this->m_NumberOfHistogramBins << "." );
+  }
+
+  const InputImageType * input = this->GetInput();
+  const InputImageRegionType & largestRegion = input->GetLargestPossibleRegion();
+  this->m_BinIndexImage = BinIndexImageType::New();
+  this->m_BinIndexImage->CopyInformation( input );
+  this->m_BinIndexImage->SetRegions( largestRegion );
+  this->m_BinIndexImage->Allocate();
+
+  /** The histogram is only read, so it is shared by the threads. */
+  HistogramPointer binning = this->CreateBinningHistogram();
+  const HistogramType * binningPtr = binning.GetPointer();
+  BinIndexImageType * binIndexImage = this->m_BinIndexImage;
+  const InputImagePixelType minimum = this->m_HistogramMinimum;
+  const InputImagePixelType maximum = this->m_HistogramMaximum;
+
+  this->GetMultiThreader()->template ParallelizeImageRegion< InputImageDimension >(
+    largestRegion,
+    [input, binIndexImage, binningPtr, minimum, maximum, outsideBin]( const InputImageRegionType & region )
+    {
+      typename HistogramType::MeasurementVectorType measurement( 2 );
+      typename HistogramType::IndexType binIndex( 2 );
+      InputIteratorType it( input, region );
+      BinIndexIteratorType bit( binIndexImage, region );
+      for( ; !it.IsAtEnd(); ++it, ++bit )
+      {
+        /** Don't put a pixel in the histogram if the value is out-of-bounds. */
+        const InputImagePixelType value = it.Get();
+        if( value < minimum || value > maximum )
+        {
+          bit.Set( outsideBin );
+          continue;
+        }
+        measurement.Fill( value );
+        binningPtr->GetIndex( measurement, binIndex );
+        bit.Set( static_cast< BinIndexType >( binIndex[ 0 ] ) );
+      }
+    }, nullptr );
+
+} // end QuantizeInput()
+
+
+/**
+ * ********************* UpdateCooccurrenceMatrix ****************************
+ *
+ * Adds or removes the co-occurrences of the pixels of a region, exactly as
+ * ScalarImageToGrayLevelCooccurrenceMatrixGenerator::FillHistogram() adds them:
+ * both orders of each pair of a pixel and the pixel at an offset, if the
+ * latter is inside the image and both values are within the histogram range.
+ */
+
+template< class TInputImage, class TOutputImage >
+void
+TextureImageToImageFilter< TInputImage, TOutputImage >
+::UpdateCooccurrenceMatrix( const InputImageRegionType & region,
+  CooccurrenceMatrixType & matrix, const bool add ) const
+{
+  typedef ImageRegionConstIteratorWithIndex< BinIndexImageType > IteratorType;
+  typedef typename InputImageType::IndexType                     IndexType;
+
+  const BinIndexImageType * binIndexImage = this->m_BinIndexImage;
+  const InputImageRegionType & bufferedRegion = binIndexImage->GetBufferedRegion();
+  const BinIndexType outsideBin = NumericTraits< BinIndexType >::max();
+  const unsigned int numberOfOffsets = this->m_Offsets->Size();
+
+  IteratorType it( binIndexImage, region );
+  for( it.GoToBegin(); !it.IsAtEnd(); ++it )
+  {
+    /** Skip the pixels that are not in the histogram. */
+    const BinIndexType centerBin = it.Get();
+    if( centerBin == outsideBin ) continue;
+
+    const IndexType centerIndex = it.GetIndex();
+    for( unsigned int i = 0; i < numberOfOffsets; ++i )
+    {
+      const IndexType index = centerIndex + this->m_Offsets->ElementAt( i );
+      if( !bufferedRegion.IsInside( index ) ) continue;
+
+      const BinIndexType bin = binIndexImage->GetPixel( index );
+      if( bin == outsideBin ) continue;
+
+      /** Both co-occurrence combinations. */
+      if( add )
+      {
+        matrix.IncreaseFrequency( centerBin, bin );
+        matrix.IncreaseFrequency( bin, centerBin );
+      }
+      else
+      {
+        matrix.DecreaseFrequency( centerBin, bin );
+        matrix.DecreaseFrequency( bin, centerBin );
+      }
+    }
+  }
+
+} // end UpdateCooccurrenceMatrix()
+
+
 /**
  * ********************* SetAndCreateOutputs ****************************
  */
@@ -455,6 +712,8 @@ TextureImageToImageFilter< TInputImage, TOutputImage >
     << this->m_HistogramMaximumSetManually << std::endl;
   os << indent << "NormalizeHistogram: "
     << this->m_NormalizeHistogram << std::endl;
+  os << indent << "Mask: "
+    << this->m_Mask.GetPointer() << std::endl;
 
 } // end PrintSelf()
 
@@ -42,6 +42,7 @@ std::string GetHelpString( void )
     << "This program computes filter features based on the gray-level co-occurrence matrix (GLCM).\n"
     << "  -in      inputFilename\n"
     << "  [-out]   outputDirectory, default equal to the inputFilename directory\n"
+    << "  [-mask]  maskFilename, the features are only computed inside the mask, 0 elsewhere\n"
     << "  [-r]     the radius of the neighborhood on which to construct the GLCM, default 3\n"
     << "  [-os]    the desired offset scales to compute the GLCM, default 1, but can be e.g. 1 2 4\n"
     << "  [-b]     the number of bins of the GLCM, default 128\n"
@@ -88,6 +89,9 @@ int main( int argc, char **argv )
   bool endslash = itksys::SystemTools::StringEndsWith( outputDirectory.c_str(), "/" );
   if( !endslash ) outputDirectory += "/";
 
+  std::string maskFileName = "";
+  parser->GetCommandLineArgument( "-mask", maskFileName );
+
   unsigned int neighborhoodRadius = 3;
   parser->GetCommandLineArgument( "-r", neighborhoodRadius );
 
@@ -157,6 +161,7 @@ int main( int argc, char **argv )
     /** Set the filter arguments. */
     filter->m_InputFileName = inputFileName;
     filter->m_OutputDirectory = outputDirectory;
+    filter->m_MaskFileName = maskFileName;
     filter->m_NeighborhoodRadius = neighborhoodRadius;
     filter->m_OffsetScales = offsetScales;
     filter->m_NumberOfBins = numberOfBins;
@@ -42,6 +42,7 @@ public:
   {
     this->m_InputFileName = "";
     this->m_OutputDirectory = "";
+    this->m_MaskFileName = "";
     this->m_NeighborhoodRadius = 0;
     this->m_NumberOfBins = 0;
     this->m_NumberOfOutputs = 0;
@@ -52,6 +53,7 @@ public:
   /** Input member parameters. */
   std::string m_InputFileName;
   std::string m_OutputDirectory;
+  std::string m_MaskFileName;
   unsigned int m_NeighborhoodRadius;
   std::vector< unsigned int > m_OffsetScales;
   unsigned int m_NumberOfBins;
@@ -101,7 +103,9 @@ public:
     typedef itk::Image<TOutputComponentType, VDimension>  OutputImageType;
     typedef itk::TextureImageToImageFilter<
       InputImageType, OutputImageType >                   TextureFilterType;
+    typedef typename TextureFilterType::MaskImageType     MaskImageType;
     typedef itk::ImageFileReader< InputImageType >        ReaderType;
+    typedef itk::ImageFileReader< MaskImageType >         MaskReaderType;
     typedef itk::ImageFileWriter< OutputImageType >       WriterType;
 
     /** Read the input. */
@@ -117,6 +121,15 @@ public:
     textureFilter->SetNormalizeHistogram( false );
     textureFilter->SetNumberOfRequestedOutputs( this->m_NumberOfOutputs );
 
+    /** Read the mask, if given. */
+    if( this->m_MaskFileName != "" )
+    {
+      typename MaskReaderType::Pointer maskReader = MaskReaderType::New();
+      maskReader->SetFileName( this->m_MaskFileName.c_str() );
+      maskReader->Update();
+      textureFilter->SetMask( maskReader->GetOutput() );
+    }
+
     /** Create and attach a progress observer. */
     ShowProgressObject progressWatch( textureFilter );
     typename itk::SimpleMemberCommand<ShowProgressObject>::Pointer progressCommand
@@ -31,6 +31,54 @@
 #include <vector>
 
 
+/**
+ * ******************* GetUnaryFunctorEnumMap *******************
+ */
+
+inline std::map< std::string, UnaryFunctorEnum > GetUnaryFunctorEnumMap( void )
+{
+  /** Define a helper map. */
+  std::map< std::string, UnaryFunctorEnum> stringToEnumMap;
+  stringToEnumMap["PLUS"] = PLUS;
+  stringToEnumMap["RMINUS"] = RMINUS;
+  stringToEnumMap["LMINUS"] = LMINUS;
+  stringToEnumMap["TIMES"] = TIMES;
+  stringToEnumMap["LDIVIDE"] = LDIVIDE;
+  stringToEnumMap["RDIVIDE"] = RDIVIDE;
+  stringToEnumMap["RMODINT"] = RMODINT;
+  stringToEnumMap["RMODDOUBLE"] = RMODDOUBLE;
+  stringToEnumMap["LMODINT"] = LMODINT;
+  stringToEnumMap["LMODDOUBLE"] = LMODDOUBLE;
+  stringToEnumMap["NLOG"] = NLOG;
+  stringToEnumMap["RPOWER"] = RPOWER;
+  stringToEnumMap["LPOWER"] = LPOWER;
+  stringToEnumMap["NEG"] = NEG;
+  stringToEnumMap["SIGNINT"] = SIGNINT;
+  stringToEnumMap["SIGNDOUBLE"] = SIGNDOUBLE;
+  stringToEnumMap["ABSINT"] = ABSINT;
+  stringToEnumMap["ABSDOUBLE"] = ABSDOUBLE;
+  stringToEnumMap["FLOOR"] = FLOOR;
+  stringToEnumMap["CEIL"] = CEIL;
+  stringToEnumMap["ROUND"] = ROUND;
+  stringToEnumMap["LN"] = LN;
+  stringToEnumMap["LOG10"] = LOG10;
+  stringToEnumMap["EXP"] = EXP;
+  stringToEnumMap["SIN"] = SIN;
+  stringToEnumMap["COS"] = COS;
+  stringToEnumMap["TAN"] = TAN;
+  stringToEnumMap["ARCSIN"] = ARCSIN;
+  stringToEnumMap["ARCCOS"] = ARCCOS;
+  stringToEnumMap["ARCTAN"] = ARCTAN;
+  stringToEnumMap["LINEAR"] = LINEAR;
+  stringToEnumMap["ERRFUNC"] = ERRFUNC;
+  stringToEnumMap["NORMCDF"] = NORMCDF;
+  stringToEnumMap["QFUNC"] = QFUNC;
+
+  return stringToEnumMap;
+
+} // end GetUnaryFunctorEnumMap()
+
+
 /** \class ITKToolsUnaryImageOperatorBase
  *
  * Untemplated pure virtual base class that holds
@@ -57,6 +105,7 @@ public:
   std::string m_OutputFileName;
   std::string m_UnaryOperatorName;
   std::vector<std::string> m_Arguments;
+  std::vector<itk::Functor::UnaryOperation> m_Operations;
   bool m_UseCompression;
 
 }; // end class ITKToolsUnaryImageOperatorBase
@@ -95,47 +144,24 @@ public:
     typename ReaderType::Pointer reader = ReaderType::New();
     reader->SetFileName( this->m_InputFileName.c_str() );
 
-    /** Define a helper map. */
-    std::map< std::string, UnaryFunctorEnum> stringToEnumMap;
-    stringToEnumMap["PLUS"] = PLUS;
-    stringToEnumMap["RMINUS"] = RMINUS;
-    stringToEnumMap["LMINUS"] = LMINUS;
-    stringToEnumMap["TIMES"] = TIMES;
-    stringToEnumMap["LDIVIDE"] = LDIVIDE;
-    stringToEnumMap["RDIVIDE"] = RDIVIDE;
-    stringToEnumMap["RMODINT"] = RMODINT;
-    stringToEnumMap["RMODDOUBLE"] = RMODDOUBLE;
-    stringToEnumMap["LMODINT"] = LMODINT;
-    stringToEnumMap["LMODDOUBLE"] = LMODDOUBLE;
-    stringToEnumMap["NLOG"] = NLOG;
-    stringToEnumMap["RPOWER"] = RPOWER;
-    stringToEnumMap["LPOWER"] = LPOWER;
-    stringToEnumMap["NEG"] = NEG;
-    stringToEnumMap["SIGNINT"] = SIGNINT;
-    stringToEnumMap["SIGNDOUBLE"] = SIGNDOUBLE;
-    stringToEnumMap["ABSINT"] = ABSINT;
-    stringToEnumMap["ABSDOUBLE"] = ABSDOUBLE;
-    stringToEnumMap["FLOOR"] = FLOOR;
-    stringToEnumMap["CEIL"] = CEIL;
-    stringToEnumMap["ROUND"] = ROUND;
-    stringToEnumMap["LN"] = LN;
-    stringToEnumMap["LOG10"] = LOG10;
-    stringToEnumMap["EXP"] = EXP;
-    stringToEnumMap["SIN"] = SIN;
-    stringToEnumMap["COS"] = COS;
-    stringToEnumMap["TAN"] = TAN;
-    stringToEnumMap["ARCSIN"] = ARCSIN;
-    stringToEnumMap["ARCCOS"] = ARCCOS;
-    stringToEnumMap["ARCTAN"] = ARCTAN;
-    stringToEnumMap["LINEAR"] = LINEAR;
-    stringToEnumMap["ERRFUNC"] = ERRFUNC;
-    stringToEnumMap["NORMCDF"] = NORMCDF;
-    stringToEnumMap["QFUNC"] = QFUNC;
-
     /** Construct the unary filter. */
-    UnaryFunctorFactory<InputImageType, OutputImageType, double> unaryFunctorFactory;
-    typename itk::InPlaceImageFilter<InputImageType, OutputImageType>::Pointer unaryFilter
-      = unaryFunctorFactory.GetFilter( stringToEnumMap[ this->m_UnaryOperatorName ], this->m_Arguments );
+    typename itk::InPlaceImageFilter<InputImageType, OutputImageType>::Pointer unaryFilter;
+    if( this->m_Operations.empty() )
+    {
+      std::map< std::string, UnaryFunctorEnum > stringToEnumMap = GetUnaryFunctorEnumMap();
+      UnaryFunctorFactory<InputImageType, OutputImageType, double> unaryFunctorFactory;
+      unaryFilter = unaryFunctorFactory.GetFilter(
+        stringToEnumMap[ this->m_UnaryOperatorName ], this->m_Arguments );
+    }
+    else
+    {
+      /** A chain of operators is evaluated per voxel in a single pass. */
+      typedef itk::UnaryFunctorImageFilter< InputImageType, OutputImageType,
+        itk::Functor::UNARYCHAIN< InputPixelType, OutputPixelType > >  ChainFilterType;
+      typename ChainFilterType::Pointer chainFilter = ChainFilterType::New();
+      chainFilter->GetFunctor().SetOperations( this->m_Operations );
+      unaryFilter = chainFilter.GetPointer();
+    }
 
     /** Connect the pipeline. */
     unaryFilter->SetInput( reader->GetOutput() );
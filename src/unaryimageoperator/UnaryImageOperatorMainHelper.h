@@ -21,7 +21,10 @@
 #include <map>
 #include <utility> // for pair
 #include <string>
+#include <vector>
+#include <sstream>
 #include <itksys/SystemTools.hxx>
+#include "UnaryImageOperatorHelper.h"
 
 
 /**
@@ -135,6 +138,76 @@ bool OperatorNeedsArgument( const std::string & ops )
 } // end OperatorNeedsArgument()
 
 
+/**
+ * ******************* OperatorNumberOfArguments *******************
+ */
+
+unsigned int OperatorNumberOfArguments( const std::string & ops )
+{
+  if( ops == "LINEAR" || ops == "NORMCDF" || ops == "QFUNC" ) return 2;
+  if( OperatorNeedsArgument( ops ) ) return 1;
+  return 0;
+
+} // end OperatorNumberOfArguments()
+
+
+/**
+ * ******************* ParseOperatorChain *******************
+ *
+ * Parses a list of operators of the form NAME[:arg1[:arg2]],
+ * e.g. "LN TIMES:2 EXP ROUND", into a compact list of operations.
+ * Since the chain is evaluated in double, the double version
+ * of the operators is used, e.g. ABS becomes ABSDOUBLE.
+ */
+
+int ParseOperatorChain( const std::vector<std::string> & opsList,
+  std::vector<itk::Functor::UnaryOperation> & operations )
+{
+  std::map< std::string, UnaryFunctorEnum > stringToEnumMap = GetUnaryFunctorEnumMap();
+
+  operations.clear();
+  for( unsigned int i = 0; i < opsList.size(); i++ )
+  {
+    /** Split the operator name and its arguments. */
+    std::vector<std::string> parts;
+    std::stringstream ss( opsList[ i ] );
+    std::string part;
+    while( std::getline( ss, part, ':' ) ) parts.push_back( part );
+    if( parts.empty() )
+    {
+      std::cerr << "ERROR: empty operator in the chain." << std::endl;
+      return 1;
+    }
+
+    /** Check the operator and the number of arguments. */
+    std::string name = parts[ 0 ];
+    const unsigned int numberOfArguments = OperatorNumberOfArguments( name );
+    int retCO = CheckOps( name, false );
+    if( retCO ) return retCO;
+    if( stringToEnumMap.count( name ) == 0 )
+    {
+      std::cerr << "ERROR: operator " << parts[ 0 ] << " is not supported in a chain." << std::endl;
+      return 1;
+    }
+    if( parts.size() - 1 != numberOfArguments )
+    {
+      std::cerr << "ERROR: operator " << parts[ 0 ] << " needs " << numberOfArguments
+        << " argument(s), specified as " << parts[ 0 ] << ":arg." << std::endl;
+      return 1;
+    }
+
+    itk::Functor::UnaryOperation operation;
+    operation.m_Operator = stringToEnumMap[ name ];
+    operation.m_Argument1 = numberOfArguments > 0 ? atof( parts[ 1 ].c_str() ) : 0.0;
+    operation.m_Argument2 = numberOfArguments > 1 ? atof( parts[ 2 ].c_str() ) : 0.0;
+    operations.push_back( operation );
+  }
+
+  return EXIT_SUCCESS;
+
+} // end ParseOperatorChain()
+
+
 /**
  * ******************* CreateOutputFileName *******************
  */
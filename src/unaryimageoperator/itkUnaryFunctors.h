@@ -21,6 +21,7 @@
 #include "vnl/vnl_math.h"
 #include "vnl/vnl_erf.h"
 #include "itkNumericTraits.h"
+#include <vector>
 
 /** All available unary operators. */
 enum UnaryFunctorEnum{ PLUS, RMINUS, LMINUS, TIMES, LDIVIDE, RDIVIDE,
@@ -617,6 +618,102 @@ private:
   TArgument m_Argument2;
 };
 
+
+/** \class UnaryOperation
+ * A single operator of a chain, with its (at most two) arguments.
+ */
+struct UnaryOperation
+{
+  UnaryFunctorEnum m_Operator;
+  double           m_Argument1;
+  double           m_Argument2;
+};
+
+/** Evaluates a chain of unary operators in one go.
+ *
+ * The chain is stored as a compact list of operators and arguments, and
+ * is evaluated with a switch per operator, so there is no virtual call.
+ * Each operator uses the functor defined above, instantiated for double.
+ * Intermediate results are kept in double; only the final result is
+ * cast to the output type.
+ */
+template< class TInput, class TOutput = TInput >
+class UNARYCHAIN
+{
+public:
+  typedef std::vector< UnaryOperation > OperationsType;
+  UNARYCHAIN() {};
+  ~UNARYCHAIN() {};
+  inline TOutput operator()( const TInput & A ) const
+  {
+    double value = static_cast<double>( A );
+    for( typename OperationsType::const_iterator it = this->m_Operations.begin();
+      it != this->m_Operations.end(); ++it )
+    {
+      const double & arg1 = it->m_Argument1;
+      const double & arg2 = it->m_Argument2;
+      switch( it->m_Operator )
+      {
+        case ::PLUS:       value = Apply< PLUS<double> >( value, arg1 ); break;
+        case ::RMINUS:     value = Apply< RMINUS<double> >( value, arg1 ); break;
+        case ::LMINUS:     value = Apply< LMINUS<double> >( value, arg1 ); break;
+        case ::TIMES:      value = Apply< TIMES<double> >( value, arg1 ); break;
+        case ::LDIVIDE:    value = Apply< LDIVIDE<double> >( value, arg1 ); break;
+        case ::RDIVIDE:    value = Apply< RDIVIDE<double> >( value, arg1 ); break;
+        case ::RMODINT:    value = Apply< RMODINT<double> >( value, arg1 ); break;
+        case ::RMODDOUBLE: value = Apply< RMODDOUBLE<double> >( value, arg1 ); break;
+        case ::LMODINT:    value = Apply< LMODINT<double> >( value, arg1 ); break;
+        case ::LMODDOUBLE: value = Apply< LMODDOUBLE<double> >( value, arg1 ); break;
+        case ::NLOG:       value = Apply< NLOG<double> >( value, arg1 ); break;
+        case ::RPOWER:     value = Apply< RPOWER<double> >( value, arg1 ); break;
+        case ::LPOWER:     value = Apply< LPOWER<double> >( value, arg1 ); break;
+        case ::NEG:        value = NEG<double>()( value ); break;
+        case ::SIGNINT:    value = SIGNINT<double>()( value ); break;
+        case ::SIGNDOUBLE: value = SIGNDOUBLE<double>()( value ); break;
+        case ::ABSINT:     value = ABSINT<double>()( value ); break;
+        case ::ABSDOUBLE:  value = ABSDOUBLE<double>()( value ); break;
+        case ::FLOOR:      value = FLOOR<double>()( value ); break;
+        case ::CEIL:       value = CEIL<double>()( value ); break;
+        case ::ROUND:      value = ROUND<double>()( value ); break;
+        case ::LN:         value = LN<double>()( value ); break;
+        case ::LOG10:      value = LOG10<double>()( value ); break;
+        case ::EXP:        value = EXP<double>()( value ); break;
+        case ::SIN:        value = SIN<double>()( value ); break;
+        case ::COS:        value = COS<double>()( value ); break;
+        case ::TAN:        value = TAN<double>()( value ); break;
+        case ::ARCSIN:     value = ARCSIN<double>()( value ); break;
+        case ::ARCCOS:     value = ARCCOS<double>()( value ); break;
+        case ::ARCTAN:     value = ARCTAN<double>()( value ); break;
+        case ::ERRFUNC:    value = ERRFUNC<double>()( value ); break;
+        case ::LINEAR:     value = Apply< LINEAR<double> >( value, arg1, arg2 ); break;
+        case ::NORMCDF:    value = Apply< NORMCDF<double> >( value, arg1, arg2 ); break;
+        case ::QFUNC:      value = Apply< QFUNC<double> >( value, arg1, arg2 ); break;
+      }
+    }
+    return static_cast<TOutput>( value );
+  }
+  void SetOperations( const OperationsType & operations ){ this->m_Operations = operations; };
+private:
+  /** Apply a functor with one or two arguments. */
+  template< class TFunctor >
+  static inline double Apply( const double & value, const double & arg )
+  {
+    TFunctor functor;
+    functor.SetArgument( arg );
+    return functor( value );
+  }
+  template< class TFunctor >
+  static inline double Apply( const double & value, const double & arg1, const double & arg2 )
+  {
+    TFunctor functor;
+    functor.SetArgument1( arg1 );
+    functor.SetArgument2( arg2 );
+    return functor( value );
+  }
+
+  OperationsType m_Operations;
+};
+
 } // end namespace Functor
 
 
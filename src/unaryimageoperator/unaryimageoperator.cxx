@@ -57,6 +57,10 @@ std::string GetHelpString( void )
     << "             LINEAR = arg1 * A + arg2\n"
     << "             NORMCDF = NORMCDF(mean=arg1, std=arg2)\n"
     << "             QFUNC = QFUNC(mean=arg1, std=arg2)\n"
+    << "           A list of operators is applied in the given order, in a single pass.\n"
+    << "           Their arguments are then given as NAME:arg or NAME:arg1:arg2, and\n"
+    << "           intermediate results are computed in double, e.g.\n"
+    << "             -ops LN TIMES:2 EXP ROUND\n"
     << "  [-arg]   argument, necessary for some ops\n"
     << "  [-out]   outputFilename, default in + <ops> + <arg> + .mhd\n"
     << "  [-z]     compression flag; if provided, the output image is compressed\n"
@@ -98,16 +102,40 @@ int main( int argc, char **argv )
   std::string outputFileName = "";
   parser->GetCommandLineArgument( "-out", outputFileName );
 
-  std::string ops = "PLUS";
-  parser->GetCommandLineArgument( "-ops", ops );
+  std::vector<std::string> opsList( 1, "PLUS" );
+  parser->GetCommandLineArgument( "-ops", opsList );
+  std::string ops = opsList[ 0 ];
+
+  /** A list of operators, or an operator with inline arguments, is a chain. */
+  const bool isChain = opsList.size() > 1 || ops.find( ':' ) != std::string::npos;
 
   std::vector<std::string> arguments( 1, "" );
   bool retarg = parser->GetCommandLineArgument( "-arg", arguments );
 
   const bool useCompression = parser->ArgumentExists( "-z" );
 
+  /** Parse the chain of operators. */
+  std::vector<itk::Functor::UnaryOperation> operations;
+  if( isChain )
+  {
+    if( retarg )
+    {
+      std::cerr << "ERROR: for a chain of operators, specify the arguments as NAME:arg." << std::endl;
+      return EXIT_FAILURE;
+    }
+    int retPOC = ParseOperatorChain( opsList, operations );
+    if( retPOC ) return retPOC;
+  }
+
   /** Create outputFileName. */
-  if( outputFileName == "" )
+  if( outputFileName == "" && isChain )
+  {
+    std::string chainName = "";
+    for( unsigned int i = 0; i < opsList.size(); i++ ) chainName += opsList[ i ];
+    itksys::SystemTools::ReplaceString( chainName, ":", "" );
+    CreateOutputFileName( inputFileName, outputFileName, "CHAIN", chainName );
+  }
+  else if( outputFileName == "" )
   {
     CreateOutputFileName( inputFileName, outputFileName, ops, arguments[0] );
   }
@@ -150,24 +178,27 @@ int main( int argc, char **argv )
   }
 
   /** Append ops and at the same time check if ops is a valid
-   * functor.
+   * functor. A chain has been checked already.
    */
-  std::string opsOld = ops;
-  int retCO  = CheckOps( ops, inputIsInteger & argumentIsInteger );
-  if( retCO ) return retCO;
-
-  /** For certain ops an argument is mandatory. */
-  bool operatorNeedsArgument = OperatorNeedsArgument( opsOld );
-  if( operatorNeedsArgument && !retarg )
-  {
-    std::cerr << "ERROR: operator " << opsOld << " needs an argument." << std::endl;
-    std::cerr << "Specify the argument with \"-arg\"." << std::endl;
-    return EXIT_FAILURE;
-  }
-  if( !operatorNeedsArgument && retarg )
+  if( !isChain )
   {
-    std::cerr << "WARNING: operator " << opsOld << " does not need an argument." << std::endl;
-    std::cerr << "The argument (" << arguments[0] << ") is ignored." << std::endl;
+    std::string opsOld = ops;
+    int retCO  = CheckOps( ops, inputIsInteger & argumentIsInteger );
+    if( retCO ) return retCO;
+
+    /** For certain ops an argument is mandatory. */
+    bool operatorNeedsArgument = OperatorNeedsArgument( opsOld );
+    if( operatorNeedsArgument && !retarg )
+    {
+      std::cerr << "ERROR: operator " << opsOld << " needs an argument." << std::endl;
+      std::cerr << "Specify the argument with \"-arg\"." << std::endl;
+      return EXIT_FAILURE;
+    }
+    if( !operatorNeedsArgument && retarg )
+    {
+      std::cerr << "WARNING: operator " << opsOld << " does not need an argument." << std::endl;
+      std::cerr << "The argument (" << arguments[0] << ") is ignored." << std::endl;
+    }
   }
 
   /** Class that does the work. */
@@ -230,6 +261,7 @@ int main( int argc, char **argv )
     filter->m_UnaryOperatorName = ops;
     filter->m_UseCompression = useCompression;
     filter->m_Arguments = arguments;
+    filter->m_Operations = operations;
 
     filter->Run();
 
@@ -0,0 +1,105 @@
+/*=========================================================================
+*
+* Copyright Marius Staring, Stefan Klein, David Doria. 2011.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0.txt
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*=========================================================================*/
+#ifndef __itkWeightedAdditionImageFilter_h_
+#define __itkWeightedAdditionImageFilter_h_
+
+#include "itkImageToImageFilter.h"
+
+
+namespace itk
+{
+
+/** \class WeightedAdditionImageFilter
+ * \brief Computes the voxel wise weighted sum of a number of images.
+ *
+ * output = sum_i input_i * weight_i
+ *
+ * The inputs and weights are set in pairs with SetInputAndWeight(). They are
+ * combined in a single pass over the output region, so no intermediate
+ * product images are created. The input and weight images can be of another
+ * (smaller) type than the output, and since this filter supports streaming
+ * only the requested regions of the inputs need to be in memory.
+ *
+ * \ingroup IntensityImageFilters
+ * \ingroup MultiThreaded
+ */
+
+template < typename TInputImage, typename TWeightImage, typename TOutputImage >
+class ITK_EXPORT WeightedAdditionImageFilter:
+    public ImageToImageFilter< TInputImage, TOutputImage >
+{
+public:
+
+  /** Standard class typedefs. */
+  typedef WeightedAdditionImageFilter                       Self;
+  typedef ImageToImageFilter< TInputImage, TOutputImage >   Superclass;
+  typedef SmartPointer<Self>                                Pointer;
+  typedef SmartPointer<const Self>                          ConstPointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro( Self );
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro( WeightedAdditionImageFilter, ImageToImageFilter );
+
+  /** Image dimension. */
+  itkStaticConstMacro( ImageDimension, unsigned int, TInputImage::ImageDimension );
+
+  /** Typedefs. */
+  typedef TInputImage                                       InputImageType;
+  typedef typename InputImageType::PixelType                InputPixelType;
+  typedef TWeightImage                                      WeightImageType;
+  typedef typename WeightImageType::PixelType               WeightPixelType;
+  typedef TOutputImage                                      OutputImageType;
+  typedef typename OutputImageType::PixelType               OutputPixelType;
+  typedef typename OutputImageType::RegionType              OutputImageRegionType;
+
+  /** Set the i-th input image and its weight image. */
+  void SetInputAndWeight( unsigned int i,
+    const InputImageType * input, const WeightImageType * weight );
+
+  /** Get the number of input and weight pairs. */
+  unsigned int GetNumberOfInputAndWeightPairs( void ) const
+  {
+    return this->GetNumberOfIndexedInputs() / 2;
+  }
+
+protected:
+  WeightedAdditionImageFilter();
+  virtual ~WeightedAdditionImageFilter() {};
+
+  /** Check that the inputs come in pairs. */
+  virtual void BeforeThreadedGenerateData( void );
+
+  /** Accumulate all weighted inputs for a part of the output. */
+  virtual void DynamicThreadedGenerateData(
+    const OutputImageRegionType & outputRegionForThread );
+
+private:
+  WeightedAdditionImageFilter(const Self&); //purposely not implemented
+  void operator=(const Self&); //purposely not implemented
+
+}; // end class WeightedAdditionImageFilter
+
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkWeightedAdditionImageFilter.hxx"
+#endif
+
+#endif // end #ifndef __itkWeightedAdditionImageFilter_h_
@@ -0,0 +1,126 @@
+/*=========================================================================
+*
+* Copyright Marius Staring, Stefan Klein, David Doria. 2011.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0.txt
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+*=========================================================================*/
+#ifndef _itkWeightedAdditionImageFilter_hxx_
+#define _itkWeightedAdditionImageFilter_hxx_
+
+#include "itkWeightedAdditionImageFilter.h"
+
+#include "itkImageRegionConstIterator.h"
+#include "itkImageRegionIterator.h"
+
+
+namespace itk
+{
+
+/**
+ * ********************* Constructor ****************************
+ */
+
+template < typename TInputImage, typename TWeightImage, typename TOutputImage >
+WeightedAdditionImageFilter< TInputImage, TWeightImage, TOutputImage >
+::WeightedAdditionImageFilter()
+{
+  this->DynamicMultiThreadingOn();
+} // end Constructor
+
+
+/**
+ * ********************* SetInputAndWeight ****************************
+ */
+
+template < typename TInputImage, typename TWeightImage, typename TOutputImage >
+void
+WeightedAdditionImageFilter< TInputImage, TWeightImage, TOutputImage >
+::SetInputAndWeight( unsigned int i,
+  const InputImageType * input, const WeightImageType * weight )
+{
+  this->SetNthInput( 2 * i, const_cast< InputImageType * >( input ) );
+  this->SetNthInput( 2 * i + 1, const_cast< WeightImageType * >( weight ) );
+} // end SetInputAndWeight()
+
+
+/**
+ * ********************* BeforeThreadedGenerateData ****************************
+ */
+
+template < typename TInputImage, typename TWeightImage, typename TOutputImage >
+void
+WeightedAdditionImageFilter< TInputImage, TWeightImage, TOutputImage >
+::BeforeThreadedGenerateData( void )
+{
+  const unsigned int nrPairs = this->GetNumberOfInputAndWeightPairs();
+  if( nrPairs == 0 || this->GetNumberOfIndexedInputs() != 2 * nrPairs )
+  {
+    itkExceptionMacro( << "The inputs should be set in pairs of input and weight images." );
+  }
+} // end BeforeThreadedGenerateData()
+
+
+/**
+ * ********************* DynamicThreadedGenerateData ****************************
+ */
+
+template < typename TInputImage, typename TWeightImage, typename TOutputImage >
+void
+WeightedAdditionImageFilter< TInputImage, TWeightImage, TOutputImage >
+::DynamicThreadedGenerateData( const OutputImageRegionType & outputRegionForThread )
+{
+  typedef ImageRegionConstIterator< InputImageType >    InputIteratorType;
+  typedef ImageRegionConstIterator< WeightImageType >   WeightIteratorType;
+  typedef ImageRegionIterator< OutputImageType >        OutputIteratorType;
+
+  OutputImageType * output = this->GetOutput();
+  OutputIteratorType outIt( output, outputRegionForThread );
+
+  /** Accumulate the weighted inputs one at a time in the output buffer.
+   * The region of a thread is small enough to stay in cache.
+   */
+  const unsigned int nrPairs = this->GetNumberOfInputAndWeightPairs();
+  for( unsigned int i = 0; i < nrPairs; ++i )
+  {
+    const InputImageType * input = dynamic_cast< const InputImageType * >(
+      this->ProcessObject::GetInput( 2 * i ) );
+    const WeightImageType * weight = dynamic_cast< const WeightImageType * >(
+      this->ProcessObject::GetInput( 2 * i + 1 ) );
+
+    InputIteratorType inIt( input, outputRegionForThread );
+    WeightIteratorType wIt( weight, outputRegionForThread );
+    outIt.GoToBegin();
+    if( i == 0 )
+    {
+      for( ; !outIt.IsAtEnd(); ++outIt, ++inIt, ++wIt )
+      {
+        outIt.Set( static_cast< OutputPixelType >( inIt.Get() )
+          * static_cast< OutputPixelType >( wIt.Get() ) );
+      }
+    }
+    else
+    {
+      for( ; !outIt.IsAtEnd(); ++outIt, ++inIt, ++wIt )
+      {
+        outIt.Set( outIt.Get() + static_cast< OutputPixelType >( inIt.Get() )
+          * static_cast< OutputPixelType >( wIt.Get() ) );
+      }
+    }
+  }
+
+} // end DynamicThreadedGenerateData()
+
+} // end namespace itk
+
+#endif // end #ifndef _itkWeightedAdditionImageFilter_hxx_
@@ -42,6 +42,16 @@ std::string GetHelpString( void )
     << "  -in      inputFilenames\n"
     << "  -w       weightFilenames\n"
     << "  -out     outputFilename; always written as float\n"
+    << "  [-running] add the weighted inputs one at a time, so that at most two input\n"
+    << "           and weight pairs are in memory, next to the output: the pair being\n"
+    << "           added, and the next pair, which is read in the meantime.\n"
+    << "           By default all inputs are combined in a single streamed pass.\n"
+    << "  [-z]     compression flag; if provided, the output image is compressed\n"
+    << "  [-s]     number of streams of the single pass; by default the number of\n"
+    << "           inputs, so that together the parts in memory are about as large\n"
+    << "           as one input and weight pair. If a file does not support\n"
+    << "           streaming, the default is -running instead.\n"
+    << "The inputs are read in their own type, the weights as float.\n"
     << "Supported: 2D, 3D, (unsigned) short, (unsigned) char, float.";
 
   return ss.str();
@@ -84,6 +94,13 @@ int main( int argc, char **argv )
   std::string outputFileName("");
   parser->GetCommandLineArgument( "-out", outputFileName );
 
+  const bool useRunningSum = parser->ArgumentExists( "-running" );
+  const bool useCompression = parser->ArgumentExists( "-z" );
+
+  /** Support for streaming. */
+  unsigned int numberOfStreams = 0;
+  parser->GetCommandLineArgument( "-s", numberOfStreams );
+
   /** Determine image properties. */
   itk::IOPixelEnum pixelType = itk::IOPixelEnum::UNKNOWNPIXELTYPE;
   itk::ImageIOBase::IOComponentEnum componentType = itk::IOComponentEnum::UNKNOWNCOMPONENTTYPE;
@@ -97,8 +114,23 @@ int main( int argc, char **argv )
   bool retNOCCheck = itktools::NumberOfComponentsCheck( numberOfComponents );
   if( !retNOCCheck ) return EXIT_FAILURE;
 
-  /** Anyway, float is only supported. */
-  componentType = itk::IOComponentEnum::FLOAT;
+  /** The inputs are read in their own type if they all have the same,
+   * supported type. Otherwise they are read as float.
+   */
+  for( unsigned int i = 1; i < inputFileNames.size(); ++i )
+  {
+    if( itktools::GetImageComponentType( inputFileNames[ i ] ) != componentType )
+    {
+      componentType = itk::IOComponentEnum::FLOAT;
+    }
+  }
+  if( componentType != itk::IOComponentEnum::UCHAR
+    && componentType != itk::IOComponentEnum::CHAR
+    && componentType != itk::IOComponentEnum::USHORT
+    && componentType != itk::IOComponentEnum::SHORT )
+  {
+    componentType = itk::IOComponentEnum::FLOAT;
+  }
 
   /** Class that does the work. */
   ITKToolsWeightedAdditionBase * filter = nullptr;
@@ -106,9 +138,17 @@ int main( int argc, char **argv )
   try
   {
     // now call all possible template combinations.
+    if( !filter ) filter = ITKToolsWeightedAddition< 2, char >::New( dim, componentType );
+    if( !filter ) filter = ITKToolsWeightedAddition< 2, unsigned char >::New( dim, componentType );
+    if( !filter ) filter = ITKToolsWeightedAddition< 2, short >::New( dim, componentType );
+    if( !filter ) filter = ITKToolsWeightedAddition< 2, unsigned short >::New( dim, componentType );
     if( !filter ) filter = ITKToolsWeightedAddition< 2, float >::New( dim, componentType );
 
 #ifdef ITKTOOLS_3D_SUPPORT
+    if( !filter ) filter = ITKToolsWeightedAddition< 3, char >::New( dim, componentType );
+    if( !filter ) filter = ITKToolsWeightedAddition< 3, unsigned char >::New( dim, componentType );
+    if( !filter ) filter = ITKToolsWeightedAddition< 3, short >::New( dim, componentType );
+    if( !filter ) filter = ITKToolsWeightedAddition< 3, unsigned short >::New( dim, componentType );
     if( !filter ) filter = ITKToolsWeightedAddition< 3, float >::New( dim, componentType );
 #endif
     /** Check if filter was instantiated. */
@@ -119,6 +159,9 @@ int main( int argc, char **argv )
     filter->m_InputFileNames = inputFileNames;
     filter->m_WeightFileNames = weightFileNames;
     filter->m_OutputFileName = outputFileName;
+    filter->m_UseRunningSum = useRunningSum;
+    filter->m_UseCompression = useCompression;
+    filter->m_NumberOfStreams = numberOfStreams;
 
     filter->Run();
 
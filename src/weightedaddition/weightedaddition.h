@@ -19,12 +19,18 @@
 #define __weightedaddition_h_
 
 #include "ITKToolsBase.h"
+#include "ITKToolsImageProperties.h"
 
 #include "itkImage.h"
 #include "itkImageFileReader.h"
 #include "itkImageFileWriter.h"
-#include "itkNaryAddImageFilter.h"
-#include "itkMultiplyImageFilter.h"
+#include "itkImageIOFactory.h"
+#include "itkImageRegionIterator.h"
+#include "itkMultiThreaderBase.h"
+#include "itkWeightedAdditionImageFilter.h"
+#include "ITKToolsImageReading.h"
+
+#include <algorithm>
 
 
 /** \class ITKToolsWeightedAdditionBase
@@ -40,6 +46,9 @@ public:
   ITKToolsWeightedAdditionBase()
   {
     this->m_OutputFileName = "";
+    this->m_UseRunningSum = false;
+    this->m_UseCompression = false;
+    this->m_NumberOfStreams = 0;
   };
   /** Destructor. */
   ~ITKToolsWeightedAdditionBase(){};
@@ -48,6 +57,9 @@ public:
   std::vector<std::string> m_InputFileNames;
   std::vector<std::string> m_WeightFileNames;
   std::string m_OutputFileName;
+  bool m_UseRunningSum;
+  bool m_UseCompression;
+  unsigned int m_NumberOfStreams; // 0 for the default, see Run()
 
 }; // end class ITKToolsWeightedAdditionBase
 
@@ -69,20 +81,25 @@ public:
   ITKToolsWeightedAddition(){};
   ~ITKToolsWeightedAddition(){};
 
+  /** TYPEDEF's. */
+  typedef itk::Image< TComponentType, VDimension >      InputImageType;
+  typedef itk::Image< float, VDimension >               WeightImageType;
+  typedef itk::Image< float, VDimension >               OutputImageType;
+  typedef typename InputImageType::Pointer              InputImagePointer;
+  typedef typename WeightImageType::Pointer             WeightImagePointer;
+  typedef typename OutputImageType::Pointer             OutputImagePointer;
+  typedef typename OutputImageType::RegionType          RegionType;
+
   /** Run function. */
   void Run( void )
   {
-    /** TYPEDEF's. */
-    typedef itk::Image< TComponentType, VDimension >      InputImageType;
     typedef itk::ImageFileReader< InputImageType >        ReaderType;
-    typedef itk::MultiplyImageFilter<
-      InputImageType, InputImageType, InputImageType>     MultiplierType;
-    typedef itk::NaryAddImageFilter<
-      InputImageType, InputImageType >                    AdderType;
-    typedef itk::ImageFileWriter< InputImageType >        WriterType;
-    typedef typename InputImageType::PixelType            PixelType;
+    typedef itk::ImageFileReader< WeightImageType >       WeightReaderType;
+    typedef itk::WeightedAdditionImageFilter<
+      InputImageType, WeightImageType, OutputImageType >  AdderType;
+    typedef itk::ImageFileWriter< OutputImageType >       WriterType;
     typedef typename ReaderType::Pointer                  ReaderPointer;
-    typedef typename MultiplierType::Pointer              MultiplierPointer;
+    typedef typename WeightReaderType::Pointer            WeightReaderPointer;
     typedef typename AdderType::Pointer                   AdderPointer;
     typedef typename WriterType::Pointer                  WriterPointer;
 
@@ -93,9 +110,33 @@ public:
       itkGenericExceptionMacro( << "ERROR: Number of weight images does not equal number of input images!" );
     }
 
+    /** Keep at most two input and weight pairs in memory at a time. */
+    if( this->m_UseRunningSum )
+    {
+      this->RunningSum();
+      return;
+    }
+
+    /** By default the single pass is streamed in as many pieces as there
+     * are pairs, so that the parts of all pairs in memory are together
+     * about as large as one pair. If the files can not be streamed, every
+     * pair would be in memory completely, so then the pairs are added one
+     * at a time instead.
+     */
+    unsigned int numberOfStreams = this->m_NumberOfStreams;
+    if( numberOfStreams == 0 )
+    {
+      if( !this->CanStream() )
+      {
+        this->RunningSum();
+        return;
+      }
+      numberOfStreams = nrInputs;
+    }
+
+    /** Compute the weighted sum in a single pass. */
     std::vector< ReaderPointer > inReaders( nrInputs );
-    std::vector< ReaderPointer > wReaders( nrInputs );
-    std::vector< MultiplierPointer > multipliers( nrInputs );
+    std::vector< WeightReaderPointer > wReaders( nrInputs );
     AdderPointer adder = AdderType::New();
     WriterPointer writer = WriterType::New();
 
@@ -103,22 +144,117 @@ public:
     {
       inReaders[ i ] = ReaderType::New();
       inReaders[ i ]->SetFileName( this->m_InputFileNames[ i ].c_str() );
-      wReaders[ i ] = ReaderType::New();
+      wReaders[ i ] = WeightReaderType::New();
       wReaders[ i ]->SetFileName( this->m_WeightFileNames[ i ].c_str() );
-      multipliers[ i ] = MultiplierType::New();
-      multipliers[ i ]->SetInput(0, inReaders[ i ]->GetOutput() );
-      multipliers[ i ]->SetInput(1, wReaders[ i ]->GetOutput() );
-      multipliers[ i ]->InPlaceOn();
-      adder->SetInput(i, multipliers[ i ]->GetOutput() );
+      adder->SetInputAndWeight( i, inReaders[ i ]->GetOutput(), wReaders[ i ]->GetOutput() );
     }
 
     /** Write the output image. */
     writer->SetFileName( this->m_OutputFileName.c_str() );
     writer->SetInput( adder->GetOutput() );
+    writer->SetUseCompression( this->m_UseCompression );
+    writer->SetNumberOfStreamDivisions( numberOfStreams );
     writer->Update();
 
   } // end Run()
 
+
+  /** Check that all inputs and weights can be read in parts, and that the
+   * output can be written in parts.
+   */
+  bool CanStream( void ) const
+  {
+    std::vector< std::string > fileNames = this->m_InputFileNames;
+    fileNames.insert( fileNames.end(),
+      this->m_WeightFileNames.begin(), this->m_WeightFileNames.end() );
+    for( unsigned int i = 0; i < fileNames.size(); ++i )
+    {
+      itk::ImageIOBase::Pointer imageIO;
+      if( !itktools::GetImageIOBase( fileNames[ i ], imageIO )
+        || !imageIO->CanStreamRead() )
+      {
+        return false;
+      }
+    }
+
+    itk::ImageIOBase::Pointer outputIO = itk::ImageIOFactory::CreateImageIO(
+      this->m_OutputFileName.c_str(), itk::IOFileModeEnum::WriteMode );
+    if( outputIO.IsNull() ) return false;
+    outputIO->SetUseCompression( this->m_UseCompression );
+    return outputIO->CanStreamWrite();
+
+  } // end CanStream()
+
+
+  /** Accumulate the weighted inputs one pair at a time in the output image.
+   * The next pair is read in the background while the current one is added.
+   */
+  void RunningSum( void )
+  {
+    const unsigned int nrInputs = this->m_InputFileNames.size();
+
+    /** Start reading the first pair. */
+    std::future< InputImagePointer > nextInput
+      = itktools::ReadImageAsynchronously< InputImageType >( this->m_InputFileNames[ 0 ] );
+    std::future< WeightImagePointer > nextWeight
+      = itktools::ReadImageAsynchronously< WeightImageType >( this->m_WeightFileNames[ 0 ] );
+
+    OutputImagePointer output = OutputImageType::New();
+    typename itk::MultiThreaderBase::Pointer threader = itk::MultiThreaderBase::New();
+    for( unsigned int i = 0; i < nrInputs; ++i )
+    {
+      InputImagePointer input = nextInput.get();
+      WeightImagePointer weight = nextWeight.get();
+      if( i + 1 < nrInputs )
+      {
+        nextInput = itktools::ReadImageAsynchronously< InputImageType >(
+          this->m_InputFileNames[ i + 1 ] );
+        nextWeight = itktools::ReadImageAsynchronously< WeightImageType >(
+          this->m_WeightFileNames[ i + 1 ] );
+      }
+
+      if( i == 0 )
+      {
+        output->CopyInformation( input );
+        output->SetRegions( input->GetLargestPossibleRegion() );
+        output->Allocate();
+      }
+      if( input->GetLargestPossibleRegion() != output->GetLargestPossibleRegion()
+        || weight->GetLargestPossibleRegion() != output->GetLargestPossibleRegion() )
+      {
+        itkGenericExceptionMacro( << "ERROR: The size of input " << this->m_InputFileNames[ i ]
+          << " or weight " << this->m_WeightFileNames[ i ] << " differs from the first input!" );
+      }
+
+      /** Add input * weight to the output. */
+      const bool first = ( i == 0 );
+      threader->ParallelizeImageRegion< VDimension >(
+        output->GetLargestPossibleRegion(),
+        [&input, &weight, &output, first]( const RegionType & region )
+        {
+          itk::ImageRegionConstIterator< InputImageType > inIt( input, region );
+          itk::ImageRegionConstIterator< WeightImageType > wIt( weight, region );
+          itk::ImageRegionIterator< OutputImageType > outIt( output, region );
+          for( ; !outIt.IsAtEnd(); ++outIt, ++inIt, ++wIt )
+          {
+            const float product = static_cast< float >( inIt.Get() ) * wIt.Get();
+            outIt.Set( first ? product : outIt.Get() + product );
+          }
+        },
+        nullptr );
+    }
+
+    /** Write the output image. */
+    typedef itk::ImageFileWriter< OutputImageType > WriterType;
+    typename WriterType::Pointer writer = WriterType::New();
+    writer->SetFileName( this->m_OutputFileName.c_str() );
+    writer->SetInput( output );
+    writer->SetUseCompression( this->m_UseCompression );
+    writer->SetNumberOfStreamDivisions( std::max( this->m_NumberOfStreams, 1u ) );
+    writer->Update();
+
+  } // end RunningSum()
+
 }; // end class ITKToolsWeightedAddition
 
 